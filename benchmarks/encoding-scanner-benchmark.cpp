@@ -0,0 +1,106 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Compares computing the size of struct encodings with objctk_getSizeAndAlignment against parsing
+// them, reading the size from the type tree and releasing the parse result.
+// Usage: encoding-scanner-benchmark [iterations]
+
+#include "objctk.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Returns a struct encoding of the given number of members mixing scalars, pointers, arrays,
+// bitfields, nested structs and, optionally, member names.
+static std::string structEncoding(const unsigned int memberCount, const bool hasMemberNames) {
+  static const char *const memberTypes[] = { "d", "^{Node=^vi}", "[4f]", "b3", "{CGPoint=dd}", "@\"NSString\"", "q", "(Value=iq)" };
+  std::string encoding = "{Struct=";
+  for (unsigned int index = 0; index < memberCount; index++) {
+    if (hasMemberNames) {
+      encoding += "\"member" + std::to_string(index) + "\"";
+    }
+    encoding += memberTypes[index % (sizeof(memberTypes) / sizeof(memberTypes[0]))];
+  }
+  return encoding + "}";
+}
+
+// Returns the average time in nanoseconds of computing the size of each encoding of a corpus.
+template <typename Function>
+static double averageNanoseconds(const std::vector<std::string> &corpus, const int iterations, Function sizeOfEncoding) {
+  int64_t sizeSum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    for (const std::string &encoding : corpus) {
+      sizeSum += sizeOfEncoding(encoding);
+    }
+  }
+  const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  if (sizeSum <= 0) {
+    fprintf(stderr, "The benchmark encodings have no size.\n");
+    exit(EXIT_FAILURE);
+  }
+  return elapsed.count() / ((double)iterations * corpus.size());
+}
+
+static int scannedSize(const std::string &encoding) {
+  int size = -1;
+  if (objctk_getSizeAndAlignment(encoding.c_str(), encoding.size(), objctk_layoutprofile_Host, &size, NULL, NULL) != objctk_statuscode_NoError) {
+    fprintf(stderr, "The benchmark encoding failed to scan.\n");
+    exit(EXIT_FAILURE);
+  }
+  return size;
+}
+
+static int parsedSize(const std::string &encoding) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(encoding.c_str());
+  int size = objctk_typenode_getTypeSize(objctk_typeparseresult_getParsedType(parseResult));
+  objctk_typeparseresult_release(parseResult);
+  return size;
+}
+
+int main(int argc, const char *argv[]) {
+  const int iterations = (argc > 1) ? atoi(argv[1]) : 20000;
+  const unsigned int memberCounts[] = { 2, 8, 32, 128 };
+
+  printf("%8s %6s %12s %12s %8s\n", "members", "names", "parse ns", "scan ns", "speedup");
+  for (const bool hasMemberNames : { false, true }) {
+    for (const unsigned int memberCount : memberCounts) {
+      // A corpus of structs of the same shape but distinct lengths, so that neither path benefits
+      // from repeating a single encoding.
+      std::vector<std::string> corpus;
+      for (unsigned int variant = 0; variant < 16; variant++) {
+        corpus.push_back(structEncoding(memberCount + variant, hasMemberNames));
+      }
+      const int corpusIterations = std::max(1, iterations / (int)memberCount);
+      const double parseNanoseconds = averageNanoseconds(corpus, corpusIterations, parsedSize);
+      const double scanNanoseconds = averageNanoseconds(corpus, corpusIterations, scannedSize);
+      printf("%8u %6s %12.1f %12.1f %7.1fx\n", memberCount, hasMemberNames ? "yes" : "no", parseNanoseconds, scanNanoseconds, parseNanoseconds / scanNanoseconds);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Measures how parsing a large struct encoding scales with the number of threads passed to
+// objctk_parseTypeEncodingInParallel. Usage: parallel-parse-benchmark [member count] [iterations]
+
+#include "objctk.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+static std::string largeStructEncoding(const unsigned long memberCount) {
+  std::string encoding = "{Large=";
+  for (unsigned long index = 0; index < memberCount; index++) {
+    const std::string suffix = std::to_string(index % 97);
+    switch (index % 4) {
+      case 0: encoding += "{Point" + suffix + "=dd}"; break;
+      case 1: encoding += "^{Node" + suffix + "=^vi}"; break;
+      case 2: encoding += "[4(Value" + suffix + "=iq)]"; break;
+      default: encoding += "@\"NSString\"i"; break;
+    }
+  }
+  return encoding + "}";
+}
+
+// Returns the fastest of several parses in seconds.
+static double fastestParseSeconds(const std::string &encoding, const unsigned int threadCount, const int iterations) {
+  double fastestSeconds = 0;
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    const auto start = std::chrono::steady_clock::now();
+    objctk_typeparseresult parseResult = (threadCount == 0)
+        ? objctk_parseTypeEncoding(encoding.c_str())
+        : objctk_parseTypeEncodingInParallel(encoding.c_str(), threadCount, NULL);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (objctk_typeparseresult_getStatusCode(parseResult) != objctk_statuscode_NoError) {
+      fprintf(stderr, "The benchmark encoding failed to parse.\n");
+      exit(EXIT_FAILURE);
+    }
+    objctk_typeparseresult_release(parseResult);
+    fastestSeconds = (iteration == 0) ? elapsed.count() : std::min(fastestSeconds, elapsed.count());
+  }
+  return fastestSeconds;
+}
+
+int main(int argc, const char *argv[]) {
+  const unsigned long memberCount = (argc > 1) ? strtoul(argv[1], NULL, 10) : 200000;
+  const int iterations = (argc > 2) ? atoi(argv[2]) : 10;
+  const std::string encoding = largeStructEncoding(memberCount);
+  const double megabytes = encoding.size() / (1024.0 * 1024.0);
+  const unsigned int hardwareThreadCount = std::max(1u, std::thread::hardware_concurrency());
+  printf("%.1f MiB encoding, %lu members, %u hardware threads\n", megabytes, memberCount, hardwareThreadCount);
+
+  const double serialSeconds = fastestParseSeconds(encoding, 0, iterations);
+  printf("%8s %10s %10s %8s\n", "threads", "ms", "MiB/s", "speedup");
+  printf("%8s %10.2f %10.1f %8.2f\n", "serial", serialSeconds * 1e3, megabytes / serialSeconds, 1.0);
+  for (unsigned int threadCount = 1; threadCount <= (2 * hardwareThreadCount); threadCount *= 2) {
+    const double seconds = fastestParseSeconds(encoding, threadCount, iterations);
+    printf("%8u %10.2f %10.1f %8.2f\n", threadCount, seconds * 1e3, megabytes / seconds, serialSeconds / seconds);
+  }
+  return EXIT_SUCCESS;
+}
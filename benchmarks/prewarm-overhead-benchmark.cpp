@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Measures the cost that prewarming adds to parses of type encodings which are not prewarmed: the
+// lookup of each type encoding among the prewarmed ones, compared with the parse that follows it.
+// Usage: prewarm-overhead-benchmark [iterations]
+
+#include "objctk.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+static std::string structEncoding(const char *name, const unsigned int memberCount) {
+  std::string encoding = std::string("{") + name + "=";
+  for (unsigned int index = 0; index < memberCount; index++) {
+    encoding += (index % 2 == 0) ? "d" : "^{Node=^vi}";
+  }
+  return encoding + "}";
+}
+
+// Returns the average time of a parse in nanoseconds, which includes the prewarmed lookup.
+static double averageParseNanoseconds(const std::string &encoding, const int iterations) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    objctk_typeparseresult parseResult = objctk_parseTypeEncoding(encoding.c_str());
+    if (objctk_typeparseresult_getStatusCode(parseResult) != objctk_statuscode_NoError) {
+      fprintf(stderr, "The benchmark encoding failed to parse.\n");
+      exit(EXIT_FAILURE);
+    }
+    objctk_typeparseresult_release(parseResult);
+  }
+  const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+// Returns the average time of a prewarmed lookup which misses in nanoseconds.
+static double averageMissNanoseconds(const std::string &encoding, const int iterations) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    if (objctk_getPrewarmedParseResult(encoding.c_str()) != NULL) {
+      fprintf(stderr, "The benchmark encoding is prewarmed.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+int main(int argc, const char *argv[]) {
+  const int iterations = (argc > 1) ? atoi(argv[1]) : 200000;
+  const std::string missedEncodings[] = {
+    "{CGPoint=dd}",
+    structEncoding("Medium", 16),
+    structEncoding("Large", 4096),
+  };
+  const size_t encodingCount = sizeof(missedEncodings) / sizeof(missedEncodings[0]);
+
+  // Prewarm encodings of the same lengths as the parsed ones, which is the worst case for a miss
+  // because the missed encodings pass the length filter and are hashed.
+  std::string prewarmedEncodings[encodingCount];
+  const char *prewarmedEncodingPointers[encodingCount];
+  for (size_t index = 0; index < encodingCount; index++) {
+    prewarmedEncodings[index] = missedEncodings[index];
+    prewarmedEncodings[index][1] = 'Z';
+    prewarmedEncodingPointers[index] = prewarmedEncodings[index].c_str();
+  }
+  objctk_prewarmTypeEncodings(prewarmedEncodingPointers, encodingCount);
+
+  printf("%8s %12s %12s %10s\n", "length", "parse ns", "miss ns", "overhead");
+  for (size_t index = 0; index < encodingCount; index++) {
+    const std::string &encoding = missedEncodings[index];
+    const int encodingIterations = std::max(1, iterations / (int)((encoding.size() / 16) + 1));
+    const double parseNanoseconds = averageParseNanoseconds(encoding, encodingIterations);
+    const double missNanoseconds = averageMissNanoseconds(encoding, encodingIterations);
+    printf("%8zu %12.1f %12.1f %9.1f%%\n", encoding.size(), parseNanoseconds, missNanoseconds, 100.0 * missNanoseconds / (parseNanoseconds - missNanoseconds));
+  }
+  return EXIT_SUCCESS;
+}
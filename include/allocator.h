@@ -0,0 +1,65 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_ALLOCATOR__
+#define OBJCTK_ALLOCATOR__
+
+#include "macros.h"
+
+#include <stddef.h>
+
+/**
+ * A set of functions through which objctk obtains and returns memory. Each function receives the
+ * context pointer of the allocator as its first argument. The functions must behave like malloc,
+ * realloc and free respectively and return memory aligned for any fundamental type.
+ */
+typedef struct objctk_allocator {
+  /** An opaque pointer passed to each of the allocator functions. */
+  void *context;
+  /** Allocates size bytes of memory, returning NULL on failure. */
+  void *(*allocate)(void *context, size_t size);
+  /** Resizes a block of memory to size bytes, returning NULL on failure. */
+  void *(*reallocate)(void *context, void *pointer, size_t size);
+  /** Frees a block of memory. */
+  void (*deallocate)(void *context, void *pointer);
+} objctk_allocator;
+
+/**
+ * Sets the allocator used by objctk unless another allocator is specified for a particular parse.
+ * Passing NULL restores the default allocator, which uses malloc, realloc and free. The default
+ * allocator may be changed while other threads parse, but it must only be changed while no memory
+ * allocated with the previous one is outstanding. The default allocator is left unchanged if its copy
+ * cannot be allocated.
+ */
+OBJCTK_EXTERN void objctk_setDefaultAllocator(const objctk_allocator *allocator);
+
+/** Returns the allocator used by objctk unless another allocator is specified for a particular parse. */
+OBJCTK_EXTERN objctk_allocator objctk_getDefaultAllocator(void);
+
+/**
+ * Frees memory returned by objctk functions whose names contain "copy" using the default allocator.
+ */
+OBJCTK_EXTERN void objctk_free(void *pointer);
+
+#endif
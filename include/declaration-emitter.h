@@ -0,0 +1,104 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_DECLARATION_EMITTER__
+#define OBJCTK_DECLARATION_EMITTER__
+
+#include "allocator.h"
+#include "macros.h"
+#include "type-encoding.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * An opaque type collecting the struct and union definitions needed to declare a set of types in C.
+ *
+ * Each struct or union with a tag and members is defined once per distinct structure, where the
+ * contents of structs referenced through pointers do not contribute to the structure. A tag defined
+ * with more than one structure is given a numeric suffix, as in CGRect_2, for all but the first.
+ * Type encodings do not record the names of members, which are declared as field0, field1 and so
+ * on, and structs and unions without a tag are declared inline. Characters of tags which are not
+ * valid in C identifiers are replaced with underscores, and tags which are C keywords, as in {int=i},
+ * are suffixed with an underscore. Objects are declared as id, qualified by their protocols if any,
+ * so that "@\"NSString\"" is declared without a declaration of NSString.
+ *
+ * A declaration emitter refers to the type nodes added to it and must not be used after their parse
+ * results are released. A declaration emitter must only be used by one thread at a time.
+ */
+typedef struct _objctk_declarationemitter *objctk_declarationemitter;
+
+/**
+ * A function receiving the emitted text in chunks which are not NUL-terminated. Returning false stops
+ * the emission.
+ */
+typedef bool (*objctk_declarationsink)(void *context, const char *text, size_t length);
+
+/**
+ * Creates an empty declaration emitter which obtains all of its memory from an allocator. The
+ * default allocator is used if allocator is NULL.
+ */
+OBJCTK_EXTERN objctk_declarationemitter objctk_declarationemitter_create(const objctk_allocator *allocator);
+
+/**
+ * Collects the definitions of the structs and unions within the type represented by a type node,
+ * including those referenced through pointers. Definitions which the emitter already holds are not
+ * collected again. Returns objctk_statuscode_OutOfMemory if memory could not be allocated, in which
+ * case some of the definitions may have been collected.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_declarationemitter_addType(objctk_declarationemitter emitter, objctk_typenode node);
+
+/** Returns the number of distinct struct and union definitions collected by an emitter. */
+OBJCTK_EXTERN size_t objctk_declarationemitter_getDefinitionCount(objctk_declarationemitter emitter);
+
+/**
+ * Writes the collected definitions to a sink, ordering them so that the definition of each struct or
+ * union precedes the definitions which contain it by value. Returns objctk_statuscode_InvalidInput if
+ * the sink stopped the emission.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_declarationemitter_emitDefinitions(objctk_declarationemitter emitter, objctk_declarationsink sink, void *context);
+
+/**
+ * Writes the collected definitions, ordered as by objctk_declarationemitter_emitDefinitions, into a
+ * buffer of a given capacity, truncating and NUL-terminating them if they do not fit. The length of
+ * the complete text, excluding the NUL terminator, is stored in outLength, so the text was truncated
+ * if it is not less than the capacity.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_declarationemitter_copyDefinitions(objctk_declarationemitter emitter, char *buffer, size_t capacity, size_t *outLength);
+
+/**
+ * Writes a C declaration of a variable or member with a given name and the type represented by a
+ * type node, such as "struct CGRect frame" or "int (*table)[4]", into a buffer as by
+ * objctk_declarationemitter_copyDefinitions. An abstract declarator such as "int (*)[4]" is written
+ * if name is NULL. Structs and unions are referred to by the tags under which the emitter defines
+ * them; emitter may be NULL, in which case their tags are used without suffixes. Returns
+ * objctk_statuscode_InvalidInput for top-level types, which describe sequences of values and cannot
+ * be declared.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_declarationemitter_copyDeclaration(objctk_declarationemitter emitter, objctk_typenode node, const char *name, char *buffer, size_t capacity, size_t *outLength);
+
+/** Frees the memory associated with a declaration emitter. */
+OBJCTK_EXTERN void objctk_declarationemitter_release(objctk_declarationemitter emitter);
+
+#endif
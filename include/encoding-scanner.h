@@ -0,0 +1,101 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_ENCODING_SCANNER__
+#define OBJCTK_ENCODING_SCANNER__
+
+#include "macros.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Computes the size and alignment of the first type of a type encoding under the data layout rules
+ * of a layout profile in a single pass over its characters, without building a type tree or
+ * allocating memory. At most length characters of the encoding are read and scanning stops at a
+ * null character. Type qualifiers and frame offsets preceding the type and the quoted names
+ * preceding the types of struct members, as in the encodings of instance variables, are skipped as
+ * they are by the parser.
+ *
+ * On success, the size and alignment agree with objctk_typenode_getTypeSizeForLayoutProfile and
+ * objctk_typenode_getTypeAlignmentForLayoutProfile for the same type, including a size and alignment
+ * of -1 for types whose layout cannot be determined, and the offset following the type is stored in
+ * outEndOffset. Any of the out parameters may be NULL. Returns objctk_statuscode_InvalidInput if
+ * the type is incomplete, malformed or nested more than 64 levels deep and
+ * objctk_statuscode_EncounteredInvalidToken if it contains a character which does not begin a
+ * type.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_getSizeAndAlignment(
+    const char *typeEncoding,
+    size_t length,
+    objctk_layoutprofile profile,
+    int *outSize,
+    int *outAlignment,
+    size_t *outEndOffset);
+
+/**
+ * Finds the end of the first complete type of a type encoding without building a type tree or
+ * allocating memory. At most length characters of the encoding are read and scanning stops at a
+ * null character. Type qualifiers, frame offsets and member names are skipped as they are by the
+ * parser, and the brackets of arrays, structs and unions are matched taking the names of structs
+ * and unions and the class names of objects into account. Members are otherwise not validated.
+ *
+ * On success, the offset following the type is stored in outEndOffset, which may be NULL. Returns
+ * objctk_statuscode_InvalidInput if the type is incomplete, has mismatched brackets or nests
+ * brackets more than 64 levels deep and objctk_statuscode_EncounteredInvalidToken if it begins with
+ * a character which does not begin a type.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_skipType(const char *typeEncoding, size_t length, size_t *outEndOffset);
+
+/**
+ * An iterator over the top-level types of a type encoding such as a method signature or the member
+ * list of a struct. Splitters are allocated by the caller, initialized with
+ * objctk_typesplitter_init and require no cleanup. Their fields are private.
+ */
+typedef struct objctk_typesplitter {
+  const char *typeEncoding;
+  size_t length;
+  size_t offset;
+  objctk_statuscode status;
+} objctk_typesplitter;
+
+/** Initializes a splitter over at most length characters of a type encoding. */
+OBJCTK_EXTERN void objctk_typesplitter_init(objctk_typesplitter *splitter, const char *typeEncoding, size_t length);
+
+/**
+ * Advances a splitter to the next top-level type, storing the range of the type, which excludes the
+ * type qualifiers and frame offsets surrounding it, in outRange. Returns false once the encoding is
+ * exhausted or a type cannot be skipped, as reported by objctk_typesplitter_getStatusCode.
+ */
+OBJCTK_EXTERN bool objctk_typesplitter_next(objctk_typesplitter *splitter, objctk_range *outRange);
+
+/**
+ * Returns objctk_statuscode_NoError unless a splitter stopped at a type which could not be skipped,
+ * in which case the status code of objctk_skipType is returned.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_typesplitter_getStatusCode(const objctk_typesplitter *splitter);
+
+#endif
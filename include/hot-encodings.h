@@ -0,0 +1,93 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_HOT_ENCODINGS__
+#define OBJCTK_HOT_ENCODINGS__
+
+#include "macros.h"
+#include "type-encoding.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The maximum number of frequently parsed type encodings tracked at once. */
+#define OBJCTK_FREQUENT_ENCODING_CAPACITY 256
+
+/**
+ * Sets how often parses are sampled to track the most frequently parsed type encodings. One of
+ * every samplingInterval parses on each thread is timed and counted in a count-min sketch, and the
+ * encodings whose estimated counts are among the highest are retained along with their parse
+ * times. A samplingInterval of zero, the default, disables tracking, which then costs a single
+ * relaxed atomic load per parse. Tracking is compiled out along with statistics when
+ * OBJCTK_ENABLE_STATISTICS is defined to 0.
+ */
+OBJCTK_EXTERN void objctk_setEncodingSamplingInterval(unsigned int samplingInterval);
+
+/** Returns the interval at which parses are sampled or zero if tracking is disabled. */
+OBJCTK_EXTERN unsigned int objctk_getEncodingSamplingInterval(void);
+
+/**
+ * A function receiving a frequently parsed type encoding, the estimated number of times it was
+ * parsed and the average time spent parsing it in nanoseconds.
+ */
+typedef void (*objctk_frequentencodingfunction)(const char *typeEncoding, uint64_t estimatedParseCount, uint64_t averageParseNanoseconds, void *context);
+
+/**
+ * Passes up to maximumCount of the most frequently parsed type encodings to a function, most
+ * frequent first. Estimated parse counts are the estimated number of sampled parses scaled by the
+ * current sampling interval and may overestimate the true counts. The function is called after the
+ * tracked encodings have been copied and may parse type encodings.
+ */
+OBJCTK_EXTERN void objctk_enumerateFrequentEncodings(size_t maximumCount, objctk_frequentencodingfunction function, void *context);
+
+/** Discards all tracked type encodings and their estimated counts. */
+OBJCTK_EXTERN void objctk_resetEncodingFrequencies(void);
+
+/**
+ * Parses type encodings ahead of time into parse results which persist for the life of the process.
+ * Subsequent parses of a prewarmed type encoding through objctk_parseTypeEncoding,
+ * objctk_parseTypeEncodingWithAllocator, objctk_parseTypeEncodingWithLimits and
+ * objctk_parser_parseTypeEncoding return its persistent parse result, for which
+ * objctk_typeparseresult_release has no effect, instead of parsing it again. Type encodings which
+ * fail to parse are not prewarmed. Parses with resource limits, and parses and parsers given a
+ * specific allocator, always parse their type encodings, as persistent parse results are allocated
+ * from the default allocator. Returns the number of type encodings which are prewarmed.
+ *
+ * Prewarming is intended for process startup, but it may be repeated: type encodings are added to
+ * the current table of prewarmed encodings while it has room for them, and otherwise to a copy of at
+ * least twice its capacity. Replaced tables are retained for the life of the process so that
+ * lookups need not synchronize with prewarming, which bounds the memory of all tables to a constant
+ * factor of the number of prewarmed type encodings however many calls prewarm them.
+ *
+ * Once any type encoding is prewarmed, every parse first looks its type encoding up. A lookup of a
+ * type encoding which is not prewarmed reads at most one character more than the longest prewarmed
+ * type encoding. It hashes those characters only if some prewarmed type encoding has the same
+ * length modulo 64. No lookup is made before the first type encoding is prewarmed.
+ */
+OBJCTK_EXTERN size_t objctk_prewarmTypeEncodings(const char *const *typeEncodings, size_t count);
+
+/** Returns the persistent parse result of a prewarmed type encoding or NULL. */
+OBJCTK_EXTERN objctk_typeparseresult objctk_getPrewarmedParseResult(const char *typeEncoding);
+
+#endif
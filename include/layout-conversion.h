@@ -0,0 +1,99 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_LAYOUT_CONVERSION__
+#define OBJCTK_LAYOUT_CONVERSION__
+
+#include "macros.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An opaque type holding a compiled plan for converting values of a type from the data layout of
+ * one layout profile to that of another, e.g. from a 32-bit memory dump to the 64-bit host layout.
+ */
+typedef struct _objctk_layoutconversion *objctk_layoutconversion;
+
+/**
+ * A function translating a non-null pointer read from a source value to the pointer written to the
+ * destination value. Pointers include object, class, selector and character string pointers.
+ */
+typedef uint64_t (*objctk_pointertranslationfunction)(uint64_t pointer, void *context);
+
+/**
+ * Compiles a plan converting values of the type represented by a type node from the data layout
+ * rules of a source layout profile to those of a destination layout profile.
+ *
+ * Members whose representation is identical in both profiles are copied in runs, integers whose
+ * sizes differ (long and unsigned long) are sign or zero extended or truncated, pointers are passed
+ * to an optional translation function and bitfields are repacked. Padding in the destination values
+ * is zeroed. Both profiles are assumed to be little-endian.
+ *
+ * Returns NULL if the layout of the type cannot be determined in either profile or if the type
+ * contains a union whose members are not laid out identically in both profiles, as the active
+ * member of a union cannot be determined. Unions are copied as a whole, so a type containing a union
+ * with a pointer member is rejected too, as the pointer could not be passed to the translation
+ * function.
+ */
+OBJCTK_EXTERN objctk_layoutconversion objctk_layoutconversion_create(
+    objctk_typenode node,
+    objctk_layoutprofile sourceProfile,
+    objctk_layoutprofile destinationProfile);
+
+/** Returns the size of the values read by a layout conversion. */
+OBJCTK_EXTERN size_t objctk_layoutconversion_getSourceValueSize(objctk_layoutconversion conversion);
+
+/** Returns the size of the values written by a layout conversion. */
+OBJCTK_EXTERN size_t objctk_layoutconversion_getDestinationValueSize(objctk_layoutconversion conversion);
+
+/**
+ * Returns the number of operations in the plan of a layout conversion. Operations of the same kind
+ * repeating at a constant stride, such as the elements of an array of longs, count as one, as do
+ * such runs repeated for every element of an array, such as the longs of an array of structs.
+ */
+OBJCTK_EXTERN size_t objctk_layoutconversion_getOperationCount(objctk_layoutconversion conversion);
+
+/**
+ * Converts a contiguous array of values from the source layout to the destination layout. The
+ * source and destination buffers must not overlap. Values are converted in blocks, applying each
+ * operation of the plan across a block at a time.
+ *
+ * Non-null pointers are passed to pointerTranslationFunction if it is not NULL and are otherwise
+ * zero extended or truncated. Null pointers remain null.
+ */
+OBJCTK_EXTERN void objctk_layoutconversion_convertValues(
+    objctk_layoutconversion conversion,
+    const void *sourceValues,
+    void *destinationValues,
+    size_t valueCount,
+    objctk_pointertranslationfunction pointerTranslationFunction,
+    void *context);
+
+/** Frees the memory associated with a layout conversion. */
+OBJCTK_EXTERN void objctk_layoutconversion_release(objctk_layoutconversion conversion);
+
+#endif
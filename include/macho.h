@@ -0,0 +1,84 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_MACHO__
+#define OBJCTK_MACHO__
+
+#include "macros.h"
+#include "type-encoding.h"
+
+#include <stddef.h>
+
+/**
+ * An opaque type describing a memory-mapped Mach-O file and the Objective-C type encodings found in
+ * its metadata sections.
+ */
+typedef struct _objctk_machoimage *objctk_machoimage;
+
+/**
+ * A function receiving a type encoding of a Mach-O image, its index and its parse result. The parse
+ * result is only valid for the duration of the call and must not be released.
+ */
+typedef void (*objctk_machoencodingfunction)(size_t index, const char *typeEncoding, objctk_typeparseresult parseResult, void *context);
+
+/**
+ * Maps a thin or fat Mach-O file into memory and collects the distinct type encodings of its
+ * Objective-C method type sections (__TEXT,__objc_methtype and __OBJC,__meth_var_types), which
+ * hold the type encodings of methods and instance variables. Encodings are not copied. Returns NULL
+ * if the file cannot be mapped or is not a valid Mach-O file.
+ */
+OBJCTK_EXTERN objctk_machoimage objctk_machoimage_open(const char *path);
+
+/** Returns the number of architectures contained in a Mach-O image. */
+OBJCTK_EXTERN size_t objctk_machoimage_getArchitectureCount(objctk_machoimage image);
+
+/** Returns the number of distinct type encodings found in a Mach-O image. */
+OBJCTK_EXTERN size_t objctk_machoimage_getEncodingCount(objctk_machoimage image);
+
+/**
+ * Returns a NUL-terminated type encoding of a Mach-O image or NULL if the index is out of bounds.
+ * The encoding points into the mapped file and remains valid until the image is released.
+ */
+OBJCTK_EXTERN const char *objctk_machoimage_getEncoding(objctk_machoimage image, size_t index);
+
+/**
+ * Parses every type encoding of a Mach-O image in place and passes each parse result to a function.
+ * Encodings are distributed over threadCount threads, each of which parses with its own reusable
+ * parser; the function may therefore be called concurrently from multiple threads. A threadCount of
+ * zero or one parses on the calling thread, as do any threads which cannot be spawned.
+ *
+ * Returns objctk_statuscode_InvalidInput if image or encodingFunction is NULL and
+ * objctk_statuscode_OutOfMemory if some encodings could not be parsed because no parser could be
+ * created.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_machoimage_parseEncodings(
+    objctk_machoimage image,
+    unsigned int threadCount,
+    objctk_machoencodingfunction encodingFunction,
+    void *context);
+
+/** Unmaps a Mach-O image and frees its associated memory. */
+OBJCTK_EXTERN void objctk_machoimage_release(objctk_machoimage image);
+
+#endif
@@ -39,6 +39,10 @@ SOFTWARE.
 #  else
 #    define OBJCTK_ENUM(name, type, ...) enum { __VA_ARGS__ }; typedef type name
 #  endif
+#elif defined(__cplusplus) && (__cplusplus >= 201103L)
+#  define OBJCTK_ENUM(name, type, ...) typedef enum : type { __VA_ARGS__ } name
+#else
+#  define OBJCTK_ENUM(name, type, ...) enum { __VA_ARGS__ }; typedef type name
 #endif
 
 #endif
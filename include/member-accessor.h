@@ -0,0 +1,123 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_MEMBER_ACCESSOR__
+#define OBJCTK_MEMBER_ACCESSOR__
+
+#include "allocator.h"
+#include "macros.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stddef.h>
+
+/**
+ * An opaque type holding a member path resolved against a type: the chain of offsets and pointer
+ * dereferences leading from the address of a value of the type to the address of the member.
+ *
+ * Type encodings do not record the names of struct members, so a path selects members by index or
+ * by the name of their type. A path is a sequence of components, the first of which may omit its
+ * leading separator:
+ *
+ * - ".N" selects member N of a struct, union or top-level type.
+ * - ".Name" selects the only member whose struct, union or class name is Name.
+ * - "[N]" selects element N of an array or, after dereferencing a pointer, the Nth value it points
+ *   to.
+ * - "->N" and "->Name" dereference a pointer to a struct or union and select one of its members.
+ *
+ * For example, "CGSize.0" selects the width of a CGRect and "[2]->1" the second member of the
+ * struct pointed to by the third element of an array of pointers. Values are read under the data
+ * layout rules of the host. A member accessor refers to the type nodes against which it is resolved
+ * and must not be used after their parse result is released.
+ */
+typedef struct _objctk_memberaccessor *objctk_memberaccessor;
+
+/**
+ * Resolves a member path against the type represented by a type node. Returns NULL if the path is
+ * malformed, does not match the type, selects a bitfield or passes through a type whose layout
+ * cannot be determined.
+ */
+OBJCTK_EXTERN objctk_memberaccessor objctk_memberaccessor_create(objctk_typenode node, const char *path);
+
+/** Returns the type node of the member selected by a member accessor. */
+OBJCTK_EXTERN objctk_typenode objctk_memberaccessor_getMemberType(objctk_memberaccessor accessor);
+
+/** Returns the number of pointers dereferenced by a member accessor. */
+OBJCTK_EXTERN size_t objctk_memberaccessor_getDereferenceCount(objctk_memberaccessor accessor);
+
+/**
+ * Returns the address of the member selected by a member accessor within the value at an address
+ * or NULL if a pointer dereferenced along the way is null.
+ */
+OBJCTK_EXTERN void *objctk_memberaccessor_getAddress(objctk_memberaccessor accessor, const void *valueAddress);
+
+/**
+ * Writes the address of the selected member of each value of an array of values, which are
+ * separated by valueStride bytes, to outAddresses. Addresses reached through null pointers are NULL.
+ */
+OBJCTK_EXTERN void objctk_memberaccessor_getAddresses(
+    objctk_memberaccessor accessor,
+    const void *values,
+    size_t valueCount,
+    size_t valueStride,
+    void **outAddresses);
+
+/**
+ * Copies the selected member of each value of an array of values, which are separated by
+ * valueStride bytes, into consecutive elements of outMemberValues, each the size of the member
+ * type. Members reached through null pointers are zero-filled. Returns the number of members copied.
+ */
+OBJCTK_EXTERN size_t objctk_memberaccessor_copyMemberValues(
+    objctk_memberaccessor accessor,
+    const void *values,
+    size_t valueCount,
+    size_t valueStride,
+    void *outMemberValues);
+
+/** Frees the memory associated with a member accessor. */
+OBJCTK_EXTERN void objctk_memberaccessor_release(objctk_memberaccessor accessor);
+
+/**
+ * An opaque type caching member accessors by type and path. Types are matched by structure rather
+ * than by type node, and the cache keeps its own copy of each type, so a type node need not outlive
+ * the cache and a cached member accessor is found again for structurally identical types parsed
+ * later. A member accessor cache is safe to use from multiple threads.
+ */
+typedef struct _objctk_memberaccessorcache *objctk_memberaccessorcache;
+
+/** Creates an empty member accessor cache. */
+OBJCTK_EXTERN objctk_memberaccessorcache objctk_memberaccessorcache_create(const objctk_allocator *allocator);
+
+/**
+ * Returns the cached member accessor resolving a path against the type represented by a type node,
+ * creating it on first use. The member accessor, including its member type node, is owned by the
+ * cache and remains valid until the cache is released. Returns NULL if the path cannot be resolved
+ * against the type.
+ */
+OBJCTK_EXTERN objctk_memberaccessor objctk_memberaccessorcache_getAccessor(objctk_memberaccessorcache cache, objctk_typenode node, const char *path);
+
+/** Frees a member accessor cache and the member accessors it owns. */
+OBJCTK_EXTERN void objctk_memberaccessorcache_release(objctk_memberaccessorcache cache);
+
+#endif
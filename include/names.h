@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_NAMES__
+#define OBJCTK_NAMES__
+
+#include "macros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A process-wide identifier of an interned name. Equal names always have equal identifiers and
+ * identifiers remain valid for the lifetime of the process.
+ */
+typedef uint32_t objctk_nameid;
+
+/** The identifier denoting the absence of a name. */
+#define OBJCTK_NAMEID_NONE ((objctk_nameid)0)
+
+/**
+ * Interns a name, returning its identifier or OBJCTK_NAMEID_NONE if the name is empty or could not
+ * be interned. This function is thread-safe. Interned names are never freed, so the name table keeps
+ * obtaining memory from the default allocator at the time it was first used. Parsing interns type
+ * names only once a parse has succeeded.
+ */
+OBJCTK_EXTERN objctk_nameid objctk_internName(const char *name, size_t length);
+
+/**
+ * Returns the identifier of a previously interned name or OBJCTK_NAMEID_NONE if the name has not
+ * been interned. This function is thread-safe.
+ */
+OBJCTK_EXTERN objctk_nameid objctk_lookupName(const char *name, size_t length);
+
+/**
+ * Returns the NUL-terminated interned name with the given identifier or NULL if the identifier is
+ * invalid. The returned string remains valid for the lifetime of the process. This function is
+ * thread-safe and lock-free.
+ */
+OBJCTK_EXTERN const char *objctk_getInternedName(objctk_nameid nameID, size_t *outLength);
+
+#endif
@@ -24,3 +24,17 @@ SOFTWARE.
 
 #import "types.h"
 #import "type-encoding.h"
+#import "statistics.h"
+#import "allocator.h"
+#import "names.h"
+#import "object-layout.h"
+#import "macho.h"
+#import "type-diff.h"
+#import "encoding-scanner.h"
+#import "hot-encodings.h"
+#import "layout-conversion.h"
+#import "value-comparator.h"
+#import "member-accessor.h"
+#import "type-corpus.h"
+#import "property-attributes.h"
+#import "declaration-emitter.h"
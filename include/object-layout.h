@@ -0,0 +1,108 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_OBJECT_LAYOUT__
+#define OBJCTK_OBJECT_LAYOUT__
+
+#include "macros.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An opaque type describing which pointer-sized slots of a value hold Objective-C object references
+ * (objects and classes), similar in spirit to the ivar layouts of the Objective-C runtime.
+ */
+typedef struct _objctk_objectlayout *objctk_objectlayout;
+
+/**
+ * A run of pointer-sized slots holding object references at a constant stride, such as consecutive
+ * slots or the slots at the same offset within each element of an array.
+ */
+typedef struct objctk_objectlayoutrun {
+  /** The byte offset of the first slot of the run. */
+  size_t offset;
+  /** The number of slots in the run. */
+  size_t count;
+  /** The distance in bytes between consecutive slots of the run, which is the slot size for consecutive slots. */
+  size_t stride;
+} objctk_objectlayoutrun;
+
+/**
+ * A function receiving each non-null object reference found by objctk_objectlayout_scanValues, the
+ * index of the value containing it and the byte offset of its slot within that value.
+ */
+typedef void (*objctk_objectreferencefunction)(size_t valueIndex, size_t offset, uint64_t reference, void *context);
+
+/**
+ * Derives the object layout of the type represented by a type node under the data layout rules of
+ * a layout profile. Object references inside unions are not reported because the active member of
+ * a union cannot be determined. Returns NULL if the layout of the type cannot be determined or if an
+ * object reference is not aligned to the slot size, which happens in top-level types because their
+ * members are not padded.
+ */
+OBJCTK_EXTERN objctk_objectlayout objctk_objectlayout_create(objctk_typenode node, objctk_layoutprofile profile);
+
+/** Returns the size of the values described by an object layout. */
+OBJCTK_EXTERN size_t objctk_objectlayout_getValueSize(objctk_objectlayout layout);
+
+/** Returns the size of the slots of an object layout, which is the pointer size of its profile. */
+OBJCTK_EXTERN size_t objctk_objectlayout_getSlotSize(objctk_objectlayout layout);
+
+/**
+ * Returns the runs of slots holding object references in order of the offset of their first slot.
+ * The slots of strided runs may interleave with those of other runs. The references of an array
+ * collapse into a single run when its element holds a single run that tiles the element, or a single
+ * reference, such as in [8@] or [8{Pair=@i}]. Otherwise the runs of the element are repeated for
+ * each element, or each reference slot of the element becomes a run strided across the elements,
+ * whichever yields fewer runs. An array thus contributes at most as many runs as its element has
+ * reference slots, but fewer for short arrays. The returned runs remain valid until the object
+ * layout is released.
+ */
+OBJCTK_EXTERN const objctk_objectlayoutrun *objctk_objectlayout_getRuns(objctk_objectlayout layout, size_t *outCount);
+
+/**
+ * Returns a bitmap with one bit per slot of a value, least significant bit first, in which set bits
+ * denote slots holding object references. The returned bitmap remains valid until the object layout
+ * is released.
+ */
+OBJCTK_EXTERN const uint8_t *objctk_objectlayout_getBitmap(objctk_objectlayout layout, size_t *outSlotCount);
+
+/**
+ * Scans a contiguous array of values laid out according to an object layout and passes every
+ * non-null object reference to a function. Returns the number of references found.
+ */
+OBJCTK_EXTERN size_t objctk_objectlayout_scanValues(
+    objctk_objectlayout layout,
+    const void *values,
+    size_t valueCount,
+    objctk_objectreferencefunction referenceFunction,
+    void *context);
+
+/** Frees the memory associated with an object layout. */
+OBJCTK_EXTERN void objctk_objectlayout_release(objctk_objectlayout layout);
+
+#endif
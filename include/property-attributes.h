@@ -0,0 +1,103 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_PROPERTY_ATTRIBUTES__
+#define OBJCTK_PROPERTY_ATTRIBUTES__
+
+#include "allocator.h"
+#include "macros.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stdbool.h>
+
+/** An enum describing how the setter of a property retains its new value. */
+OBJCTK_ENUM(objctk_propertyownership, signed int,
+  // The value is assigned without being retained, as for assign and unsafe_unretained properties.
+  objctk_propertyownership_Assign = 0,
+
+  // The value is retained ('&').
+  objctk_propertyownership_Retain,
+
+  // The value is copied ('C').
+  objctk_propertyownership_Copy,
+
+  // The value is referenced weakly ('W').
+  objctk_propertyownership_Weak,
+);
+
+/**
+ * The attributes of an Objective-C property as described by a property attribute string such as
+ * "T@\"NSString\",&,N,V_name". The names of the getter, setter and instance variable are ranges of
+ * the attribute string rather than copies and are { UINT_MAX, UINT_MAX } if the attribute string
+ * does not specify them. Unrecognized attributes are ignored.
+ */
+typedef struct objctk_propertyattributes {
+  /** The type of the property or NULL if the attribute string has no type attribute. */
+  objctk_typenode type;
+
+  /** The range of the type encoding of the property in the attribute string. */
+  objctk_range typeEncodingRange;
+
+  /** The ownership semantics of the setter of the property. */
+  objctk_propertyownership ownership;
+
+  /** Whether the property is readonly ('R'). */
+  bool isReadOnly;
+
+  /** Whether the property is nonatomic ('N'). */
+  bool isNonatomic;
+
+  /** Whether the property is @dynamic ('D'). */
+  bool isDynamic;
+
+  /** The range of the name of a custom getter ('G') in the attribute string. */
+  objctk_range getterNameRange;
+
+  /** The range of the name of a custom setter ('S') in the attribute string. */
+  objctk_range setterNameRange;
+
+  /** The range of the name of the backing instance variable ('V') in the attribute string. */
+  objctk_range instanceVariableNameRange;
+} objctk_propertyattributes;
+
+/**
+ * Parses a property attribute string into its attributes in a single pass over the string. Commas
+ * within the quoted class name of an object type do not separate attributes, and an unterminated
+ * class name extends the type attribute to the end of the string. The type of a block property,
+ * "@?", is an object type without a class name whose range spans both characters, as blocks are in
+ * other type encodings. The returned parse result owns the type of the property, which is also its
+ * parsed type, and reports the status of parsing it. The default allocator is used if allocator is
+ * NULL.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_parsePropertyAttributes(const char *attributes, objctk_propertyattributes *outAttributes, const objctk_allocator *allocator);
+
+/**
+ * Parses a property attribute string into a parser, applying the resource limits of the parser to
+ * the type of the property. The returned parse result is owned by the parser and remains valid
+ * until the parser is reset, parses another type encoding or is released.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_parser_parsePropertyAttributes(objctk_parser parser, const char *attributes, objctk_propertyattributes *outAttributes);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_STATISTICS__
+#define OBJCTK_STATISTICS__
+
+#include "macros.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The number of buckets in each statistics histogram. Bucket 0 counts samples with a value of zero
+ * and bucket i counts samples in the range [2^(i-1), 2^i). The last bucket also counts all larger
+ * samples.
+ */
+#define OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT 32
+
+/** A snapshot of the statistics collected by objctk since they were last reset. */
+typedef struct objctk_statistics {
+  /** The number of type encodings parsed. */
+  uint64_t parseCount;
+  /** The number of parses whose status code was not objctk_statuscode_NoError. */
+  uint64_t failedParseCount;
+  /** The number of bytes of type encodings parsed. */
+  uint64_t inputByteCount;
+  /** The number of tokens produced by the lexer. */
+  uint64_t tokenCount;
+  /** The number of type nodes allocated. */
+  uint64_t nodeCount;
+  /** The number of bytes retained by parse results. */
+  uint64_t retainedByteCount;
+  /** The total time spent parsing type encodings in nanoseconds. */
+  uint64_t parseNanoseconds;
+
+  /** A histogram of the time spent per parse in nanoseconds. */
+  uint64_t parseLatencyHistogram[OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT];
+  /** A histogram of the number of type nodes allocated per parse. */
+  uint64_t nodeCountHistogram[OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT];
+  /** A histogram of the number of bytes retained per parse result. */
+  uint64_t retainedByteHistogram[OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT];
+} objctk_statistics;
+
+/**
+ * Enables or disables the collection of statistics. Statistics are disabled by default and cost a
+ * single relaxed atomic load per parse while disabled. Statistics support can be compiled out
+ * entirely by defining OBJCTK_ENABLE_STATISTICS to 0 when building objctk.
+ */
+OBJCTK_EXTERN void objctk_setStatisticsEnabled(bool enabled);
+
+/** Returns whether statistics are being collected. */
+OBJCTK_EXTERN bool objctk_isStatisticsEnabled(void);
+
+/**
+ * Copies a snapshot of the collected statistics into outStatistics. Counters updated concurrently
+ * with the snapshot may or may not be included.
+ */
+OBJCTK_EXTERN void objctk_getStatistics(objctk_statistics *outStatistics);
+
+/** Resets all collected statistics to zero. */
+OBJCTK_EXTERN void objctk_resetStatistics(void);
+
+#endif
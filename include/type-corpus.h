@@ -0,0 +1,126 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_TYPE_CORPUS__
+#define OBJCTK_TYPE_CORPUS__
+
+#include "allocator.h"
+#include "macros.h"
+#include "names.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An opaque type holding a read-only corpus of parsed types in a succinct representation.
+ *
+ * The tree of every type is stored as a balanced parentheses sequence of two bits per type node,
+ * with the type category, host size and any array element count, bitfield width or name of each
+ * type node in bit-packed arrays indexed by rank. Type nodes take a few bytes each rather than the
+ * hundred or so bytes of a parsed type node and are navigated with rank and excess queries over
+ * the parentheses without decompression.
+ */
+typedef struct _objctk_typecorpus *objctk_typecorpus;
+
+/** An opaque type which accumulates types and creates type corpora from them. */
+typedef struct _objctk_typecorpusbuilder *objctk_typecorpusbuilder;
+
+/**
+ * A handle to a type node in a type corpus. Handles are only meaningful to the corpus from which
+ * they were obtained.
+ */
+typedef size_t objctk_corpusnode;
+
+/** The handle denoting the absence of a type node. */
+#define OBJCTK_CORPUSNODE_NONE ((objctk_corpusnode)SIZE_MAX)
+
+/** Creates an empty type corpus builder. */
+OBJCTK_EXTERN objctk_typecorpusbuilder objctk_typecorpusbuilder_create(const objctk_allocator *allocator);
+
+/** Adds the type represented by a type node and its descendants to a type corpus builder. */
+OBJCTK_EXTERN objctk_statuscode objctk_typecorpusbuilder_addType(objctk_typecorpusbuilder builder, objctk_typenode node);
+
+/**
+ * Parses a type encoding and adds the parsed type to a type corpus builder. Returns the status code
+ * of the parse if the type encoding could not be parsed, in which case nothing is added.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_typecorpusbuilder_addTypeEncoding(objctk_typecorpusbuilder builder, const char *typeEncoding);
+
+/**
+ * Creates a type corpus holding the types added to a type corpus builder so far, in the order in
+ * which they were added. Returns NULL if memory could not be allocated.
+ */
+OBJCTK_EXTERN objctk_typecorpus objctk_typecorpusbuilder_createCorpus(objctk_typecorpusbuilder builder);
+
+/** Frees the memory associated with a type corpus builder. */
+OBJCTK_EXTERN void objctk_typecorpusbuilder_release(objctk_typecorpusbuilder builder);
+
+/** Returns the number of types in a type corpus. */
+OBJCTK_EXTERN size_t objctk_typecorpus_getTypeCount(objctk_typecorpus corpus);
+
+/** Returns the total number of type nodes in a type corpus. */
+OBJCTK_EXTERN size_t objctk_typecorpus_getNodeCount(objctk_typecorpus corpus);
+
+/** Returns the number of bytes of memory used by a type corpus. */
+OBJCTK_EXTERN size_t objctk_typecorpus_getByteCount(objctk_typecorpus corpus);
+
+/** Returns the root type node of a type in a type corpus or OBJCTK_CORPUSNODE_NONE. */
+OBJCTK_EXTERN objctk_corpusnode objctk_typecorpus_getType(objctk_typecorpus corpus, size_t typeIndex);
+
+/** Returns the type category of a type node. */
+OBJCTK_EXTERN objctk_typecategory objctk_typecorpus_getTypeCategory(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Returns the size of a type node on the host or -1 if its size cannot be determined. */
+OBJCTK_EXTERN int64_t objctk_typecorpus_getTypeSize(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Returns the number of elements of an array type node or the width of a bitfield type node. */
+OBJCTK_EXTERN size_t objctk_typecorpus_getElementCount(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Returns the name of a struct, union or object type node or OBJCTK_NAMEID_NONE. */
+OBJCTK_EXTERN objctk_nameid objctk_typecorpus_getNameID(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Returns the NUL-terminated name of a struct, union or object type node or NULL. */
+OBJCTK_EXTERN const char *objctk_typecorpus_getName(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/**
+ * Returns the first child of a type node or OBJCTK_CORPUSNODE_NONE. The children of pointer and
+ * array type nodes are their referenced types and those of composite type nodes their members.
+ */
+OBJCTK_EXTERN objctk_corpusnode objctk_typecorpus_getFirstChild(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Returns the next sibling of a type node or OBJCTK_CORPUSNODE_NONE. */
+OBJCTK_EXTERN objctk_corpusnode objctk_typecorpus_getNextSibling(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Returns the number of children of a type node. */
+OBJCTK_EXTERN size_t objctk_typecorpus_getChildCount(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Returns the number of type nodes in the subtree rooted at a type node, including itself. */
+OBJCTK_EXTERN size_t objctk_typecorpus_getSubtreeSize(objctk_typecorpus corpus, objctk_corpusnode node);
+
+/** Frees the memory associated with a type corpus. */
+OBJCTK_EXTERN void objctk_typecorpus_release(objctk_typecorpus corpus);
+
+#endif
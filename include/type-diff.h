@@ -0,0 +1,105 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_TYPE_DIFF__
+#define OBJCTK_TYPE_DIFF__
+
+#include "macros.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stddef.h>
+
+/** An opaque type describing a reusable set of changes between two types. */
+typedef struct _objctk_typediff *objctk_typediff;
+
+/** A list of kinds of changes between two types. */
+OBJCTK_ENUM(objctk_typechangekind, signed int,
+  // The types are unrelated, e.g. they have different categories or names.
+  objctk_typechangekind_TypeReplaced = 0,
+  // A member was added to a composite type.
+  objctk_typechangekind_MemberAdded,
+  // A member was removed from a composite type.
+  objctk_typechangekind_MemberRemoved,
+  // The type of a member of a composite type changed.
+  objctk_typechangekind_MemberRetyped,
+  // A member of a composite type kept its type but moved to a different offset.
+  objctk_typechangekind_MemberMoved,
+  // The size of a composite or array type changed.
+  objctk_typechangekind_SizeChanged,
+);
+
+/** A change between two types. */
+typedef struct objctk_typechange {
+  /** The kind of change. */
+  objctk_typechangekind kind;
+  /** The nesting depth of the changed type node, where the compared types have a depth of zero. */
+  unsigned int depth;
+  /** The changed type node in the old type or NULL if a member was added. */
+  objctk_typenode oldNode;
+  /** The changed type node in the new type or NULL if a member was removed. */
+  objctk_typenode newNode;
+  /** The composite type node containing oldNode or NULL. */
+  objctk_typenode oldParentNode;
+  /** The composite type node containing newNode or NULL. */
+  objctk_typenode newParentNode;
+  /** The index of oldNode within oldParentNode or UINT_MAX. */
+  unsigned int oldMemberIndex;
+  /** The index of newNode within newParentNode or UINT_MAX. */
+  unsigned int newMemberIndex;
+  /** The byte offset of oldNode from the start of the old type or -1. */
+  int oldOffset;
+  /** The byte offset of newNode from the start of the new type or -1. */
+  int newOffset;
+  /** The size of oldNode or -1. */
+  int oldSize;
+  /** The size of newNode or -1. */
+  int newSize;
+} objctk_typechange;
+
+/**
+ * Creates an empty type diff. A type diff retains its memory across comparisons so that comparing
+ * many pairs of types with the same diff allocates memory only while it warms up.
+ */
+OBJCTK_EXTERN objctk_typediff objctk_typediff_create(void);
+
+/**
+ * Compares two types under the data layout rules of a layout profile, replacing the changes held by
+ * the diff, and returns the number of changes found. Structurally identical subtrees are skipped
+ * using their structural hashes. Members of composite types are matched after trimming their
+ * longest common prefix and suffix of identical members, so a member inserted into or removed from
+ * a struct is reported as a single change.
+ */
+OBJCTK_EXTERN size_t objctk_typediff_compare(objctk_typediff diff, objctk_typenode oldNode, objctk_typenode newNode, objctk_layoutprofile profile);
+
+/**
+ * Returns the changes found by the last comparison in depth-first order. The returned changes
+ * remain valid until the diff is used for another comparison or released.
+ */
+OBJCTK_EXTERN const objctk_typechange *objctk_typediff_getChanges(objctk_typediff diff, size_t *outCount);
+
+/** Frees the memory associated with a type diff. */
+OBJCTK_EXTERN void objctk_typediff_release(objctk_typediff diff);
+
+#endif
@@ -25,25 +25,62 @@ SOFTWARE.
 #ifndef OBJCTK_TYPE_ENCODING__
 #define OBJCTK_TYPE_ENCODING__
 
+#include "allocator.h"
 #include "macros.h"
+#include "names.h"
 #include "types.h"
 
-#import <memory>
-#import <string>
+#include <stddef.h>
+#include <stdint.h>
 
 /** An opaque type describing a type node. */
 typedef struct _objctk_typenode *objctk_typenode;
 
-/** An opaque type describing the result of parsing an Objective-C type encoding. */
+/**
+ * An opaque type describing the result of parsing an Objective-C type encoding. A parse result and
+ * its type nodes are immutable while referenced, so any number of threads may read them without
+ * locking. Functions copying data out of a parse result only share its allocator between threads.
+ */
 typedef struct _objctk_typeparseresult *objctk_typeparseresult;
 
+/** An opaque type describing a reusable parser. */
+typedef struct _objctk_parser *objctk_parser;
+
 /** A list of status codes describing the result of parsing an Objective-C type encoding. */
 OBJCTK_ENUM(objctk_statuscode, signed int,
   objctk_statuscode_NoError = 0,
   objctk_statuscode_InvalidInput = -1,
   objctk_statuscode_EncounteredInvalidToken = -2,
+  objctk_statuscode_OutOfMemory = -3,
+  objctk_statuscode_LimitExceeded = -4,
 );
 
+/** The nesting depth to which parses are limited unless objctk_parselimits specifies otherwise. */
+#define OBJCTK_DEFAULT_MAXIMUM_PARSE_DEPTH 512
+
+/**
+ * Limits on the resources consumed by a single parse, for type encodings from untrusted sources.
+ * A parse exceeding a limit fails with objctk_statuscode_LimitExceeded and releases the type nodes
+ * created so far. A limit of zero leaves a resource unlimited, except for the nesting depth which
+ * defaults to OBJCTK_DEFAULT_MAXIMUM_PARSE_DEPTH because nested types are parsed recursively.
+ */
+typedef struct objctk_parselimits {
+  /** The maximum length of a type encoding, checked before it is parsed. */
+  size_t maximumInputLength;
+
+  /** The maximum nesting depth of a type, where a type that is not nested has a depth of one. */
+  unsigned int maximumDepth;
+
+  /** The maximum number of type nodes. */
+  size_t maximumNodeCount;
+
+  /** The maximum number of bytes allocated for the type nodes and member lists. */
+  size_t maximumByteCount;
+
+  /** The maximum duration of a parse in nanoseconds according to a monotonic clock. */
+  uint64_t maximumNanoseconds;
+} objctk_parselimits;
+
 /** Returns the type category of a type node. */
 OBJCTK_EXTERN objctk_typecategory objctk_typenode_getTypeCategory(objctk_typenode node);
 
@@ -53,6 +90,31 @@ OBJCTK_EXTERN objctk_typecategory objctk_typenode_getTypeCategory(objctk_typenod
  */
 OBJCTK_EXTERN int objctk_typenode_getTypeSize(objctk_typenode node);
 
+/**
+ * Returns the size of the type represented by the type node under the data layout rules of a
+ * layout profile or -1 if the size of the type cannot be determined.
+ */
+OBJCTK_EXTERN int objctk_typenode_getTypeSizeForLayoutProfile(objctk_typenode node, objctk_layoutprofile profile);
+
+/**
+ * Returns the alignment of the type represented by the type node or -1 if the alignment of the
+ * type cannot be determined.
+ */
+OBJCTK_EXTERN int objctk_typenode_getTypeAlignment(objctk_typenode node);
+
+/**
+ * Returns the alignment of the type represented by the type node under the data layout rules of a
+ * layout profile or -1 if the alignment of the type cannot be determined.
+ */
+OBJCTK_EXTERN int objctk_typenode_getTypeAlignmentForLayoutProfile(objctk_typenode node, objctk_layoutprofile profile);
+
+/**
+ * Returns the byte offset of a member type of the type node under the data layout rules of a
+ * layout profile or -1 if the type node has no such member type or its layout cannot be determined.
+ * Bitfield members report the offset of the byte containing their first bit.
+ */
+OBJCTK_EXTERN int objctk_typenode_getMemberOffsetForLayoutProfile(objctk_typenode node, unsigned int memberIndex, objctk_layoutprofile profile);
+
 /** Returns the range that the type node occupies in the type encoding from which it was parsed. */
 OBJCTK_EXTERN objctk_range objctk_typenode_getRange(objctk_typenode node);
 
@@ -62,6 +124,26 @@ OBJCTK_EXTERN objctk_range objctk_typenode_getRange(objctk_typenode node);
  */
 OBJCTK_EXTERN objctk_range objctk_typenode_getNameRange(objctk_typenode node);
 
+/**
+ * Returns the process-wide identifier of the interned type name of the type node or
+ * OBJCTK_NAMEID_NONE if the type node has no associated type name.
+ */
+OBJCTK_EXTERN objctk_nameid objctk_typenode_getNameID(objctk_typenode node);
+
+/**
+ * Returns the interned, NUL-terminated type name of the type node or NULL if the type node has no
+ * associated type name. Unlike the name range, the returned string does not refer to the type
+ * encoding from which the type node was parsed and remains valid for the lifetime of the process.
+ */
+OBJCTK_EXTERN const char *objctk_typenode_getName(objctk_typenode node);
+
+/**
+ * Returns a hash of the structure of the type represented by the type node which is equal for
+ * structurally identical types regardless of the encodings they were parsed from. Distinct types may
+ * share a hash.
+ */
+OBJCTK_EXTERN uint64_t objctk_typenode_getStructuralHash(objctk_typenode node);
+
 /**
  * Returns a type node representing the referenced type of the input type node or NULL if the type
  * node has no referenced type.
@@ -70,22 +152,85 @@ OBJCTK_EXTERN objctk_typenode objctk_typenode_getReferencedType(objctk_typenode
 
 /**
  * Creates and returns a list of type nodes representing the member types of the input type node or NULL
- * if the input type node has no member types.
+ * if the input type node has no member types. The list must be freed with objctk_free.
  */
 OBJCTK_EXTERN objctk_typenode *objctk_typenode_copyMemberTypeList(objctk_typenode node, unsigned int *outCount);
 
+/**
+ * Creates and returns a list of the member types of a type node as objctk_typenode_copyMemberTypeList
+ * does, obtaining its memory from an allocator, which must also free it. The default allocator is
+ * used if allocator is NULL. Type nodes do not refer to their parse results, so callers parsing with
+ * a specific allocator pass it here to keep all memory in that allocator.
+ */
+OBJCTK_EXTERN objctk_typenode *objctk_typenode_copyMemberTypeListWithAllocator(objctk_typenode node, const objctk_allocator *allocator, unsigned int *outCount);
+
 /**
  * Parses an input type encoding.
  */
 OBJCTK_EXTERN objctk_typeparseresult objctk_parseTypeEncoding(const char *typeEncoding);
 
+/**
+ * Parses an input type encoding, obtaining all memory of the parse result from an allocator. The
+ * default allocator is used if allocator is NULL. Prewarmed parse results, which are allocated from
+ * the default allocator, are only returned if allocator is NULL.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_parseTypeEncodingWithAllocator(const char *typeEncoding, const objctk_allocator *allocator);
+
+/**
+ * Parses an input type encoding within resource limits, obtaining all memory of the parse result
+ * from an allocator. No limits besides the default nesting depth apply if limits is NULL and the
+ * default allocator is used if allocator is NULL. Prewarmed parse results are only returned if
+ * allocator is NULL.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_parseTypeEncodingWithLimits(const char *typeEncoding, const objctk_parselimits *limits, const objctk_allocator *allocator);
+
+/**
+ * Parses an input type encoding consisting of a single struct or union, dividing the members of the
+ * struct or union among up to threadCount threads. The resulting type tree is identical to the one
+ * produced by objctk_parseTypeEncodingWithAllocator. Encodings which are short or cannot be divided
+ * at member boundaries are parsed serially on the calling thread. Members are parsed by the calling
+ * thread and by worker threads which are spawned on first use and reused by later parses. The
+ * default allocator is used if allocator is NULL.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_parseTypeEncodingInParallel(const char *typeEncoding, unsigned int threadCount, const objctk_allocator *allocator);
+
+/**
+ * Parses an input type encoding consisting of a single struct or union in parallel within resource
+ * limits, as objctk_parseTypeEncodingInParallel does. The limits apply to the parse as a whole, as
+ * with objctk_parseTypeEncodingWithLimits, and each thread stops once its share of the members
+ * alone exceeds them. No limits besides the default nesting depth apply if limits is NULL.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_parseTypeEncodingInParallelWithLimits(const char *typeEncoding, unsigned int threadCount, const objctk_parselimits *limits, const objctk_allocator *allocator);
+
+/**
+ * Parses a batch of type encodings, such as the method type encodings of a class hierarchy, storing a
+ * parse result for each type encoding in outParseResults. The type encodings are parsed in sorted
+ * order so that the top-level types within the prefix an encoding shares with the previous one are
+ * reused rather than lexed and parsed again. Parse results sharing type nodes keep each other alive,
+ * so each must still be released with objctk_typeparseresult_release. Returns
+ * objctk_statuscode_OutOfMemory without storing any parse results if memory could not be allocated;
+ * the outcome of each parse is reported by its parse result. The default allocator is used if
+ * allocator is NULL.
+ */
+OBJCTK_EXTERN objctk_statuscode objctk_parseTypeEncodingBatch(const char *const *typeEncodings, size_t count, objctk_typeparseresult *outParseResults, const objctk_allocator *allocator);
+
 /**
  * Returns the status code of a parse result.
  */
 OBJCTK_EXTERN objctk_statuscode objctk_typeparseresult_getStatusCode(objctk_typeparseresult parseResult);
 
 /**
- * Returns a copy of the error description of a parse result if it exists.
+ * Returns the number of unexpected tokens which were skipped while parsing the type encoding of a
+ * parse result. The parser is lenient: a malformed type encoding is parsed as far as possible and
+ * its unexpected tokens skipped, so a parse result may have a status code of
+ * objctk_statuscode_NoError and a parsed type yet stem from a malformed type encoding.
+ */
+OBJCTK_EXTERN size_t objctk_typeparseresult_getUnexpectedTokenCount(objctk_typeparseresult parseResult);
+
+/**
+ * Returns a copy of the error description of a parse result if it exists. The copy is allocated from
+ * the allocator of the parse result, which must also free it, so the copy must be freed with
+ * objctk_free if the parse result uses the default allocator.
  */
 OBJCTK_EXTERN char *objctk_typeparseresult_copyErrorDescription(objctk_typeparseresult parseResult);
 
@@ -95,8 +240,55 @@ OBJCTK_EXTERN char *objctk_typeparseresult_copyErrorDescription(objctk_typeparse
 OBJCTK_EXTERN objctk_typenode objctk_typeparseresult_getParsedType(objctk_typeparseresult parseResult);
 
 /**
- * Frees the memory associated with a parse result.
+ * Adds a reference to a parse result and returns it. A retained parse result owned by a parser
+ * remains valid after the parser parses another type encoding, is reset or is released. Retaining
+ * and releasing a parse result is safe from any thread, except that a parse result owned by a parser
+ * must be retained on the thread using the parser.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_typeparseresult_retain(objctk_typeparseresult parseResult);
+
+/**
+ * Removes a reference to a parse result, freeing its memory once no references remain. Releasing a
+ * parse result owned by a parser which has not been retained has no effect.
  */
 OBJCTK_EXTERN void objctk_typeparseresult_release(objctk_typeparseresult parseResult);
 
+/**
+ * Creates a parser which retains its memory across parses so that repeatedly parsing type encodings
+ * of similar complexity does not allocate memory once the parser has warmed up. A parser must only
+ * be used by one thread at a time.
+ */
+OBJCTK_EXTERN objctk_parser objctk_parser_create(void);
+
+/**
+ * Creates a parser which obtains all of its memory from an allocator. The default allocator is used
+ * if allocator is NULL. Only parsers created without an allocator return prewarmed parse results.
+ */
+OBJCTK_EXTERN objctk_parser objctk_parser_createWithAllocator(const objctk_allocator *allocator);
+
+/**
+ * Parses an input type encoding into the parser. The returned parse result is owned by the parser
+ * and remains valid until the parser is reset, parses another type encoding or is released unless it
+ * is retained with objctk_typeparseresult_retain, in which case it remains valid until it is
+ * released. Returns NULL if memory could not be allocated.
+ */
+OBJCTK_EXTERN objctk_typeparseresult objctk_parser_parseTypeEncoding(objctk_parser parser, const char *typeEncoding);
+
+/**
+ * Sets the resource limits applied to subsequent parses of a parser. Passing NULL removes all limits
+ * besides the default nesting depth.
+ */
+OBJCTK_EXTERN void objctk_parser_setLimits(objctk_parser parser, const objctk_parselimits *limits);
+
+/**
+ * Invalidates the parse result owned by the parser while retaining its memory for reuse. A parse
+ * result which has been retained is left intact and replaced with a new one.
+ */
+OBJCTK_EXTERN void objctk_parser_reset(objctk_parser parser);
+
+/**
+ * Frees the memory associated with a parser, including its parse result.
+ */
+OBJCTK_EXTERN void objctk_parser_release(objctk_parser parser);
+
 #endif
@@ -60,6 +60,27 @@ OBJCTK_ENUM(objctk_typecategory, signed int,
   OBJCTKTypeCategoryTopLevel,
 );
 
+/**
+ * An enum describing a target ABI whose data layout rules are used to compute the sizes, alignments
+ * and member offsets of types.
+ */
+OBJCTK_ENUM(objctk_layoutprofile, signed int,
+  // The ABI of the process using objctk.
+  objctk_layoutprofile_Host = 0,
+
+  // Generic 64-bit targets with 64-bit long and pointers (e.g. x86_64).
+  objctk_layoutprofile_LP64,
+
+  // Generic 32-bit targets with 32-bit long and pointers and naturally aligned 64-bit types (e.g. armv7).
+  objctk_layoutprofile_ILP32,
+
+  // 64-bit ARM (arm64).
+  objctk_layoutprofile_ARM64,
+
+  // 32-bit Intel (i386), which aligns 64-bit types to 4 bytes.
+  objctk_layoutprofile_I386,
+);
+
 /** Defines a range over a serial data. */
 typedef struct objctk_range {
   /** The beginning of the range. */
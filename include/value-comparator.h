@@ -0,0 +1,91 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_VALUE_COMPARATOR__
+#define OBJCTK_VALUE_COMPARATOR__
+
+#include "macros.h"
+#include "type-encoding.h"
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An opaque type holding compiled equality and hash kernels for values of a type laid out under
+ * the data layout rules of a layout profile.
+ *
+ * Values are compared member by member rather than byte by byte: padding bytes, including unnamed
+ * bits of bitfield storage units, are ignored, floating point members compare equal when they are
+ * numerically equal or both NaN (so 0.0 equals -0.0) and pointers, including object pointers,
+ * compare by identity. Runs of members without padding or floating point values are compared with
+ * a single memcmp. Unions are compared byte by byte as their active member cannot be determined.
+ */
+typedef struct _objctk_valuecomparator *objctk_valuecomparator;
+
+/**
+ * Compiles the equality and hash kernels of the type represented by a type node under the data
+ * layout rules of a layout profile. Returns NULL if the layout of the type cannot be determined.
+ */
+OBJCTK_EXTERN objctk_valuecomparator objctk_valuecomparator_create(objctk_typenode node, objctk_layoutprofile profile);
+
+/** Returns the size of the values compared by a value comparator. */
+OBJCTK_EXTERN size_t objctk_valuecomparator_getValueSize(objctk_valuecomparator comparator);
+
+/**
+ * Returns the number of operations in the kernels of a value comparator. Members of the same kind
+ * repeating at a constant stride, such as the elements of an array of doubles, count as one
+ * operation, as do such runs repeated for every element of an array, such as the doubles of an
+ * array of structs.
+ */
+OBJCTK_EXTERN size_t objctk_valuecomparator_getOperationCount(objctk_valuecomparator comparator);
+
+/** Returns whether two values are equal. */
+OBJCTK_EXTERN bool objctk_valuecomparator_equalValues(objctk_valuecomparator comparator, const void *value, const void *otherValue);
+
+/**
+ * Compares two contiguous arrays of values element by element and returns the index of the first
+ * pair of values which are not equal or valueCount if all pairs are equal.
+ */
+OBJCTK_EXTERN size_t objctk_valuecomparator_findFirstDifference(
+    objctk_valuecomparator comparator,
+    const void *values,
+    const void *otherValues,
+    size_t valueCount);
+
+/** Returns a hash of a value which is equal for values which compare equal. */
+OBJCTK_EXTERN uint64_t objctk_valuecomparator_hashValue(objctk_valuecomparator comparator, const void *value);
+
+/** Writes the hash of every value of a contiguous array of values to outHashes. */
+OBJCTK_EXTERN void objctk_valuecomparator_hashValues(
+    objctk_valuecomparator comparator,
+    const void *values,
+    size_t valueCount,
+    uint64_t *outHashes);
+
+/** Frees the memory associated with a value comparator. */
+OBJCTK_EXTERN void objctk_valuecomparator_release(objctk_valuecomparator comparator);
+
+#endif
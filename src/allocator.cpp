@@ -0,0 +1,112 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "internal-allocator.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
+
+using namespace objctk;
+
+static void *defaultAllocate(void * /* context */, size_t size) {
+  return malloc(size);
+}
+
+static void *defaultReallocate(void * /* context */, void *pointer, size_t size) {
+  return realloc(pointer, size);
+}
+
+static void defaultDeallocate(void * /* context */, void *pointer) {
+  free(pointer);
+}
+
+static const objctk_allocator kMallocAllocator = {
+  .context = NULL,
+  .allocate = defaultAllocate,
+  .reallocate = defaultReallocate,
+  .deallocate = defaultDeallocate,
+};
+
+// An allocator which has been installed as the default allocator.
+struct objctk_installedallocator {
+  objctk_allocator allocator;
+  objctk_installedallocator *next;
+};
+
+// Threads read the default allocator while parsing, so it is published as a pointer to an immutable
+// copy. Installed copies are never freed because concurrent parses may still read them, but
+// installing an allocator equal to an earlier one reuses its copy so that the retained memory is
+// bounded by the number of distinct allocators.
+static std::atomic<const objctk_allocator *> gDefaultAllocator(&kMallocAllocator);
+static std::mutex gInstalledAllocatorsMutex;
+static objctk_installedallocator *gInstalledAllocators = NULL;
+
+static inline bool isEqualAllocator(const objctk_allocator *allocator1, const objctk_allocator *allocator2) {
+  return (allocator1->context == allocator2->context) && (allocator1->allocate == allocator2->allocate) && (allocator1->reallocate == allocator2->reallocate) && (allocator1->deallocate == allocator2->deallocate);
+}
+
+// Returns the installed copy of an allocator, or NULL if a copy could not be allocated.
+static const objctk_allocator *installedAllocator(const objctk_allocator *allocator) {
+  if (isEqualAllocator(allocator, &kMallocAllocator)) {
+    return &kMallocAllocator;
+  }
+  std::lock_guard<std::mutex> lock(gInstalledAllocatorsMutex);
+  for (objctk_installedallocator *installedAllocator = gInstalledAllocators; installedAllocator != NULL; installedAllocator = installedAllocator->next) {
+    if (isEqualAllocator(allocator, &installedAllocator->allocator)) {
+      return &installedAllocator->allocator;
+    }
+  }
+  objctk_installedallocator *installedAllocator = static_cast<objctk_installedallocator *>(malloc(sizeof(objctk_installedallocator)));
+  if (installedAllocator == NULL) {
+    return NULL;
+  }
+  installedAllocator->allocator = *allocator;
+  installedAllocator->next = gInstalledAllocators;
+  gInstalledAllocators = installedAllocator;
+  return &installedAllocator->allocator;
+}
+
+namespace objctk {
+
+const objctk_allocator *defaultAllocator() {
+  return gDefaultAllocator.load(std::memory_order_acquire);
+}
+
+}
+
+void objctk_setDefaultAllocator(const objctk_allocator *allocator) {
+  const objctk_allocator *installed = (allocator != NULL) ? installedAllocator(allocator) : &kMallocAllocator;
+  if (installed != NULL) {
+    gDefaultAllocator.store(installed, std::memory_order_release);
+  }
+}
+
+objctk_allocator objctk_getDefaultAllocator(void) {
+  return *defaultAllocator();
+}
+
+void objctk_free(void *pointer) {
+  deallocateMemory(defaultAllocator(), pointer);
+}
@@ -0,0 +1,137 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "arena.h"
+
+#include <stdint.h>
+#include <algorithm>
+
+using namespace objctk;
+
+static const size_t kMinimumArenaBlockCapacity = 1024;
+static const size_t kMaximumArenaBlockCapacity = 64 * 1024;
+
+static inline size_t alignedSize(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static inline bool storageHasCapacity(char *storage, const size_t capacity, const size_t used, const size_t size, const size_t alignment) {
+  size_t offset = alignedSize((uintptr_t)(storage + used), alignment) - (uintptr_t)storage;
+  return (offset + size) <= capacity;
+}
+
+namespace objctk {
+
+arena::~arena() {
+  block *currentBlock = m_first_block;
+  while (currentBlock != NULL) {
+    block *nextBlock = currentBlock->next;
+    deallocateMemory(&m_allocator, currentBlock);
+    currentBlock = nextBlock;
+  }
+}
+
+arena::block *arena::blockWithCapacity(size_t size, size_t alignment) {
+  // Prefer a block retained from before the last reset.
+  block *candidateBlock = (m_current_block != NULL) ? m_current_block->next : m_first_block;
+  if ((candidateBlock != NULL) && storageHasCapacity(candidateBlock->storage(), candidateBlock->capacity, 0, size, alignment)) {
+    return candidateBlock;
+  }
+
+  size_t previousCapacity = (m_current_block != NULL) ? m_current_block->capacity : 0;
+  size_t capacity = std::min(std::max(kMinimumArenaBlockCapacity, previousCapacity * 2), kMaximumArenaBlockCapacity);
+  capacity = std::max(capacity, size + alignment);
+  block *newBlock = static_cast<block *>(allocateMemory(&m_allocator, sizeof(block) + capacity));
+  if (newBlock == NULL) {
+    return NULL;
+  }
+  newBlock->capacity = capacity;
+  newBlock->used = 0;
+  m_reserved_byte_count += sizeof(block) + capacity;
+
+  // Insert the block after the current block so that retained blocks remain reachable.
+  if (m_current_block == NULL) {
+    newBlock->next = m_first_block;
+    m_first_block = newBlock;
+  } else {
+    newBlock->next = m_current_block->next;
+    m_current_block->next = newBlock;
+  }
+  return newBlock;
+}
+
+void *arena::allocate(size_t size, size_t alignment) {
+  block *currentBlock = m_current_block;
+  if ((currentBlock == NULL) || !storageHasCapacity(currentBlock->storage(), currentBlock->capacity, currentBlock->used, size, alignment)) {
+    currentBlock = blockWithCapacity(size, alignment);
+    if (currentBlock == NULL) {
+      return NULL;
+    }
+    currentBlock->used = 0;
+    m_current_block = currentBlock;
+  }
+
+  char *storage = currentBlock->storage();
+  uintptr_t address = alignedSize((uintptr_t)(storage + currentBlock->used), alignment);
+  size_t usedByteCount = (address - (uintptr_t)storage) + size;
+  m_used_byte_count += usedByteCount - currentBlock->used;
+  currentBlock->used = usedByteCount;
+  return (void *)address;
+}
+
+void arena::adoptBlocks(arena *other) {
+  block *adoptedFirstBlock = other->m_first_block;
+  if (adoptedFirstBlock == NULL) {
+    return;
+  }
+  block *adoptedLastBlock = adoptedFirstBlock;
+  while (adoptedLastBlock->next != NULL) {
+    adoptedLastBlock = adoptedLastBlock->next;
+  }
+
+  // Adopted blocks precede the current block so that they are not reused before the next reset.
+  adoptedLastBlock->next = m_first_block;
+  m_first_block = adoptedFirstBlock;
+  if (m_current_block == NULL) {
+    m_current_block = adoptedLastBlock;
+  }
+  m_used_byte_count += other->m_used_byte_count;
+  m_reserved_byte_count += other->m_reserved_byte_count;
+
+  other->m_first_block = NULL;
+  other->m_current_block = NULL;
+  other->m_used_byte_count = 0;
+  other->m_reserved_byte_count = 0;
+}
+
+void arena::reset() {
+  m_current_block = NULL;
+  m_used_byte_count = 0;
+  if (m_first_block != NULL) {
+    m_first_block->used = 0;
+    m_current_block = m_first_block;
+  }
+}
+
+}
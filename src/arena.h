@@ -0,0 +1,106 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_ARENA__
+#define OBJCTK_ARENA__
+
+#include "internal-allocator.h"
+
+#include <stddef.h>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace objctk {
+
+/**
+ * A bump allocator that owns the type nodes of a parse result.
+ *
+ * Memory is obtained from an allocator in blocks which are only returned when the arena is
+ * destroyed. Resetting an
+ * arena rewinds all of its blocks so that subsequent allocations reuse them. Objects allocated in
+ * an arena are never destroyed and must therefore not own resources of their own.
+ */
+class arena {
+  struct alignas(alignof(std::max_align_t)) block {
+    block *next;
+    size_t capacity;
+    size_t used;
+
+    char *storage() { return reinterpret_cast<char *>(this + 1); }
+  };
+
+  objctk_allocator m_allocator;
+  block *m_first_block;
+  block *m_current_block;
+  size_t m_used_byte_count;
+  size_t m_reserved_byte_count;
+
+  block *blockWithCapacity(size_t size, size_t alignment);
+
+public:
+  explicit arena(const objctk_allocator *allocator) : m_allocator(*allocator), m_first_block(NULL), m_current_block(NULL), m_used_byte_count(0), m_reserved_byte_count(0) {}
+  ~arena();
+
+  arena(const arena &) = delete;
+  arena &operator=(const arena &) = delete;
+
+  /** Allocates uninitialized memory of the given size and alignment, returning NULL on failure. */
+  void *allocate(size_t size, size_t alignment);
+
+  /** Allocates and constructs an object in the arena, returning NULL on failure. */
+  template <typename T, typename... Arguments>
+  T *make(Arguments&&... arguments) {
+    void *memory = allocate(sizeof(T), alignof(T));
+    if (memory == NULL) {
+      return NULL;
+    }
+    return new (memory) T(std::forward<Arguments>(arguments)...);
+  }
+
+  /** Allocates an uninitialized array in the arena, returning NULL on failure. */
+  template <typename T>
+  T *makeArray(size_t count) {
+    return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  /** Rewinds the arena, invalidating all objects allocated in it while retaining its blocks. */
+  void reset();
+
+  /**
+   * Takes ownership of all blocks of another arena which uses the same allocator, leaving the other
+   * arena empty. Objects allocated in the other arena remain valid until this arena is reset.
+   */
+  void adoptBlocks(arena *other);
+
+  /** Returns the number of bytes allocated from the arena since it was last reset. */
+  size_t usedByteCount() const { return m_used_byte_count; }
+
+  /** Returns the number of bytes of memory held by the arena. */
+  size_t reservedByteCount() const { return m_reserved_byte_count; }
+};
+
+}
+
+#endif
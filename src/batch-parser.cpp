@@ -0,0 +1,151 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "type-encoding.h"
+
+#include "internal-allocator.h"
+#include "parser.h"
+#include "typenode.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace objctk;
+
+// An encoding of a batch, which is parsed in sorted order alongside its neighbours.
+struct objctk_batchencoding {
+  const char *typeEncoding;
+  size_t length;
+  size_t index;
+};
+
+static inline bool batchEncodingPrecedes(const objctk_batchencoding &encoding1, const objctk_batchencoding &encoding2) {
+  return (strcmp(encoding1.typeEncoding, encoding2.typeEncoding) < 0);
+}
+
+static inline size_t commonPrefixLength(const objctk_batchencoding *encoding1, const objctk_batchencoding *encoding2) {
+  const size_t maximumLength = std::min(encoding1->length, encoding2->length);
+  size_t length = 0;
+  while ((length < maximumLength) && (encoding1->typeEncoding[length] == encoding2->typeEncoding[length])) {
+    length++;
+  }
+  return length;
+}
+
+// Returns the top-level types of a parse result, which are the members of its root type node unless
+// the type encoding consists of a single type.
+static _objctk_typenode_list topLevelTypes(_objctk_typeparseresult *parseResult) {
+  if ((parseResult->status.status_code != objctk_statuscode_NoError) || (parseResult->node == NULL)) {
+    return _objctk_typenode_list();
+  }
+  if (parseResult->node->typeCategory() == OBJCTKTypeCategoryTopLevel) {
+    return parseResult->node->memberTypes();
+  }
+  return _objctk_typenode_list(&parseResult->node, 1);
+}
+
+// Returns the leading top-level types which end before a prefix. The type ending exactly at the end of
+// the prefix is excluded as the token ending it may extend differently in another encoding, such as
+// the bitfield 'b1' which continues as 'b12'.
+static _objctk_typenode_list typesWithinPrefix(const _objctk_typenode_list types, const size_t prefixLength) {
+  size_t count = 0;
+  while (count < types.size()) {
+    const objctk_substring substring = types[count]->substring();
+    if ((substring.offset + substring.length) >= prefixLength) {
+      break;
+    }
+    count++;
+  }
+  return _objctk_typenode_list(types.begin(), count);
+}
+
+static void parseBatchEncoding(const objctk_batchencoding *encoding, const objctk_batchencoding *previousEncoding, _objctk_typeparseresult *previousResult, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack) {
+  if (previousEncoding == NULL) {
+    parseTypeEncodingAfterPrefix(encoding->typeEncoding, encoding->length, _objctk_typenode_list(), result, scratchStack);
+    return;
+  }
+  const size_t prefixLength = commonPrefixLength(encoding, previousEncoding);
+
+  // Duplicate encodings share the whole type tree.
+  if ((prefixLength == encoding->length) && (prefixLength == previousEncoding->length) && (previousResult->status.status_code == objctk_statuscode_NoError)) {
+    result->node = previousResult->node;
+    result->unexpected_token_count = previousResult->unexpected_token_count;
+    result->prefix_result = objctk_typeparseresult_retain(previousResult);
+    return;
+  }
+
+  const _objctk_typenode_list prefixTypes = typesWithinPrefix(topLevelTypes(previousResult), prefixLength);
+  parseTypeEncodingAfterPrefix(encoding->typeEncoding, encoding->length, prefixTypes, result, scratchStack);
+  if (!prefixTypes.empty() && (result->status.status_code == objctk_statuscode_NoError)) {
+    result->prefix_result = objctk_typeparseresult_retain(previousResult);
+  }
+}
+
+objctk_statuscode objctk_parseTypeEncodingBatch(const char *const *typeEncodings, size_t count, objctk_typeparseresult *outParseResults, const objctk_allocator *allocator) {
+  if ((count != 0) && ((typeEncodings == NULL) || (outParseResults == NULL))) {
+    return objctk_statuscode_InvalidInput;
+  }
+  for (size_t index = 0; index < count; index++) {
+    if (typeEncodings[index] == NULL) {
+      return objctk_statuscode_InvalidInput;
+    }
+  }
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+
+  scratchstack<objctk_batchencoding> encodings(allocator);
+  bool isAllocated = true;
+  for (size_t index = 0; index < count; index++) {
+    outParseResults[index] = NULL;
+  }
+  for (size_t index = 0; isAllocated && (index < count); index++) {
+    const objctk_batchencoding encoding = {
+      .typeEncoding = typeEncodings[index],
+      .length = strlen(typeEncodings[index]),
+      .index = index,
+    };
+    outParseResults[index] = makeObject<_objctk_typeparseresult>(allocator, allocator);
+    isAllocated = (outParseResults[index] != NULL) && encodings.push_back(encoding);
+  }
+  if (!isAllocated) {
+    for (size_t index = 0; index < count; index++) {
+      releaseObject(allocator, outParseResults[index]);
+      outParseResults[index] = NULL;
+    }
+    return objctk_statuscode_OutOfMemory;
+  }
+
+  // Sorting places each encoding after the one sharing its longest prefix.
+  std::sort(encodings.begin(), encodings.end(), batchEncodingPrecedes);
+  _objctk_typenode_stack scratchStack(allocator);
+  const objctk_batchencoding *previousEncoding = NULL;
+  for (const objctk_batchencoding *encoding = encodings.begin(); encoding != encodings.end(); encoding++) {
+    _objctk_typeparseresult *previousResult = (previousEncoding != NULL) ? outParseResults[previousEncoding->index] : NULL;
+    parseBatchEncoding(encoding, previousEncoding, previousResult, outParseResults[encoding->index], &scratchStack);
+    previousEncoding = encoding;
+  }
+  return objctk_statuscode_NoError;
+}
@@ -0,0 +1,712 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "declaration-emitter.h"
+
+#include "internal-allocator.h"
+#include "name-table.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace objctk;
+
+/**
+ * An open-addressing table mapping pairs of 64-bit keys to indexes. The table grows to stay at most
+ * half full and never shrinks.
+ */
+class indextable {
+  struct entry {
+    uint64_t first;
+    uint64_t second;
+    uint32_t index;
+    bool occupied;
+  };
+
+  objctk_allocator m_allocator;
+  entry *m_entries;
+  size_t m_capacity;
+  size_t m_count;
+
+  static size_t slotForKey(const uint64_t first, const uint64_t second, const size_t capacity) {
+    return (size_t)combinedStructuralHash(first, second) & (capacity - 1);
+  }
+
+  entry *entryForKey(entry *entries, const size_t capacity, const uint64_t first, const uint64_t second) const {
+    for (size_t slot = slotForKey(first, second, capacity); ; slot = (slot + 1) & (capacity - 1)) {
+      entry *candidate = &entries[slot];
+      if (!candidate->occupied || ((candidate->first == first) && (candidate->second == second))) {
+        return candidate;
+      }
+    }
+  }
+
+  bool grow() {
+    const size_t capacity = (m_capacity > 0) ? (m_capacity * 2) : 64;
+    entry *entries = static_cast<entry *>(allocateMemory(&m_allocator, capacity * sizeof(entry)));
+    if (entries == NULL) {
+      return false;
+    }
+    memset(entries, 0, capacity * sizeof(entry));
+    for (size_t slot = 0; slot < m_capacity; slot++) {
+      const entry *existing = &m_entries[slot];
+      if (existing->occupied) {
+        *entryForKey(entries, capacity, existing->first, existing->second) = *existing;
+      }
+    }
+    deallocateMemory(&m_allocator, m_entries);
+    m_entries = entries;
+    m_capacity = capacity;
+    return true;
+  }
+
+public:
+  explicit indextable(const objctk_allocator *allocator) : m_allocator(*allocator), m_entries(NULL), m_capacity(0), m_count(0) {}
+  ~indextable() { deallocateMemory(&m_allocator, m_entries); }
+
+  indextable(const indextable &) = delete;
+  indextable &operator=(const indextable &) = delete;
+
+  /** Returns the index stored for a key or NULL if the key is absent. */
+  uint32_t *find(const uint64_t first, const uint64_t second) const {
+    if (m_count == 0) {
+      return NULL;
+    }
+    entry *found = entryForKey(m_entries, m_capacity, first, second);
+    return found->occupied ? &found->index : NULL;
+  }
+
+  /**
+   * Returns the index stored for a key, storing index for the key first if it is absent, or NULL if
+   * the table could not grow.
+   */
+  uint32_t *insert(const uint64_t first, const uint64_t second, const uint32_t index, bool *outInserted) {
+    *outInserted = false;
+    if ((((m_count + 1) * 2) > m_capacity) && !grow()) {
+      return NULL;
+    }
+    entry *found = entryForKey(m_entries, m_capacity, first, second);
+    if (!found->occupied) {
+      *found = { first, second, index, true };
+      m_count++;
+      *outInserted = true;
+    }
+    return &found->index;
+  }
+};
+
+/**
+ * Writes text either in chunks to a sink or into a fixed buffer, in which case text beyond its
+ * capacity is counted but discarded.
+ */
+class textwriter {
+  objctk_declarationsink m_sink;
+  void *m_context;
+  char *m_buffer;
+  size_t m_capacity;
+  size_t m_bufferedLength;
+  size_t m_length;
+  bool m_terminates;
+  bool m_stopped;
+
+  void flush() {
+    if (!m_stopped && (m_bufferedLength > 0) && !m_sink(m_context, m_buffer, m_bufferedLength)) {
+      m_stopped = true;
+    }
+    m_bufferedLength = 0;
+  }
+
+public:
+  textwriter(objctk_declarationsink sink, void *context, char *chunk, const size_t chunkCapacity) : m_sink(sink), m_context(context), m_buffer(chunk), m_capacity(chunkCapacity), m_bufferedLength(0), m_length(0), m_terminates(false), m_stopped(false) {}
+
+  // One byte of the buffer is reserved for the NUL terminator.
+  textwriter(char *buffer, const size_t capacity) : m_sink(NULL), m_context(NULL), m_buffer(buffer), m_capacity((capacity > 0) ? (capacity - 1) : 0), m_bufferedLength(0), m_length(0), m_terminates(capacity > 0), m_stopped(false) {}
+
+  void write(const char *text, size_t length) {
+    m_length += length;
+    while (length > 0) {
+      if (m_bufferedLength == m_capacity) {
+        if (m_sink == NULL) {
+          return;
+        }
+        flush();
+      }
+      const size_t copiedLength = std::min(length, m_capacity - m_bufferedLength);
+      memcpy(m_buffer + m_bufferedLength, text, copiedLength);
+      m_bufferedLength += copiedLength;
+      text += copiedLength;
+      length -= copiedLength;
+    }
+  }
+
+  void write(const char *text) { write(text, strlen(text)); }
+
+  void write(const char ch) { write(&ch, 1); }
+
+  void writeNumber(const size_t number) {
+    char digits[24];
+    const int length = snprintf(digits, sizeof(digits), "%zu", number);
+    write(digits, (size_t)length);
+  }
+
+  void writeIndentation(const unsigned int level) {
+    for (unsigned int index = 0; index < level; index++) {
+      write("    ", 4);
+    }
+  }
+
+  /** Flushes the remaining text to the sink or NUL-terminates the buffer, returning false if the sink stopped. */
+  bool finish() {
+    if (m_sink != NULL) {
+      flush();
+    } else if (m_terminates) {
+      m_buffer[m_bufferedLength] = '\0';
+    }
+    return !m_stopped;
+  }
+
+  /** Returns the length of all text written so far, including text which did not fit. */
+  size_t length() const { return m_length; }
+};
+
+// A struct or union definition, identified by its tag and the hash of its declaration.
+typedef struct objctk_compositedefinition {
+  _objctk_typenode *node;
+  objctk_nameid tagNameID;
+  // Zero for the first structure defined under the tag, which is emitted without a suffix.
+  uint32_t variant;
+} objctk_compositedefinition;
+
+struct _objctk_declarationemitter {
+  objctk_allocator allocator;
+  scratchstack<objctk_compositedefinition> definitions;
+
+  // Definitions by tag and declaration hash.
+  indextable definitionIndexes;
+
+  // The number of structures defined under each tag, keyed by the tag and kTagVariantCountKey, and
+  // the index of the first definition under each tag, keyed by the tag and kTagFirstDefinitionKey.
+  indextable tagIndexes;
+
+  // Scratch space for the chains of pointer and array types of declarators.
+  scratchstack<_objctk_typenode *> declaratorStack;
+
+  explicit _objctk_declarationemitter(const objctk_allocator *allocator) : allocator(*allocator), definitions(allocator), definitionIndexes(allocator), tagIndexes(allocator), declaratorStack(allocator) {}
+};
+
+static const size_t kChunkCapacity = 16384;
+static const uint64_t kTagVariantCountKey = 0;
+static const uint64_t kTagFirstDefinitionKey = 1;
+
+static inline bool isCompositeTypeCategory(const objctk_typecategory typeCategory) {
+  return (typeCategory == OBJCTKTypeCategoryStruct) || (typeCategory == OBJCTKTypeCategoryUnion);
+}
+
+// Structs and unions named '?' in type encodings are anonymous.
+static inline bool isTaggedComposite(_objctk_typenode *node) {
+  if (!isCompositeTypeCategory(node->typeCategory()) || (node->typeNameID() == OBJCTK_NAMEID_NONE)) {
+    return false;
+  }
+  size_t tagLength = 0;
+  const char *tag = internedName(node->typeNameID(), &tagLength);
+  return (tag != NULL) && !((tagLength == 1) && (tag[0] == '?'));
+}
+
+// A tagged struct or union with members is a definition, while one without members only refers to
+// a definition, as pointers to structs commonly do in type encodings.
+static inline bool isCompositeDefinition(_objctk_typenode *node) {
+  return isTaggedComposite(node) && !node->memberTypes().empty();
+}
+
+// Returns a hash that is equal for type nodes with identical declarations. Unlike the structural
+// hash, the members of tagged structs and unions referenced through pointers are ignored since the
+// declaration refers to them by tag alone.
+static uint64_t declarationHash(_objctk_typenode *node);
+
+static uint64_t referencedDeclarationHash(_objctk_typenode *node) {
+  if (node == NULL) {
+    return 0;
+  }
+  if (isTaggedComposite(node)) {
+    return combinedStructuralHash(node->typeCategory(), node->typeNameID());
+  }
+  return declarationHash(node);
+}
+
+static uint64_t declarationHash(_objctk_typenode *node) {
+  const objctk_typecategory typeCategory = node->typeCategory();
+  uint64_t hash = combinedStructuralHash(0, typeCategory);
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryPointer:
+      return combinedStructuralHash(hash, referencedDeclarationHash(node->referencedType()));
+    case OBJCTKTypeCategoryArray:
+      hash = combinedStructuralHash(hash, static_cast<arraynode *>(node)->elementCount());
+      return combinedStructuralHash(hash, declarationHash(node->referencedType()));
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryUnion:
+    case OBJCTKTypeCategoryTopLevel: {
+      hash = combinedStructuralHash(hash, node->typeNameID());
+      _objctk_typenode_list memberTypes = node->memberTypes();
+      for (_objctk_typenode_list::const_iterator iter = memberTypes.begin(); iter != memberTypes.end(); iter++) {
+        hash = combinedStructuralHash(hash, declarationHash(*iter));
+      }
+      return hash;
+    }
+    default:
+      return node->structuralHash();
+  }
+}
+
+// Returns the definition under which a tagged struct or union is declared or NULL if the emitter
+// holds none. Structs and unions without members refer to the first structure defined under their
+// tag, and the declarations of others are only hashed if their tag has several definitions.
+static const objctk_compositedefinition *definitionForNode(objctk_declarationemitter emitter, _objctk_typenode *node) {
+  if ((emitter == NULL) || !isTaggedComposite(node)) {
+    return NULL;
+  }
+  const objctk_nameid tagNameID = node->typeNameID();
+  const uint32_t *definitionIndex = emitter->tagIndexes.find(tagNameID, kTagFirstDefinitionKey);
+  const uint32_t *variantCount = emitter->tagIndexes.find(tagNameID, kTagVariantCountKey);
+  if ((definitionIndex != NULL) && (variantCount != NULL) && (*variantCount > 1) && !node->memberTypes().empty()) {
+    definitionIndex = emitter->definitionIndexes.find(tagNameID, declarationHash(node));
+  }
+  if ((definitionIndex == NULL) || (*definitionIndex == UINT32_MAX)) {
+    return NULL;
+  }
+  return emitter->definitions.begin() + *definitionIndex;
+}
+
+// Collects the definitions within a type, returning the declaration hash of the type or setting
+// outStatusCode if memory could not be allocated. Hashes are computed bottom-up as the type is
+// walked, so each type node is hashed once.
+static uint64_t collectDefinitions(objctk_declarationemitter emitter, _objctk_typenode *node, objctk_statuscode *outStatusCode) {
+  const objctk_typecategory typeCategory = node->typeCategory();
+  uint64_t hash = combinedStructuralHash(0, typeCategory);
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryPointer: {
+      _objctk_typenode *referencedType = node->referencedType();
+      if (referencedType == NULL) {
+        return combinedStructuralHash(hash, 0);
+      }
+      // The pointee is collected even though the pointer refers to it by tag alone.
+      const uint64_t referencedHash = collectDefinitions(emitter, referencedType, outStatusCode);
+      return combinedStructuralHash(hash, isTaggedComposite(referencedType) ? combinedStructuralHash(referencedType->typeCategory(), referencedType->typeNameID()) : referencedHash);
+    }
+    case OBJCTKTypeCategoryArray:
+      hash = combinedStructuralHash(hash, static_cast<arraynode *>(node)->elementCount());
+      return combinedStructuralHash(hash, collectDefinitions(emitter, node->referencedType(), outStatusCode));
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryUnion:
+    case OBJCTKTypeCategoryTopLevel:
+      break;
+    default:
+      return node->structuralHash();
+  }
+
+  hash = combinedStructuralHash(hash, node->typeNameID());
+  _objctk_typenode_list memberTypes = node->memberTypes();
+  for (_objctk_typenode_list::const_iterator iter = memberTypes.begin(); iter != memberTypes.end(); iter++) {
+    hash = combinedStructuralHash(hash, collectDefinitions(emitter, *iter, outStatusCode));
+  }
+  if (!isCompositeDefinition(node) || (*outStatusCode != objctk_statuscode_NoError)) {
+    return hash;
+  }
+
+  // Members are collected first so that nested definitions precede their containers when the
+  // definitions are ordered by their first appearance.
+  const objctk_nameid tagNameID = node->typeNameID();
+  const uint32_t nextIndex = (uint32_t)emitter->definitions.size();
+  bool inserted = false;
+  uint32_t *definitionIndex = emitter->definitionIndexes.insert(tagNameID, hash, nextIndex, &inserted);
+  if (definitionIndex == NULL) {
+    *outStatusCode = objctk_statuscode_OutOfMemory;
+    return hash;
+  }
+  if (inserted) {
+    // The variant count is looked up last since inserting into the table invalidates its entries.
+    bool insertedTag = false;
+    uint32_t *variantCount = NULL;
+    if (emitter->tagIndexes.insert(tagNameID, kTagFirstDefinitionKey, nextIndex, &insertedTag) != NULL) {
+      variantCount = emitter->tagIndexes.insert(tagNameID, kTagVariantCountKey, 0, &insertedTag);
+    }
+    objctk_compositedefinition definition = { node, tagNameID, (variantCount != NULL) ? *variantCount : 0 };
+    if ((variantCount == NULL) || !emitter->definitions.push_back(definition)) {
+      // The definition is left unreachable rather than removed from the tables.
+      uint32_t *firstDefinitionIndex = emitter->tagIndexes.find(tagNameID, kTagFirstDefinitionKey);
+      if ((firstDefinitionIndex != NULL) && (*firstDefinitionIndex == nextIndex)) {
+        *firstDefinitionIndex = UINT32_MAX;
+      }
+      *definitionIndex = UINT32_MAX;
+      *outStatusCode = objctk_statuscode_OutOfMemory;
+      return hash;
+    }
+    (*variantCount)++;
+  }
+  if (*definitionIndex == UINT32_MAX) {
+    *outStatusCode = objctk_statuscode_OutOfMemory;
+  }
+  return hash;
+}
+
+// The keywords of C, including those added by C23, which cannot be used as tags.
+static const char *const kReservedWords[] = {
+  "_Alignas", "_Alignof", "_Atomic", "_BitInt", "_Bool", "_Complex", "_Decimal128", "_Decimal32",
+  "_Decimal64", "_Generic", "_Imaginary", "_Noreturn", "_Static_assert", "_Thread_local", "alignas",
+  "alignof", "auto", "bool", "break", "case", "char", "const", "constexpr", "continue", "default", "do",
+  "double", "else", "enum", "extern", "false", "float", "for", "goto", "if", "inline", "int", "long",
+  "nullptr", "register", "restrict", "return", "short", "signed", "sizeof", "static", "static_assert",
+  "struct", "switch", "thread_local", "true", "typedef", "typeof", "typeof_unqual", "union", "unsigned",
+  "void", "volatile", "while",
+};
+
+static bool isReservedWord(const char *word, const size_t length) {
+  for (const char *reservedWord : kReservedWords) {
+    if ((strncmp(reservedWord, word, length) == 0) && (reservedWord[length] == '\0')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Writes a tag as a C identifier. Tags which are C keywords, as in {int=i}, are suffixed with an
+// underscore.
+static void writeTag(textwriter *writer, const objctk_nameid tagNameID, const uint32_t variant) {
+  size_t tagLength = 0;
+  const char *tag = internedName(tagNameID, &tagLength);
+  for (size_t index = 0; index < tagLength; index++) {
+    const char ch = tag[index];
+    const bool isIdentifierCharacter = isalnum((unsigned char)ch) || (ch == '_');
+    writer->write(isIdentifierCharacter ? ch : '_');
+  }
+  if ((tag != NULL) && isReservedWord(tag, tagLength)) {
+    writer->write('_');
+  }
+  if (variant > 0) {
+    writer->write('_');
+    writer->writeNumber(variant + 1);
+  }
+}
+
+static void writeDeclaration(objctk_declarationemitter emitter, scratchstack<_objctk_typenode *> *declaratorStack, textwriter *writer, _objctk_typenode *node, const char *name, const size_t nameLength, const unsigned int indentation);
+
+static void writeCompositeBody(objctk_declarationemitter emitter, scratchstack<_objctk_typenode *> *declaratorStack, textwriter *writer, _objctk_typenode *node, const unsigned int indentation) {
+  writer->write("{\n", 2);
+  _objctk_typenode_list memberTypes = node->memberTypes();
+  char memberName[32];
+  for (size_t memberIndex = 0; memberIndex < memberTypes.size(); memberIndex++) {
+    writer->writeIndentation(indentation + 1);
+    const int memberNameLength = snprintf(memberName, sizeof(memberName), "field%zu", memberIndex);
+    writeDeclaration(emitter, declaratorStack, writer, memberTypes[memberIndex], memberName, (size_t)memberNameLength, indentation + 1);
+    writer->write(";\n", 2);
+  }
+  writer->writeIndentation(indentation);
+  writer->write('}');
+}
+
+// Writes the type specifier of the innermost type of a declarator. Character strings and unknown
+// types outside pointers are declared through a pointer which is not part of the type tree, which is
+// reported through outImplicitPointer.
+static void writeSpecifier(objctk_declarationemitter emitter, scratchstack<_objctk_typenode *> *declaratorStack, textwriter *writer, _objctk_typenode *node, const bool isReferenced, const unsigned int indentation, bool *outImplicitPointer) {
+  *outImplicitPointer = false;
+  if (node == NULL) {
+    writer->write("void", 4);
+    return;
+  }
+  const objctk_typecategory typeCategory = node->typeCategory();
+  switch (typeCategory) {
+    case OBJCTKTypeCategorySignedChar: writer->write("char"); return;
+    case OBJCTKTypeCategorySignedInt: writer->write("int"); return;
+    case OBJCTKTypeCategorySignedShort: writer->write("short"); return;
+    case OBJCTKTypeCategorySignedLong: writer->write("long"); return;
+    case OBJCTKTypeCategorySignedLongLong: writer->write("long long"); return;
+    case OBJCTKTypeCategoryUnsignedChar: writer->write("unsigned char"); return;
+    case OBJCTKTypeCategoryUnsignedInt: writer->write("unsigned int"); return;
+    case OBJCTKTypeCategoryUnsignedShort: writer->write("unsigned short"); return;
+    case OBJCTKTypeCategoryUnsignedLong: writer->write("unsigned long"); return;
+    case OBJCTKTypeCategoryUnsignedLongLong: writer->write("unsigned long long"); return;
+    case OBJCTKTypeCategoryFloat: writer->write("float"); return;
+    case OBJCTKTypeCategoryDouble: writer->write("double"); return;
+    case OBJCTKTypeCategoryBool: writer->write("_Bool"); return;
+    case OBJCTKTypeCategoryVoid: writer->write("void"); return;
+    case OBJCTKTypeCategoryClass: writer->write("Class"); return;
+    case OBJCTKTypeCategorySelector: writer->write("SEL"); return;
+    case OBJCTKTypeCategoryBitField: writer->write("unsigned int"); return;
+    case OBJCTKTypeCategoryCharacterString:
+      writer->write("char");
+      *outImplicitPointer = true;
+      return;
+    case OBJCTKTypeCategoryObject: {
+      // Objects are declared as ids, keeping the protocols which qualify them, since their classes
+      // are not declared by the emitted text.
+      size_t classNameLength = 0;
+      const char *className = internedName(node->typeNameID(), &classNameLength);
+      const char *protocols = (className != NULL) ? (const char *)memchr(className, '<', classNameLength) : NULL;
+      writer->write("id", 2);
+      if (protocols != NULL) {
+        writer->write(protocols, classNameLength - (size_t)(protocols - className));
+      }
+      return;
+    }
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryUnion: {
+      writer->write((typeCategory == OBJCTKTypeCategoryStruct) ? "struct" : "union");
+      if (!isTaggedComposite(node)) {
+        writer->write(' ');
+        writeCompositeBody(emitter, declaratorStack, writer, node, indentation);
+        return;
+      }
+      writer->write(' ');
+      const objctk_compositedefinition *definition = definitionForNode(emitter, node);
+      writeTag(writer, node->typeNameID(), (definition != NULL) ? definition->variant : 0);
+      return;
+    }
+    default:
+      // Unknown types are usually function pointers, which are declared as pointers to void.
+      writer->write("void", 4);
+      *outImplicitPointer = !isReferenced;
+      return;
+  }
+}
+
+static void writeDeclaration(objctk_declarationemitter emitter, scratchstack<_objctk_typenode *> *declaratorStack, textwriter *writer, _objctk_typenode *node, const char *name, const size_t nameLength, const unsigned int indentation) {
+  // Collect the pointers and arrays from the outermost to the innermost, whose declarators are
+  // written inside out around the name.
+  const size_t declaratorBase = declaratorStack->size();
+  _objctk_typenode *innermostType = node;
+  while ((innermostType != NULL) && ((innermostType->typeCategory() == OBJCTKTypeCategoryPointer) || (innermostType->typeCategory() == OBJCTKTypeCategoryArray))) {
+    if (!declaratorStack->push_back(innermostType)) {
+      break;
+    }
+    innermostType = innermostType->referencedType();
+  }
+  _objctk_typenode **declarators = declaratorStack->begin() + declaratorBase;
+  const size_t declaratorCount = declaratorStack->size() - declaratorBase;
+  const bool isReferenced = (declaratorCount > 0) && (declarators[declaratorCount - 1]->typeCategory() == OBJCTKTypeCategoryPointer);
+
+  bool implicitPointer = false;
+  writeSpecifier(emitter, declaratorStack, writer, innermostType, isReferenced, indentation, &implicitPointer);
+  const bool isBitField = (innermostType != NULL) && (innermostType->typeCategory() == OBJCTKTypeCategoryBitField);
+  if ((nameLength > 0) || (declaratorCount > 0) || implicitPointer) {
+    writer->write(' ');
+  }
+  if (implicitPointer) {
+    writer->write('*');
+  }
+  // A pointer to an array is parenthesized to bind before the array's brackets.
+  for (size_t index = declaratorCount; index-- > 0; ) {
+    if (declarators[index]->typeCategory() == OBJCTKTypeCategoryPointer) {
+      const bool pointsToArray = ((index + 1) < declaratorCount) && (declarators[index + 1]->typeCategory() == OBJCTKTypeCategoryArray);
+      writer->write(pointsToArray ? "(*" : "*");
+    }
+  }
+  writer->write(name, nameLength);
+  for (size_t index = 0; index < declaratorCount; index++) {
+    if (declarators[index]->typeCategory() == OBJCTKTypeCategoryArray) {
+      writer->write('[');
+      writer->writeNumber(static_cast<arraynode *>(declarators[index])->elementCount());
+      writer->write(']');
+    } else if (((index + 1) < declaratorCount) && (declarators[index + 1]->typeCategory() == OBJCTKTypeCategoryArray)) {
+      writer->write(')');
+    }
+  }
+  if (isBitField) {
+    writer->write(" : ", 3);
+    writer->writeNumber(static_cast<bitfieldnode *>(innermostType)->bitCount());
+  }
+  declaratorStack->resize(declaratorBase);
+}
+
+// Pushes the definitions of the tagged structs and unions contained by value in a type, looking
+// through arrays and anonymous structs and unions.
+static bool pushValueDependencies(objctk_declarationemitter emitter, _objctk_typenode *node, scratchstack<uint32_t> *dependencies) {
+  while (node->typeCategory() == OBJCTKTypeCategoryArray) {
+    node = node->referencedType();
+  }
+  if (!isCompositeTypeCategory(node->typeCategory())) {
+    return true;
+  }
+  if (isTaggedComposite(node)) {
+    const objctk_compositedefinition *definition = definitionForNode(emitter, node);
+    return (definition == NULL) || dependencies->push_back((uint32_t)(definition - emitter->definitions.begin()));
+  }
+  _objctk_typenode_list memberTypes = node->memberTypes();
+  for (_objctk_typenode_list::const_iterator iter = memberTypes.begin(); iter != memberTypes.end(); iter++) {
+    if (!pushValueDependencies(emitter, *iter, dependencies)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void writeDefinition(objctk_declarationemitter emitter, textwriter *writer, const objctk_compositedefinition *definition) {
+  _objctk_typenode *node = definition->node;
+  writer->write((node->typeCategory() == OBJCTKTypeCategoryStruct) ? "struct " : "union ");
+  writeTag(writer, definition->tagNameID, definition->variant);
+  writer->write(' ');
+  writeCompositeBody(emitter, &emitter->declaratorStack, writer, node, 0);
+  writer->write(";\n\n", 3);
+}
+
+// Writes the definitions in a depth-first postorder over their by-value dependencies, visiting the
+// definitions in the order they were collected. The traversal uses explicit stacks since chains of
+// dependencies may be arbitrarily long.
+static objctk_statuscode writeDefinitions(objctk_declarationemitter emitter, textwriter *writer) {
+  enum : uint8_t { Unvisited = 0, Visiting, Written };
+  const size_t definitionCount = emitter->definitions.size();
+  uint8_t *states = static_cast<uint8_t *>(allocateMemory(&emitter->allocator, std::max<size_t>(definitionCount, 1)));
+  if (states == NULL) {
+    return objctk_statuscode_OutOfMemory;
+  }
+  memset(states, Unvisited, definitionCount);
+
+  objctk_statuscode statusCode = objctk_statuscode_NoError;
+  scratchstack<uint32_t> dependencies(&emitter->allocator);
+  // Each frame is a definition and the position in the dependency stack where its dependencies start.
+  scratchstack<uint64_t> frames(&emitter->allocator);
+  for (size_t rootIndex = 0; (rootIndex < definitionCount) && (statusCode == objctk_statuscode_NoError); rootIndex++) {
+    if (states[rootIndex] != Unvisited) {
+      continue;
+    }
+    uint32_t index = (uint32_t)rootIndex;
+    while (true) {
+      if (states[index] == Unvisited) {
+        states[index] = Visiting;
+        const size_t dependencyBase = dependencies.size();
+        _objctk_typenode_list memberTypes = emitter->definitions.begin()[index].node->memberTypes();
+        bool pushed = frames.push_back(((uint64_t)dependencyBase << 32) | index);
+        for (_objctk_typenode_list::const_iterator iter = memberTypes.begin(); pushed && (iter != memberTypes.end()); iter++) {
+          pushed = pushValueDependencies(emitter, *iter, &dependencies);
+        }
+        if (!pushed) {
+          statusCode = objctk_statuscode_OutOfMemory;
+          break;
+        }
+        // Dependencies are popped from the top, so they are reversed to be written in member order.
+        std::reverse(dependencies.begin() + dependencyBase, dependencies.end());
+      }
+
+      // Descend into the next unvisited dependency of the innermost frame or write its definition.
+      const uint64_t frame = frames.back();
+      const size_t dependencyBase = (size_t)(frame >> 32);
+      const uint32_t frameIndex = (uint32_t)frame;
+      uint32_t nextIndex = UINT32_MAX;
+      while (dependencies.size() > dependencyBase) {
+        const uint32_t dependency = dependencies.back();
+        dependencies.pop_back();
+        // Dependencies already being visited would form a cycle, which by-value containment cannot.
+        if (states[dependency] == Unvisited) {
+          nextIndex = dependency;
+          break;
+        }
+      }
+      if (nextIndex != UINT32_MAX) {
+        index = nextIndex;
+        continue;
+      }
+      frames.pop_back();
+      states[frameIndex] = Written;
+      writeDefinition(emitter, writer, &emitter->definitions.begin()[frameIndex]);
+      if (frames.empty()) {
+        break;
+      }
+      index = (uint32_t)frames.back();
+    }
+  }
+  deallocateMemory(&emitter->allocator, states);
+  return statusCode;
+}
+
+objctk_declarationemitter objctk_declarationemitter_create(const objctk_allocator *allocator) {
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+  return makeObject<_objctk_declarationemitter>(allocator, allocator);
+}
+
+objctk_statuscode objctk_declarationemitter_addType(objctk_declarationemitter emitter, objctk_typenode node) {
+  if ((emitter == NULL) || (node == NULL)) {
+    return objctk_statuscode_InvalidInput;
+  }
+  objctk_statuscode statusCode = objctk_statuscode_NoError;
+  collectDefinitions(emitter, node, &statusCode);
+  return statusCode;
+}
+
+size_t objctk_declarationemitter_getDefinitionCount(objctk_declarationemitter emitter) {
+  return (emitter != NULL) ? emitter->definitions.size() : 0;
+}
+
+objctk_statuscode objctk_declarationemitter_emitDefinitions(objctk_declarationemitter emitter, objctk_declarationsink sink, void *context) {
+  if ((emitter == NULL) || (sink == NULL)) {
+    return objctk_statuscode_InvalidInput;
+  }
+  char chunk[kChunkCapacity];
+  textwriter writer(sink, context, chunk, sizeof(chunk));
+  objctk_statuscode statusCode = writeDefinitions(emitter, &writer);
+  if (!writer.finish() && (statusCode == objctk_statuscode_NoError)) {
+    statusCode = objctk_statuscode_InvalidInput;
+  }
+  return statusCode;
+}
+
+objctk_statuscode objctk_declarationemitter_copyDefinitions(objctk_declarationemitter emitter, char *buffer, size_t capacity, size_t *outLength) {
+  if ((emitter == NULL) || ((buffer == NULL) && (capacity > 0))) {
+    return objctk_statuscode_InvalidInput;
+  }
+  textwriter writer(buffer, capacity);
+  objctk_statuscode statusCode = writeDefinitions(emitter, &writer);
+  writer.finish();
+  if (outLength != NULL) {
+    *outLength = writer.length();
+  }
+  return statusCode;
+}
+
+objctk_statuscode objctk_declarationemitter_copyDeclaration(objctk_declarationemitter emitter, objctk_typenode node, const char *name, char *buffer, size_t capacity, size_t *outLength) {
+  if ((node == NULL) || (node->typeCategory() == OBJCTKTypeCategoryTopLevel) || ((buffer == NULL) && (capacity > 0))) {
+    return objctk_statuscode_InvalidInput;
+  }
+  const objctk_allocator *allocator = (emitter != NULL) ? &emitter->allocator : defaultAllocator();
+  scratchstack<_objctk_typenode *> declaratorStack(allocator);
+  textwriter writer(buffer, capacity);
+  writeDeclaration(emitter, &declaratorStack, &writer, node, name, (name != NULL) ? strlen(name) : 0, 0);
+  writer.finish();
+  if (outLength != NULL) {
+    *outLength = writer.length();
+  }
+  return objctk_statuscode_NoError;
+}
+
+void objctk_declarationemitter_release(objctk_declarationemitter emitter) {
+  if (emitter == NULL) {
+    return;
+  }
+  objctk_allocator allocator = emitter->allocator;
+  releaseObject(&allocator, emitter);
+}
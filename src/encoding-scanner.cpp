@@ -0,0 +1,525 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "encoding-scanner.h"
+
+#include "layout.h"
+#include "lexer.h"
+#include "structural-characters.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace objctk;
+
+// The maximum number of pointers, arrays, structs and unions enclosing a type being scanned, and
+// of arrays, structs and unions enclosing a type being skipped.
+static const int kMaximumScanDepth = 64;
+
+// A pointer, array, struct or union whose referenced, element or member types are being scanned.
+typedef struct objctk_scanframe {
+  objctk_typecategory typeCategory;
+  char closingCharacter;
+
+  // Arrays.
+  size_t elementCount;
+  bool hasElementType;
+  objctk_typelayout elementLayout;
+
+  // Structs and unions, laid out as by compositetypenode::layoutMembers.
+  bool hasValidLayout;
+  int64_t bitOffset;
+  int largestMemberTypeSize;
+  int largestAlignment;
+} objctk_scanframe;
+
+static inline objctk_scanframe makeScanFrame(const objctk_typecategory typeCategory, const char closingCharacter) {
+  objctk_scanframe frame = {
+    .typeCategory = typeCategory,
+    .closingCharacter = closingCharacter,
+    .elementCount = 0,
+    .hasElementType = false,
+    .elementLayout = invalidTypeLayout(),
+    .hasValidLayout = true,
+    .bitOffset = 0,
+    .largestMemberTypeSize = 0,
+    .largestAlignment = 1,
+  };
+  return frame;
+}
+
+static inline char characterAtIndex(const char *typeEncoding, const size_t length, const size_t index) {
+  return (index < length) ? typeEncoding[index] : '\0';
+}
+
+// Consumes a decimal number, saturating at SIZE_MAX so that overlong counts are rejected as too
+// large rather than wrapping around.
+static inline size_t consumeNumber(const char *typeEncoding, const size_t length, size_t *index) {
+  size_t number = 0;
+  while (isdigit((unsigned char)characterAtIndex(typeEncoding, length, *index))) {
+    const size_t digit = (size_t)(typeEncoding[*index] - '0');
+    number = (number > ((SIZE_MAX - digit) / 10)) ? SIZE_MAX : ((number * 10) + digit);
+    (*index)++;
+  }
+  return number;
+}
+
+// Advances past the given character, returning false if the encoding ends before it.
+static inline bool consumeThroughCharacter(const char *typeEncoding, const size_t length, size_t *index, const char ch) {
+  while (true) {
+    const char currentCharacter = characterAtIndex(typeEncoding, length, *index);
+    if (currentCharacter == '\0') {
+      return false;
+    }
+    (*index)++;
+    if (currentCharacter == ch) {
+      return true;
+    }
+  }
+}
+
+// Advances past type qualifiers, frame offsets and the quoted names which may precede the types of
+// struct members, all of which the lexer skips, returning false if a name is not terminated.
+static inline bool consumeSkippedCharacters(const char *typeEncoding, const size_t length, size_t *index) {
+  while (true) {
+    const char currentCharacter = characterAtIndex(typeEncoding, length, *index);
+    if (currentCharacter == '"') {
+      (*index)++;
+      if (!consumeThroughCharacter(typeEncoding, length, index, '"')) {
+        return false;
+      }
+    } else if (lexer_isSkippedCharacter(currentCharacter)) {
+      (*index)++;
+    } else {
+      return true;
+    }
+  }
+}
+
+// Advances past the name of a struct or union, which ends at the '=' preceding its members or before
+// the closing bracket of a struct or union without members, returning false if the encoding ends
+// before it.
+static inline bool consumeTypeName(const char *typeEncoding, const size_t length, size_t *index) {
+  while (true) {
+    const char currentCharacter = characterAtIndex(typeEncoding, length, *index);
+    if (currentCharacter == '\0') {
+      return false;
+    }
+    if ((currentCharacter == '}') || (currentCharacter == ')')) {
+      return true;
+    }
+    (*index)++;
+    if (currentCharacter == '=') {
+      return true;
+    }
+  }
+}
+
+static inline objctk_typelayout scalarTypeLayout(const objctk_layoutrules *rules, const objctk_typecategory typeCategory) {
+  if (rules->alignments[typeCategory] == 0) {
+    return invalidTypeLayout();
+  }
+  return makeTypeLayout(rules->sizes[typeCategory], rules->alignments[typeCategory]);
+}
+
+static inline objctk_typelayout bitfieldTypeLayout(const int64_t bitCount) {
+  if (bitCount > kMaximumTypeBitCount) {
+    return invalidTypeLayout();
+  }
+  return makeTypeLayout((int)((bitCount + CHAR_BIT - 1) / CHAR_BIT), 1);
+}
+
+// Adds an element or member type to an array, struct or union. Bitfields have a non-negative bit
+// count. Offsets are accumulated in 64-bit arithmetic so that types too large for an int layout are
+// reported as invalid, as by compositetypenode::layoutMembers.
+static void addMemberType(objctk_scanframe *frame, const objctk_layoutrules *rules, const objctk_typelayout layout, const int64_t bitCount) {
+  if (frame->typeCategory == OBJCTKTypeCategoryArray) {
+    frame->hasElementType = true;
+    frame->elementLayout = layout;
+    return;
+  }
+
+  const bool isUnion = (frame->typeCategory == OBJCTKTypeCategoryUnion);
+  if (layout.size < 0) {
+    frame->hasValidLayout = false;
+    return;
+  }
+  if (bitCount >= 0) {
+    const int unitBits = rules->bitfieldUnitSize * CHAR_BIT;
+    int64_t memberBitOffset = isUnion ? 0 : frame->bitOffset;
+    if ((bitCount == 0) || ((memberBitOffset % unitBits) + bitCount > unitBits)) {
+      memberBitOffset = alignedOffset(memberBitOffset, unitBits);
+    }
+    if (memberBitOffset + bitCount > kMaximumTypeBitCount) {
+      frame->hasValidLayout = false;
+      return;
+    }
+    frame->largestAlignment = std::max(frame->largestAlignment, (int)rules->bitfieldUnitAlignment);
+    frame->largestMemberTypeSize = std::max(frame->largestMemberTypeSize, layout.size);
+    if (!isUnion) {
+      frame->bitOffset = memberBitOffset + bitCount;
+    }
+    return;
+  }
+
+  const int64_t byteOffset = alignedOffset((frame->bitOffset + CHAR_BIT - 1) / CHAR_BIT, layout.alignment);
+  const int64_t memberOffset = isUnion ? 0 : byteOffset;
+  if (memberOffset + layout.size > kMaximumTypeSize) {
+    frame->hasValidLayout = false;
+    return;
+  }
+  frame->largestAlignment = std::max(frame->largestAlignment, layout.alignment);
+  frame->largestMemberTypeSize = std::max(frame->largestMemberTypeSize, layout.size);
+  if (!isUnion) {
+    frame->bitOffset = (memberOffset + layout.size) * CHAR_BIT;
+  }
+}
+
+static objctk_typelayout completedTypeLayout(const objctk_scanframe *frame) {
+  if (frame->typeCategory == OBJCTKTypeCategoryArray) {
+    if (frame->elementLayout.size < 0) {
+      return invalidTypeLayout();
+    }
+    if ((frame->elementLayout.size != 0) && (frame->elementCount > (size_t)(kMaximumTypeSize / frame->elementLayout.size))) {
+      return invalidTypeLayout();
+    }
+    return makeTypeLayout((int)(frame->elementCount * frame->elementLayout.size), frame->elementLayout.alignment);
+  }
+
+  if (!frame->hasValidLayout) {
+    return invalidTypeLayout();
+  }
+  const bool isUnion = (frame->typeCategory == OBJCTKTypeCategoryUnion);
+  const int64_t size = isUnion ? frame->largestMemberTypeSize : ((frame->bitOffset + CHAR_BIT - 1) / CHAR_BIT);
+  return makeCheckedTypeLayout(alignedOffset(size, frame->largestAlignment), frame->largestAlignment);
+}
+
+objctk_statuscode objctk_getSizeAndAlignment(
+    const char *typeEncoding,
+    size_t length,
+    objctk_layoutprofile profile,
+    int *outSize,
+    int *outAlignment,
+    size_t *outEndOffset) {
+  const objctk_layoutrules *rules = layoutRulesForProfile(profile);
+  if ((typeEncoding == NULL) || (rules == NULL)) {
+    return objctk_statuscode_InvalidInput;
+  }
+
+  objctk_scanframe frames[kMaximumScanDepth];
+  int depth = 0;
+  size_t index = 0;
+  while (true) {
+    if (!consumeSkippedCharacters(typeEncoding, length, &index)) {
+      return objctk_statuscode_InvalidInput;
+    }
+    const char ch = characterAtIndex(typeEncoding, length, index);
+    if (ch == '\0') {
+      return objctk_statuscode_InvalidInput;
+    }
+    index++;
+
+    objctk_scanframe *frame = (depth > 0) ? &frames[depth - 1] : NULL;
+    const bool expectsClosingCharacter = (frame != NULL) && (frame->typeCategory == OBJCTKTypeCategoryArray) && frame->hasElementType;
+    objctk_typelayout layout;
+    int64_t bitCount = -1;
+    if ((frame != NULL) && (ch == frame->closingCharacter) && ((frame->typeCategory != OBJCTKTypeCategoryArray) || expectsClosingCharacter)) {
+      layout = completedTypeLayout(frame);
+      depth--;
+    } else if (expectsClosingCharacter) {
+      return objctk_statuscode_InvalidInput;
+    } else {
+      switch (ch) {
+        case '^':
+        case '[':
+        case '{':
+        case '(': {
+          if (depth == kMaximumScanDepth) {
+            return objctk_statuscode_InvalidInput;
+          }
+          frame = &frames[depth++];
+          if (ch == '^') {
+            *frame = makeScanFrame(OBJCTKTypeCategoryPointer, '\0');
+          } else if (ch == '[') {
+            *frame = makeScanFrame(OBJCTKTypeCategoryArray, ']');
+            frame->elementCount = consumeNumber(typeEncoding, length, &index);
+          } else {
+            const bool isStruct = (ch == '{');
+            *frame = makeScanFrame(isStruct ? OBJCTKTypeCategoryStruct : OBJCTKTypeCategoryUnion, isStruct ? '}' : ')');
+            if (!consumeTypeName(typeEncoding, length, &index)) {
+              return objctk_statuscode_InvalidInput;
+            }
+          }
+          continue;
+        }
+        case 'b':
+          bitCount = (int64_t)std::min(consumeNumber(typeEncoding, length, &index), (size_t)INT64_MAX);
+          layout = bitfieldTypeLayout(bitCount);
+          break;
+        case '@':
+          // The class name, if any, is enclosed in quotes following the '@' and blocks are encoded
+          // as "@?".
+          if (characterAtIndex(typeEncoding, length, index) == '"') {
+            index++;
+            if (!consumeThroughCharacter(typeEncoding, length, &index, '"')) {
+              return objctk_statuscode_InvalidInput;
+            }
+          } else if (characterAtIndex(typeEncoding, length, index) == '?') {
+            index++;
+          }
+          layout = scalarTypeLayout(rules, OBJCTKTypeCategoryObject);
+          break;
+        case '#':
+          layout = scalarTypeLayout(rules, OBJCTKTypeCategoryClass);
+          break;
+        case ':':
+          layout = scalarTypeLayout(rules, OBJCTKTypeCategorySelector);
+          break;
+        case '*':
+          layout = scalarTypeLayout(rules, OBJCTKTypeCategoryCharacterString);
+          break;
+        case 'v':
+          layout = scalarTypeLayout(rules, OBJCTKTypeCategoryVoid);
+          break;
+        case '?':
+          layout = scalarTypeLayout(rules, OBJCTKTypeCategoryUnknown);
+          break;
+        default: {
+          objctk_typecategory typeCategory = typeCategoryFromBasicTypeCode(ch);
+          if (typeCategory == OBJCTKTypeCategoryUnknown) {
+            return objctk_statuscode_EncounteredInvalidToken;
+          }
+          layout = scalarTypeLayout(rules, typeCategory);
+          break;
+        }
+      }
+    }
+
+    // Pointers are complete once their referenced type is, regardless of its layout.
+    while ((depth > 0) && (frames[depth - 1].typeCategory == OBJCTKTypeCategoryPointer)) {
+      depth--;
+      layout = scalarTypeLayout(rules, OBJCTKTypeCategoryPointer);
+      bitCount = -1;
+    }
+    if (depth > 0) {
+      addMemberType(&frames[depth - 1], rules, layout, bitCount);
+      continue;
+    }
+
+    if (outSize != NULL) {
+      *outSize = layout.size;
+    }
+    if (outAlignment != NULL) {
+      *outAlignment = (layout.size < 0) ? -1 : layout.alignment;
+    }
+    if (outEndOffset != NULL) {
+      *outEndOffset = index;
+    }
+    return objctk_statuscode_NoError;
+  }
+}
+
+// Advances from the opening bracket of an array, struct or union past its matching closing bracket.
+static objctk_statuscode skipBracketedType(const char *typeEncoding, const size_t length, size_t *index) {
+  char closingCharacters[kMaximumScanDepth];
+  int depth = 0;
+#if OBJCTK_HAS_STRUCTURAL_CHARACTER_MASK
+  // The length may exceed the NUL-terminated encoding, so blocks are only loaded once the encoding is
+  // known to extend over them. The encoding is measured a few blocks at a time as it is skipped.
+  const size_t measuredBlockLength = 16 * kStructuralCharacterBlockSize;
+  size_t measuredLength = *index;
+  bool hasMeasuredEnd = false;
+#endif
+  while (true) {
+#if OBJCTK_HAS_STRUCTURAL_CHARACTER_MASK
+    if (!hasMeasuredEnd && ((*index + kStructuralCharacterBlockSize) > measuredLength) && ((*index + kStructuralCharacterBlockSize) <= length)) {
+      const size_t maximumLength = std::min(length - *index, measuredBlockLength);
+      const size_t characterCount = strnlen(typeEncoding + *index, maximumLength);
+      measuredLength = *index + characterCount;
+      hasMeasuredEnd = (characterCount < maximumLength);
+    }
+    // Skip over blocks of member types until a structural character.
+    if ((*index + kStructuralCharacterBlockSize) <= std::min(length, measuredLength)) {
+      uint64_t mask = structuralCharacterMask(typeEncoding + *index);
+      if (mask == 0) {
+        *index += kStructuralCharacterBlockSize;
+        continue;
+      }
+      *index += firstStructuralCharacterIndex(mask);
+    }
+#endif
+    const char ch = characterAtIndex(typeEncoding, length, *index);
+    (*index)++;
+    switch (ch) {
+      case '\0':
+        return objctk_statuscode_InvalidInput;
+      case '{':
+      case '(':
+      case '[':
+        if (depth == kMaximumScanDepth) {
+          return objctk_statuscode_InvalidInput;
+        }
+        closingCharacters[depth++] = (ch == '{') ? '}' : ((ch == '(') ? ')' : ']');
+        if ((ch != '[') && !consumeTypeName(typeEncoding, length, index)) {
+          return objctk_statuscode_InvalidInput;
+        }
+        break;
+      case '}':
+      case ')':
+      case ']':
+        if ((depth == 0) || (closingCharacters[depth - 1] != ch)) {
+          return objctk_statuscode_InvalidInput;
+        }
+        if (--depth == 0) {
+          return objctk_statuscode_NoError;
+        }
+        break;
+      case '"':
+        // The class name of an object is enclosed in quotes following the '@'.
+        if ((*index >= 2) && (typeEncoding[*index - 2] == '@') && !consumeThroughCharacter(typeEncoding, length, index, '"')) {
+          return objctk_statuscode_InvalidInput;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// Skips the type beginning at or after an offset, storing its range.
+static objctk_statuscode skipType(const char *typeEncoding, const size_t length, size_t index, objctk_range *outRange) {
+  if (!consumeSkippedCharacters(typeEncoding, length, &index)) {
+    return objctk_statuscode_InvalidInput;
+  }
+  const size_t startOffset = index;
+  while (characterAtIndex(typeEncoding, length, index) == '^') {
+    index++;
+    if (!consumeSkippedCharacters(typeEncoding, length, &index)) {
+      return objctk_statuscode_InvalidInput;
+    }
+  }
+
+  const char ch = characterAtIndex(typeEncoding, length, index);
+  switch (ch) {
+    case '\0':
+      return objctk_statuscode_InvalidInput;
+    case '[':
+    case '{':
+    case '(': {
+      objctk_statuscode statusCode = skipBracketedType(typeEncoding, length, &index);
+      if (statusCode != objctk_statuscode_NoError) {
+        return statusCode;
+      }
+      break;
+    }
+    case '@':
+      index++;
+      if (characterAtIndex(typeEncoding, length, index) == '"') {
+        index++;
+        if (!consumeThroughCharacter(typeEncoding, length, &index, '"')) {
+          return objctk_statuscode_InvalidInput;
+        }
+      } else if (characterAtIndex(typeEncoding, length, index) == '?') {
+        index++;
+      }
+      break;
+    case 'b':
+      index++;
+      consumeNumber(typeEncoding, length, &index);
+      break;
+    case '#':
+    case ':':
+    case '*':
+    case 'v':
+    case '?':
+      index++;
+      break;
+    default:
+      if (typeCategoryFromBasicTypeCode(ch) == OBJCTKTypeCategoryUnknown) {
+        return objctk_statuscode_EncounteredInvalidToken;
+      }
+      index++;
+      break;
+  }
+  *outRange = makeRange(startOffset, index - startOffset);
+  return objctk_statuscode_NoError;
+}
+
+objctk_statuscode objctk_skipType(const char *typeEncoding, size_t length, size_t *outEndOffset) {
+  if (typeEncoding == NULL) {
+    return objctk_statuscode_InvalidInput;
+  }
+  objctk_range range;
+  objctk_statuscode statusCode = skipType(typeEncoding, length, 0, &range);
+  if ((statusCode == objctk_statuscode_NoError) && (outEndOffset != NULL)) {
+    *outEndOffset = range.offset + range.length;
+  }
+  return statusCode;
+}
+
+void objctk_typesplitter_init(objctk_typesplitter *splitter, const char *typeEncoding, size_t length) {
+  if (splitter == NULL) {
+    return;
+  }
+  splitter->typeEncoding = typeEncoding;
+  splitter->length = (typeEncoding != NULL) ? length : 0;
+  splitter->offset = 0;
+  splitter->status = objctk_statuscode_NoError;
+}
+
+bool objctk_typesplitter_next(objctk_typesplitter *splitter, objctk_range *outRange) {
+  if ((splitter == NULL) || (splitter->status != objctk_statuscode_NoError)) {
+    return false;
+  }
+
+  // Trailing type qualifiers, frame offsets and member names do not begin another type.
+  const char *typeEncoding = splitter->typeEncoding;
+  size_t offset = splitter->offset;
+  if (!consumeSkippedCharacters(typeEncoding, splitter->length, &offset)) {
+    splitter->status = objctk_statuscode_InvalidInput;
+    return false;
+  }
+  if (characterAtIndex(typeEncoding, splitter->length, offset) == '\0') {
+    splitter->offset = offset;
+    return false;
+  }
+
+  objctk_range range;
+  objctk_statuscode statusCode = skipType(typeEncoding, splitter->length, offset, &range);
+  if (statusCode != objctk_statuscode_NoError) {
+    splitter->status = statusCode;
+    return false;
+  }
+  splitter->offset = range.offset + range.length;
+  if (outRange != NULL) {
+    *outRange = range;
+  }
+  return true;
+}
+
+objctk_statuscode objctk_typesplitter_getStatusCode(const objctk_typesplitter *splitter) {
+  return (splitter != NULL) ? splitter->status : objctk_statuscode_InvalidInput;
+}
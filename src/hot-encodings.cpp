@@ -0,0 +1,430 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "hot-encodings.h"
+
+#include "internal-allocator.h"
+#include "internal-hot-encodings.h"
+#include "parser.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using namespace objctk;
+
+// Count-min sketch dimensions. Each row is indexed by a different 16-bit slice of the hash.
+static const int kSketchDepth = 4;
+static const size_t kSketchWidth = 4096;
+
+// A frequently parsed type encoding. Copies of the encodings are owned by the tracker.
+typedef struct objctk_frequentencoding {
+  uint64_t hash;
+  char *typeEncoding;
+  size_t length;
+  objctk_allocator allocator;
+  uint32_t estimatedSampleCount;
+  uint64_t timedSampleCount;
+  uint64_t nanoseconds;
+} objctk_frequentencoding;
+
+static std::atomic<uint32_t> gSketch[kSketchDepth][kSketchWidth];
+
+// The tracked encodings are guarded by a lock which sampled parses only take once their estimated
+// count reaches the threshold, the lowest count among a full set of tracked encodings.
+static std::mutex gFrequentEncodingsLock;
+static objctk_frequentencoding gFrequentEncodings[OBJCTK_FREQUENT_ENCODING_CAPACITY];
+static size_t gFrequentEncodingCount = 0;
+static std::atomic<uint32_t> gFrequentEncodingThreshold(0);
+
+typedef struct objctk_prewarmentry {
+  uint64_t hash;
+  size_t length;
+  const char *typeEncoding;
+  _objctk_typeparseresult *result;
+} objctk_prewarmentry;
+
+// A slot of a prewarm table. Slots are filled at most once, and the result is stored last so that
+// a lookup which finds the result also finds the rest of the entry.
+typedef struct objctk_prewarmslot {
+  uint64_t hash;
+  size_t length;
+  const char *typeEncoding;
+  std::atomic<_objctk_typeparseresult *> result;
+} objctk_prewarmslot;
+
+namespace objctk {
+
+// Prewarm tables are open-addressed by hash. Entries are added to the published table while it is
+// at most half full, and a table twice the size replaces it otherwise.
+struct objctk_prewarmtable {
+  // Superseded tables are retained because concurrent lookups may still be reading them. As each
+  // table is at least twice the size of the one it replaces, they take less memory in total than
+  // the current table.
+  const objctk_prewarmtable *previous;
+  size_t capacity;
+  // The number of entries, which is only accessed while prewarming.
+  size_t count;
+  // Lookups of type encodings which are longer than every prewarmed encoding or whose length
+  // modulo 64 is not in the length filter miss without hashing the type encoding, so that a miss
+  // reads at most maximumLength + 1 characters. Both are updated after the entries they describe
+  // are stored.
+  std::atomic<size_t> maximumLength;
+  std::atomic<uint64_t> lengthFilter;
+  objctk_prewarmslot slots[];
+};
+
+static inline uint64_t lengthFilterBit(const size_t length) {
+  return 1ULL << (length % 64);
+}
+
+std::atomic<unsigned int> gEncodingSamplingInterval(0);
+std::atomic<objctk_prewarmtable *> gPrewarmTable(NULL);
+
+}
+
+static std::mutex gPrewarmLock;
+
+static inline size_t sketchIndex(const uint64_t hash, const int row) {
+  return (size_t)(hash >> (row * 16)) & (kSketchWidth - 1);
+}
+
+static void releaseFrequentEncoding(objctk_frequentencoding *frequentEncoding) {
+  deallocateMemory(&frequentEncoding->allocator, frequentEncoding->typeEncoding);
+  frequentEncoding->typeEncoding = NULL;
+}
+
+// Updates the threshold after the tracked encodings change. The lock must be held.
+static void updateFrequentEncodingThreshold() {
+  uint32_t threshold = 0;
+  if (gFrequentEncodingCount == OBJCTK_FREQUENT_ENCODING_CAPACITY) {
+    threshold = UINT32_MAX;
+    for (size_t index = 0; index < gFrequentEncodingCount; index++) {
+      threshold = std::min(threshold, gFrequentEncodings[index].estimatedSampleCount);
+    }
+  }
+  gFrequentEncodingThreshold.store(threshold, std::memory_order_relaxed);
+}
+
+// Tracks a sampled encoding whose estimated count reached the threshold. The lock must be held.
+static void trackFrequentEncoding(const char *typeEncoding, const size_t length, const uint64_t hash, const uint32_t estimatedSampleCount, const uint64_t nanoseconds) {
+  objctk_frequentencoding *frequentEncoding = NULL;
+  objctk_frequentencoding *leastFrequentEncoding = NULL;
+  for (size_t index = 0; index < gFrequentEncodingCount; index++) {
+    objctk_frequentencoding *candidate = &gFrequentEncodings[index];
+    if ((candidate->hash == hash) && (candidate->length == length) && (memcmp(candidate->typeEncoding, typeEncoding, length) == 0)) {
+      frequentEncoding = candidate;
+      break;
+    }
+    if ((leastFrequentEncoding == NULL) || (candidate->estimatedSampleCount < leastFrequentEncoding->estimatedSampleCount)) {
+      leastFrequentEncoding = candidate;
+    }
+  }
+
+  if (frequentEncoding == NULL) {
+    if (gFrequentEncodingCount < OBJCTK_FREQUENT_ENCODING_CAPACITY) {
+      frequentEncoding = &gFrequentEncodings[gFrequentEncodingCount];
+    } else if (estimatedSampleCount > leastFrequentEncoding->estimatedSampleCount) {
+      frequentEncoding = leastFrequentEncoding;
+      releaseFrequentEncoding(frequentEncoding);
+    } else {
+      return;
+    }
+
+    const objctk_allocator *allocator = defaultAllocator();
+    char *typeEncodingCopy = static_cast<char *>(allocateMemory(allocator, length + 1));
+    if (typeEncodingCopy == NULL) {
+      // An evicted slot is refilled by the last tracked encoding.
+      if (frequentEncoding != &gFrequentEncodings[gFrequentEncodingCount]) {
+        *frequentEncoding = gFrequentEncodings[--gFrequentEncodingCount];
+        updateFrequentEncodingThreshold();
+      }
+      return;
+    }
+    memcpy(typeEncodingCopy, typeEncoding, length);
+    typeEncodingCopy[length] = '\0';
+    if (frequentEncoding == &gFrequentEncodings[gFrequentEncodingCount]) {
+      gFrequentEncodingCount++;
+    }
+    *frequentEncoding = {
+      .hash = hash,
+      .typeEncoding = typeEncodingCopy,
+      .length = length,
+      .allocator = *allocator,
+      .estimatedSampleCount = 0,
+      .timedSampleCount = 0,
+      .nanoseconds = 0,
+    };
+  }
+
+  frequentEncoding->estimatedSampleCount = std::max(frequentEncoding->estimatedSampleCount, estimatedSampleCount);
+  frequentEncoding->timedSampleCount++;
+  frequentEncoding->nanoseconds += nanoseconds;
+  updateFrequentEncodingThreshold();
+}
+
+namespace objctk {
+
+bool shouldSampleEncoding() {
+  static thread_local unsigned int parsesUntilSample = 0;
+  static thread_local uint32_t randomState = 0x9E3779B9;
+  if (parsesUntilSample > 0) {
+    parsesUntilSample--;
+    return false;
+  }
+  const unsigned int samplingInterval = gEncodingSamplingInterval.load(std::memory_order_relaxed);
+  if (samplingInterval <= 1) {
+    return (samplingInterval == 1);
+  }
+  // Jitter the gap between samples, averaging the sampling interval, so that workloads which
+  // repeat with the same period are not sampled at the same point every time.
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  parsesUntilSample = (unsigned int)(randomState % ((2 * (uint64_t)samplingInterval) - 1));
+  return true;
+}
+
+void recordEncodingSample(const char *typeEncoding, const size_t length, const uint64_t nanoseconds) {
+  const uint64_t hash = encodingHash(typeEncoding, length);
+  uint32_t estimatedSampleCount = UINT32_MAX;
+  for (int row = 0; row < kSketchDepth; row++) {
+    uint32_t count = gSketch[row][sketchIndex(hash, row)].fetch_add(1, std::memory_order_relaxed) + 1;
+    estimatedSampleCount = std::min(estimatedSampleCount, count);
+  }
+  if (estimatedSampleCount < gFrequentEncodingThreshold.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(gFrequentEncodingsLock);
+  trackFrequentEncoding(typeEncoding, length, hash, estimatedSampleCount, nanoseconds);
+}
+
+_objctk_typeparseresult *lookupPrewarmedParseResult(const objctk_prewarmtable *table, const char *typeEncoding) {
+  const size_t maximumLength = table->maximumLength.load(std::memory_order_acquire);
+  const size_t length = strnlen(typeEncoding, maximumLength + 1);
+  if ((length > maximumLength) || ((table->lengthFilter.load(std::memory_order_acquire) & lengthFilterBit(length)) == 0)) {
+    return NULL;
+  }
+  const uint64_t hash = encodingHash(typeEncoding, length);
+  const size_t mask = table->capacity - 1;
+  _objctk_typeparseresult *result;
+  for (size_t index = hash & mask; (result = table->slots[index].result.load(std::memory_order_acquire)) != NULL; index = (index + 1) & mask) {
+    const objctk_prewarmslot *slot = &table->slots[index];
+    if ((slot->hash == hash) && (slot->length == length) && (memcmp(slot->typeEncoding, typeEncoding, length) == 0)) {
+      return result;
+    }
+  }
+  return NULL;
+}
+
+}
+
+// Adds an entry to a table which may be published. The prewarm lock must be held.
+static void insertPrewarmEntry(objctk_prewarmtable *table, const objctk_prewarmentry *entry) {
+  const size_t mask = table->capacity - 1;
+  size_t index = entry->hash & mask;
+  while (table->slots[index].result.load(std::memory_order_relaxed) != NULL) {
+    index = (index + 1) & mask;
+  }
+  objctk_prewarmslot *slot = &table->slots[index];
+  slot->hash = entry->hash;
+  slot->length = entry->length;
+  slot->typeEncoding = entry->typeEncoding;
+  slot->result.store(entry->result, std::memory_order_release);
+  table->count++;
+  if (entry->length > table->maximumLength.load(std::memory_order_relaxed)) {
+    table->maximumLength.store(entry->length, std::memory_order_release);
+  }
+  table->lengthFilter.fetch_or(lengthFilterBit(entry->length), std::memory_order_release);
+}
+
+// Allocates an empty table of a power-of-two capacity which holds every entry of the previous table.
+static objctk_prewarmtable *makePrewarmTable(const objctk_prewarmtable *previousTable, const size_t capacity) {
+  objctk_prewarmtable *table = static_cast<objctk_prewarmtable *>(allocateMemory(defaultAllocator(), sizeof(objctk_prewarmtable) + (capacity * sizeof(objctk_prewarmslot))));
+  if (table == NULL) {
+    return NULL;
+  }
+  table->previous = previousTable;
+  table->capacity = capacity;
+  table->count = 0;
+  table->maximumLength.store(0, std::memory_order_relaxed);
+  table->lengthFilter.store(0, std::memory_order_relaxed);
+  for (size_t index = 0; index < capacity; index++) {
+    table->slots[index].result.store(NULL, std::memory_order_relaxed);
+  }
+  if (previousTable == NULL) {
+    return table;
+  }
+  for (size_t index = 0; index < previousTable->capacity; index++) {
+    const objctk_prewarmslot *slot = &previousTable->slots[index];
+    _objctk_typeparseresult *result = slot->result.load(std::memory_order_relaxed);
+    if (result != NULL) {
+      const objctk_prewarmentry entry = { slot->hash, slot->length, slot->typeEncoding, result };
+      insertPrewarmEntry(table, &entry);
+    }
+  }
+  return table;
+}
+
+// Parses a type encoding into a persistent parse result whose arena also holds a copy of the type
+// encoding.
+static bool makePrewarmEntry(const char *typeEncoding, objctk_prewarmentry *outEntry) {
+  const objctk_allocator *allocator = defaultAllocator();
+  _objctk_typeparseresult *result = makeObject<_objctk_typeparseresult>(allocator, allocator);
+  if (result == NULL) {
+    return false;
+  }
+  _objctk_typenode_stack scratchStack(allocator);
+  parseTypeEncoding(typeEncoding, result, &scratchStack, NULL);
+  const size_t length = strlen(typeEncoding);
+  char *typeEncodingCopy = (result->status.status_code == objctk_statuscode_NoError) ? result->arena.makeArray<char>(length + 1) : NULL;
+  if (typeEncodingCopy == NULL) {
+    releaseObject(allocator, result);
+    return false;
+  }
+  memcpy(typeEncodingCopy, typeEncoding, length + 1);
+  result->is_persistent = true;
+  *outEntry = {
+    .hash = encodingHash(typeEncoding, length),
+    .length = length,
+    .typeEncoding = typeEncodingCopy,
+    .result = result,
+  };
+  return true;
+}
+
+void objctk_setEncodingSamplingInterval(unsigned int samplingInterval) {
+  gEncodingSamplingInterval.store(samplingInterval, std::memory_order_relaxed);
+}
+
+unsigned int objctk_getEncodingSamplingInterval(void) {
+  return gEncodingSamplingInterval.load(std::memory_order_relaxed);
+}
+
+void objctk_enumerateFrequentEncodings(size_t maximumCount, objctk_frequentencodingfunction function, void *context) {
+  if ((function == NULL) || (maximumCount == 0)) {
+    return;
+  }
+
+  // Copy the tracked encodings so that the function is called without holding the lock.
+  const objctk_allocator *allocator = defaultAllocator();
+  objctk_frequentencoding *frequentEncodings = NULL;
+  size_t count = 0;
+  {
+    std::lock_guard<std::mutex> lock(gFrequentEncodingsLock);
+    size_t byteCount = gFrequentEncodingCount * sizeof(objctk_frequentencoding);
+    for (size_t index = 0; index < gFrequentEncodingCount; index++) {
+      byteCount += gFrequentEncodings[index].length + 1;
+    }
+    frequentEncodings = static_cast<objctk_frequentencoding *>(allocateMemory(allocator, byteCount));
+    if (frequentEncodings == NULL) {
+      return;
+    }
+    char *characters = reinterpret_cast<char *>(frequentEncodings + gFrequentEncodingCount);
+    for (count = 0; count < gFrequentEncodingCount; count++) {
+      frequentEncodings[count] = gFrequentEncodings[count];
+      frequentEncodings[count].typeEncoding = characters;
+      memcpy(characters, gFrequentEncodings[count].typeEncoding, gFrequentEncodings[count].length + 1);
+      characters += gFrequentEncodings[count].length + 1;
+    }
+  }
+
+  std::sort(frequentEncodings, frequentEncodings + count, [](const objctk_frequentencoding &lhs, const objctk_frequentencoding &rhs) {
+    return lhs.estimatedSampleCount > rhs.estimatedSampleCount;
+  });
+  const uint64_t samplingInterval = std::max(1U, gEncodingSamplingInterval.load(std::memory_order_relaxed));
+  for (size_t index = 0; index < std::min(count, maximumCount); index++) {
+    const objctk_frequentencoding *frequentEncoding = &frequentEncodings[index];
+    uint64_t averageNanoseconds = (frequentEncoding->timedSampleCount > 0) ? (frequentEncoding->nanoseconds / frequentEncoding->timedSampleCount) : 0;
+    function(frequentEncoding->typeEncoding, frequentEncoding->estimatedSampleCount * samplingInterval, averageNanoseconds, context);
+  }
+  deallocateMemory(allocator, frequentEncodings);
+}
+
+void objctk_resetEncodingFrequencies(void) {
+  std::lock_guard<std::mutex> lock(gFrequentEncodingsLock);
+  for (int row = 0; row < kSketchDepth; row++) {
+    for (size_t column = 0; column < kSketchWidth; column++) {
+      gSketch[row][column].store(0, std::memory_order_relaxed);
+    }
+  }
+  for (size_t index = 0; index < gFrequentEncodingCount; index++) {
+    releaseFrequentEncoding(&gFrequentEncodings[index]);
+  }
+  gFrequentEncodingCount = 0;
+  updateFrequentEncodingThreshold();
+}
+
+size_t objctk_prewarmTypeEncodings(const char *const *typeEncodings, size_t count) {
+  if ((typeEncodings == NULL) || (count == 0)) {
+    return 0;
+  }
+
+  // Tables are kept at most half full. A table which cannot take every new entry is replaced by one
+  // of at least twice its capacity, so that prewarming in many small calls neither copies the
+  // entries nor retains superseded tables more than a constant number of times over.
+  std::lock_guard<std::mutex> lock(gPrewarmLock);
+  objctk_prewarmtable *previousTable = gPrewarmTable.load(std::memory_order_relaxed);
+  const size_t previousCount = (previousTable != NULL) ? previousTable->count : 0;
+  objctk_prewarmtable *table = previousTable;
+  if ((previousTable == NULL) || ((2 * (previousCount + count)) > previousTable->capacity)) {
+    size_t capacity = (previousTable != NULL) ? (2 * previousTable->capacity) : 16;
+    while (capacity < (2 * (previousCount + count))) {
+      capacity *= 2;
+    }
+    table = makePrewarmTable(previousTable, capacity);
+    if (table == NULL) {
+      return 0;
+    }
+  }
+
+  size_t prewarmedCount = 0;
+  for (size_t index = 0; index < count; index++) {
+    const char *typeEncoding = typeEncodings[index];
+    if (typeEncoding == NULL) {
+      continue;
+    }
+    objctk_prewarmentry entry;
+    if ((lookupPrewarmedParseResult(table, typeEncoding) == NULL) && makePrewarmEntry(typeEncoding, &entry)) {
+      insertPrewarmEntry(table, &entry);
+    }
+    if (lookupPrewarmedParseResult(table, typeEncoding) != NULL) {
+      prewarmedCount++;
+    }
+  }
+
+  if (table != previousTable) {
+    gPrewarmTable.store(table, std::memory_order_release);
+  }
+  return prewarmedCount;
+}
+
+objctk_typeparseresult objctk_getPrewarmedParseResult(const char *typeEncoding) {
+  if (typeEncoding == NULL) {
+    return NULL;
+  }
+  return prewarmedParseResult(typeEncoding);
+}
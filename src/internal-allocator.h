@@ -0,0 +1,128 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_INTERNAL_ALLOCATOR__
+#define OBJCTK_INTERNAL_ALLOCATOR__
+
+#include "allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <new>
+#include <utility>
+
+namespace objctk {
+
+/** Returns the process-wide default allocator. */
+const objctk_allocator *defaultAllocator();
+
+static inline void *allocateMemory(const objctk_allocator *allocator, const size_t size) {
+  return allocator->allocate(allocator->context, size);
+}
+
+static inline void *reallocateMemory(const objctk_allocator *allocator, void *pointer, const size_t size) {
+  return allocator->reallocate(allocator->context, pointer, size);
+}
+
+static inline void deallocateMemory(const objctk_allocator *allocator, void *pointer) {
+  if (pointer != NULL) {
+    allocator->deallocate(allocator->context, pointer);
+  }
+}
+
+/** Allocates and constructs an object with an allocator, returning NULL on failure. */
+template <typename T, typename... Arguments>
+T *makeObject(const objctk_allocator *allocator, Arguments&&... arguments) {
+  void *memory = allocateMemory(allocator, sizeof(T));
+  if (memory == NULL) {
+    return NULL;
+  }
+  return new (memory) T(std::forward<Arguments>(arguments)...);
+}
+
+/** Destroys and deallocates an object allocated with makeObject. */
+template <typename T>
+void releaseObject(const objctk_allocator *allocator, T *object) {
+  if (object == NULL) {
+    return;
+  }
+  object->~T();
+  deallocateMemory(allocator, object);
+}
+
+/**
+ * A growable stack of trivially copyable values whose storage is obtained from an allocator.
+ * Clearing the stack retains its capacity.
+ */
+template <typename T>
+class scratchstack {
+  objctk_allocator m_allocator;
+  T *m_values;
+  size_t m_count;
+  size_t m_capacity;
+
+  bool grow() {
+    size_t capacity = (m_capacity == 0) ? 16 : (m_capacity * 2);
+    T *values = static_cast<T *>(reallocateMemory(&m_allocator, m_values, capacity * sizeof(T)));
+    if (values == NULL) {
+      return false;
+    }
+    m_values = values;
+    m_capacity = capacity;
+    return true;
+  }
+
+public:
+  explicit scratchstack(const objctk_allocator *allocator) : m_allocator(*allocator), m_values(NULL), m_count(0), m_capacity(0) {}
+  ~scratchstack() { deallocateMemory(&m_allocator, m_values); }
+
+  scratchstack(const scratchstack &) = delete;
+  scratchstack &operator=(const scratchstack &) = delete;
+
+  /** Pushes a value onto the stack, returning false if the stack could not grow. */
+  bool push_back(const T value) {
+    if ((m_count == m_capacity) && !grow()) {
+      return false;
+    }
+    m_values[m_count++] = value;
+    return true;
+  }
+
+  void pop_back() { --m_count; }
+  T back() const { return m_values[m_count - 1]; }
+  T *begin() { return m_values; }
+  T *end() { return m_values + m_count; }
+  const T *begin() const { return m_values; }
+  const T *end() const { return m_values + m_count; }
+  size_t size() const { return m_count; }
+  bool empty() const { return m_count == 0; }
+
+  /** Shrinks the stack to the given size. */
+  void resize(const size_t count) { m_count = (count < m_count) ? count : m_count; }
+  void clear() { m_count = 0; }
+};
+
+}
+
+#endif
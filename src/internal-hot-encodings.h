@@ -0,0 +1,89 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_INTERNAL_HOT_ENCODINGS__
+#define OBJCTK_INTERNAL_HOT_ENCODINGS__
+
+#include "hot-encodings.h"
+
+#include "internal-statistics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+namespace objctk {
+
+struct objctk_prewarmtable;
+
+extern std::atomic<unsigned int> gEncodingSamplingInterval;
+extern std::atomic<objctk_prewarmtable *> gPrewarmTable;
+
+/** Returns whether parses should be sampled to track frequently parsed type encodings. */
+static inline bool encodingSamplingEnabled() {
+#if OBJCTK_ENABLE_STATISTICS
+  return gEncodingSamplingInterval.load(std::memory_order_relaxed) != 0;
+#else
+  return false;
+#endif
+}
+
+/** Returns whether the next parse on the calling thread should be sampled. */
+bool shouldSampleEncoding();
+
+/** Counts a sampled parse of a type encoding which took the given number of nanoseconds. */
+void recordEncodingSample(const char *typeEncoding, size_t length, uint64_t nanoseconds);
+
+/** Hashes the characters of a type encoding a word at a time. */
+static inline uint64_t encodingHash(const char *typeEncoding, const size_t length) {
+  uint64_t hash = 0x9E3779B97F4A7C15ULL ^ length;
+  size_t offset = 0;
+  for (; (offset + sizeof(uint64_t)) <= length; offset += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, typeEncoding + offset, sizeof(word));
+    hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 31;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, typeEncoding + offset, length - offset);
+  hash = (hash ^ tail) * 0x94D049BB133111EBULL;
+  return hash ^ (hash >> 29);
+}
+
+/** Returns the persistent parse result of a type encoding in a prewarm table or NULL. */
+_objctk_typeparseresult *lookupPrewarmedParseResult(const objctk_prewarmtable *table, const char *typeEncoding);
+
+/** Returns the persistent parse result of a prewarmed type encoding or NULL. */
+static inline _objctk_typeparseresult *prewarmedParseResult(const char *typeEncoding) {
+  const objctk_prewarmtable *table = gPrewarmTable.load(std::memory_order_acquire);
+  if (table == NULL) {
+    return NULL;
+  }
+  return lookupPrewarmedParseResult(table, typeEncoding);
+}
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_INTERNAL_STATISTICS__
+#define OBJCTK_INTERNAL_STATISTICS__
+
+#include "statistics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#if !defined(OBJCTK_ENABLE_STATISTICS)
+#  define OBJCTK_ENABLE_STATISTICS 1
+#endif
+
+namespace objctk {
+
+/** The measurements taken while parsing a single type encoding. */
+typedef struct objctk_parsesample {
+  bool failed;
+  uint64_t inputByteCount;
+  uint64_t tokenCount;
+  uint64_t nodeCount;
+  uint64_t retainedByteCount;
+  uint64_t nanoseconds;
+} objctk_parsesample;
+
+extern std::atomic<bool> gStatisticsEnabled;
+
+/** Returns whether parse samples should be recorded. */
+static inline bool statisticsEnabled() {
+#if OBJCTK_ENABLE_STATISTICS
+  return gStatisticsEnabled.load(std::memory_order_relaxed);
+#else
+  return false;
+#endif
+}
+
+/** Returns a monotonic timestamp in nanoseconds. */
+uint64_t statisticsTimestamp();
+
+/** Adds a parse sample to the statistics shard of the calling thread. */
+void recordParseSample(const objctk_parsesample *sample);
+
+}
+
+#endif
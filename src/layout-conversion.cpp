@@ -0,0 +1,673 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "layout-conversion.h"
+
+#include "internal-allocator.h"
+#include "layout.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace objctk;
+
+// The number of values converted at a time. Each operation is applied across a block of values
+// before the next so that its loop runs at constant strides over memory which stays in cache.
+static const size_t kConversionBlockValueCount = 64;
+
+enum objctk_conversionkind : unsigned char {
+  // Copies bytes whose representation is identical in both layouts.
+  OBJCTKConversionKindCopy,
+
+  // Sign or zero extends or truncates an integer.
+  OBJCTKConversionKindInteger,
+
+  // Translates a pointer and resizes it.
+  OBJCTKConversionKindPointer,
+
+  // Moves a bitfield to a different bit offset.
+  OBJCTKConversionKindBitField,
+};
+
+/**
+ * An operation of a conversion plan, repeated count times at constant strides from the offsets of
+ * its first occurrence. The whole run of repetitions is itself repeated outerCount times at the
+ * outer strides, which is how the elements of an array repeat operations that do not tile an
+ * element. Offsets and strides of bitfields are measured in bits and all others in bytes.
+ */
+typedef struct objctk_conversionop {
+  objctk_conversionkind kind;
+  bool isSigned;
+  unsigned char sourceSize;
+  unsigned char destinationSize;
+  // The number of bytes copied or the width of a bitfield in bits.
+  size_t length;
+  size_t sourceOffset;
+  size_t destinationOffset;
+  size_t count;
+  size_t sourceStride;
+  size_t destinationStride;
+  size_t outerCount;
+  size_t outerSourceStride;
+  size_t outerDestinationStride;
+} objctk_conversionop;
+
+struct _objctk_layoutconversion {
+  objctk_allocator allocator;
+  size_t sourceValueSize;
+  size_t destinationValueSize;
+  // Whether destination values contain bytes which are not written by any operation, or bitfields
+  // which are merged into their bytes, and must therefore be zeroed first.
+  bool zeroesDestination;
+  size_t operationCount;
+  const objctk_conversionop *operations;
+};
+
+typedef scratchstack<objctk_conversionop> objctk_operationstack;
+
+static inline bool isPointerTypeCategory(const objctk_typecategory typeCategory) {
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryCharacterString:
+    case OBJCTKTypeCategoryObject:
+    case OBJCTKTypeCategoryClass:
+    case OBJCTKTypeCategorySelector:
+    case OBJCTKTypeCategoryPointer:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static inline bool isIntegerTypeCategory(const objctk_typecategory typeCategory, bool *outIsSigned) {
+  switch (typeCategory) {
+    case OBJCTKTypeCategorySignedChar:
+    case OBJCTKTypeCategorySignedShort:
+    case OBJCTKTypeCategorySignedInt:
+    case OBJCTKTypeCategorySignedLong:
+    case OBJCTKTypeCategorySignedLongLong:
+      *outIsSigned = true;
+      return true;
+    case OBJCTKTypeCategoryUnsignedChar:
+    case OBJCTKTypeCategoryUnsignedShort:
+    case OBJCTKTypeCategoryUnsignedInt:
+    case OBJCTKTypeCategoryUnsignedLong:
+    case OBJCTKTypeCategoryUnsignedLongLong:
+    case OBJCTKTypeCategoryBool:
+      *outIsSigned = false;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static inline objctk_conversionop makeConversionOperation(const objctk_conversionkind kind, const size_t length, const size_t sourceOffset, const size_t destinationOffset) {
+  objctk_conversionop operation = {
+    .kind = kind,
+    .isSigned = false,
+    .sourceSize = 0,
+    .destinationSize = 0,
+    .length = length,
+    .sourceOffset = sourceOffset,
+    .destinationOffset = destinationOffset,
+    .count = 1,
+    .sourceStride = 0,
+    .destinationStride = 0,
+    .outerCount = 1,
+    .outerSourceStride = 0,
+    .outerDestinationStride = 0,
+  };
+  return operation;
+}
+
+static inline bool haveSameShape(const objctk_conversionop *operation, const objctk_conversionop *otherOperation) {
+  return (operation->kind == otherOperation->kind) && (operation->isSigned == otherOperation->isSigned) && (operation->sourceSize == otherOperation->sourceSize) && (operation->destinationSize == otherOperation->destinationSize) && (operation->length == otherOperation->length);
+}
+
+// Appends an operation, merging it into the previous operation when it extends a run of bytes
+// copied or continues a stride of operations of the same shape.
+static bool appendOperation(objctk_operationstack *operations, const objctk_conversionop operation) {
+  if ((operations->size() > 0) && (operation.count == 1) && (operation.outerCount == 1) && (operations->back().outerCount == 1)) {
+    objctk_conversionop *previous = operations->end() - 1;
+    if ((previous->kind == OBJCTKConversionKindCopy) && (operation.kind == OBJCTKConversionKindCopy) && (previous->count == 1) &&
+        (operation.sourceOffset == (previous->sourceOffset + previous->length)) && (operation.destinationOffset == (previous->destinationOffset + previous->length))) {
+      previous->length += operation.length;
+      return true;
+    }
+    if (haveSameShape(previous, &operation)) {
+      if ((previous->count == 1) && (operation.sourceOffset > previous->sourceOffset) && (operation.destinationOffset > previous->destinationOffset)) {
+        previous->sourceStride = operation.sourceOffset - previous->sourceOffset;
+        previous->destinationStride = operation.destinationOffset - previous->destinationOffset;
+        previous->count = 2;
+        return true;
+      }
+      if ((previous->count > 1) && (operation.sourceOffset == (previous->sourceOffset + (previous->count * previous->sourceStride))) &&
+          (operation.destinationOffset == (previous->destinationOffset + (previous->count * previous->destinationStride)))) {
+        previous->count++;
+        return true;
+      }
+    }
+  }
+  return operations->push_back(operation);
+}
+
+static bool appendConversionOperations(_objctk_typenode *node, const objctk_layoutrules *sourceRules, const objctk_layoutrules *destinationRules, const size_t sourceOffset, const size_t destinationOffset, objctk_operationstack *operations);
+
+static bool appendBitFieldOperation(bitfieldnode *bitFieldNode, const size_t sourceBitOffset, const size_t destinationBitOffset, objctk_operationstack *operations) {
+  const size_t bitCount = bitFieldNode->bitCount();
+  if (bitCount == 0) {
+    return true;
+  }
+  // Bitfields are moved through a 64-bit word.
+  if ((((sourceBitOffset % CHAR_BIT) + bitCount) > 64) || (((destinationBitOffset % CHAR_BIT) + bitCount) > 64)) {
+    return false;
+  }
+  return appendOperation(operations, makeConversionOperation(OBJCTKConversionKindBitField, bitCount, sourceBitOffset, destinationBitOffset));
+}
+
+static bool appendStructOperations(compositetypenode *compositeTypeNode, const objctk_layoutrules *sourceRules, const objctk_layoutrules *destinationRules, const size_t sourceOffset, const size_t destinationOffset, objctk_operationstack *operations) {
+  // Record the bit offsets of the members in the source layout and pair them with the members as
+  // they are laid out in the destination layout.
+  scratchstack<size_t> sourceBitOffsets(defaultAllocator());
+  bool succeeded = true;
+  objctk_typelayout sourceLayout = compositeTypeNode->layoutMembers(sourceRules, [&](_objctk_typenode *, int offset, int bitOffset) {
+    succeeded = succeeded && sourceBitOffsets.push_back((offset * CHAR_BIT) + bitOffset);
+  });
+  if (!succeeded || (sourceLayout.size < 0)) {
+    return false;
+  }
+
+  size_t memberIndex = 0;
+  objctk_typelayout destinationLayout = compositeTypeNode->layoutMembers(destinationRules, [&](_objctk_typenode *memberTypeNode, int offset, int bitOffset) {
+    const size_t sourceBitOffset = sourceBitOffsets.begin()[memberIndex++];
+    if (!succeeded) {
+      return;
+    }
+    if (memberTypeNode->typeCategory() == OBJCTKTypeCategoryBitField) {
+      size_t destinationBitOffset = (offset * CHAR_BIT) + bitOffset;
+      succeeded = appendBitFieldOperation(static_cast<bitfieldnode *>(memberTypeNode), (sourceOffset * CHAR_BIT) + sourceBitOffset, (destinationOffset * CHAR_BIT) + destinationBitOffset, operations);
+    } else {
+      succeeded = appendConversionOperations(memberTypeNode, sourceRules, destinationRules, sourceOffset + (sourceBitOffset / CHAR_BIT), destinationOffset + offset, operations);
+    }
+  });
+  return succeeded && (destinationLayout.size >= 0);
+}
+
+// Unions are copied as a whole, which is only correct if every member is laid out identically in
+// both layouts. Unions with pointer members are rejected because copying them would bypass the
+// pointer translation function for whichever member is active.
+static bool appendUnionOperations(compositetypenode *compositeTypeNode, const objctk_layoutrules *sourceRules, const objctk_layoutrules *destinationRules, const size_t sourceOffset, const size_t destinationOffset, objctk_operationstack *operations) {
+  objctk_typelayout sourceLayout = compositeTypeNode->typeLayout(sourceRules->profile);
+  objctk_typelayout destinationLayout = compositeTypeNode->typeLayout(destinationRules->profile);
+  if ((sourceLayout.size < 0) || (sourceLayout.size != destinationLayout.size)) {
+    return false;
+  }
+
+  objctk_operationstack memberOperations(defaultAllocator());
+  if (!appendStructOperations(compositeTypeNode, sourceRules, destinationRules, 0, 0, &memberOperations)) {
+    return false;
+  }
+  for (const objctk_conversionop *operation = memberOperations.begin(); operation != memberOperations.end(); operation++) {
+    bool isIdentical = (operation->sourceOffset == operation->destinationOffset) && (operation->sourceStride == operation->destinationStride) &&
+        (operation->outerSourceStride == operation->outerDestinationStride) && (operation->sourceSize == operation->destinationSize);
+    if (!isIdentical || (operation->kind == OBJCTKConversionKindInteger) || (operation->kind == OBJCTKConversionKindPointer)) {
+      return false;
+    }
+  }
+  if (sourceLayout.size == 0) {
+    return true;
+  }
+  return appendOperation(operations, makeConversionOperation(OBJCTKConversionKindCopy, sourceLayout.size, sourceOffset, destinationOffset));
+}
+
+static bool appendArrayOperations(arraynode *arrayNode, const objctk_layoutrules *sourceRules, const objctk_layoutrules *destinationRules, const size_t sourceOffset, const size_t destinationOffset, objctk_operationstack *operations) {
+  _objctk_typenode *elementTypeNode = arrayNode->referencedType();
+  objctk_typelayout sourceElementLayout = elementTypeNode->typeLayout(sourceRules->profile);
+  objctk_typelayout destinationElementLayout = elementTypeNode->typeLayout(destinationRules->profile);
+  if ((sourceElementLayout.size < 0) || (destinationElementLayout.size < 0)) {
+    return false;
+  }
+  // Arrays too large for a valid layout in either profile cannot be converted.
+  if ((arrayNode->typeLayout(sourceRules->profile).size < 0) || (arrayNode->typeLayout(destinationRules->profile).size < 0)) {
+    return false;
+  }
+  const size_t elementCount = arrayNode->elementCount();
+  if ((elementCount == 0) || (sourceElementLayout.size == 0)) {
+    return true;
+  }
+
+  objctk_operationstack elementOperations(defaultAllocator());
+  if (!appendConversionOperations(elementTypeNode, sourceRules, destinationRules, 0, 0, &elementOperations)) {
+    return false;
+  }
+
+  // Elements copied as a whole are copied as one run.
+  const objctk_conversionop *firstOperation = elementOperations.begin();
+  if ((elementOperations.size() == 1) && (firstOperation->kind == OBJCTKConversionKindCopy) && (firstOperation->count == 1) &&
+      (firstOperation->length == (size_t)sourceElementLayout.size) && (sourceElementLayout.size == destinationElementLayout.size)) {
+    return appendOperation(operations, makeConversionOperation(OBJCTKConversionKindCopy, elementCount * sourceElementLayout.size, sourceOffset, destinationOffset));
+  }
+
+  // Each operation of an element whose repetitions tile the element repeats across the array at
+  // the element strides. Operations whose repetitions do not tile the element repeat at the element
+  // strides as their outer repetitions. Operations whose outer repetitions do not tile the element
+  // either, which only arise from arrays nested three deep, are replicated for every element.
+  for (const objctk_conversionop *elementOperation = elementOperations.begin(); elementOperation != elementOperations.end(); elementOperation++) {
+    const size_t scale = (elementOperation->kind == OBJCTKConversionKindBitField) ? CHAR_BIT : 1;
+    const size_t sourceElementStride = sourceElementLayout.size * scale;
+    const size_t destinationElementStride = destinationElementLayout.size * scale;
+    objctk_conversionop operation = *elementOperation;
+    operation.sourceOffset += sourceOffset * scale;
+    operation.destinationOffset += destinationOffset * scale;
+    const bool tilesElement = (operation.count == 1) || (((operation.count * operation.sourceStride) == sourceElementStride) && ((operation.count * operation.destinationStride) == destinationElementStride));
+    if ((operation.outerCount == 1) && tilesElement) {
+      if (operation.count == 1) {
+        operation.sourceStride = sourceElementStride;
+        operation.destinationStride = destinationElementStride;
+      }
+      operation.count *= elementCount;
+      if (!appendOperation(operations, operation)) {
+        return false;
+      }
+      continue;
+    }
+    if (operation.outerCount == 1) {
+      operation.outerCount = elementCount;
+      operation.outerSourceStride = sourceElementStride;
+      operation.outerDestinationStride = destinationElementStride;
+      if (!appendOperation(operations, operation)) {
+        return false;
+      }
+      continue;
+    }
+    if (((operation.outerCount * operation.outerSourceStride) == sourceElementStride) && ((operation.outerCount * operation.outerDestinationStride) == destinationElementStride)) {
+      operation.outerCount *= elementCount;
+      if (!appendOperation(operations, operation)) {
+        return false;
+      }
+      continue;
+    }
+    for (size_t elementIndex = 0; elementIndex < elementCount; elementIndex++) {
+      if (!appendOperation(operations, operation)) {
+        return false;
+      }
+      operation.sourceOffset += sourceElementStride;
+      operation.destinationOffset += destinationElementStride;
+    }
+  }
+  return true;
+}
+
+static bool appendConversionOperations(_objctk_typenode *node, const objctk_layoutrules *sourceRules, const objctk_layoutrules *destinationRules, const size_t sourceOffset, const size_t destinationOffset, objctk_operationstack *operations) {
+  const objctk_typecategory typeCategory = node->typeCategory();
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryTopLevel:
+      return appendStructOperations(static_cast<compositetypenode *>(node), sourceRules, destinationRules, sourceOffset, destinationOffset, operations);
+    case OBJCTKTypeCategoryUnion:
+      return appendUnionOperations(static_cast<compositetypenode *>(node), sourceRules, destinationRules, sourceOffset, destinationOffset, operations);
+    case OBJCTKTypeCategoryArray:
+      return appendArrayOperations(static_cast<arraynode *>(node), sourceRules, destinationRules, sourceOffset, destinationOffset, operations);
+    case OBJCTKTypeCategoryBitField:
+      // Bitfields are only laid out as members of composite types.
+      return false;
+    default:
+      break;
+  }
+
+  objctk_typelayout sourceLayout = node->typeLayout(sourceRules->profile);
+  objctk_typelayout destinationLayout = node->typeLayout(destinationRules->profile);
+  if ((sourceLayout.size < 0) || (destinationLayout.size < 0)) {
+    return false;
+  }
+  bool isSigned = false;
+  objctk_conversionop operation;
+  if (isPointerTypeCategory(typeCategory)) {
+    operation = makeConversionOperation(OBJCTKConversionKindPointer, 0, sourceOffset, destinationOffset);
+  } else if (sourceLayout.size == destinationLayout.size) {
+    if (sourceLayout.size == 0) {
+      return true;
+    }
+    return appendOperation(operations, makeConversionOperation(OBJCTKConversionKindCopy, sourceLayout.size, sourceOffset, destinationOffset));
+  } else if (isIntegerTypeCategory(typeCategory, &isSigned)) {
+    operation = makeConversionOperation(OBJCTKConversionKindInteger, 0, sourceOffset, destinationOffset);
+    operation.isSigned = isSigned;
+  } else {
+    return false;
+  }
+  if ((sourceLayout.size > 8) || (destinationLayout.size > 8)) {
+    return false;
+  }
+  operation.sourceSize = (unsigned char)sourceLayout.size;
+  operation.destinationSize = (unsigned char)destinationLayout.size;
+  return appendOperation(operations, operation);
+}
+
+static inline uint64_t loadInteger(const char *address, const size_t size, const bool isSigned) {
+  // Both layouts are little-endian, so the value occupies the low bytes of the word. Common sizes
+  // are loaded with fixed-size copies, which compile to single loads.
+  if (size == sizeof(uint32_t)) {
+    uint32_t value;
+    memcpy(&value, address, sizeof(value));
+    return isSigned ? (uint64_t)(int64_t)(int32_t)value : value;
+  }
+  uint64_t value = 0;
+  if (size == sizeof(uint64_t)) {
+    memcpy(&value, address, sizeof(value));
+    return value;
+  }
+  memcpy(&value, address, size);
+  if (isSigned) {
+    const int shift = (int)(sizeof(uint64_t) - size) * CHAR_BIT;
+    value = (uint64_t)(((int64_t)(value << shift)) >> shift);
+  }
+  return value;
+}
+
+static inline void storeInteger(char *address, const size_t size, const uint64_t value) {
+  if (size == sizeof(uint32_t)) {
+    uint32_t truncatedValue = (uint32_t)value;
+    memcpy(address, &truncatedValue, sizeof(truncatedValue));
+  } else if (size == sizeof(uint64_t)) {
+    memcpy(address, &value, sizeof(value));
+  } else {
+    memcpy(address, &value, size);
+  }
+}
+
+static inline void copyBytes(char *destination, const char *source, const size_t length) {
+  switch (length) {
+    case 1:
+      *destination = *source;
+      break;
+    case 2:
+      memcpy(destination, source, 2);
+      break;
+    case 4:
+      memcpy(destination, source, 4);
+      break;
+    case 8:
+      memcpy(destination, source, 8);
+      break;
+    case 16:
+      memcpy(destination, source, 16);
+      break;
+    default:
+      memcpy(destination, source, length);
+      break;
+  }
+}
+
+// Extends or truncates a contiguous run of integers four at a time. Returns the number of integers
+// converted.
+static size_t convertIntegerRun(const char *source, char *destination, const objctk_conversionop *operation) {
+  size_t index = 0;
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+  if ((operation->sourceStride != operation->sourceSize) || (operation->destinationStride != operation->destinationSize)) {
+    return 0;
+  }
+  if ((operation->sourceSize == 4) && (operation->destinationSize == 8)) {
+    for (; (index + 4) <= operation->count; index += 4) {
+      const char *sourceAddress = source + (index * 4);
+      char *destinationAddress = destination + (index * 8);
+#if defined(__SSE2__)
+      __m128i values = _mm_loadu_si128((const __m128i *)sourceAddress);
+      __m128i highBits = operation->isSigned ? _mm_srai_epi32(values, 31) : _mm_setzero_si128();
+      _mm_storeu_si128((__m128i *)destinationAddress, _mm_unpacklo_epi32(values, highBits));
+      _mm_storeu_si128((__m128i *)(destinationAddress + 16), _mm_unpackhi_epi32(values, highBits));
+#else
+      if (operation->isSigned) {
+        int32x4_t values = vld1q_s32((const int32_t *)sourceAddress);
+        vst1q_s64((int64_t *)destinationAddress, vmovl_s32(vget_low_s32(values)));
+        vst1q_s64((int64_t *)(destinationAddress + 16), vmovl_high_s32(values));
+      } else {
+        uint32x4_t values = vld1q_u32((const uint32_t *)sourceAddress);
+        vst1q_u64((uint64_t *)destinationAddress, vmovl_u32(vget_low_u32(values)));
+        vst1q_u64((uint64_t *)(destinationAddress + 16), vmovl_high_u32(values));
+      }
+#endif
+    }
+  } else if ((operation->sourceSize == 8) && (operation->destinationSize == 4)) {
+    for (; (index + 4) <= operation->count; index += 4) {
+      const char *sourceAddress = source + (index * 8);
+      char *destinationAddress = destination + (index * 4);
+#if defined(__SSE2__)
+      __m128i lowValues = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)sourceAddress), _MM_SHUFFLE(2, 0, 2, 0));
+      __m128i highValues = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(sourceAddress + 16)), _MM_SHUFFLE(2, 0, 2, 0));
+      _mm_storeu_si128((__m128i *)destinationAddress, _mm_unpacklo_epi64(lowValues, highValues));
+#else
+      uint32x2_t lowValues = vmovn_u64(vld1q_u64((const uint64_t *)sourceAddress));
+      uint32x2_t highValues = vmovn_u64(vld1q_u64((const uint64_t *)(sourceAddress + 16)));
+      vst1q_u32((uint32_t *)destinationAddress, vcombine_u32(lowValues, highValues));
+#endif
+    }
+  }
+#endif
+  return index;
+}
+
+// Calls a function with the source and destination addresses of each value of a block.
+template <typename Function>
+static inline void forEachValue(const char *sourceValues, char *destinationValues, const size_t valueCount, const size_t sourceValueSize, const size_t destinationValueSize, Function function) {
+  for (size_t valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+    function(sourceValues + (valueIndex * sourceValueSize), destinationValues + (valueIndex * destinationValueSize));
+  }
+}
+
+static void applyInnerOperation(
+    const objctk_conversionop *operation,
+    const char *sourceValues,
+    char *destinationValues,
+    const size_t valueCount,
+    const size_t sourceValueSize,
+    const size_t destinationValueSize,
+    objctk_pointertranslationfunction pointerTranslationFunction,
+    void *context) {
+  const char *sourceBase = sourceValues + operation->sourceOffset;
+  char *destinationBase = destinationValues + operation->destinationOffset;
+  switch (operation->kind) {
+    case OBJCTKConversionKindCopy:
+      forEachValue(sourceBase, destinationBase, valueCount, sourceValueSize, destinationValueSize, [&](const char *source, char *destination) {
+        for (size_t index = 0; index < operation->count; index++) {
+          copyBytes(destination + (index * operation->destinationStride), source + (index * operation->sourceStride), operation->length);
+        }
+      });
+      break;
+    case OBJCTKConversionKindInteger:
+      forEachValue(sourceBase, destinationBase, valueCount, sourceValueSize, destinationValueSize, [&](const char *source, char *destination) {
+        for (size_t index = convertIntegerRun(source, destination, operation); index < operation->count; index++) {
+          uint64_t value = loadInteger(source + (index * operation->sourceStride), operation->sourceSize, operation->isSigned);
+          storeInteger(destination + (index * operation->destinationStride), operation->destinationSize, value);
+        }
+      });
+      break;
+    case OBJCTKConversionKindPointer:
+      forEachValue(sourceBase, destinationBase, valueCount, sourceValueSize, destinationValueSize, [&](const char *source, char *destination) {
+        for (size_t index = 0; index < operation->count; index++) {
+          uint64_t pointer = loadInteger(source + (index * operation->sourceStride), operation->sourceSize, false);
+          if ((pointer != 0) && (pointerTranslationFunction != NULL)) {
+            pointer = pointerTranslationFunction(pointer, context);
+          }
+          storeInteger(destination + (index * operation->destinationStride), operation->destinationSize, pointer);
+        }
+      });
+      break;
+    case OBJCTKConversionKindBitField: {
+      // Bitfield offsets are measured in bits from the start of each value.
+      const uint64_t mask = (operation->length < 64) ? ((UINT64_C(1) << operation->length) - 1) : UINT64_MAX;
+      forEachValue(sourceValues, destinationValues, valueCount, sourceValueSize, destinationValueSize, [&](const char *source, char *destination) {
+        for (size_t index = 0; index < operation->count; index++) {
+          const size_t sourceBitOffset = operation->sourceOffset + (index * operation->sourceStride);
+          const size_t destinationBitOffset = operation->destinationOffset + (index * operation->destinationStride);
+          const size_t sourceByteCount = ((sourceBitOffset % CHAR_BIT) + operation->length + CHAR_BIT - 1) / CHAR_BIT;
+          const size_t destinationByteCount = ((destinationBitOffset % CHAR_BIT) + operation->length + CHAR_BIT - 1) / CHAR_BIT;
+          uint64_t bits = (loadInteger(source + (sourceBitOffset / CHAR_BIT), sourceByteCount, false) >> (sourceBitOffset % CHAR_BIT)) & mask;
+          char *address = destination + (destinationBitOffset / CHAR_BIT);
+          storeInteger(address, destinationByteCount, loadInteger(address, destinationByteCount, false) | (bits << (destinationBitOffset % CHAR_BIT)));
+        }
+      });
+      break;
+    }
+  }
+}
+
+// Applies each outer repetition of an operation in turn.
+static void applyOperation(
+    const objctk_conversionop *operation,
+    const char *sourceValues,
+    char *destinationValues,
+    const size_t valueCount,
+    const size_t sourceValueSize,
+    const size_t destinationValueSize,
+    objctk_pointertranslationfunction pointerTranslationFunction,
+    void *context) {
+  if (operation->outerCount == 1) {
+    applyInnerOperation(operation, sourceValues, destinationValues, valueCount, sourceValueSize, destinationValueSize, pointerTranslationFunction, context);
+    return;
+  }
+  objctk_conversionop innerOperation = *operation;
+  for (size_t outerIndex = 0; outerIndex < operation->outerCount; outerIndex++) {
+    innerOperation.sourceOffset = operation->sourceOffset + (outerIndex * operation->outerSourceStride);
+    innerOperation.destinationOffset = operation->destinationOffset + (outerIndex * operation->outerDestinationStride);
+    applyInnerOperation(&innerOperation, sourceValues, destinationValues, valueCount, sourceValueSize, destinationValueSize, pointerTranslationFunction, context);
+  }
+}
+
+objctk_layoutconversion objctk_layoutconversion_create(objctk_typenode node, objctk_layoutprofile sourceProfile, objctk_layoutprofile destinationProfile) {
+  const objctk_layoutrules *sourceRules = layoutRulesForProfile(sourceProfile);
+  const objctk_layoutrules *destinationRules = layoutRulesForProfile(destinationProfile);
+  if ((node == NULL) || (sourceRules == NULL) || (destinationRules == NULL)) {
+    return NULL;
+  }
+  objctk_typelayout sourceLayout = node->typeLayout(sourceProfile);
+  objctk_typelayout destinationLayout = node->typeLayout(destinationProfile);
+  if ((sourceLayout.size < 0) || (destinationLayout.size < 0)) {
+    return NULL;
+  }
+
+  const objctk_allocator *allocator = defaultAllocator();
+  objctk_operationstack operations(allocator);
+  if (!appendConversionOperations(node, sourceRules, destinationRules, 0, 0, &operations)) {
+    return NULL;
+  }
+
+  // Destination values are zeroed first unless the operations write every byte.
+  size_t writtenByteCount = 0;
+  bool hasBitFields = false;
+  for (const objctk_conversionop *operation = operations.begin(); operation != operations.end(); operation++) {
+    switch (operation->kind) {
+      case OBJCTKConversionKindCopy:
+        writtenByteCount += operation->outerCount * operation->count * operation->length;
+        break;
+      case OBJCTKConversionKindInteger:
+      case OBJCTKConversionKindPointer:
+        writtenByteCount += operation->outerCount * operation->count * operation->destinationSize;
+        break;
+      case OBJCTKConversionKindBitField:
+        hasBitFields = true;
+        break;
+    }
+  }
+
+  // The conversion and its operations share a single allocation.
+  const size_t operationsOffset = sizeof(_objctk_layoutconversion);
+  char *memory = static_cast<char *>(allocateMemory(allocator, operationsOffset + (operations.size() * sizeof(objctk_conversionop))));
+  if (memory == NULL) {
+    return NULL;
+  }
+  objctk_conversionop *conversionOperations = reinterpret_cast<objctk_conversionop *>(memory + operationsOffset);
+  std::copy(operations.begin(), operations.end(), conversionOperations);
+
+  objctk_layoutconversion conversion = new (memory) _objctk_layoutconversion();
+  conversion->allocator = *allocator;
+  conversion->sourceValueSize = sourceLayout.size;
+  conversion->destinationValueSize = destinationLayout.size;
+  conversion->zeroesDestination = hasBitFields || (writtenByteCount != conversion->destinationValueSize);
+  conversion->operationCount = operations.size();
+  conversion->operations = conversionOperations;
+  return conversion;
+}
+
+size_t objctk_layoutconversion_getSourceValueSize(objctk_layoutconversion conversion) {
+  return (conversion != NULL) ? conversion->sourceValueSize : 0;
+}
+
+size_t objctk_layoutconversion_getDestinationValueSize(objctk_layoutconversion conversion) {
+  return (conversion != NULL) ? conversion->destinationValueSize : 0;
+}
+
+size_t objctk_layoutconversion_getOperationCount(objctk_layoutconversion conversion) {
+  return (conversion != NULL) ? conversion->operationCount : 0;
+}
+
+void objctk_layoutconversion_convertValues(
+    objctk_layoutconversion conversion,
+    const void *sourceValues,
+    void *destinationValues,
+    size_t valueCount,
+    objctk_pointertranslationfunction pointerTranslationFunction,
+    void *context) {
+  if ((conversion == NULL) || (sourceValues == NULL) || (destinationValues == NULL) || (conversion->destinationValueSize == 0)) {
+    return;
+  }
+  const char *source = static_cast<const char *>(sourceValues);
+  char *destination = static_cast<char *>(destinationValues);
+
+  // Values whose bytes are all copied unchanged are copied in one run.
+  const objctk_conversionop *firstOperation = conversion->operations;
+  if ((conversion->operationCount == 1) && (firstOperation->kind == OBJCTKConversionKindCopy) && (firstOperation->count == 1) &&
+      (firstOperation->length == conversion->sourceValueSize) && (conversion->sourceValueSize == conversion->destinationValueSize)) {
+    memcpy(destination, source, valueCount * conversion->sourceValueSize);
+    return;
+  }
+
+  for (size_t valueIndex = 0; valueIndex < valueCount; valueIndex += kConversionBlockValueCount) {
+    const size_t blockValueCount = std::min(kConversionBlockValueCount, valueCount - valueIndex);
+    const char *sourceBlock = source + (valueIndex * conversion->sourceValueSize);
+    char *destinationBlock = destination + (valueIndex * conversion->destinationValueSize);
+    if (conversion->zeroesDestination) {
+      memset(destinationBlock, 0, blockValueCount * conversion->destinationValueSize);
+    }
+    for (size_t operationIndex = 0; operationIndex < conversion->operationCount; operationIndex++) {
+      applyOperation(&conversion->operations[operationIndex], sourceBlock, destinationBlock, blockValueCount, conversion->sourceValueSize, conversion->destinationValueSize, pointerTranslationFunction, context);
+    }
+  }
+}
+
+void objctk_layoutconversion_release(objctk_layoutconversion conversion) {
+  if (conversion == NULL) {
+    return;
+  }
+  objctk_allocator allocator = conversion->allocator;
+  deallocateMemory(&allocator, conversion);
+}
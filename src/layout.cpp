@@ -0,0 +1,119 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "layout.h"
+
+#include <stddef.h>
+
+using namespace objctk;
+
+/** The size and alignment of a scalar type on a target. */
+typedef struct objctk_scalarlayout {
+  unsigned char size;
+  unsigned char alignment;
+} objctk_scalarlayout;
+
+/** The target-specific parameters from which the layout rules of a profile are derived. */
+typedef struct objctk_layouttarget {
+  objctk_layoutprofile profile;
+  objctk_scalarlayout longType;
+  objctk_scalarlayout longLongType;
+  objctk_scalarlayout doubleType;
+  objctk_scalarlayout pointerType;
+  objctk_scalarlayout bitfieldUnit;
+} objctk_layouttarget;
+
+#define HOST_SCALAR_LAYOUT(type) { sizeof(type), alignof(type) }
+static const objctk_layouttarget kLayoutTargets[kLayoutProfileCount] = {
+  // profile                     long    long long double  pointer bitfield unit
+  { objctk_layoutprofile_Host,
+    HOST_SCALAR_LAYOUT(long), HOST_SCALAR_LAYOUT(long long), HOST_SCALAR_LAYOUT(double),
+    HOST_SCALAR_LAYOUT(void *), HOST_SCALAR_LAYOUT(unsigned int) },
+  { objctk_layoutprofile_LP64,   {8, 8}, {8, 8},   {8, 8}, {8, 8}, {4, 4} },
+  { objctk_layoutprofile_ILP32,  {4, 4}, {8, 8},   {8, 8}, {4, 4}, {4, 4} },
+  { objctk_layoutprofile_ARM64,  {8, 8}, {8, 8},   {8, 8}, {8, 8}, {4, 4} },
+  { objctk_layoutprofile_I386,   {4, 4}, {8, 4},   {8, 4}, {4, 4}, {4, 4} },
+};
+#undef HOST_SCALAR_LAYOUT
+
+static void setScalarLayout(objctk_layoutrules *rules, const objctk_typecategory typeCategory, const objctk_scalarlayout layout) {
+  rules->sizes[typeCategory] = layout.size;
+  rules->alignments[typeCategory] = layout.alignment;
+}
+
+static objctk_layoutrules makeLayoutRules(const objctk_layouttarget *target) {
+  const objctk_scalarlayout charType = { 1, 1 };
+  const objctk_scalarlayout shortType = { 2, 2 };
+  const objctk_scalarlayout intType = { 4, 4 };
+  const objctk_scalarlayout floatType = { 4, 4 };
+
+  objctk_layoutrules rules = {};
+  rules.profile = target->profile;
+  setScalarLayout(&rules, OBJCTKTypeCategorySignedChar, charType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryUnsignedChar, charType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryBool, charType);
+  setScalarLayout(&rules, OBJCTKTypeCategorySignedShort, shortType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryUnsignedShort, shortType);
+  setScalarLayout(&rules, OBJCTKTypeCategorySignedInt, intType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryUnsignedInt, intType);
+  setScalarLayout(&rules, OBJCTKTypeCategorySignedLong, target->longType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryUnsignedLong, target->longType);
+  setScalarLayout(&rules, OBJCTKTypeCategorySignedLongLong, target->longLongType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryUnsignedLongLong, target->longLongType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryFloat, floatType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryDouble, target->doubleType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryCharacterString, target->pointerType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryObject, target->pointerType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryClass, target->pointerType);
+  setScalarLayout(&rules, OBJCTKTypeCategorySelector, target->pointerType);
+  setScalarLayout(&rules, OBJCTKTypeCategoryPointer, target->pointerType);
+
+  // Void has no size but may appear as a member of a top-level type.
+  rules.alignments[OBJCTKTypeCategoryVoid] = 1;
+
+  rules.bitfieldUnitSize = target->bitfieldUnit.size;
+  rules.bitfieldUnitAlignment = target->bitfieldUnit.alignment;
+  return rules;
+}
+
+namespace objctk {
+
+const objctk_layoutrules *layoutRulesForProfile(const objctk_layoutprofile profile) {
+  static const struct layoutrulestable {
+    objctk_layoutrules rules[kLayoutProfileCount];
+    layoutrulestable() {
+      for (int index = 0; index < kLayoutProfileCount; index++) {
+        const objctk_layouttarget *target = &kLayoutTargets[index];
+        rules[target->profile] = makeLayoutRules(target);
+      }
+    }
+  } table;
+
+  if (!isValidLayoutProfile(profile)) {
+    return NULL;
+  }
+  return &table.rules[profile];
+}
+
+}
@@ -0,0 +1,114 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_LAYOUT__
+#define OBJCTK_LAYOUT__
+
+#include "internal-types.h"
+
+#include <limits.h>
+#include <stdint.h>
+
+namespace objctk {
+
+/** The number of layout profiles described by objctk_layoutprofile. */
+static const int kLayoutProfileCount = (objctk_layoutprofile_I386 + 1);
+
+/** The number of type categories described by objctk_typecategory. */
+static const int kTypeCategoryCount = (OBJCTKTypeCategoryTopLevel + 1);
+
+/**
+ * The data layout rules of a target ABI.
+ *
+ * Scalar sizes and alignments are indexed by type category. Categories whose layout is derived
+ * from other types (arrays, composites, bitfields) have a size and alignment of zero.
+ */
+typedef struct objctk_layoutrules {
+  objctk_layoutprofile profile;
+  unsigned char sizes[kTypeCategoryCount];
+  unsigned char alignments[kTypeCategoryCount];
+
+  // Bitfields are allocated in storage units of this size and alignment and never straddle two
+  // storage units. The encoding does not record the declared type of a bitfield so the storage
+  // unit of unsigned int, the overwhelmingly common declaration, is assumed.
+  unsigned char bitfieldUnitSize;
+  unsigned char bitfieldUnitAlignment;
+} objctk_layoutrules;
+
+/** The size and alignment of a type. A size of -1 indicates that the layout cannot be determined. */
+typedef struct objctk_typelayout {
+  int size;
+  int alignment;
+} objctk_typelayout;
+
+static inline objctk_typelayout makeTypeLayout(const int size, const int alignment) {
+  objctk_typelayout layout = {
+    .size = size,
+    .alignment = alignment,
+  };
+  return layout;
+}
+
+static inline objctk_typelayout invalidTypeLayout() {
+  return makeTypeLayout(-1, 0);
+}
+
+/** The largest size in bytes of a type with a valid layout, since sizes are reported as an int. */
+static const int64_t kMaximumTypeSize = INT_MAX;
+
+/** The largest width in bits of a type with a valid layout. */
+static const int64_t kMaximumTypeBitCount = kMaximumTypeSize * CHAR_BIT;
+
+/**
+ * Makes the layout of a type whose size was computed in 64-bit arithmetic, which is invalid if the
+ * size exceeds kMaximumTypeSize.
+ */
+static inline objctk_typelayout makeCheckedTypeLayout(const int64_t size, const int alignment) {
+  if ((size < 0) || (size > kMaximumTypeSize)) {
+    return invalidTypeLayout();
+  }
+  return makeTypeLayout((int)size, alignment);
+}
+
+static inline bool isValidLayoutProfile(const objctk_layoutprofile profile) {
+  return (profile >= 0) && (profile < kLayoutProfileCount);
+}
+
+static inline int64_t alignedOffset(const int64_t offset, const int64_t alignment) {
+  if (alignment <= 1) {
+    return offset;
+  }
+  // Alignments are almost always powers of two, which avoid a division.
+  if ((alignment & (alignment - 1)) == 0) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+  }
+  return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+/** Returns the layout rules of a layout profile or NULL if the profile is invalid. */
+const objctk_layoutrules *layoutRulesForProfile(const objctk_layoutprofile profile);
+
+}
+
+#endif
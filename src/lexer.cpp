@@ -29,6 +29,7 @@ SOFTWARE.
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <algorithm>
 
 using namespace objctk;
 
@@ -62,6 +63,18 @@ static void lexer_extendLexemeUntilCharacter(objctk_lexerstate *state, const sig
   lexer_nextChar(state);
 }
 
+// Extends the lexeme through the name of a composite type, which ends at the '=' preceding its
+// members or, for composite types without members such as those referenced through pointers, at
+// its closing bracket.
+static void lexer_extendLexemeThroughTypeName(objctk_lexerstate *state) {
+  while ((state->peekChar != '=') && (state->peekChar != '}') && (state->peekChar != ')') && (state->peekChar != '\0')) {
+    lexer_nextChar(state);
+  }
+  if (state->peekChar == '=') {
+    lexer_nextChar(state);
+  }
+}
+
 static void lexer_consumeNumber(objctk_lexerstate *state) {
   while (isdigit(state->peekChar)) {
     lexer_nextChar(state);
@@ -93,6 +106,9 @@ static objctk_token lexer_consumeType(objctk_lexerstate *state) {
         if (state->peekChar == '"') {
           lexer_nextChar(state);
           lexer_extendLexemeUntilCharacter(state, '"');
+        } else if (state->peekChar == '?') {
+          // A block, which is an object without a class name.
+          lexer_nextChar(state);
         }
         return makeToken(OBJCTKTokenNameObjCObjectPointerType, state->lexeme);
       }
@@ -111,7 +127,7 @@ static objctk_token lexer_consumeType(objctk_lexerstate *state) {
       }
     case '{': // Struct type start
       {
-        lexer_extendLexemeUntilCharacter(state, '=');
+        lexer_extendLexemeThroughTypeName(state);
         return makeToken(OBJCTKTokenNameStructDeclarationStart, state->lexeme);
       }
     case '}': // Struct type end
@@ -120,7 +136,7 @@ static objctk_token lexer_consumeType(objctk_lexerstate *state) {
       }
     case '(': // Union type start
       {
-        lexer_extendLexemeUntilCharacter(state, '=');
+        lexer_extendLexemeThroughTypeName(state);
         return makeToken(OBJCTKTokenNameUnionDeclarationStart, state->lexeme);
       }
     case ')': // Union type end
@@ -149,7 +165,18 @@ namespace objctk {
 objctk_token lexer_nextToken(objctk_lexerstate *state) {
   objctk_lexeme lastLexeme = state->lexeme;
   state->lexeme = makeRange(lastLexeme.offset + lastLexeme.length, 0);
+  state->tokenCount++;
   lexer_nextChar(state);
+  while (lexer_isSkippedCharacter(state->lastChar) || (state->lastChar == '"')) {
+    // The types of struct members may be preceded by their names in quotes, as in the encodings of
+    // instance variables. Quotes following the '@' of an object type enclose its class name
+    // instead and are consumed with the object type.
+    if (state->lastChar == '"') {
+      lexer_extendLexemeUntilCharacter(state, '"');
+    }
+    state->lexeme = makeRange(state->index, 0);
+    lexer_nextChar(state);
+  }
 
   if (state->lastChar == EOF) return makeToken(OBJCTKTokenNameEOF, state->lexeme);
   if (state->lastChar == '\0') return makeToken(OBJCTKTokenNameEOF, state->lexeme);
@@ -157,4 +184,17 @@ objctk_token lexer_nextToken(objctk_lexerstate *state) {
   return lexer_consumeType(state);
 }
 
+size_t lexer_findUnquotedCharacter(const char *input, const size_t inputLength, const size_t index, const char ch) {
+  objctk_lexerstate state = makeLexerStateWithRange(input, makeRange(index, inputLength - index));
+  while ((state.index < inputLength) && (input[state.index] != ch)) {
+    lexer_nextChar(&state);
+    // The character may appear within the class name following the '@' of an object type.
+    if ((state.lastChar == '@') && (state.peekChar == '"')) {
+      lexer_nextChar(&state);
+      lexer_extendLexemeUntilCharacter(&state, '"');
+    }
+  }
+  return std::min(state.index, inputLength);
+}
+
 }
@@ -28,6 +28,7 @@ SOFTWARE.
 #include "macros.h"
 #include "internal-types.h"
 
+#include <ctype.h>
 #include <limits.h>
 
 namespace objctk {
@@ -72,6 +73,7 @@ typedef struct objctk_lexerstate {
   const char *input;
   size_t inputLength;
   size_t index;
+  size_t tokenCount;
 
   objctk_lexeme lexeme;
   char lastChar;
@@ -84,6 +86,7 @@ static inline objctk_lexerstate makeLexerState(const char *input) {
     .input = input,
     .inputLength = inputLength,
     .index = 0,
+    .tokenCount = 0,
     .lexeme = makeRange(0, 0),
     .lastChar = '\0',
     .peekChar = '\0',
@@ -91,8 +94,67 @@ static inline objctk_lexerstate makeLexerState(const char *input) {
   return state;
 }
 
+/** Makes a lexer state which tokenizes only the characters within a range of the input. */
+static inline objctk_lexerstate makeLexerStateWithRange(const char *input, const objctk_range range) {
+  objctk_lexerstate state = {
+    .input = input,
+    .inputLength = range.offset + range.length,
+    .index = range.offset,
+    .tokenCount = 0,
+    .lexeme = makeRange(range.offset, 0),
+    .lastChar = '\0',
+    .peekChar = '\0',
+  };
+  return state;
+}
+
+// Method type encodings interleave types with frame offsets and prefix them with qualifiers, neither
+// of which affects the type.
+static inline bool lexer_isSkippedCharacter(const char ch) {
+  switch (ch) {
+    case 'r': // const
+    case 'n': // in
+    case 'N': // inout
+    case 'o': // out
+    case 'O': // bycopy
+    case 'R': // byref
+    case 'V': // oneway
+      return true;
+    default:
+      return isdigit((unsigned char)ch);
+  }
+}
+
+#define BASIC_TYPE_MAPPING(code, type) case code: return type
+static inline objctk_typecategory typeCategoryFromBasicTypeCode(char code) {
+  switch (code) {
+    BASIC_TYPE_MAPPING('c', OBJCTKTypeCategorySignedChar);
+    BASIC_TYPE_MAPPING('i', OBJCTKTypeCategorySignedInt);
+    BASIC_TYPE_MAPPING('s', OBJCTKTypeCategorySignedShort);
+    BASIC_TYPE_MAPPING('l', OBJCTKTypeCategorySignedLong);
+    BASIC_TYPE_MAPPING('q', OBJCTKTypeCategorySignedLongLong);
+    BASIC_TYPE_MAPPING('C', OBJCTKTypeCategoryUnsignedChar);
+    BASIC_TYPE_MAPPING('I', OBJCTKTypeCategoryUnsignedInt);
+    BASIC_TYPE_MAPPING('S', OBJCTKTypeCategoryUnsignedShort);
+    BASIC_TYPE_MAPPING('L', OBJCTKTypeCategoryUnsignedLong);
+    BASIC_TYPE_MAPPING('Q', OBJCTKTypeCategoryUnsignedLongLong);
+    BASIC_TYPE_MAPPING('f', OBJCTKTypeCategoryFloat);
+    BASIC_TYPE_MAPPING('d', OBJCTKTypeCategoryDouble);
+    BASIC_TYPE_MAPPING('B', OBJCTKTypeCategoryBool);
+    default:
+      return OBJCTKTypeCategoryUnknown;
+  }
+}
+#undef BASIC_TYPE_MAPPING
+
 objctk_token lexer_nextToken(objctk_lexerstate *state);
 
+/**
+ * Returns the offset of the first occurrence of a character at or after an index of the input which
+ * is not within the quoted class name of an object type, or the input length if there is none.
+ */
+size_t lexer_findUnquotedCharacter(const char *input, const size_t inputLength, const size_t index, const char ch);
+
 }
 
 #endif
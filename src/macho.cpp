@@ -0,0 +1,439 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "macho.h"
+
+#include "internal-allocator.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+
+using namespace objctk;
+
+// Mach-O constants, mirroring <mach-o/loader.h> and <mach-o/fat.h> which are unavailable on
+// non-Apple hosts.
+static const uint32_t kMachOMagic32 = 0xfeedface;
+static const uint32_t kMachOMagic64 = 0xfeedfacf;
+static const uint32_t kMachOCigam32 = 0xcefaedfe;
+static const uint32_t kMachOCigam64 = 0xcffaedfe;
+static const uint32_t kFatMagic32 = 0xcafebabe;
+static const uint32_t kFatMagic64 = 0xcafebabf;
+static const uint32_t kLoadCommandSegment32 = 0x1;
+static const uint32_t kLoadCommandSegment64 = 0x19;
+
+static const size_t kMachHeaderSize32 = 28;
+static const size_t kMachHeaderSize64 = 32;
+static const size_t kSegmentCommandSize32 = 56;
+static const size_t kSegmentCommandSize64 = 72;
+static const size_t kSectionSize32 = 68;
+static const size_t kSectionSize64 = 80;
+static const size_t kFatArchSize32 = 20;
+static const size_t kFatArchSize64 = 32;
+
+static const size_t kNameFieldSize = 16;
+
+struct _objctk_machoimage {
+  objctk_allocator allocator;
+  const char *mapping;
+  size_t mappingSize;
+  size_t architectureCount;
+  scratchstack<const char *> encodings;
+
+  explicit _objctk_machoimage(const objctk_allocator *allocator) : allocator(*allocator), mapping(NULL), mappingSize(0), architectureCount(0), encodings(allocator) {}
+};
+
+/** A bounds-checked view of a range of the mapped file. */
+typedef struct objctk_filereader {
+  const char *bytes;
+  size_t size;
+  bool swapsBytes;
+} objctk_filereader;
+
+static inline bool readUInt32(const objctk_filereader *reader, const size_t offset, uint32_t *outValue) {
+  if ((offset > reader->size) || ((reader->size - offset) < sizeof(uint32_t))) {
+    return false;
+  }
+  uint32_t value;
+  memcpy(&value, reader->bytes + offset, sizeof(value));
+  *outValue = reader->swapsBytes ? __builtin_bswap32(value) : value;
+  return true;
+}
+
+static inline bool readUInt64(const objctk_filereader *reader, const size_t offset, uint64_t *outValue) {
+  if ((offset > reader->size) || ((reader->size - offset) < sizeof(uint64_t))) {
+    return false;
+  }
+  uint64_t value;
+  memcpy(&value, reader->bytes + offset, sizeof(value));
+  *outValue = reader->swapsBytes ? __builtin_bswap64(value) : value;
+  return true;
+}
+
+static inline bool nameFieldEquals(const objctk_filereader *reader, const size_t offset, const char *name) {
+  if ((offset > reader->size) || ((reader->size - offset) < kNameFieldSize)) {
+    return false;
+  }
+  return strncmp(reader->bytes + offset, name, kNameFieldSize) == 0;
+}
+
+static inline bool isHostLittleEndian() {
+  const uint16_t value = 1;
+  return *reinterpret_cast<const uint8_t *>(&value) == 1;
+}
+
+static inline bool isTypeEncodingSection(const objctk_filereader *reader, const size_t sectionOffset) {
+  const size_t segmentNameOffset = sectionOffset + kNameFieldSize;
+  return (nameFieldEquals(reader, sectionOffset, "__objc_methtype") && nameFieldEquals(reader, segmentNameOffset, "__TEXT"))
+      || (nameFieldEquals(reader, sectionOffset, "__meth_var_types") && nameFieldEquals(reader, segmentNameOffset, "__OBJC"));
+}
+
+// Appends the NUL-terminated strings of a section. A trailing string that is not terminated within
+// the section cannot be parsed in place and is ignored.
+static bool collectSectionEncodings(objctk_machoimage image, const char *section, const size_t sectionSize) {
+  size_t index = 0;
+  while (index < sectionSize) {
+    const char *encoding = section + index;
+    const char *terminator = static_cast<const char *>(memchr(encoding, '\0', sectionSize - index));
+    if (terminator == NULL) {
+      break;
+    }
+    if ((terminator != encoding) && !image->encodings.push_back(encoding)) {
+      return false;
+    }
+    index = (terminator - section) + 1;
+  }
+  return true;
+}
+
+static bool collectSliceEncodings(objctk_machoimage image, const objctk_filereader *slice) {
+  uint32_t magic = 0;
+  if (!readUInt32(slice, 0, &magic)) {
+    return false;
+  }
+
+  objctk_filereader reader = *slice;
+  bool is64Bit = false;
+  if ((magic == kMachOMagic32) || (magic == kMachOMagic64)) {
+    reader.swapsBytes = false;
+    is64Bit = (magic == kMachOMagic64);
+  } else if ((magic == kMachOCigam32) || (magic == kMachOCigam64)) {
+    reader.swapsBytes = true;
+    is64Bit = (magic == kMachOCigam64);
+  } else {
+    return false;
+  }
+
+  uint32_t commandCount = 0;
+  if (!readUInt32(&reader, 16, &commandCount)) {
+    return false;
+  }
+
+  size_t commandOffset = is64Bit ? kMachHeaderSize64 : kMachHeaderSize32;
+  for (uint32_t commandIndex = 0; commandIndex < commandCount; commandIndex++) {
+    uint32_t command = 0;
+    uint32_t commandSize = 0;
+    if (!readUInt32(&reader, commandOffset, &command) || !readUInt32(&reader, commandOffset + 4, &commandSize) || (commandSize < 8)) {
+      return false;
+    }
+
+    const bool isSegment32 = (command == kLoadCommandSegment32);
+    const bool isSegment64 = (command == kLoadCommandSegment64);
+    if (isSegment32 || isSegment64) {
+      const size_t segmentCommandSize = isSegment64 ? kSegmentCommandSize64 : kSegmentCommandSize32;
+      const size_t sectionSize = isSegment64 ? kSectionSize64 : kSectionSize32;
+      uint32_t sectionCount = 0;
+      if (!readUInt32(&reader, commandOffset + (isSegment64 ? 64 : 48), &sectionCount)) {
+        return false;
+      }
+      for (uint32_t sectionIndex = 0; sectionIndex < sectionCount; sectionIndex++) {
+        const size_t sectionOffset = commandOffset + segmentCommandSize + (sectionIndex * sectionSize);
+        if ((sectionOffset + sectionSize) > (commandOffset + commandSize)) {
+          return false;
+        }
+        if (!isTypeEncodingSection(&reader, sectionOffset)) {
+          continue;
+        }
+
+        uint64_t dataSize = 0;
+        uint32_t dataOffset = 0;
+        if (isSegment64) {
+          if (!readUInt64(&reader, sectionOffset + 40, &dataSize) || !readUInt32(&reader, sectionOffset + 48, &dataOffset)) {
+            return false;
+          }
+        } else {
+          uint32_t dataSize32 = 0;
+          if (!readUInt32(&reader, sectionOffset + 36, &dataSize32) || !readUInt32(&reader, sectionOffset + 40, &dataOffset)) {
+            return false;
+          }
+          dataSize = dataSize32;
+        }
+        if ((dataOffset > reader.size) || (dataSize > (reader.size - dataOffset))) {
+          return false;
+        }
+        if (!collectSectionEncodings(image, reader.bytes + dataOffset, (size_t)dataSize)) {
+          return false;
+        }
+      }
+    }
+    commandOffset += commandSize;
+  }
+  image->architectureCount++;
+  return true;
+}
+
+static bool collectFileEncodings(objctk_machoimage image) {
+  objctk_filereader file = {
+    .bytes = image->mapping,
+    .size = image->mappingSize,
+    .swapsBytes = false,
+  };
+
+  // Fat headers are always big-endian.
+  objctk_filereader fatReader = file;
+  fatReader.swapsBytes = isHostLittleEndian();
+  uint32_t magic = 0;
+  if (!readUInt32(&fatReader, 0, &magic)) {
+    return false;
+  }
+  if ((magic != kFatMagic32) && (magic != kFatMagic64)) {
+    return collectSliceEncodings(image, &file);
+  }
+
+  const bool is64Bit = (magic == kFatMagic64);
+  uint32_t architectureCount = 0;
+  if (!readUInt32(&fatReader, 4, &architectureCount)) {
+    return false;
+  }
+  for (uint32_t architectureIndex = 0; architectureIndex < architectureCount; architectureIndex++) {
+    const size_t architectureOffset = 8 + (architectureIndex * (is64Bit ? kFatArchSize64 : kFatArchSize32));
+    uint64_t sliceOffset = 0;
+    uint64_t sliceSize = 0;
+    if (is64Bit) {
+      if (!readUInt64(&fatReader, architectureOffset + 8, &sliceOffset) || !readUInt64(&fatReader, architectureOffset + 16, &sliceSize)) {
+        return false;
+      }
+    } else {
+      uint32_t sliceOffset32 = 0;
+      uint32_t sliceSize32 = 0;
+      if (!readUInt32(&fatReader, architectureOffset + 8, &sliceOffset32) || !readUInt32(&fatReader, architectureOffset + 12, &sliceSize32)) {
+        return false;
+      }
+      sliceOffset = sliceOffset32;
+      sliceSize = sliceSize32;
+    }
+    if ((sliceOffset > file.size) || (sliceSize > (file.size - sliceOffset))) {
+      return false;
+    }
+    objctk_filereader slice = {
+      .bytes = file.bytes + sliceOffset,
+      .size = (size_t)sliceSize,
+      .swapsBytes = false,
+    };
+    if (!collectSliceEncodings(image, &slice)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline uint64_t encodingHash(const char *encoding) {
+  // 64-bit FNV-1a.
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char *character = encoding; *character != '\0'; character++) {
+    hash ^= (unsigned char)*character;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Removes duplicate encodings, preserving the order of first occurrence.
+static bool removeDuplicateEncodings(objctk_machoimage image) {
+  const size_t encodingCount = image->encodings.size();
+  size_t capacity = 16;
+  while (capacity < (encodingCount * 2)) {
+    capacity *= 2;
+  }
+  const char **table = static_cast<const char **>(allocateMemory(&image->allocator, capacity * sizeof(const char *)));
+  if (table == NULL) {
+    return false;
+  }
+  memset(table, 0, capacity * sizeof(const char *));
+
+  const char **encodings = image->encodings.begin();
+  size_t distinctEncodingCount = 0;
+  for (size_t index = 0; index < encodingCount; index++) {
+    const char *encoding = encodings[index];
+    size_t slotIndex = encodingHash(encoding) & (capacity - 1);
+    bool isDuplicate = false;
+    while (table[slotIndex] != NULL) {
+      if (strcmp(table[slotIndex], encoding) == 0) {
+        isDuplicate = true;
+        break;
+      }
+      slotIndex = (slotIndex + 1) & (capacity - 1);
+    }
+    if (!isDuplicate) {
+      table[slotIndex] = encoding;
+      encodings[distinctEncodingCount++] = encoding;
+    }
+  }
+  image->encodings.resize(distinctEncodingCount);
+  deallocateMemory(&image->allocator, table);
+  return true;
+}
+
+// Parses batches of encodings until none remain. Encodings are left to other threads if a parser
+// cannot be created.
+static void parseEncodingRange(objctk_machoimage image, std::atomic<size_t> *nextIndex, objctk_machoencodingfunction encodingFunction, void *context) {
+  static const size_t kEncodingBatchSize = 64;
+  objctk_parser parser = objctk_parser_createWithAllocator(&image->allocator);
+  if (parser == NULL) {
+    return;
+  }
+  const size_t encodingCount = image->encodings.size();
+  while (true) {
+    size_t startIndex = nextIndex->fetch_add(kEncodingBatchSize, std::memory_order_relaxed);
+    if (startIndex >= encodingCount) {
+      break;
+    }
+    size_t endIndex = std::min(startIndex + kEncodingBatchSize, encodingCount);
+    for (size_t index = startIndex; index < endIndex; index++) {
+      const char *encoding = image->encodings.begin()[index];
+      objctk_typeparseresult parseResult = objctk_parser_parseTypeEncoding(parser, encoding);
+      encodingFunction(index, encoding, parseResult, context);
+    }
+  }
+  objctk_parser_release(parser);
+}
+
+objctk_machoimage objctk_machoimage_open(const char *path) {
+  if (path == NULL) {
+    return NULL;
+  }
+  int fileDescriptor = open(path, O_RDONLY);
+  if (fileDescriptor < 0) {
+    return NULL;
+  }
+  struct stat fileStatus;
+  if ((fstat(fileDescriptor, &fileStatus) != 0) || (fileStatus.st_size <= 0)) {
+    close(fileDescriptor);
+    return NULL;
+  }
+  size_t mappingSize = (size_t)fileStatus.st_size;
+  void *mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  close(fileDescriptor);
+  if (mapping == MAP_FAILED) {
+    return NULL;
+  }
+
+  objctk_machoimage image = makeObject<_objctk_machoimage>(defaultAllocator(), defaultAllocator());
+  if (image == NULL) {
+    munmap(mapping, mappingSize);
+    return NULL;
+  }
+  image->mapping = static_cast<const char *>(mapping);
+  image->mappingSize = mappingSize;
+  if (!collectFileEncodings(image) || !removeDuplicateEncodings(image)) {
+    objctk_machoimage_release(image);
+    return NULL;
+  }
+  return image;
+}
+
+size_t objctk_machoimage_getArchitectureCount(objctk_machoimage image) {
+  return (image != NULL) ? image->architectureCount : 0;
+}
+
+size_t objctk_machoimage_getEncodingCount(objctk_machoimage image) {
+  return (image != NULL) ? image->encodings.size() : 0;
+}
+
+const char *objctk_machoimage_getEncoding(objctk_machoimage image, size_t index) {
+  if ((image == NULL) || (index >= image->encodings.size())) {
+    return NULL;
+  }
+  return image->encodings.begin()[index];
+}
+
+objctk_statuscode objctk_machoimage_parseEncodings(
+    objctk_machoimage image,
+    unsigned int threadCount,
+    objctk_machoencodingfunction encodingFunction,
+    void *context) {
+  if ((image == NULL) || (encodingFunction == NULL)) {
+    return objctk_statuscode_InvalidInput;
+  }
+
+  // The calling thread parses alongside the spawned threads. Threads which cannot be spawned leave
+  // their share of the encodings to the threads which were.
+  std::atomic<size_t> nextIndex(0);
+  scratchstack<std::thread *> threads(&image->allocator);
+  for (unsigned int threadIndex = 1; threadIndex < threadCount; threadIndex++) {
+    std::thread *thread = makeObject<std::thread>(&image->allocator);
+    if (thread == NULL) {
+      break;
+    }
+    try {
+      *thread = std::thread(parseEncodingRange, image, &nextIndex, encodingFunction, context);
+    } catch (const std::system_error &) {
+      releaseObject(&image->allocator, thread);
+      break;
+    }
+    if (!threads.push_back(thread)) {
+      thread->join();
+      releaseObject(&image->allocator, thread);
+      break;
+    }
+  }
+  parseEncodingRange(image, &nextIndex, encodingFunction, context);
+  for (std::thread **thread = threads.begin(); thread != threads.end(); thread++) {
+    (*thread)->join();
+    releaseObject(&image->allocator, *thread);
+  }
+
+  // Encodings remain unparsed only if no thread could create a parser.
+  if (nextIndex.load(std::memory_order_relaxed) < image->encodings.size()) {
+    return objctk_statuscode_OutOfMemory;
+  }
+  return objctk_statuscode_NoError;
+}
+
+void objctk_machoimage_release(objctk_machoimage image) {
+  if (image == NULL) {
+    return;
+  }
+  if (image->mapping != NULL) {
+    munmap(const_cast<char *>(image->mapping), image->mappingSize);
+  }
+  objctk_allocator allocator = image->allocator;
+  releaseObject(&allocator, image);
+}
@@ -0,0 +1,459 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "member-accessor.h"
+
+#include "arena.h"
+#include "internal-allocator.h"
+#include "layout.h"
+#include "name-table.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+#include <mutex>
+
+using namespace objctk;
+
+struct _objctk_memberaccessor {
+  objctk_allocator allocator;
+  _objctk_typenode *memberType;
+  size_t memberSize;
+  size_t dereferenceCount;
+  // The offset at which each pointer is loaded followed by the offset of the member from the
+  // address reached by the last dereference.
+  const size_t *offsets;
+};
+
+typedef struct objctk_accessorcacheentry {
+  // A copy of the type node against which the path is resolved, owned by the cache.
+  _objctk_typenode *node;
+  uint64_t hash;
+  // A copy of the path, which is NULL for unused entries.
+  char *path;
+  objctk_memberaccessor accessor;
+} objctk_accessorcacheentry;
+
+struct _objctk_memberaccessorcache {
+  objctk_allocator allocator;
+  std::mutex lock;
+  size_t capacity;
+  size_t count;
+  objctk_accessorcacheentry *entries;
+  // Holds the copies of the type nodes of the entries.
+  arena nodeArena;
+
+  explicit _objctk_memberaccessorcache(const objctk_allocator *allocator) : allocator(*allocator), capacity(0), count(0), entries(NULL), nodeArena(allocator) {}
+};
+
+typedef scratchstack<size_t> objctk_offsetstack;
+
+static inline bool isNameCharacter(const char character) {
+  return (character != '\0') && (character != '.') && (character != '[') && (character != ']') && (character != '-');
+}
+
+static bool consumeIndex(const char **cursor, size_t *outIndex) {
+  const char *characters = *cursor;
+  if (!isdigit((unsigned char)*characters)) {
+    return false;
+  }
+  size_t index = 0;
+  for (; isdigit((unsigned char)*characters); characters++) {
+    size_t digit = (size_t)(*characters - '0');
+    if (index > ((SIZE_MAX - digit) / 10)) {
+      return false;
+    }
+    index = (index * 10) + digit;
+  }
+  *cursor = characters;
+  *outIndex = index;
+  return true;
+}
+
+// Consumes a member index or type name and returns the selected member of a composite type,
+// advancing the offset to that of the member.
+static _objctk_typenode *consumeMember(const char **cursor, _objctk_typenode *node, const objctk_layoutrules *rules, size_t *offset) {
+  const objctk_typecategory typeCategory = node->typeCategory();
+  if ((typeCategory != OBJCTKTypeCategoryStruct) && (typeCategory != OBJCTKTypeCategoryUnion) && (typeCategory != OBJCTKTypeCategoryTopLevel)) {
+    return NULL;
+  }
+
+  size_t memberIndex = SIZE_MAX;
+  objctk_nameid memberTypeNameID = OBJCTK_NAMEID_NONE;
+  if (!consumeIndex(cursor, &memberIndex)) {
+    const char *name = *cursor;
+    while (isNameCharacter(**cursor)) {
+      (*cursor)++;
+    }
+    // Names which were never interned cannot match any type.
+    memberTypeNameID = lookupName(name, *cursor - name);
+    if (memberTypeNameID == OBJCTK_NAMEID_NONE) {
+      return NULL;
+    }
+  }
+
+  _objctk_typenode *memberTypeNode = NULL;
+  int memberOffset = -1;
+  size_t index = 0;
+  bool isAmbiguous = false;
+  objctk_typelayout layout = static_cast<compositetypenode *>(node)->layoutMembers(rules, [&](_objctk_typenode *candidateTypeNode, int candidateOffset, int) {
+    bool matches = (memberTypeNameID != OBJCTK_NAMEID_NONE) ? (candidateTypeNode->typeNameID() == memberTypeNameID) : (index == memberIndex);
+    if (matches) {
+      isAmbiguous = isAmbiguous || (memberTypeNode != NULL);
+      memberTypeNode = candidateTypeNode;
+      memberOffset = candidateOffset;
+    }
+    ++index;
+  });
+  if ((layout.size < 0) || (memberTypeNode == NULL) || isAmbiguous || (memberTypeNode->typeCategory() == OBJCTKTypeCategoryBitField)) {
+    return NULL;
+  }
+  *offset += memberOffset;
+  return memberTypeNode;
+}
+
+// Resolves a path, collecting the offsets of dereferenced pointers followed by the final offset.
+// Returns the selected member type node or NULL.
+static _objctk_typenode *resolveMemberPath(_objctk_typenode *node, const char *path, objctk_offsetstack *offsets) {
+  const objctk_layoutrules *rules = layoutRulesForProfile(objctk_layoutprofile_Host);
+  const char *cursor = path;
+  size_t offset = 0;
+  while ((node != NULL) && (*cursor != '\0')) {
+    if (*cursor == '[') {
+      cursor++;
+      size_t elementIndex;
+      if (!consumeIndex(&cursor, &elementIndex) || (*cursor != ']')) {
+        return NULL;
+      }
+      cursor++;
+
+      const objctk_typecategory typeCategory = node->typeCategory();
+      if ((typeCategory != OBJCTKTypeCategoryArray) && (typeCategory != OBJCTKTypeCategoryPointer)) {
+        return NULL;
+      }
+      _objctk_typenode *elementTypeNode = node->referencedType();
+      int elementSize = (elementTypeNode != NULL) ? elementTypeNode->typeSize(objctk_layoutprofile_Host) : -1;
+      if ((elementSize < 0) || ((elementIndex > 0) && ((elementSize == 0) || (elementIndex > (SIZE_MAX / elementSize))))) {
+        return NULL;
+      }
+      if (typeCategory == OBJCTKTypeCategoryArray) {
+        if ((elementIndex >= static_cast<arraynode *>(node)->elementCount()) || (node->typeSize(objctk_layoutprofile_Host) < 0)) {
+          return NULL;
+        }
+      } else {
+        if (!offsets->push_back(offset)) {
+          return NULL;
+        }
+        offset = 0;
+      }
+      offset += elementIndex * elementSize;
+      node = elementTypeNode;
+    } else if ((cursor[0] == '-') && (cursor[1] == '>')) {
+      cursor += 2;
+      if ((node->typeCategory() != OBJCTKTypeCategoryPointer) || (node->referencedType() == NULL) || !offsets->push_back(offset)) {
+        return NULL;
+      }
+      offset = 0;
+      node = consumeMember(&cursor, node->referencedType(), rules, &offset);
+    } else {
+      // The separator of the first component is optional.
+      if (*cursor == '.') {
+        cursor++;
+      } else if (cursor != path) {
+        return NULL;
+      }
+      node = consumeMember(&cursor, node, rules, &offset);
+    }
+  }
+  if ((node == NULL) || (node->typeSize(objctk_layoutprofile_Host) < 0) || !offsets->push_back(offset)) {
+    return NULL;
+  }
+  return node;
+}
+
+static inline const char *memberAddress(const objctk_memberaccessor accessor, const char *valueAddress) {
+  const char *address = valueAddress;
+  for (size_t index = 0; index < accessor->dereferenceCount; index++) {
+    const char *pointer;
+    memcpy(&pointer, address + accessor->offsets[index], sizeof(pointer));
+    if (pointer == NULL) {
+      return NULL;
+    }
+    address = pointer;
+  }
+  return address + accessor->offsets[accessor->dereferenceCount];
+}
+
+static objctk_memberaccessor createMemberAccessor(_objctk_typenode *node, const char *path, const objctk_allocator *allocator) {
+  objctk_offsetstack offsets(allocator);
+  _objctk_typenode *memberTypeNode = resolveMemberPath(node, path, &offsets);
+  if (memberTypeNode == NULL) {
+    return NULL;
+  }
+
+  // The accessor and its offsets share a single allocation.
+  const size_t offsetsOffset = sizeof(_objctk_memberaccessor);
+  char *memory = static_cast<char *>(allocateMemory(allocator, offsetsOffset + (offsets.size() * sizeof(size_t))));
+  if (memory == NULL) {
+    return NULL;
+  }
+  size_t *accessorOffsets = reinterpret_cast<size_t *>(memory + offsetsOffset);
+  memcpy(accessorOffsets, offsets.begin(), offsets.size() * sizeof(size_t));
+
+  objctk_memberaccessor accessor = new (memory) _objctk_memberaccessor();
+  accessor->allocator = *allocator;
+  accessor->memberType = memberTypeNode;
+  accessor->memberSize = memberTypeNode->typeSize(objctk_layoutprofile_Host);
+  accessor->dereferenceCount = offsets.size() - 1;
+  accessor->offsets = accessorOffsets;
+  return accessor;
+}
+
+objctk_memberaccessor objctk_memberaccessor_create(objctk_typenode node, const char *path) {
+  if ((node == NULL) || (path == NULL)) {
+    return NULL;
+  }
+  return createMemberAccessor(node, path, defaultAllocator());
+}
+
+objctk_typenode objctk_memberaccessor_getMemberType(objctk_memberaccessor accessor) {
+  return (accessor != NULL) ? accessor->memberType : NULL;
+}
+
+size_t objctk_memberaccessor_getDereferenceCount(objctk_memberaccessor accessor) {
+  return (accessor != NULL) ? accessor->dereferenceCount : 0;
+}
+
+void *objctk_memberaccessor_getAddress(objctk_memberaccessor accessor, const void *valueAddress) {
+  if ((accessor == NULL) || (valueAddress == NULL)) {
+    return NULL;
+  }
+  return const_cast<char *>(memberAddress(accessor, static_cast<const char *>(valueAddress)));
+}
+
+void objctk_memberaccessor_getAddresses(
+    objctk_memberaccessor accessor,
+    const void *values,
+    size_t valueCount,
+    size_t valueStride,
+    void **outAddresses) {
+  if ((accessor == NULL) || (values == NULL) || (outAddresses == NULL)) {
+    return;
+  }
+  const char *value = static_cast<const char *>(values);
+  if (accessor->dereferenceCount == 0) {
+    const size_t offset = accessor->offsets[0];
+    for (size_t valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+      outAddresses[valueIndex] = const_cast<char *>(value + offset);
+      value += valueStride;
+    }
+    return;
+  }
+  for (size_t valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+    outAddresses[valueIndex] = const_cast<char *>(memberAddress(accessor, value));
+    value += valueStride;
+  }
+}
+
+size_t objctk_memberaccessor_copyMemberValues(
+    objctk_memberaccessor accessor,
+    const void *values,
+    size_t valueCount,
+    size_t valueStride,
+    void *outMemberValues) {
+  if ((accessor == NULL) || (values == NULL) || (outMemberValues == NULL)) {
+    return 0;
+  }
+  const char *value = static_cast<const char *>(values);
+  char *memberValue = static_cast<char *>(outMemberValues);
+  const size_t memberSize = accessor->memberSize;
+  size_t copiedCount = 0;
+  for (size_t valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+    const char *address = memberAddress(accessor, value);
+    if (address != NULL) {
+      memcpy(memberValue, address, memberSize);
+      ++copiedCount;
+    } else {
+      memset(memberValue, 0, memberSize);
+    }
+    value += valueStride;
+    memberValue += memberSize;
+  }
+  return copiedCount;
+}
+
+void objctk_memberaccessor_release(objctk_memberaccessor accessor) {
+  if (accessor == NULL) {
+    return;
+  }
+  objctk_allocator allocator = accessor->allocator;
+  deallocateMemory(&allocator, accessor);
+}
+
+// Copies a type tree into an arena, returning NULL if memory could not be allocated. The copies
+// keep the structural hashes, type name identifiers and cached layouts of the originals.
+static _objctk_typenode *copyTypeNode(arena *nodeArena, _objctk_typenode *node) {
+  switch (node->typeCategory()) {
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryUnion:
+    case OBJCTKTypeCategoryTopLevel: {
+      const _objctk_typenode_list memberTypes = node->memberTypes();
+      _objctk_typenode_ptr *memberTypeCopies = nodeArena->makeArray<_objctk_typenode_ptr>(memberTypes.size());
+      if ((memberTypeCopies == NULL) && !memberTypes.empty()) {
+        return NULL;
+      }
+      for (size_t index = 0; index < memberTypes.size(); index++) {
+        memberTypeCopies[index] = copyTypeNode(nodeArena, memberTypes[index]);
+        if (memberTypeCopies[index] == NULL) {
+          return NULL;
+        }
+      }
+      return nodeArena->make<compositetypenode>(*static_cast<compositetypenode *>(node), _objctk_typenode_list(memberTypeCopies, memberTypes.size()));
+    }
+    case OBJCTKTypeCategoryArray:
+    case OBJCTKTypeCategoryPointer:
+    case OBJCTKTypeCategoryCharacterString:
+    case OBJCTKTypeCategoryClass:
+    case OBJCTKTypeCategorySelector: {
+      _objctk_typenode *referencedTypeCopy = NULL;
+      if (node->referencedType() != NULL) {
+        referencedTypeCopy = copyTypeNode(nodeArena, node->referencedType());
+        if (referencedTypeCopy == NULL) {
+          return NULL;
+        }
+      }
+      if (node->typeCategory() == OBJCTKTypeCategoryArray) {
+        return nodeArena->make<arraynode>(*static_cast<arraynode *>(node), referencedTypeCopy);
+      }
+      return nodeArena->make<pointernode>(*static_cast<pointernode *>(node), referencedTypeCopy);
+    }
+    case OBJCTKTypeCategoryBitField:
+      return nodeArena->make<bitfieldnode>(*static_cast<bitfieldnode *>(node));
+    case OBJCTKTypeCategoryObject:
+      return nodeArena->make<objectpointernode>(*static_cast<objectpointernode *>(node));
+    default:
+      return nodeArena->make<_objctk_typenode>(*node);
+  }
+}
+
+// Entries are keyed on the structure of their type rather than the address of its type node, as
+// parsers and released parse results reuse the memory of type nodes for unrelated types.
+static uint64_t accessorCacheHash(_objctk_typenode *node, const char *path, const size_t pathLength) {
+  uint64_t hash = node->structuralHash() * 0x9E3779B97F4A7C15ULL;
+  for (size_t index = 0; index < pathLength; index++) {
+    hash = (hash ^ (unsigned char)path[index]) * 0x100000001B3ULL;
+  }
+  return hash ^ (hash >> 32);
+}
+
+// Returns the entry of a node and path or the unused entry where it belongs. The cache must have
+// a capacity greater than its count.
+static objctk_accessorcacheentry *accessorCacheEntry(objctk_accessorcacheentry *entries, const size_t capacity, _objctk_typenode *node, const char *path, const uint64_t hash) {
+  const size_t mask = capacity - 1;
+  for (size_t index = hash & mask;; index = (index + 1) & mask) {
+    objctk_accessorcacheentry *entry = &entries[index];
+    if ((entry->path == NULL) || ((entry->hash == hash) && (strcmp(entry->path, path) == 0) && areStructurallyEqualTypeNodes(entry->node, node))) {
+      return entry;
+    }
+  }
+}
+
+static bool growAccessorCache(objctk_memberaccessorcache cache) {
+  const size_t capacity = (cache->capacity > 0) ? (cache->capacity * 2) : 16;
+  objctk_accessorcacheentry *entries = static_cast<objctk_accessorcacheentry *>(allocateMemory(&cache->allocator, capacity * sizeof(objctk_accessorcacheentry)));
+  if (entries == NULL) {
+    return false;
+  }
+  memset(entries, 0, capacity * sizeof(objctk_accessorcacheentry));
+  for (size_t index = 0; index < cache->capacity; index++) {
+    const objctk_accessorcacheentry *entry = &cache->entries[index];
+    if (entry->path != NULL) {
+      *accessorCacheEntry(entries, capacity, entry->node, entry->path, entry->hash) = *entry;
+    }
+  }
+  deallocateMemory(&cache->allocator, cache->entries);
+  cache->entries = entries;
+  cache->capacity = capacity;
+  return true;
+}
+
+objctk_memberaccessorcache objctk_memberaccessorcache_create(const objctk_allocator *allocator) {
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+  return makeObject<_objctk_memberaccessorcache>(allocator, allocator);
+}
+
+objctk_memberaccessor objctk_memberaccessorcache_getAccessor(objctk_memberaccessorcache cache, objctk_typenode node, const char *path) {
+  if ((cache == NULL) || (node == NULL) || (path == NULL)) {
+    return NULL;
+  }
+  const size_t pathLength = strlen(path);
+  const uint64_t hash = accessorCacheHash(node, path, pathLength);
+
+  std::lock_guard<std::mutex> lock(cache->lock);
+  if ((((cache->count + 1) * 2) > cache->capacity) && !growAccessorCache(cache)) {
+    return NULL;
+  }
+  objctk_accessorcacheentry *entry = accessorCacheEntry(cache->entries, cache->capacity, node, path, hash);
+  if (entry->path != NULL) {
+    return entry->accessor;
+  }
+
+  // Paths which cannot be resolved are cached along with those which can. The path is resolved
+  // against the copy of the type so that the member type of the accessor outlives the original.
+  _objctk_typenode *nodeCopy = copyTypeNode(&cache->nodeArena, node);
+  if (nodeCopy == NULL) {
+    return NULL;
+  }
+  char *pathCopy = static_cast<char *>(allocateMemory(&cache->allocator, pathLength + 1));
+  if (pathCopy == NULL) {
+    return NULL;
+  }
+  memcpy(pathCopy, path, pathLength + 1);
+  entry->node = nodeCopy;
+  entry->hash = hash;
+  entry->path = pathCopy;
+  entry->accessor = createMemberAccessor(nodeCopy, path, &cache->allocator);
+  cache->count++;
+  return entry->accessor;
+}
+
+void objctk_memberaccessorcache_release(objctk_memberaccessorcache cache) {
+  if (cache == NULL) {
+    return;
+  }
+  for (size_t index = 0; index < cache->capacity; index++) {
+    objctk_accessorcacheentry *entry = &cache->entries[index];
+    if (entry->path != NULL) {
+      objctk_memberaccessor_release(entry->accessor);
+      deallocateMemory(&cache->allocator, entry->path);
+    }
+  }
+  deallocateMemory(&cache->allocator, cache->entries);
+  objctk_allocator allocator = cache->allocator;
+  releaseObject(&allocator, cache);
+}
@@ -0,0 +1,300 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "name-table.h"
+
+#include "internal-allocator.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+
+using namespace objctk;
+
+// Interned names are stored as records holding their length followed by their NUL-terminated
+// characters. Records are never freed.
+typedef struct objctk_namerecord {
+  uint32_t length;
+  uint32_t hash;
+} objctk_namerecord;
+
+static inline const char *nameRecordCharacters(const objctk_namerecord *record) {
+  return reinterpret_cast<const char *>(record + 1);
+}
+
+// Identifiers index a table of records split into segments of doubling size so that the table can
+// grow without moving existing entries, which keeps lookups by identifier lock-free.
+static const size_t kNameSegmentBaseCapacity = 256;
+static const unsigned int kNameSegmentCount = 24;
+static std::atomic<std::atomic<const objctk_namerecord *> *> gNameSegments[kNameSegmentCount];
+static std::atomic<uint32_t> gNextNameID(1);
+
+// Lookups by name are spread over shards, each guarded by its own lock.
+static const unsigned int kNameShardCount = 64;
+static const size_t kNameStorageChunkCapacity = 64 * 1024;
+
+typedef struct objctk_nameslot {
+  objctk_nameid nameID;
+  uint32_t hash;
+} objctk_nameslot;
+
+typedef struct alignas(64) objctk_nameshard {
+  std::mutex mutex;
+  objctk_nameslot *slots;
+  size_t capacity;
+  size_t count;
+  char *storage;
+  size_t storageRemaining;
+} objctk_nameshard;
+
+static objctk_nameshard gNameShards[kNameShardCount];
+
+// The name table never frees its memory, so it keeps obtaining memory from the default allocator at
+// the time of its first use even if the default allocator is changed later.
+static const objctk_allocator *nameTableAllocator() {
+  static const objctk_allocator allocator = *defaultAllocator();
+  return &allocator;
+}
+
+// Each thread remembers the names it interned recently so that interning common names again, such
+// as the class names of many object types, rarely locks a shard.
+static const size_t kNameCacheCapacity = 256;
+
+typedef struct objctk_namecacheentry {
+  uint32_t hash;
+  objctk_nameid nameID;
+} objctk_namecacheentry;
+
+static thread_local objctk_namecacheentry tNameCache[kNameCacheCapacity];
+
+static inline uint32_t nameHash(const char *name, const size_t length) {
+  // 32-bit FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (size_t index = 0; index < length; index++) {
+    hash ^= (unsigned char)name[index];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static inline unsigned int nameSegmentIndex(const size_t index, size_t *outSegmentOffset) {
+  // Segment s holds kNameSegmentBaseCapacity * 2^s entries.
+  size_t scaledIndex = (index / kNameSegmentBaseCapacity) + 1;
+  unsigned int segmentIndex = (unsigned int)(63 - __builtin_clzll((unsigned long long)scaledIndex));
+  *outSegmentOffset = index - (((size_t)1 << segmentIndex) - 1) * kNameSegmentBaseCapacity;
+  return segmentIndex;
+}
+
+static std::atomic<const objctk_namerecord *> *nameEntry(const objctk_nameid nameID, const bool createsSegment) {
+  if (nameID == OBJCTK_NAMEID_NONE) {
+    return NULL;
+  }
+  size_t segmentOffset = 0;
+  unsigned int segmentIndex = nameSegmentIndex(nameID - 1, &segmentOffset);
+  if (segmentIndex >= kNameSegmentCount) {
+    return NULL;
+  }
+
+  std::atomic<const objctk_namerecord *> *segment = gNameSegments[segmentIndex].load(std::memory_order_acquire);
+  if ((segment == NULL) && createsSegment) {
+    size_t segmentSize = (kNameSegmentBaseCapacity << segmentIndex) * sizeof(std::atomic<const objctk_namerecord *>);
+    void *memory = allocateMemory(nameTableAllocator(), segmentSize);
+    if (memory == NULL) {
+      return NULL;
+    }
+    memset(memory, 0, segmentSize);
+    std::atomic<const objctk_namerecord *> *newSegment = static_cast<std::atomic<const objctk_namerecord *> *>(memory);
+    if (gNameSegments[segmentIndex].compare_exchange_strong(segment, newSegment, std::memory_order_acq_rel)) {
+      segment = newSegment;
+    } else {
+      deallocateMemory(nameTableAllocator(), memory);
+    }
+  }
+  return (segment != NULL) ? &segment[segmentOffset] : NULL;
+}
+
+static inline const objctk_namerecord *nameRecord(const objctk_nameid nameID) {
+  std::atomic<const objctk_namerecord *> *entry = nameEntry(nameID, false);
+  return (entry != NULL) ? entry->load(std::memory_order_acquire) : NULL;
+}
+
+static inline bool nameRecordMatches(const objctk_namerecord *record, const char *name, const size_t length, const uint32_t hash) {
+  return (record->hash == hash) && (record->length == length) && (memcmp(nameRecordCharacters(record), name, length) == 0);
+}
+
+// Returns the slot holding the name or the empty slot where it belongs. The shard must be locked.
+static objctk_nameslot *findNameSlot(objctk_nameshard *shard, const char *name, const size_t length, const uint32_t hash) {
+  if (shard->capacity == 0) {
+    return NULL;
+  }
+  size_t mask = shard->capacity - 1;
+  size_t index = (hash >> 6) & mask;
+  while (true) {
+    objctk_nameslot *slot = &shard->slots[index];
+    if (slot->nameID == OBJCTK_NAMEID_NONE) {
+      return slot;
+    }
+    if ((slot->hash == hash) && nameRecordMatches(nameRecord(slot->nameID), name, length, hash)) {
+      return slot;
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+static bool growNameShard(objctk_nameshard *shard) {
+  size_t capacity = (shard->capacity == 0) ? 64 : (shard->capacity * 2);
+  objctk_nameslot *slots = static_cast<objctk_nameslot *>(allocateMemory(nameTableAllocator(), capacity * sizeof(objctk_nameslot)));
+  if (slots == NULL) {
+    return false;
+  }
+  memset(slots, 0, capacity * sizeof(objctk_nameslot));
+  for (size_t index = 0; index < shard->capacity; index++) {
+    objctk_nameslot slot = shard->slots[index];
+    if (slot.nameID == OBJCTK_NAMEID_NONE) {
+      continue;
+    }
+    size_t slotIndex = (slot.hash >> 6) & (capacity - 1);
+    while (slots[slotIndex].nameID != OBJCTK_NAMEID_NONE) {
+      slotIndex = (slotIndex + 1) & (capacity - 1);
+    }
+    slots[slotIndex] = slot;
+  }
+  deallocateMemory(nameTableAllocator(), shard->slots);
+  shard->slots = slots;
+  shard->capacity = capacity;
+  return true;
+}
+
+static objctk_namerecord *makeNameRecord(objctk_nameshard *shard, const char *name, const size_t length, const uint32_t hash) {
+  size_t recordSize = (sizeof(objctk_namerecord) + length + 1 + (alignof(objctk_namerecord) - 1)) & ~(alignof(objctk_namerecord) - 1);
+  if (recordSize > shard->storageRemaining) {
+    size_t chunkCapacity = (recordSize > kNameStorageChunkCapacity) ? recordSize : kNameStorageChunkCapacity;
+    char *chunk = static_cast<char *>(allocateMemory(nameTableAllocator(), chunkCapacity));
+    if (chunk == NULL) {
+      return NULL;
+    }
+    shard->storage = chunk;
+    shard->storageRemaining = chunkCapacity;
+  }
+  objctk_namerecord *record = reinterpret_cast<objctk_namerecord *>(shard->storage);
+  shard->storage += recordSize;
+  shard->storageRemaining -= recordSize;
+
+  record->length = (uint32_t)length;
+  record->hash = hash;
+  char *characters = reinterpret_cast<char *>(record + 1);
+  memcpy(characters, name, length);
+  characters[length] = '\0';
+  return record;
+}
+
+static objctk_nameid internUncachedName(const char *name, const size_t length, const uint32_t hash) {
+  objctk_nameshard *shard = &gNameShards[hash % kNameShardCount];
+  std::lock_guard<std::mutex> lock(shard->mutex);
+
+  objctk_nameslot *slot = findNameSlot(shard, name, length, hash);
+  if ((slot != NULL) && (slot->nameID != OBJCTK_NAMEID_NONE)) {
+    return slot->nameID;
+  }
+
+  // Keep the load factor of the shard below 3/4.
+  if ((((shard->count + 1) * 4) > (shard->capacity * 3)) && !growNameShard(shard)) {
+    return OBJCTK_NAMEID_NONE;
+  }
+
+  objctk_namerecord *record = makeNameRecord(shard, name, length, hash);
+  if (record == NULL) {
+    return OBJCTK_NAMEID_NONE;
+  }
+  objctk_nameid nameID = gNextNameID.fetch_add(1, std::memory_order_relaxed);
+  std::atomic<const objctk_namerecord *> *entry = nameEntry(nameID, true);
+  if (entry == NULL) {
+    return OBJCTK_NAMEID_NONE;
+  }
+  entry->store(record, std::memory_order_release);
+
+  slot = findNameSlot(shard, name, length, hash);
+  slot->nameID = nameID;
+  slot->hash = hash;
+  shard->count++;
+  return nameID;
+}
+
+namespace objctk {
+
+objctk_nameid internName(const char *name, size_t length) {
+  if ((name == NULL) || (length == 0) || (length > UINT32_MAX)) {
+    return OBJCTK_NAMEID_NONE;
+  }
+
+  const uint32_t hash = nameHash(name, length);
+  objctk_namecacheentry *cacheEntry = &tNameCache[hash % kNameCacheCapacity];
+  if ((cacheEntry->hash == hash) && (cacheEntry->nameID != OBJCTK_NAMEID_NONE) && nameRecordMatches(nameRecord(cacheEntry->nameID), name, length, hash)) {
+    return cacheEntry->nameID;
+  }
+  const objctk_nameid nameID = internUncachedName(name, length, hash);
+  if (nameID != OBJCTK_NAMEID_NONE) {
+    cacheEntry->hash = hash;
+    cacheEntry->nameID = nameID;
+  }
+  return nameID;
+}
+
+objctk_nameid lookupName(const char *name, size_t length) {
+  if ((name == NULL) || (length == 0) || (length > UINT32_MAX)) {
+    return OBJCTK_NAMEID_NONE;
+  }
+
+  const uint32_t hash = nameHash(name, length);
+  objctk_nameshard *shard = &gNameShards[hash % kNameShardCount];
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  objctk_nameslot *slot = findNameSlot(shard, name, length, hash);
+  return (slot != NULL) ? slot->nameID : OBJCTK_NAMEID_NONE;
+}
+
+const char *internedName(objctk_nameid nameID, size_t *outLength) {
+  const objctk_namerecord *record = nameRecord(nameID);
+  if (record == NULL) {
+    return NULL;
+  }
+  if (outLength != NULL) {
+    *outLength = record->length;
+  }
+  return nameRecordCharacters(record);
+}
+
+}
+
+objctk_nameid objctk_internName(const char *name, size_t length) {
+  return internName(name, length);
+}
+
+objctk_nameid objctk_lookupName(const char *name, size_t length) {
+  return lookupName(name, length);
+}
+
+const char *objctk_getInternedName(objctk_nameid nameID, size_t *outLength) {
+  return internedName(nameID, outLength);
+}
@@ -0,0 +1,48 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_NAME_TABLE__
+#define OBJCTK_NAME_TABLE__
+
+#include "names.h"
+
+#include <stddef.h>
+
+namespace objctk {
+
+/**
+ * Interns a name in the process-wide name table, returning OBJCTK_NAMEID_NONE if the name is empty
+ * or memory could not be allocated.
+ */
+objctk_nameid internName(const char *name, size_t length);
+
+/** Returns the identifier of an interned name or OBJCTK_NAMEID_NONE if it has not been interned. */
+objctk_nameid lookupName(const char *name, size_t length);
+
+/** Returns an interned name or NULL if the identifier is invalid. */
+const char *internedName(objctk_nameid nameID, size_t *outLength);
+
+}
+
+#endif
@@ -0,0 +1,338 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "object-layout.h"
+
+#include "internal-allocator.h"
+#include "layout.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace objctk;
+
+struct _objctk_objectlayout {
+  objctk_allocator allocator;
+  size_t valueSize;
+  size_t slotSize;
+  size_t slotCount;
+  size_t runCount;
+  const objctk_objectlayoutrun *runs;
+  const uint8_t *bitmap;
+};
+
+typedef scratchstack<objctk_objectlayoutrun> objctk_runstack;
+
+// Appends a run, extending the previous run when the run continues it.
+static bool appendRun(objctk_runstack *runs, const objctk_objectlayoutrun run) {
+  if (!runs->empty()) {
+    objctk_objectlayoutrun &previousRun = runs->end()[-1];
+    bool continuesPreviousRun = (previousRun.offset + (previousRun.count * previousRun.stride)) == run.offset;
+    if (continuesPreviousRun && ((previousRun.stride == run.stride) || (run.count == 1))) {
+      previousRun.count += run.count;
+      return true;
+    }
+  }
+  return runs->push_back(run);
+}
+
+// Repeats the runs collected for the first element of an array, which are above runStart, for
+// every element. The number of resulting runs is bounded by the number of reference slots per
+// element however many elements there are.
+static bool repeatElementRuns(objctk_runstack *runs, const size_t runStart, const size_t elementCount, const size_t elementSize) {
+  const size_t runEnd = runs->size();
+  if ((elementCount == 1) || (runEnd == runStart)) {
+    return true;
+  }
+  if (elementCount == 0) {
+    runs->resize(runStart);
+    return true;
+  }
+
+  // A single run that tiles the element continues through every element.
+  objctk_objectlayoutrun &firstRun = runs->begin()[runStart];
+  if ((runEnd == (runStart + 1)) && ((firstRun.count == 1) || ((firstRun.count * firstRun.stride) == elementSize))) {
+    firstRun.stride = (firstRun.count == 1) ? elementSize : firstRun.stride;
+    firstRun.count *= elementCount;
+    return true;
+  }
+
+  // Otherwise either repeat the runs of the element for every element or stride each slot of the
+  // element across the elements, whichever yields fewer runs.
+  size_t elementSlotCount = 0;
+  for (size_t index = runStart; index < runEnd; index++) {
+    elementSlotCount += runs->begin()[index].count;
+  }
+  if (elementCount <= (elementSlotCount / (runEnd - runStart))) {
+    for (size_t elementIndex = 1; elementIndex < elementCount; elementIndex++) {
+      for (size_t index = runStart; index < runEnd; index++) {
+        objctk_objectlayoutrun run = runs->begin()[index];
+        run.offset += elementIndex * elementSize;
+        if (!runs->push_back(run)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  for (size_t index = runStart; index < runEnd; index++) {
+    const objctk_objectlayoutrun run = runs->begin()[index];
+    for (size_t slotIndex = 0; slotIndex < run.count; slotIndex++) {
+      if (!runs->push_back({ run.offset + (slotIndex * run.stride), elementCount, elementSize })) {
+        return false;
+      }
+    }
+  }
+  objctk_objectlayoutrun *stridedRuns = runs->begin() + runEnd;
+  const size_t stridedRunCount = runs->size() - runEnd;
+  std::sort(stridedRuns, stridedRuns + stridedRunCount, [](const objctk_objectlayoutrun &lhs, const objctk_objectlayoutrun &rhs) {
+    return lhs.offset < rhs.offset;
+  });
+  memmove(runs->begin() + runStart, stridedRuns, stridedRunCount * sizeof(objctk_objectlayoutrun));
+  runs->resize(runStart + stridedRunCount);
+  return true;
+}
+
+// Appends the runs of slots holding object references in order of the offsets of their first slots.
+static bool collectObjectReferenceRuns(_objctk_typenode *node, const objctk_layoutrules *rules, const size_t slotSize, const size_t baseOffset, objctk_runstack *runs) {
+  switch (node->typeCategory()) {
+    case OBJCTKTypeCategoryObject:
+    case OBJCTKTypeCategoryClass:
+      return appendRun(runs, { baseOffset, 1, slotSize });
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryTopLevel: {
+      compositetypenode *compositeTypeNode = static_cast<compositetypenode *>(node);
+      bool succeeded = true;
+      objctk_typelayout layout = compositeTypeNode->layoutMembers(rules, [&](_objctk_typenode *memberTypeNode, int offset, int) {
+        if (succeeded && (memberTypeNode->typeCategory() != OBJCTKTypeCategoryBitField)) {
+          succeeded = collectObjectReferenceRuns(memberTypeNode, rules, slotSize, baseOffset + offset, runs);
+        }
+      });
+      return succeeded && (layout.size >= 0);
+    }
+    case OBJCTKTypeCategoryArray: {
+      arraynode *arrayNode = static_cast<arraynode *>(node);
+      _objctk_typenode *elementTypeNode = arrayNode->referencedType();
+      objctk_typelayout elementLayout = elementTypeNode->typeLayout(rules->profile);
+      if ((elementLayout.size < 0) || (arrayNode->typeLayout(rules->profile).size < 0)) {
+        return false;
+      }
+
+      // Collect the runs of the first element without merging them into preceding runs.
+      const size_t runStart = runs->size();
+      objctk_runstack elementRuns(defaultAllocator());
+      if (!collectObjectReferenceRuns(elementTypeNode, rules, slotSize, baseOffset, &elementRuns)) {
+        return false;
+      }
+      for (const objctk_objectlayoutrun &run : elementRuns) {
+        if (!runs->push_back(run)) {
+          return false;
+        }
+      }
+      return repeatElementRuns(runs, runStart, arrayNode->elementCount(), elementLayout.size);
+    }
+    default:
+      // Unions are skipped as their active member is unknown. Other types hold no references.
+      return true;
+  }
+}
+
+static inline uint64_t loadSlot(const char *address, const size_t slotSize) {
+  if (slotSize == sizeof(uint64_t)) {
+    uint64_t value;
+    memcpy(&value, address, sizeof(value));
+    return value;
+  }
+  uint32_t value;
+  memcpy(&value, address, sizeof(value));
+  return value;
+}
+
+// Returns whether four 64-bit slots at a stride are all null.
+static inline bool fourSlotsAreNull(const char *address, const size_t stride) {
+  if (stride != sizeof(uint64_t)) {
+    return (loadSlot(address, 8) | loadSlot(address + stride, 8) | loadSlot(address + (2 * stride), 8) | loadSlot(address + (3 * stride), 8)) == 0;
+  }
+#if defined(__SSE2__)
+  __m128i slots = _mm_or_si128(_mm_loadu_si128((const __m128i *)address), _mm_loadu_si128((const __m128i *)(address + 16)));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(slots, _mm_setzero_si128())) == 0xFFFF;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  uint64x2_t slots = vorrq_u64(vld1q_u64((const uint64_t *)address), vld1q_u64((const uint64_t *)(address + 16)));
+  return vmaxvq_u32(vreinterpretq_u32_u64(slots)) == 0;
+#else
+  return (loadSlot(address, 8) | loadSlot(address + 8, 8) | loadSlot(address + 16, 8) | loadSlot(address + 24, 8)) == 0;
+#endif
+}
+
+static size_t scanRun(
+    const char *value,
+    const size_t valueIndex,
+    const objctk_objectlayoutrun run,
+    const size_t slotSize,
+    objctk_objectreferencefunction referenceFunction,
+    void *context) {
+  size_t referenceCount = 0;
+  size_t slotIndex = 0;
+  if (slotSize == sizeof(uint64_t)) {
+    // Skip blocks of null references, which dominate sparsely populated buffers, four at a time.
+    for (; (slotIndex + 4) <= run.count; slotIndex += 4) {
+      const char *address = value + run.offset + (slotIndex * run.stride);
+      if (fourSlotsAreNull(address, run.stride)) {
+        continue;
+      }
+      for (size_t index = 0; index < 4; index++) {
+        uint64_t reference = loadSlot(address + (index * run.stride), slotSize);
+        if (reference != 0) {
+          referenceFunction(valueIndex, run.offset + ((slotIndex + index) * run.stride), reference, context);
+          ++referenceCount;
+        }
+      }
+    }
+  }
+  for (; slotIndex < run.count; slotIndex++) {
+    size_t offset = run.offset + (slotIndex * run.stride);
+    uint64_t reference = loadSlot(value + offset, slotSize);
+    if (reference != 0) {
+      referenceFunction(valueIndex, offset, reference, context);
+      ++referenceCount;
+    }
+  }
+  return referenceCount;
+}
+
+objctk_objectlayout objctk_objectlayout_create(objctk_typenode node, objctk_layoutprofile profile) {
+  const objctk_layoutrules *rules = layoutRulesForProfile(profile);
+  if ((node == NULL) || (rules == NULL)) {
+    return NULL;
+  }
+  objctk_typelayout layout = node->typeLayout(profile);
+  if (layout.size < 0) {
+    return NULL;
+  }
+
+  const objctk_allocator *allocator = defaultAllocator();
+  const size_t slotSize = rules->sizes[OBJCTKTypeCategoryPointer];
+  objctk_runstack runs(allocator);
+  if (!collectObjectReferenceRuns(node, rules, slotSize, 0, &runs)) {
+    return NULL;
+  }
+
+  // Top-level types are not padded, so their object references may not fall on a slot.
+  for (const objctk_objectlayoutrun &run : runs) {
+    if (((run.offset % slotSize) != 0) || ((run.stride % slotSize) != 0)) {
+      return NULL;
+    }
+  }
+
+  // The layout, its runs and its bitmap share a single allocation.
+  const size_t runCount = runs.size();
+  const size_t slotCount = (layout.size + slotSize - 1) / slotSize;
+  const size_t bitmapSize = (slotCount + CHAR_BIT - 1) / CHAR_BIT;
+  const size_t runsOffset = sizeof(_objctk_objectlayout);
+  const size_t bitmapOffset = runsOffset + (runCount * sizeof(objctk_objectlayoutrun));
+  char *memory = static_cast<char *>(allocateMemory(allocator, bitmapOffset + bitmapSize));
+  if (memory == NULL) {
+    return NULL;
+  }
+  objctk_objectlayoutrun *layoutRuns = reinterpret_cast<objctk_objectlayoutrun *>(memory + runsOffset);
+  uint8_t *bitmap = reinterpret_cast<uint8_t *>(memory + bitmapOffset);
+  memcpy(layoutRuns, runs.begin(), runCount * sizeof(objctk_objectlayoutrun));
+  memset(bitmap, 0, bitmapSize);
+  for (const objctk_objectlayoutrun &run : runs) {
+    for (size_t index = 0; index < run.count; index++) {
+      size_t slotIndex = (run.offset + (index * run.stride)) / slotSize;
+      bitmap[slotIndex / CHAR_BIT] |= (uint8_t)(1 << (slotIndex % CHAR_BIT));
+    }
+  }
+
+  objctk_objectlayout objectLayout = new (memory) _objctk_objectlayout();
+  objectLayout->allocator = *allocator;
+  objectLayout->valueSize = layout.size;
+  objectLayout->slotSize = slotSize;
+  objectLayout->slotCount = slotCount;
+  objectLayout->runCount = runCount;
+  objectLayout->runs = layoutRuns;
+  objectLayout->bitmap = bitmap;
+  return objectLayout;
+}
+
+size_t objctk_objectlayout_getValueSize(objctk_objectlayout layout) {
+  return (layout != NULL) ? layout->valueSize : 0;
+}
+
+size_t objctk_objectlayout_getSlotSize(objctk_objectlayout layout) {
+  return (layout != NULL) ? layout->slotSize : 0;
+}
+
+const objctk_objectlayoutrun *objctk_objectlayout_getRuns(objctk_objectlayout layout, size_t *outCount) {
+  if (outCount != NULL) {
+    *outCount = (layout != NULL) ? layout->runCount : 0;
+  }
+  return (layout != NULL) ? layout->runs : NULL;
+}
+
+const uint8_t *objctk_objectlayout_getBitmap(objctk_objectlayout layout, size_t *outSlotCount) {
+  if (outSlotCount != NULL) {
+    *outSlotCount = (layout != NULL) ? layout->slotCount : 0;
+  }
+  return (layout != NULL) ? layout->bitmap : NULL;
+}
+
+size_t objctk_objectlayout_scanValues(
+    objctk_objectlayout layout,
+    const void *values,
+    size_t valueCount,
+    objctk_objectreferencefunction referenceFunction,
+    void *context) {
+  if ((layout == NULL) || (values == NULL) || (referenceFunction == NULL) || (layout->runCount == 0)) {
+    return 0;
+  }
+
+  size_t referenceCount = 0;
+  const char *value = static_cast<const char *>(values);
+  for (size_t valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+    for (size_t runIndex = 0; runIndex < layout->runCount; runIndex++) {
+      referenceCount += scanRun(value, valueIndex, layout->runs[runIndex], layout->slotSize, referenceFunction, context);
+    }
+    value += layout->valueSize;
+  }
+  return referenceCount;
+}
+
+void objctk_objectlayout_release(objctk_objectlayout layout) {
+  if (layout == NULL) {
+    return;
+  }
+  objctk_allocator allocator = layout->allocator;
+  deallocateMemory(&allocator, layout);
+}
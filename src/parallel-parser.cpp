@@ -0,0 +1,505 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "type-encoding.h"
+
+#include "arena.h"
+#include "internal-allocator.h"
+#include "internal-statistics.h"
+#include "parser.h"
+#include "structural-characters.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <system_error>
+#include <thread>
+
+using namespace objctk;
+
+// Encodings shorter than this are parsed serially as the cost of handing chunks to worker threads
+// would dominate.
+static const size_t kMinimumParallelEncodingLength = 16 * 1024;
+
+// The number of worker threads is bounded regardless of the requested thread counts.
+static const unsigned int kMaximumParserWorkerCount = 64;
+
+typedef scratchstack<size_t> objctk_offsetstack;
+
+// A range of top-level members of the outermost composite type parsed by one thread.
+struct objctk_parallelchunk {
+  objctk_range range;
+  arena nodeArena;
+  _objctk_typenode_stack memberTypes;
+  _objctk_rangeparse rangeParse;
+
+  objctk_parallelchunk(const objctk_range range, const objctk_allocator *allocator) : range(range), nodeArena(allocator), memberTypes(allocator), rangeParse() {}
+};
+
+// Appends the offsets of all structural characters of the input in increasing order.
+static bool collectStructuralOffsets(const char *input, const size_t length, objctk_offsetstack *offsets) {
+  size_t offset = 0;
+#if OBJCTK_HAS_STRUCTURAL_CHARACTER_MASK
+  for (; (offset + kStructuralCharacterBlockSize) <= length; offset += kStructuralCharacterBlockSize) {
+    for (uint64_t mask = structuralCharacterMask(input + offset); mask != 0; mask = maskWithoutFirstStructuralCharacter(mask)) {
+      if (!offsets->push_back(offset + firstStructuralCharacterIndex(mask))) {
+        return false;
+      }
+    }
+  }
+#endif
+  for (; offset < length; offset++) {
+    if (isStructuralCharacter(input[offset]) && !offsets->push_back(offset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline char closingBracketForOpeningBracket(const char ch) {
+  switch (ch) {
+    case '{': return '}';
+    case '(': return ')';
+    case '[': return ']';
+    default: return '\0';
+  }
+}
+
+// Tracks the nesting depth across the structural characters of an encoding consisting of a single
+// struct or union, skipping the names of composite types and the class names of object pointers as
+// the lexer does. Appends the offsets following each member of the outermost composite type which
+// ends in a closing bracket, and returns the offset of the first member of the outermost composite
+// type or zero if the brackets of the encoding are not balanced.
+static size_t collectMemberBoundaries(const char *input, const size_t length, const objctk_offsetstack *structuralOffsets, objctk_offsetstack *memberBoundaries, const objctk_allocator *allocator) {
+  if ((length == 0) || ((input[0] != '{') && (input[0] != '('))) {
+    return 0;
+  }
+  scratchstack<char> closingBrackets(allocator);
+  size_t firstMemberOffset = 0;
+  bool isInTypeName = false;
+  bool isInClassName = false;
+  for (const size_t *iterator = structuralOffsets->begin(); iterator != structuralOffsets->end(); iterator++) {
+    const size_t offset = *iterator;
+    const char ch = input[offset];
+    if (isInClassName) {
+      isInClassName = (ch != '"');
+      continue;
+    }
+    if (isInTypeName) {
+      // Composite types without members end their name at their closing bracket.
+      if ((ch != '=') && (ch != '}') && (ch != ')')) {
+        continue;
+      }
+      isInTypeName = false;
+      if (ch == '=') {
+        if (firstMemberOffset == 0) {
+          firstMemberOffset = offset + 1;
+        }
+        continue;
+      }
+    }
+
+    switch (ch) {
+      case '"':
+        isInClassName = ((offset > 0) && (input[offset - 1] == '@'));
+        break;
+      case '{':
+      case '(':
+        isInTypeName = true;
+        // fall through
+      case '[':
+        if ((offset == 0) != closingBrackets.empty()) {
+          return 0;
+        }
+        if (!closingBrackets.push_back(closingBracketForOpeningBracket(ch))) {
+          return 0;
+        }
+        break;
+      case '}':
+      case ')':
+      case ']':
+        if (closingBrackets.empty() || (closingBrackets.back() != ch)) {
+          return 0;
+        }
+        closingBrackets.pop_back();
+        if (closingBrackets.size() == 1) {
+          if (!memberBoundaries->push_back(offset + 1)) {
+            return 0;
+          }
+        } else if (closingBrackets.empty() && (offset != (length - 1))) {
+          return 0;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  if (!closingBrackets.empty() || isInTypeName || isInClassName) {
+    return 0;
+  }
+  return firstMemberOffset;
+}
+
+// Divides the members of the outermost composite type into at most chunkCount ranges of similar
+// length which start at member boundaries.
+static bool makeChunkRanges(const size_t firstMemberOffset, const size_t endOffset, const objctk_offsetstack *memberBoundaries, const unsigned int chunkCount, scratchstack<objctk_range> *chunkRanges) {
+  const size_t membersLength = endOffset - firstMemberOffset;
+  const size_t *boundary = memberBoundaries->begin();
+  size_t chunkOffset = firstMemberOffset;
+  for (unsigned int chunkIndex = 1; chunkIndex < chunkCount; chunkIndex++) {
+    const size_t targetOffset = firstMemberOffset + (membersLength / chunkCount) * chunkIndex;
+    while ((boundary != memberBoundaries->end()) && (*boundary < targetOffset)) {
+      boundary++;
+    }
+    if ((boundary == memberBoundaries->end()) || (*boundary >= endOffset)) {
+      break;
+    }
+    if (*boundary > chunkOffset) {
+      if (!chunkRanges->push_back(makeRange(chunkOffset, *boundary - chunkOffset))) {
+        return false;
+      }
+      chunkOffset = *boundary;
+    }
+  }
+  return chunkRanges->push_back(makeRange(chunkOffset, endOffset - chunkOffset));
+}
+
+// The chunks of one parallel parse which are claimed by worker threads and the calling thread.
+struct objctk_chunkbatch {
+  const char *typeEncoding;
+  const objctk_parselimits *limits;
+  uint64_t startTimestamp;
+  objctk_parallelchunk **chunks;
+  size_t chunkCount;
+  size_t claimedCount;
+  size_t parsedCount;
+  objctk_chunkbatch *next;
+};
+
+static void parseChunk(const objctk_chunkbatch *batch, objctk_parallelchunk *chunk) {
+  // The members of a chunk are nested within the outermost composite type. Each chunk is held to
+  // the limits on its own, which bounds the work of every thread; the combined node and byte counts
+  // are checked once the chunks are stitched together.
+  chunk->rangeParse = parseTypeSequence(batch->typeEncoding, chunk->range, 1, &chunk->nodeArena, &chunk->memberTypes, batch->limits, batch->startTimestamp);
+}
+
+// Worker threads are spawned as parallel parses request them and are reused by later parses rather
+// than spawned for every parse. They wait for batches with unclaimed chunks for the lifetime of the
+// process, so the pool is never destroyed.
+struct objctk_parserworkerpool {
+  std::mutex lock;
+  std::condition_variable batchQueued;
+  std::condition_variable chunkParsed;
+  objctk_chunkbatch *firstBatch;
+  objctk_chunkbatch *lastBatch;
+  unsigned int workerCount;
+
+  objctk_parserworkerpool() : firstBatch(NULL), lastBatch(NULL), workerCount(0) {}
+};
+
+static objctk_parserworkerpool *parserWorkerPool() {
+  static objctk_parserworkerpool *pool = makeObject<objctk_parserworkerpool>(defaultAllocator());
+  return pool;
+}
+
+static void dequeueBatch(objctk_parserworkerpool *pool, objctk_chunkbatch *batch) {
+  objctk_chunkbatch **link = &pool->firstBatch;
+  objctk_chunkbatch *previousBatch = NULL;
+  while ((*link != NULL) && (*link != batch)) {
+    previousBatch = *link;
+    link = &(*link)->next;
+  }
+  if (*link == NULL) {
+    return;
+  }
+  *link = batch->next;
+  if (pool->lastBatch == batch) {
+    pool->lastBatch = previousBatch;
+  }
+  batch->next = NULL;
+}
+
+// Claims the next unclaimed chunk of a batch, dequeuing the batch once all its chunks are claimed.
+// The pool lock must be held.
+static objctk_parallelchunk *claimChunk(objctk_parserworkerpool *pool, objctk_chunkbatch *batch) {
+  if (batch->claimedCount == batch->chunkCount) {
+    return NULL;
+  }
+  objctk_parallelchunk *chunk = batch->chunks[batch->claimedCount++];
+  if (batch->claimedCount == batch->chunkCount) {
+    dequeueBatch(pool, batch);
+  }
+  return chunk;
+}
+
+static void runParserWorker(objctk_parserworkerpool *pool) {
+  std::unique_lock<std::mutex> lock(pool->lock);
+  while (true) {
+    pool->batchQueued.wait(lock, [pool] { return pool->firstBatch != NULL; });
+    objctk_chunkbatch *batch = pool->firstBatch;
+    objctk_parallelchunk *chunk = claimChunk(pool, batch);
+    lock.unlock();
+    parseChunk(batch, chunk);
+    lock.lock();
+    if (++batch->parsedCount == batch->chunkCount) {
+      pool->chunkParsed.notify_all();
+    }
+  }
+}
+
+// Spawns workers until the pool holds workerCount of them, returning false if none could be
+// spawned. The pool lock must be held.
+static bool ensureParserWorkers(objctk_parserworkerpool *pool, unsigned int workerCount) {
+  workerCount = (workerCount < kMaximumParserWorkerCount) ? workerCount : kMaximumParserWorkerCount;
+  while (pool->workerCount < workerCount) {
+    try {
+      std::thread(runParserWorker, pool).detach();
+    } catch (const std::system_error &) {
+      break;
+    }
+    ++pool->workerCount;
+  }
+  return pool->workerCount > 0;
+}
+
+// Parses the chunks of a batch on the worker threads of the pool with the calling thread claiming
+// chunks alongside them. Chunks are parsed on the calling thread alone if no workers are available.
+static void parseChunkBatch(objctk_chunkbatch *batch, const unsigned int threadCount) {
+  objctk_parserworkerpool *pool = parserWorkerPool();
+  std::unique_lock<std::mutex> lock;
+  if (pool != NULL) {
+    lock = std::unique_lock<std::mutex>(pool->lock);
+    if (ensureParserWorkers(pool, threadCount - 1)) {
+      if (pool->lastBatch != NULL) {
+        pool->lastBatch->next = batch;
+      } else {
+        pool->firstBatch = batch;
+      }
+      pool->lastBatch = batch;
+      pool->batchQueued.notify_all();
+    }
+  }
+
+  for (size_t index = 0; index < batch->chunkCount; index++) {
+    objctk_parallelchunk *chunk = (pool != NULL) ? claimChunk(pool, batch) : batch->chunks[batch->claimedCount++];
+    if (chunk == NULL) {
+      break;
+    }
+    if (pool != NULL) {
+      lock.unlock();
+    }
+    parseChunk(batch, chunk);
+    if (pool != NULL) {
+      lock.lock();
+    }
+    ++batch->parsedCount;
+  }
+  if (pool != NULL) {
+    pool->chunkParsed.wait(lock, [batch] { return batch->parsedCount == batch->chunkCount; });
+  }
+}
+
+// A chunk reproduces the serial parse if it parsed without unexpected tokens and every chunk but
+// the last ends with a member.
+static bool chunkMatchesSerialParse(const objctk_parallelchunk *chunk, const bool isLastChunk) {
+  if (chunk->rangeParse.unexpected_token_count != 0) {
+    return false;
+  }
+  if (isLastChunk || (chunk->rangeParse.status.status_code != objctk_statuscode_NoError)) {
+    return true;
+  }
+  if (chunk->memberTypes.size() == 0) {
+    return false;
+  }
+  const objctk_substring lastMemberSubstring = chunk->memberTypes.back()->substring();
+  return (lastMemberSubstring.offset + lastMemberSubstring.length) == (chunk->range.offset + chunk->range.length);
+}
+
+// Parses the chunks of an encoding on up to one thread per chunk and stitches their member types
+// into the outermost composite type. Returns false if the result differs from a serial parse.
+static bool parseChunksInParallel(const char *typeEncoding, const size_t length, scratchstack<objctk_parallelchunk *> *chunks, const objctk_parselimits *limits, const uint64_t startTimestamp, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack, objctk_parsesample *sample) {
+  objctk_chunkbatch batch = {
+    .typeEncoding = typeEncoding,
+    .limits = limits,
+    .startTimestamp = startTimestamp,
+    .chunks = chunks->begin(),
+    .chunkCount = chunks->size(),
+    .claimedCount = 0,
+    .parsedCount = 0,
+    .next = NULL,
+  };
+  parseChunkBatch(&batch, (unsigned int)chunks->size());
+
+  for (objctk_parallelchunk **chunk = chunks->begin(); chunk != chunks->end(); chunk++) {
+    if (!chunkMatchesSerialParse(*chunk, (chunk + 1) == chunks->end())) {
+      return false;
+    }
+    sample->tokenCount += (*chunk)->rangeParse.token_count;
+    sample->nodeCount += (*chunk)->rangeParse.node_count;
+    if ((*chunk)->rangeParse.status.status_code != objctk_statuscode_NoError) {
+      result->status = (*chunk)->rangeParse.status;
+      return true;
+    }
+  }
+
+  for (objctk_parallelchunk **chunk = chunks->begin(); chunk != chunks->end(); chunk++) {
+    for (_objctk_typenode_ptr *memberType = (*chunk)->memberTypes.begin(); memberType != (*chunk)->memberTypes.end(); memberType++) {
+      if (!scratchStack->push_back(*memberType)) {
+        result->status = { objctk_statuscode_OutOfMemory, "Unable to grow the parser stack." };
+        return true;
+      }
+    }
+  }
+  _objctk_rangeparse rangeParse;
+  result->node = parseCompositeTypeWithMembers(typeEncoding, makeRange(0, length), &result->arena, scratchStack, 0, limits, startTimestamp, &rangeParse);
+  if (rangeParse.unexpected_token_count != 0) {
+    return false;
+  }
+  result->status = rangeParse.status;
+  sample->tokenCount += rangeParse.token_count;
+  sample->nodeCount += rangeParse.node_count;
+  for (objctk_parallelchunk **chunk = chunks->begin(); chunk != chunks->end(); chunk++) {
+    result->arena.adoptBlocks(&(*chunk)->nodeArena);
+  }
+  if ((result->status.status_code == objctk_statuscode_NoError) && (limits != NULL)) {
+    if ((limits->maximumNodeCount != 0) && (sample->nodeCount > limits->maximumNodeCount)) {
+      result->status = { objctk_statuscode_LimitExceeded, "The type encoding exceeds the maximum node count." };
+    } else if ((limits->maximumByteCount != 0) && (result->arena.usedByteCount() > limits->maximumByteCount)) {
+      result->status = { objctk_statuscode_LimitExceeded, "The type encoding exceeds the maximum byte count." };
+    }
+  }
+  if ((result->status.status_code == objctk_statuscode_NoError) && (result->node != NULL) && !internTypeNames(typeEncoding, result->node, scratchStack)) {
+    result->status = { objctk_statuscode_OutOfMemory, "Unable to intern a type name." };
+  }
+  return true;
+}
+
+// Attempts to parse an encoding consisting of a single struct or union in parallel. Returns false
+// without modifying the parse result if the encoding must be parsed serially.
+static bool parseTypeEncodingInParallel(const char *typeEncoding, const unsigned int threadCount, const objctk_parselimits *limits, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack) {
+  if (threadCount <= 1) {
+    return false;
+  }
+  // Encodings over the maximum input length are left to the serial parse to reject without
+  // measuring the rest of the input.
+  const size_t maximumInputLength = (limits != NULL) ? limits->maximumInputLength : 0;
+  const size_t length = (maximumInputLength != 0) ? strnlen(typeEncoding, maximumInputLength + 1) : strlen(typeEncoding);
+  if ((length < kMinimumParallelEncodingLength) || ((maximumInputLength != 0) && (length > maximumInputLength))) {
+    return false;
+  }
+
+  const bool recordsStatistics = statisticsEnabled();
+  const bool hasDeadline = (limits != NULL) && (limits->maximumNanoseconds != 0);
+  const uint64_t startTimestamp = (recordsStatistics || hasDeadline) ? statisticsTimestamp() : 0;
+
+  const objctk_allocator *allocator = &result->allocator;
+  objctk_offsetstack memberBoundaries(allocator);
+  size_t firstMemberOffset = 0;
+  {
+    objctk_offsetstack structuralOffsets(allocator);
+    if (!collectStructuralOffsets(typeEncoding, length, &structuralOffsets)) {
+      return false;
+    }
+    firstMemberOffset = collectMemberBoundaries(typeEncoding, length, &structuralOffsets, &memberBoundaries, allocator);
+  }
+  if (firstMemberOffset == 0) {
+    return false;
+  }
+
+  scratchstack<objctk_range> chunkRanges(allocator);
+  if (!makeChunkRanges(firstMemberOffset, length - 1, &memberBoundaries, threadCount, &chunkRanges) || (chunkRanges.size() <= 1)) {
+    return false;
+  }
+
+  scratchstack<objctk_parallelchunk *> chunks(allocator);
+  bool isParsed = true;
+  for (objctk_range *chunkRange = chunkRanges.begin(); chunkRange != chunkRanges.end(); chunkRange++) {
+    objctk_parallelchunk *chunk = makeObject<objctk_parallelchunk>(allocator, *chunkRange, allocator);
+    if ((chunk != NULL) && !chunks.push_back(chunk)) {
+      releaseObject(allocator, chunk);
+      chunk = NULL;
+    }
+    if (chunk == NULL) {
+      isParsed = false;
+      break;
+    }
+  }
+
+  objctk_parsesample sample = {
+    .failed = false,
+    .inputByteCount = length,
+    .tokenCount = 0,
+    .nodeCount = 0,
+    .retainedByteCount = 0,
+    .nanoseconds = 0,
+  };
+  if (isParsed) {
+    isParsed = parseChunksInParallel(typeEncoding, length, &chunks, limits, startTimestamp, result, scratchStack, &sample);
+  }
+  for (objctk_parallelchunk **chunk = chunks.begin(); chunk != chunks.end(); chunk++) {
+    releaseObject(allocator, *chunk);
+  }
+  if (!isParsed || (result->status.status_code != objctk_statuscode_NoError)) {
+    // Release any partially constructed type tree.
+    result->node = NULL;
+    result->arena.reset();
+    scratchStack->clear();
+  }
+  if (!isParsed) {
+    result->status = { objctk_statuscode_NoError, NULL };
+    return false;
+  }
+
+  if (recordsStatistics) {
+    sample.failed = (result->status.status_code != objctk_statuscode_NoError);
+    sample.retainedByteCount = sizeof(_objctk_typeparseresult) + result->arena.reservedByteCount();
+    sample.nanoseconds = statisticsTimestamp() - startTimestamp;
+    recordParseSample(&sample);
+  }
+  return true;
+}
+
+objctk_typeparseresult objctk_parseTypeEncodingInParallel(const char *typeEncoding, unsigned int threadCount, const objctk_allocator *allocator) {
+  return objctk_parseTypeEncodingInParallelWithLimits(typeEncoding, threadCount, NULL, allocator);
+}
+
+objctk_typeparseresult objctk_parseTypeEncodingInParallelWithLimits(const char *typeEncoding, unsigned int threadCount, const objctk_parselimits *limits, const objctk_allocator *allocator) {
+  if (typeEncoding == NULL) {
+    return NULL;
+  }
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+  objctk_typeparseresult parseResult = makeObject<_objctk_typeparseresult>(allocator, allocator);
+  if (parseResult == NULL) {
+    return NULL;
+  }
+  _objctk_typenode_stack scratchStack(allocator);
+  if (!parseTypeEncodingInParallel(typeEncoding, threadCount, limits, parseResult, &scratchStack)) {
+    parseTypeEncoding(typeEncoding, parseResult, &scratchStack, limits);
+  }
+  return parseResult;
+}
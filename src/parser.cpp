@@ -24,14 +24,19 @@ SOFTWARE.
 
 #include "parser.h"
 
+#include "internal-hot-encodings.h"
+#include "internal-statistics.h"
 #include "lexer.h"
+#include "name-table.h"
 #include "typenode.h"
 #include "typenode-subtypes.h"
 
 #include <ctype.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 using namespace objctk;
 
@@ -48,67 +53,182 @@ static inline objctk_lexeme mergedLexeme(objctk_lexeme l1, objctk_lexeme l2) {
 typedef struct objctk_parserstate {
   objctk_lexerstate lexerState;
   _objctk_parsestatus status;
+  arena *nodeArena;
+  _objctk_typenode_stack *scratchStack;
+  size_t nodeCount;
+
+  // Unexpected tokens are always counted but only logged when parsing a whole type encoding without
+  // resource limits, which are applied to untrusted input.
+  bool logsUnexpectedTokens;
+  size_t unexpectedTokenCount;
+
+  // Resource limits, of which zero values are unlimited except for the maximum depth. The deadline
+  // is only compared against the clock every kDeadlineCheckInterval tokens.
+  unsigned int depth;
+  unsigned int maximumDepth;
+  size_t maximumNodeCount;
+  size_t maximumByteCount;
+  uint64_t deadline;
+  unsigned int tokensUntilDeadlineCheck;
 } objctk_parserstate;
 
-static inline objctk_parserstate makeParserState(const char *input) {
+static const unsigned int kDeadlineCheckInterval = 256;
+
+static inline objctk_parserstate makeParserState(const objctk_lexerstate lexerState, arena *nodeArena, _objctk_typenode_stack *scratchStack, const bool logsUnexpectedTokens) {
   objctk_parserstate parserState = {
-    .lexerState = makeLexerState(input),
+    .lexerState = lexerState,
     .status = {
       .status_code = objctk_statuscode_NoError,
+      .error_description = NULL,
     },
+    .nodeArena = nodeArena,
+    .scratchStack = scratchStack,
+    .nodeCount = 0,
+    .logsUnexpectedTokens = logsUnexpectedTokens,
+    .unexpectedTokenCount = 0,
+    .depth = 0,
+    .maximumDepth = OBJCTK_DEFAULT_MAXIMUM_PARSE_DEPTH,
+    .maximumNodeCount = 0,
+    .maximumByteCount = 0,
+    .deadline = 0,
+    .tokensUntilDeadlineCheck = kDeadlineCheckInterval,
   };
   return parserState;
 }
 
-#define BASIC_TYPE_MAPPING(code, type) case code: return type
-static objctk_typecategory typeCategoryFromBasicTypeCode(char code) {
-  switch (code) {
-    BASIC_TYPE_MAPPING('c', OBJCTKTypeCategorySignedChar);
-    BASIC_TYPE_MAPPING('i', OBJCTKTypeCategorySignedInt);
-    BASIC_TYPE_MAPPING('s', OBJCTKTypeCategorySignedShort);
-    BASIC_TYPE_MAPPING('l', OBJCTKTypeCategorySignedLong);
-    BASIC_TYPE_MAPPING('q', OBJCTKTypeCategorySignedLongLong);
-    BASIC_TYPE_MAPPING('C', OBJCTKTypeCategoryUnsignedChar);
-    BASIC_TYPE_MAPPING('I', OBJCTKTypeCategoryUnsignedInt);
-    BASIC_TYPE_MAPPING('S', OBJCTKTypeCategoryUnsignedShort);
-    BASIC_TYPE_MAPPING('L', OBJCTKTypeCategoryUnsignedLong);
-    BASIC_TYPE_MAPPING('Q', OBJCTKTypeCategoryUnsignedLongLong);
-    BASIC_TYPE_MAPPING('f', OBJCTKTypeCategoryFloat);
-    BASIC_TYPE_MAPPING('d', OBJCTKTypeCategoryDouble);
-    BASIC_TYPE_MAPPING('B', OBJCTKTypeCategoryBool);
-    default:
-      return OBJCTKTypeCategoryUnknown;
+static inline void applyParseLimits(objctk_parserstate *parserState, const objctk_parselimits *limits, const uint64_t startTimestamp) {
+  if (limits == NULL) {
+    return;
+  }
+  if (limits->maximumDepth != 0) {
+    parserState->maximumDepth = limits->maximumDepth;
+  }
+  parserState->maximumNodeCount = limits->maximumNodeCount;
+  parserState->maximumByteCount = limits->maximumByteCount;
+  if (limits->maximumNanoseconds != 0) {
+    parserState->deadline = startTimestamp + limits->maximumNanoseconds;
   }
 }
-#undef BASIC_TYPE_MAPPING
 
-#define LOCAL_LEXEME_BUFFER(typeEncoding, lexemeBufferName, lexeme) \
-  char lexemeBufferName[lexeme.length + 1]; \
-  memcpy(lexemeBufferName, typeEncoding + lexeme.offset, lexeme.length); \
-  lexemeBufferName[lexeme.length] = '\0'
+static inline _objctk_rangeparse makeRangeParse(const objctk_parserstate *parserState) {
+  _objctk_rangeparse rangeParse = {
+    .status = parserState->status,
+    .token_count = parserState->lexerState.tokenCount,
+    .node_count = parserState->nodeCount,
+    .unexpected_token_count = parserState->unexpectedTokenCount,
+  };
+  return rangeParse;
+}
+
+static inline void setParseError(objctk_parserstate *parserState, const objctk_statuscode statusCode, const char *errorDescription) {
+  // Only the first error is reported.
+  if (parserState->status.status_code != objctk_statuscode_NoError) {
+    return;
+  }
+  parserState->status.status_code = statusCode;
+  parserState->status.error_description = errorDescription;
+}
+
+static inline bool hasParseError(objctk_parserstate *parserState) {
+  return (parserState->status.status_code != objctk_statuscode_NoError);
+}
+
+template <typename T, typename... Arguments>
+static inline _objctk_typenode_ptr makeTypeNode(objctk_parserstate *parserState, Arguments&&... arguments) {
+  if ((parserState->maximumNodeCount != 0) && (parserState->nodeCount >= parserState->maximumNodeCount)) {
+    setParseError(parserState, objctk_statuscode_LimitExceeded, "The type encoding exceeds the maximum number of type nodes.");
+    return NULL;
+  }
+  _objctk_typenode_ptr typeNode = parserState->nodeArena->make<T>(std::forward<Arguments>(arguments)...);
+  if (typeNode == NULL) {
+    setParseError(parserState, objctk_statuscode_OutOfMemory, "Unable to allocate a type node.");
+    return NULL;
+  }
+  if ((parserState->maximumByteCount != 0) && (parserState->nodeArena->usedByteCount() > parserState->maximumByteCount)) {
+    setParseError(parserState, objctk_statuscode_LimitExceeded, "The type encoding exceeds the maximum number of bytes.");
+    return NULL;
+  }
+  parserState->nodeCount++;
+  return typeNode;
+}
+
+static inline bool hasPassedDeadline(objctk_parserstate *parserState) {
+  if ((parserState->deadline == 0) || (--parserState->tokensUntilDeadlineCheck != 0)) {
+    return false;
+  }
+  parserState->tokensUntilDeadlineCheck = kDeadlineCheckInterval;
+  if (statisticsTimestamp() <= parserState->deadline) {
+    return false;
+  }
+  setParseError(parserState, objctk_statuscode_LimitExceeded, "The type encoding could not be parsed before the deadline.");
+  return true;
+}
+
+static inline uint64_t hashTypeName(objctk_parserstate *parserState, const objctk_substring typeName) {
+  return typeNameStructuralHash(parserState->lexerState.input + typeName.offset, typeName.length);
+}
+
+// Interns the type names of a successfully parsed type, failing the parse if memory could not be
+// allocated.
+static void internParsedTypeNames(objctk_parserstate *parserState, _objctk_typenode_ptr typeNode) {
+  if (!hasParseError(parserState) && (typeNode != NULL) && !internTypeNames(parserState->lexerState.input, typeNode, parserState->scratchStack)) {
+    setParseError(parserState, objctk_statuscode_OutOfMemory, "Unable to intern a type name.");
+  }
+}
+
+// Only the first few unexpected tokens of a parse are logged, and only their leading characters, so
+// that malformed encodings cannot flood the log.
+static const size_t kMaximumLoggedUnexpectedTokenCount = 4;
+static const size_t kMaximumLoggedLexemeLength = 64;
 
 static inline void logUnexpectedToken(objctk_parserstate *parserState, objctk_token token) {
-  LOCAL_LEXEME_BUFFER(parserState->lexerState.input, unexpectedLexeme, token.value);
-  printf("Unexpected token:  %d ('%s')\n", token.name, unexpectedLexeme);
+  parserState->unexpectedTokenCount++;
+  if (!parserState->logsUnexpectedTokens || (parserState->unexpectedTokenCount > kMaximumLoggedUnexpectedTokenCount)) {
+    return;
+  }
+  const int loggedLength = (int)std::min(token.value.length, kMaximumLoggedLexemeLength);
+  const char *ellipsis = (token.value.length > kMaximumLoggedLexemeLength) ? "..." : "";
+  fprintf(stderr, "Unexpected token:  %d ('%.*s%s')\n", token.name, loggedLength, parserState->lexerState.input + token.value.offset, ellipsis);
+}
+
+// Returns the decimal number following the first character of an array or bitfield token, saturating
+// at SIZE_MAX so that counts too large to represent yield invalid layouts instead of wrapping around.
+static size_t decimalCountFollowingTokenStart(const char *input, const objctk_lexeme lexeme) {
+  size_t count = 0;
+  for (size_t index = lexeme.offset + 1; index < (lexeme.offset + lexeme.length); index++) {
+    const size_t digit = (size_t)(input[index] - '0');
+    if (count > ((SIZE_MAX - digit) / 10)) {
+      return SIZE_MAX;
+    }
+    count = (count * 10) + digit;
+  }
+  return count;
 }
 
 static _objctk_typenode_ptr parseCompositeType(objctk_parserstate *parserState, const size_t starting_offset, const objctk_token *startingToken);
 
 static _objctk_typenode_ptr parseTypeFromToken(objctk_parserstate *parserState, objctk_token token) {
+  // Nested types are parsed recursively so their depth is limited to bound the stack usage.
+  if (parserState->depth >= parserState->maximumDepth) {
+    setParseError(parserState, objctk_statuscode_LimitExceeded, "The type encoding exceeds the maximum nesting depth.");
+    return NULL;
+  }
+  parserState->depth++;
+
   _objctk_typenode_ptr typeNode = nullptr;
   const char *input = parserState->lexerState.input;
   switch (token.name) {
     case OBJCTKTokenNameBasicType:
-      typeNode = _objctk_typenode_ptr(new _objctk_typenode(token.value, typeCategoryFromBasicTypeCode(input[token.value.offset])));
+      typeNode = makeTypeNode<_objctk_typenode>(parserState, token.value, typeCategoryFromBasicTypeCode(input[token.value.offset]));
       break;
     case OBJCTKTokenNameUnknownType:
-      typeNode = _objctk_typenode_ptr(new _objctk_typenode(token.value, OBJCTKTypeCategoryUnknown));
+      typeNode = makeTypeNode<_objctk_typenode>(parserState, token.value, OBJCTKTypeCategoryUnknown);
       break;
     case OBJCTKTokenNameVoidType:
-      typeNode = _objctk_typenode_ptr(new _objctk_typenode(token.value, OBJCTKTypeCategoryVoid));
+      typeNode = makeTypeNode<_objctk_typenode>(parserState, token.value, OBJCTKTypeCategoryVoid);
       break;
     case OBJCTKTokenNameCharacterStringType:
-      typeNode = _objctk_typenode_ptr(new pointernode(token.value, OBJCTKTypeCategoryCharacterString, nullptr));
+      typeNode = makeTypeNode<pointernode>(parserState, token.value, OBJCTKTypeCategoryCharacterString, nullptr);
       break;
     case OBJCTKTokenNameStructDeclarationStart:
       typeNode = parseCompositeType(parserState, token.value.offset, &token);
@@ -119,106 +239,344 @@ static _objctk_typenode_ptr parseTypeFromToken(objctk_parserstate *parserState,
     case OBJCTKTokenNamePointerType: {
       objctk_token nextToken = lexer_nextToken(&(parserState->lexerState));
       _objctk_typenode_ptr subtypeNode = parseTypeFromToken(parserState, nextToken);
+      if (subtypeNode == NULL) {
+        break;
+      }
       objctk_substring fullSubstring = mergedLexeme(token.value, subtypeNode->substring());
-      typeNode = _objctk_typenode_ptr(new pointernode(fullSubstring, OBJCTKTypeCategoryPointer, subtypeNode));
+      typeNode = makeTypeNode<pointernode>(parserState, fullSubstring, OBJCTKTypeCategoryPointer, subtypeNode);
       break;
     }
     case OBJCTKTokenNameBitfieldType: {
-      size_t bitfield_size = (size_t)atoi(input + (token.value.offset + 1));
-      typeNode = _objctk_typenode_ptr(new bitfieldnode(token.value, bitfield_size));
+      size_t bitfield_size = decimalCountFollowingTokenStart(input, token.value);
+      typeNode = makeTypeNode<bitfieldnode>(parserState, token.value, bitfield_size);
       break;
     }
     case OBJCTKTokenNameArrayDeclarationStart: {
-      size_t array_size = (size_t)atoi(input + (token.value.offset + 1));
+      size_t array_size = decimalCountFollowingTokenStart(input, token.value);
       objctk_token nextToken = lexer_nextToken(&(parserState->lexerState));
       _objctk_typenode_ptr subtypeNode = parseTypeFromToken(parserState, nextToken);
+      if (subtypeNode == NULL) {
+        break;
+      }
       objctk_token terminatingToken = lexer_nextToken(&(parserState->lexerState));
       if (terminatingToken.name != OBJCTKTokenNameArrayDeclarationEnd) {
         logUnexpectedToken(parserState, terminatingToken);
       }
       objctk_substring fullSubstring = mergedLexeme(token.value, terminatingToken.value);
-      typeNode = _objctk_typenode_ptr(new arraynode(fullSubstring, subtypeNode, array_size));
+      typeNode = makeTypeNode<arraynode>(parserState, fullSubstring, subtypeNode, array_size);
       break;
     }
     case OBJCTKTokenNameObjCObjectPointerType: {
-      objctk_substring typeName = token.value;
-      typeName.offset++;
-      typeName.length--;
-      typeNode = _objctk_typenode_ptr(new objectpointernode(token.value, typeName));
+      // The class name, if any, is enclosed in quotes following the '@'.
+      objctk_substring typeName = makeRange(token.value.offset + 1, 0);
+      if (token.value.length >= 3) {
+        typeName = makeRange(token.value.offset + 2, token.value.length - 3);
+      }
+      typeNode = makeTypeNode<objectpointernode>(parserState, token.value, typeName, hashTypeName(parserState, typeName));
       break;
     }
     case OBJCTKTokenNameObjCClassPointerType:
-      typeNode = _objctk_typenode_ptr(new pointernode(token.value, OBJCTKTypeCategoryClass, nullptr));
+      typeNode = makeTypeNode<pointernode>(parserState, token.value, OBJCTKTypeCategoryClass, nullptr);
       break;
     case OBJCTKTokenNameObjCSelectorType:
-      typeNode = _objctk_typenode_ptr(new pointernode(token.value, OBJCTKTypeCategorySelector, nullptr));
+      typeNode = makeTypeNode<pointernode>(parserState, token.value, OBJCTKTypeCategorySelector, nullptr);
       break;
     default:
       break;
   }
+  parserState->depth--;
   return typeNode;
 }
 
-static _objctk_typenode_ptr parseCompositeType(objctk_parserstate *parserState, const size_t starting_offset, const objctk_token *startingToken) {
-  objctk_substring substring = {
-    .offset = starting_offset, // parserState->lexerState.index ?
-    .length = 0,
-  };
-
-  // The terminating token is inferred from the starting token.
-  int terminatingTokenName = OBJCTKTokenNameEOF;
-  objctk_substring compositeTypeName = makeRange(0, 0);
-  if (startingToken != NULL) {
-    objctk_lexeme startingTokenValue = startingToken->value;
-    compositeTypeName = makeRange(startingTokenValue.offset + 1, startingTokenValue.length - 2);
-    switch (startingToken->name) {
-      case OBJCTKTokenNameStructDeclarationStart:
-        terminatingTokenName = OBJCTKTokenNameStructDeclarationEnd;
-        break;
-      case OBJCTKTokenNameUnionDeclarationStart:
-        terminatingTokenName = OBJCTKTokenNameUnionDeclarationEnd;
-        break;
-      default:
-        break;
-    }
+// Infers the terminating token, category and name of a composite type from its starting token,
+// which ends with '=' unless the composite type has no members.
+static void getCompositeTypeTraits(const char *input, const objctk_token *startingToken, int *outTerminatingTokenName, objctk_typecategory *outTypeCategory, objctk_substring *outTypeName) {
+  *outTerminatingTokenName = OBJCTKTokenNameEOF;
+  *outTypeCategory = OBJCTKTypeCategoryTopLevel;
+  *outTypeName = makeRange(0, 0);
+  if (startingToken == NULL) {
+    return;
+  }
+  objctk_lexeme startingTokenValue = startingToken->value;
+  const bool hasMembers = (startingTokenValue.length > 1) && (input[startingTokenValue.offset + startingTokenValue.length - 1] == '=');
+  *outTypeName = makeRange(startingTokenValue.offset + 1, startingTokenValue.length - (hasMembers ? 2 : 1));
+  switch (startingToken->name) {
+    case OBJCTKTokenNameStructDeclarationStart:
+      *outTerminatingTokenName = OBJCTKTokenNameStructDeclarationEnd;
+      *outTypeCategory = OBJCTKTypeCategoryStruct;
+      break;
+    case OBJCTKTokenNameUnionDeclarationStart:
+      *outTerminatingTokenName = OBJCTKTokenNameUnionDeclarationEnd;
+      *outTypeCategory = OBJCTKTypeCategoryUnion;
+      break;
+    default:
+      break;
   }
+}
 
-  const char *input = parserState->lexerState.input;
-  _objctk_typenode_list typeNodes;
+// Parses member types until the terminating token, collecting them on the scratch stack above the
+// members of enclosing composite types.
+static void parseMemberTypes(objctk_parserstate *parserState, const int terminatingTokenName) {
+  _objctk_typenode_stack *scratchStack = parserState->scratchStack;
   while (true) {
     objctk_token token = lexer_nextToken(&(parserState->lexerState));
 
     if ((token.name == terminatingTokenName) || (token.name == OBJCTKTokenNameEOF)) {
       break;
     }
+    if (hasPassedDeadline(parserState)) {
+      break;
+    }
 
     _objctk_typenode_ptr typeNode = parseTypeFromToken(parserState, token);
-    if (typeNode.get() != NULL) {
-      typeNodes.push_back(typeNode);
+    if (hasParseError(parserState)) {
+      break;
+    }
+    if (typeNode != NULL) {
+      if (!scratchStack->push_back(typeNode)) {
+        setParseError(parserState, objctk_statuscode_OutOfMemory, "Unable to grow the parser stack.");
+        break;
+      }
       continue;
     }
     logUnexpectedToken(parserState, token);
   }
+}
 
-  if ((startingToken == NULL) && (typeNodes.size() == 1)) {
-    return typeNodes[0];
+// Makes a composite type node whose members are the type nodes on the scratch stack above
+// scratchStackBase, popping them off the scratch stack.
+static _objctk_typenode_ptr makeCompositeTypeNode(objctk_parserstate *parserState, const objctk_substring substring, const objctk_typecategory compositeTypeCategory, const objctk_substring compositeTypeName, const size_t scratchStackBase) {
+  _objctk_typenode_stack *scratchStack = parserState->scratchStack;
+  const size_t memberCount = scratchStack->size() - scratchStackBase;
+  _objctk_typenode_ptr *memberTypes = parserState->nodeArena->makeArray<_objctk_typenode_ptr>(memberCount);
+  if (memberTypes == NULL) {
+    setParseError(parserState, objctk_statuscode_OutOfMemory, "Unable to allocate a member type list.");
+    scratchStack->resize(scratchStackBase);
+    return NULL;
   }
+  std::copy(scratchStack->begin() + scratchStackBase, scratchStack->end(), memberTypes);
+  scratchStack->resize(scratchStackBase);
+  _objctk_typenode_list typeNodes(memberTypes, memberCount);
 
-  substring.length = (parserState->lexerState.index - substring.offset);
-  _objctk_typenode_ptr typeNode = _objctk_typenode_ptr(new compositetypenode(substring, OBJCTKTypeCategoryTopLevel, typeNodes, compositeTypeName));
+  _objctk_typenode_ptr typeNode = makeTypeNode<compositetypenode>(parserState, substring, compositeTypeCategory, typeNodes, compositeTypeName, hashTypeName(parserState, compositeTypeName));
   return typeNode;
 }
 
+static _objctk_typenode_ptr parseCompositeType(objctk_parserstate *parserState, const size_t starting_offset, const objctk_token *startingToken) {
+  objctk_substring substring = {
+    .offset = starting_offset, // parserState->lexerState.index ?
+    .length = 0,
+  };
+
+  // The terminating token is inferred from the starting token.
+  int terminatingTokenName;
+  objctk_typecategory compositeTypeCategory;
+  objctk_substring compositeTypeName;
+  getCompositeTypeTraits(parserState->lexerState.input, startingToken, &terminatingTokenName, &compositeTypeCategory, &compositeTypeName);
+
+  _objctk_typenode_stack *scratchStack = parserState->scratchStack;
+  const size_t scratchStackBase = scratchStack->size();
+  parseMemberTypes(parserState, terminatingTokenName);
+
+  if (hasParseError(parserState)) {
+    scratchStack->resize(scratchStackBase);
+    return NULL;
+  }
+
+  const size_t memberCount = scratchStack->size() - scratchStackBase;
+  if ((startingToken == NULL) && (memberCount == 1)) {
+    _objctk_typenode_ptr typeNode = scratchStack->back();
+    scratchStack->pop_back();
+    return typeNode;
+  }
+
+  substring.length = (parserState->lexerState.index - substring.offset);
+  return makeCompositeTypeNode(parserState, substring, compositeTypeCategory, compositeTypeName, scratchStackBase);
+}
+
+// Stores the status of a parse in its parse result, releasing any partially constructed type tree if
+// the parse failed.
+static void storeParseStatus(objctk_parserstate *parserState, _objctk_typeparseresult *result) {
+  result->status = parserState->status;
+  result->unexpected_token_count = parserState->unexpectedTokenCount;
+  if (hasParseError(parserState)) {
+    result->node = NULL;
+    result->arena.reset();
+  }
+}
+
 namespace objctk {
 
-_objctk_typeparseresult parseTypeEncoding(const char *typeEncoding) {
-  objctk_parserstate parserState = makeParserState(typeEncoding);
-  _objctk_typenode_ptr typeNode = parseCompositeType(&parserState, 0, NULL);
-  _objctk_typeparseresult result = {
-    .node = typeNode,
-    .status = parserState.status
-  };
-  return result;
+bool internTypeNames(const char *typeEncoding, _objctk_typenode_ptr typeNode, _objctk_typenode_stack *scratchStack) {
+  // The type nodes awaiting a visit are pushed above the current top of the scratch stack.
+  const size_t scratchStackBase = scratchStack->size();
+  bool succeeded = scratchStack->push_back(typeNode);
+  while (succeeded && (scratchStack->size() > scratchStackBase)) {
+    _objctk_typenode_ptr node = scratchStack->back();
+    scratchStack->pop_back();
+    const objctk_substring typeName = node->typeName();
+    if ((typeName.length != 0) && (node->typeNameID() == OBJCTK_NAMEID_NONE)) {
+      const objctk_nameid typeNameID = internName(typeEncoding + typeName.offset, typeName.length);
+      if (typeNameID == OBJCTK_NAMEID_NONE) {
+        succeeded = false;
+        break;
+      }
+      if (node->typeCategory() == OBJCTKTypeCategoryObject) {
+        static_cast<objectpointernode *>(node)->setTypeNameID(typeNameID);
+      } else {
+        static_cast<compositetypenode *>(node)->setTypeNameID(typeNameID);
+      }
+    }
+    if (node->referencedType() != NULL) {
+      succeeded = scratchStack->push_back(node->referencedType());
+    }
+    const _objctk_typenode_list memberTypes = node->memberTypes();
+    for (_objctk_typenode_list::const_iterator iter = memberTypes.begin(); succeeded && (iter != memberTypes.end()); iter++) {
+      succeeded = scratchStack->push_back(*iter);
+    }
+  }
+  scratchStack->resize(scratchStackBase);
+  return succeeded;
+}
+
+void parseTypeEncoding(const char *typeEncoding, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack, const objctk_parselimits *limits) {
+  const bool recordsStatistics = statisticsEnabled();
+  const bool hasDeadline = (limits != NULL) && (limits->maximumNanoseconds != 0);
+  const bool samplesEncoding = encodingSamplingEnabled() && shouldSampleEncoding();
+  const uint64_t startTimestamp = (recordsStatistics || hasDeadline || samplesEncoding) ? statisticsTimestamp() : 0;
+
+  // Overlong encodings are rejected without measuring their full length.
+  objctk_lexerstate lexerState;
+  const size_t maximumInputLength = (limits != NULL) ? limits->maximumInputLength : 0;
+  if (maximumInputLength != 0) {
+    lexerState = makeLexerStateWithRange(typeEncoding, makeRange(0, strnlen(typeEncoding, std::max(maximumInputLength, maximumInputLength + 1))));
+  } else {
+    lexerState = makeLexerState(typeEncoding);
+  }
+
+  objctk_parserstate parserState = makeParserState(lexerState, &result->arena, scratchStack, limits == NULL);
+  applyParseLimits(&parserState, limits, startTimestamp);
+  if ((maximumInputLength != 0) && (lexerState.inputLength > maximumInputLength)) {
+    setParseError(&parserState, objctk_statuscode_LimitExceeded, "The type encoding exceeds the maximum input length.");
+  } else {
+    result->node = parseCompositeType(&parserState, 0, NULL);
+    internParsedTypeNames(&parserState, result->node);
+  }
+  storeParseStatus(&parserState, result);
+
+  if (!recordsStatistics && !samplesEncoding) {
+    return;
+  }
+  const uint64_t nanoseconds = statisticsTimestamp() - startTimestamp;
+  if (samplesEncoding && !hasParseError(&parserState)) {
+    recordEncodingSample(typeEncoding, parserState.lexerState.inputLength, nanoseconds);
+  }
+  if (recordsStatistics) {
+    objctk_parsesample sample = {
+      .failed = (parserState.status.status_code != objctk_statuscode_NoError),
+      .inputByteCount = parserState.lexerState.inputLength,
+      .tokenCount = parserState.lexerState.tokenCount,
+      .nodeCount = parserState.nodeCount,
+      .retainedByteCount = sizeof(_objctk_typeparseresult) + result->arena.reservedByteCount(),
+      .nanoseconds = nanoseconds,
+    };
+    recordParseSample(&sample);
+  }
+}
+
+void parseTypeEncodingAfterPrefix(const char *typeEncoding, const size_t inputLength, const _objctk_typenode_list prefixTypes, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack) {
+  const bool recordsStatistics = statisticsEnabled();
+  const uint64_t startTimestamp = recordsStatistics ? statisticsTimestamp() : 0;
+
+  objctk_range resumedRange = makeRange(0, inputLength);
+  if (!prefixTypes.empty()) {
+    const objctk_substring lastPrefixType = prefixTypes[prefixTypes.size() - 1]->substring();
+    const size_t prefixLength = lastPrefixType.offset + lastPrefixType.length;
+    resumedRange = makeRange(prefixLength, inputLength - prefixLength);
+  }
+  objctk_parserstate parserState = makeParserState(makeLexerStateWithRange(typeEncoding, resumedRange), &result->arena, scratchStack, true);
+
+  // The top-level types continue from the reused prefix types exactly as in parseCompositeType.
+  const size_t scratchStackBase = scratchStack->size();
+  for (_objctk_typenode_list::const_iterator iter = prefixTypes.begin(); iter != prefixTypes.end(); iter++) {
+    if (!scratchStack->push_back(*iter)) {
+      setParseError(&parserState, objctk_statuscode_OutOfMemory, "Unable to grow the parser stack.");
+      break;
+    }
+  }
+  if (!hasParseError(&parserState)) {
+    parseMemberTypes(&parserState, OBJCTKTokenNameEOF);
+  }
+  // The reused prefix types were interned when they were first parsed.
+  for (size_t index = scratchStackBase + prefixTypes.size(); (index < scratchStack->size()) && !hasParseError(&parserState); index++) {
+    internParsedTypeNames(&parserState, scratchStack->begin()[index]);
+  }
+  if (hasParseError(&parserState)) {
+    scratchStack->resize(scratchStackBase);
+  } else if ((scratchStack->size() - scratchStackBase) == 1) {
+    result->node = scratchStack->back();
+    scratchStack->pop_back();
+  } else {
+    result->node = makeCompositeTypeNode(&parserState, makeRange(0, parserState.lexerState.index), OBJCTKTypeCategoryTopLevel, makeRange(0, 0), scratchStackBase);
+  }
+  storeParseStatus(&parserState, result);
+
+  if (recordsStatistics) {
+    objctk_parsesample sample = {
+      .failed = hasParseError(&parserState),
+      .inputByteCount = inputLength,
+      .tokenCount = parserState.lexerState.tokenCount,
+      .nodeCount = parserState.nodeCount,
+      .retainedByteCount = sizeof(_objctk_typeparseresult) + result->arena.reservedByteCount(),
+      .nanoseconds = statisticsTimestamp() - startTimestamp,
+    };
+    recordParseSample(&sample);
+  }
+}
+
+void parseTypeEncodingInRange(const char *input, const objctk_range range, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack, const objctk_parselimits *limits) {
+  const bool hasDeadline = (limits != NULL) && (limits->maximumNanoseconds != 0);
+  objctk_parserstate parserState = makeParserState(makeLexerStateWithRange(input, range), &result->arena, scratchStack, limits == NULL);
+  applyParseLimits(&parserState, limits, hasDeadline ? statisticsTimestamp() : 0);
+  if ((limits != NULL) && (limits->maximumInputLength != 0) && (range.length > limits->maximumInputLength)) {
+    setParseError(&parserState, objctk_statuscode_LimitExceeded, "The type encoding exceeds the maximum input length.");
+  } else {
+    result->node = parseCompositeType(&parserState, range.offset, NULL);
+    internParsedTypeNames(&parserState, result->node);
+  }
+  storeParseStatus(&parserState, result);
+}
+
+_objctk_rangeparse parseTypeSequence(const char *typeEncoding, const objctk_range range, const unsigned int enclosingDepth, arena *nodeArena, _objctk_typenode_stack *scratchStack, const objctk_parselimits *limits, const uint64_t startTimestamp) {
+  objctk_parserstate parserState = makeParserState(makeLexerStateWithRange(typeEncoding, range), nodeArena, scratchStack, false);
+  applyParseLimits(&parserState, limits, startTimestamp);
+  parserState.depth = enclosingDepth;
+  const size_t scratchStackBase = scratchStack->size();
+  parseMemberTypes(&parserState, OBJCTKTokenNameEOF);
+  if (hasParseError(&parserState)) {
+    scratchStack->resize(scratchStackBase);
+  }
+  return makeRangeParse(&parserState);
+}
+
+_objctk_typenode_ptr parseCompositeTypeWithMembers(const char *typeEncoding, const objctk_range range, arena *nodeArena, _objctk_typenode_stack *scratchStack, const size_t scratchStackBase, const objctk_parselimits *limits, const uint64_t startTimestamp, _objctk_rangeparse *outRangeParse) {
+  objctk_parserstate parserState = makeParserState(makeLexerStateWithRange(typeEncoding, range), nodeArena, scratchStack, false);
+  applyParseLimits(&parserState, limits, startTimestamp);
+  objctk_token startingToken = lexer_nextToken(&(parserState.lexerState));
+  int terminatingTokenName;
+  objctk_typecategory compositeTypeCategory;
+  objctk_substring compositeTypeName;
+  getCompositeTypeTraits(typeEncoding, &startingToken, &terminatingTokenName, &compositeTypeCategory, &compositeTypeName);
+
+  _objctk_typenode_ptr typeNode = NULL;
+  if (compositeTypeCategory == OBJCTKTypeCategoryTopLevel) {
+    logUnexpectedToken(&parserState, startingToken);
+    scratchStack->resize(scratchStackBase);
+  } else {
+    typeNode = makeCompositeTypeNode(&parserState, range, compositeTypeCategory, compositeTypeName, scratchStackBase);
+  }
+  *outRangeParse = makeRangeParse(&parserState);
+  return typeNode;
 }
 
 }
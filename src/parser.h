@@ -26,21 +26,151 @@ SOFTWARE.
 #define OBJCTK_PARSER__
 
 #include "type-encoding.h"
+
+#include "arena.h"
 #include "typenode.h"
 
+#include <atomic>
+
 struct _objctk_parsestatus {
   objctk_statuscode status_code;
-  std::string error_description;
+  // A static string describing the error or NULL.
+  const char *error_description;
 };
 
+namespace objctk {
+
+// The reference state of a parse result counts kParseResultReference for each reference held by
+// callers and includes kParseResultParserOwnership while a parser owns the result.
+static const size_t kParseResultParserOwnership = 1;
+static const size_t kParseResultReference = 2;
+
+}
+
 struct _objctk_typeparseresult {
   _objctk_typenode_ptr node;
   struct _objctk_parsestatus status;
+
+  // The allocator from which the parse result and its arena obtain memory.
+  objctk_allocator allocator;
+
+  // The arena owning the type nodes of the parse result.
+  objctk::arena arena;
+
+  // The references to the parse result, which is freed once neither callers nor a parser own it. A
+  // parse result is not modified while callers hold references to it.
+  std::atomic<size_t> reference_state;
+
+  // Prewarmed parse results outlive their users and ignore retains and releases.
+  bool is_persistent;
+
+  // The parse result of a batch whose type nodes this parse result shares for a common prefix, which
+  // it retains, or NULL.
+  _objctk_typeparseresult *prefix_result;
+
+  // The number of unexpected tokens skipped by the parse.
+  size_t unexpected_token_count;
+
+  explicit _objctk_typeparseresult(const objctk_allocator *allocator) : node(NULL), status({ objctk_statuscode_NoError, NULL }), allocator(*allocator), arena(allocator), reference_state(objctk::kParseResultReference), is_persistent(false), prefix_result(NULL), unexpected_token_count(0) {}
+};
+
+struct _objctk_parser {
+  // The allocator from which the parser and its parse results obtain memory.
+  objctk_allocator allocator;
+
+  // The parse result owned by the parser, which is replaced when callers retain it beyond the next
+  // reset, or NULL if a replacement could not be allocated.
+  _objctk_typeparseresult *result;
+
+  // Scratch space which retains its capacity across parses.
+  _objctk_typenode_stack scratch_stack;
+
+  // The resource limits applied to each parse.
+  objctk_parselimits limits;
+
+  // Whether parses may return prewarmed parse results, which is only the case for parsers using
+  // the default allocator.
+  bool uses_prewarmed_parse_results;
+
+  explicit _objctk_parser(const objctk_allocator *allocator) : allocator(*allocator), result(NULL), scratch_stack(allocator), limits(), uses_prewarmed_parse_results(false) {}
+};
+
+// The outcome of parsing a range of a type encoding.
+struct _objctk_rangeparse {
+  struct _objctk_parsestatus status;
+  size_t token_count;
+  size_t node_count;
+
+  // Unexpected tokens are skipped without failing the parse. Ranges split at positions which the
+  // serial parser does not reach as member boundaries encounter unexpected tokens.
+  size_t unexpected_token_count;
 };
 
 namespace objctk {
 
-_objctk_typeparseresult parseTypeEncoding(const char *typeEncoding);
+/**
+ * Makes a parse result owned by a parser, returning NULL if memory could not be allocated.
+ */
+_objctk_typeparseresult *makeParserOwnedParseResult(const objctk_allocator *allocator);
+
+/**
+ * Prepares the parse result of a parser for another parse and returns it. If callers retain the
+ * previous parse result, it is handed over to them and replaced with a new parse result so that it
+ * is never modified while referenced. Returns NULL if the replacement could not be allocated.
+ */
+_objctk_typeparseresult *resetParserResult(_objctk_parser *parser);
+
+/**
+ * Gives up the ownership of a parse result by a parser, freeing it unless callers retain it.
+ */
+void releaseParserOwnedParseResult(_objctk_typeparseresult *result);
+
+/**
+ * Interns the type names of a successfully parsed type and its referenced and member types, using
+ * the scratch stack above its current top to visit them. Type names are only interned once a parse
+ * has succeeded so that failed parses of untrusted input do not grow the process-wide name table.
+ * Returns false if memory could not be allocated.
+ */
+bool internTypeNames(const char *typeEncoding, _objctk_typenode_ptr typeNode, _objctk_typenode_stack *scratchStack);
+
+/**
+ * Parses a type encoding into a parse result whose arena has been reset, using a scratch stack to
+ * collect the member types of composite types. Only the default nesting depth is enforced if limits
+ * is NULL.
+ */
+void parseTypeEncoding(const char *typeEncoding, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack, const objctk_parselimits *limits);
+
+/**
+ * Parses a type encoding of a known length into a parse result whose arena has been reset, reusing
+ * the type nodes of its leading top-level types which were parsed from an identical prefix of another
+ * type encoding and resuming the parse after them. The reused type nodes must end before the prefix
+ * does because the lexer looks one character past each token.
+ */
+void parseTypeEncodingAfterPrefix(const char *typeEncoding, const size_t inputLength, const _objctk_typenode_list prefixTypes, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack);
+
+/**
+ * Parses the types within a range of a string which embeds a type encoding, such as a property
+ * attribute string, into a parse result whose arena has been reset. Unlike parseTypeEncoding, the
+ * parse is not recorded in the statistics or encoding samples. Only the default nesting depth is
+ * enforced if limits is NULL.
+ */
+void parseTypeEncodingInRange(const char *input, const objctk_range range, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack, const objctk_parselimits *limits);
+
+/**
+ * Parses the sequence of types within a range of a type encoding, pushing their type nodes onto the
+ * scratch stack. The types are nested within enclosingDepth enclosing types for the purpose of the
+ * nesting depth limit. The limits, if any, apply to the range alone and its deadline is measured
+ * from startTimestamp. The type nodes are removed from the scratch stack if the parse fails.
+ */
+_objctk_rangeparse parseTypeSequence(const char *typeEncoding, const objctk_range range, const unsigned int enclosingDepth, arena *nodeArena, _objctk_typenode_stack *scratchStack, const objctk_parselimits *limits, const uint64_t startTimestamp);
+
+/**
+ * Makes the type node of the struct or union spanning a range of a type encoding from its starting
+ * token and the member type nodes above scratchStackBase on the scratch stack, which are popped.
+ * The limits, if any, apply to the composite type node alone and its deadline is measured from
+ * startTimestamp. Returns NULL if the range does not start with a struct or union.
+ */
+_objctk_typenode_ptr parseCompositeTypeWithMembers(const char *typeEncoding, const objctk_range range, arena *nodeArena, _objctk_typenode_stack *scratchStack, const size_t scratchStackBase, const objctk_parselimits *limits, const uint64_t startTimestamp, _objctk_rangeparse *outRangeParse);
 
 }
 
@@ -0,0 +1,147 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "property-attributes.h"
+
+#include "internal-allocator.h"
+#include "lexer.h"
+#include "parser.h"
+
+#include <limits.h>
+#include <string.h>
+
+using namespace objctk;
+
+static inline objctk_range absentNameRange() {
+  objctk_range absentNameRange = {
+    .offset = UINT_MAX,
+    .length = UINT_MAX,
+  };
+  return absentNameRange;
+}
+
+// Splits an attribute string at the commas separating its attributes, each of which is identified
+// by its first character, and parses the type attribute into a parse result whose arena has been
+// reset.
+static void parsePropertyAttributes(const char *attributes, objctk_propertyattributes *outAttributes, _objctk_typeparseresult *result, _objctk_typenode_stack *scratchStack, const objctk_parselimits *limits) {
+  objctk_propertyattributes propertyAttributes = {
+    .type = NULL,
+    .typeEncodingRange = absentNameRange(),
+    .ownership = objctk_propertyownership_Assign,
+    .isReadOnly = false,
+    .isNonatomic = false,
+    .isDynamic = false,
+    .getterNameRange = absentNameRange(),
+    .setterNameRange = absentNameRange(),
+    .instanceVariableNameRange = absentNameRange(),
+  };
+  bool hasType = false;
+
+  const size_t length = strlen(attributes);
+  size_t offset = 0;
+  while (offset < length) {
+    // Only the type attribute may contain a quoted class name, within which commas do not separate
+    // attributes.
+    const char code = attributes[offset];
+    const char *comma = NULL;
+    size_t end;
+    if (code == 'T') {
+      end = lexer_findUnquotedCharacter(attributes, length, offset + 1, ',');
+    } else {
+      comma = (const char *)memchr(attributes + offset, ',', length - offset);
+      end = (comma != NULL) ? (size_t)(comma - attributes) : length;
+    }
+    const objctk_range value = makeRange(offset + 1, (end > offset) ? (end - offset - 1) : 0);
+    switch (code) {
+      case 'T':
+        propertyAttributes.typeEncodingRange = value;
+        hasType = true;
+        break;
+      case 'R':
+        propertyAttributes.isReadOnly = true;
+        break;
+      case '&':
+        propertyAttributes.ownership = objctk_propertyownership_Retain;
+        break;
+      case 'C':
+        propertyAttributes.ownership = objctk_propertyownership_Copy;
+        break;
+      case 'W':
+        propertyAttributes.ownership = objctk_propertyownership_Weak;
+        break;
+      case 'N':
+        propertyAttributes.isNonatomic = true;
+        break;
+      case 'D':
+        propertyAttributes.isDynamic = true;
+        break;
+      case 'G':
+        propertyAttributes.getterNameRange = value;
+        break;
+      case 'S':
+        propertyAttributes.setterNameRange = value;
+        break;
+      case 'V':
+        propertyAttributes.instanceVariableNameRange = value;
+        break;
+      default:
+        break;
+    }
+    offset = end + 1;
+  }
+
+  if (hasType) {
+    parseTypeEncodingInRange(attributes, propertyAttributes.typeEncodingRange, result, scratchStack, limits);
+    propertyAttributes.type = result->node;
+  }
+  *outAttributes = propertyAttributes;
+}
+
+objctk_typeparseresult objctk_parsePropertyAttributes(const char *attributes, objctk_propertyattributes *outAttributes, const objctk_allocator *allocator) {
+  if ((attributes == NULL) || (outAttributes == NULL)) {
+    return NULL;
+  }
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+  _objctk_typeparseresult *parseResult = makeObject<_objctk_typeparseresult>(allocator, allocator);
+  if (parseResult == NULL) {
+    return NULL;
+  }
+  _objctk_typenode_stack scratchStack(allocator);
+  parsePropertyAttributes(attributes, outAttributes, parseResult, &scratchStack, NULL);
+  return parseResult;
+}
+
+objctk_typeparseresult objctk_parser_parsePropertyAttributes(objctk_parser parser, const char *attributes, objctk_propertyattributes *outAttributes) {
+  if ((parser == NULL) || (attributes == NULL) || (outAttributes == NULL)) {
+    return NULL;
+  }
+  _objctk_typeparseresult *parseResult = resetParserResult(parser);
+  if (parseResult == NULL) {
+    return NULL;
+  }
+  parsePropertyAttributes(attributes, outAttributes, parseResult, &parser->scratch_stack, &parser->limits);
+  return parseResult;
+}
@@ -0,0 +1,143 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "internal-statistics.h"
+
+#include <string.h>
+#include <chrono>
+
+using namespace objctk;
+
+// Threads are spread over a fixed number of shards so that concurrent parses rarely update the
+// same cache line.
+static const unsigned int kStatisticsShardCount = 16;
+
+typedef struct alignas(64) objctk_statisticsshard {
+  std::atomic<uint64_t> parseCount;
+  std::atomic<uint64_t> failedParseCount;
+  std::atomic<uint64_t> inputByteCount;
+  std::atomic<uint64_t> tokenCount;
+  std::atomic<uint64_t> nodeCount;
+  std::atomic<uint64_t> retainedByteCount;
+  std::atomic<uint64_t> parseNanoseconds;
+  std::atomic<uint64_t> parseLatencyHistogram[OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT];
+  std::atomic<uint64_t> nodeCountHistogram[OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT];
+  std::atomic<uint64_t> retainedByteHistogram[OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT];
+} objctk_statisticsshard;
+
+static objctk_statisticsshard gStatisticsShards[kStatisticsShardCount];
+static std::atomic<unsigned int> gNextStatisticsShardIndex(0);
+
+static objctk_statisticsshard *currentThreadStatisticsShard() {
+  static thread_local unsigned int shardIndex = gNextStatisticsShardIndex.fetch_add(1, std::memory_order_relaxed) % kStatisticsShardCount;
+  return &gStatisticsShards[shardIndex];
+}
+
+static unsigned int histogramBucketIndex(uint64_t value) {
+  unsigned int bucketIndex = 0;
+  while ((value != 0) && (bucketIndex < (OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT - 1))) {
+    value >>= 1;
+    ++bucketIndex;
+  }
+  return bucketIndex;
+}
+
+static inline void addToCounter(std::atomic<uint64_t> *counter, const uint64_t value) {
+  counter->fetch_add(value, std::memory_order_relaxed);
+}
+
+static inline void addToHistogram(std::atomic<uint64_t> *histogram, const uint64_t value) {
+  addToCounter(&histogram[histogramBucketIndex(value)], 1);
+}
+
+static void accumulateCounter(uint64_t *total, std::atomic<uint64_t> *counter, const bool reset) {
+  *total += reset ? counter->exchange(0, std::memory_order_relaxed) : counter->load(std::memory_order_relaxed);
+}
+
+static void accumulateStatistics(objctk_statistics *statistics, const bool reset) {
+  for (unsigned int shardIndex = 0; shardIndex < kStatisticsShardCount; shardIndex++) {
+    objctk_statisticsshard *shard = &gStatisticsShards[shardIndex];
+    accumulateCounter(&statistics->parseCount, &shard->parseCount, reset);
+    accumulateCounter(&statistics->failedParseCount, &shard->failedParseCount, reset);
+    accumulateCounter(&statistics->inputByteCount, &shard->inputByteCount, reset);
+    accumulateCounter(&statistics->tokenCount, &shard->tokenCount, reset);
+    accumulateCounter(&statistics->nodeCount, &shard->nodeCount, reset);
+    accumulateCounter(&statistics->retainedByteCount, &shard->retainedByteCount, reset);
+    accumulateCounter(&statistics->parseNanoseconds, &shard->parseNanoseconds, reset);
+    for (unsigned int bucketIndex = 0; bucketIndex < OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT; bucketIndex++) {
+      accumulateCounter(&statistics->parseLatencyHistogram[bucketIndex], &shard->parseLatencyHistogram[bucketIndex], reset);
+      accumulateCounter(&statistics->nodeCountHistogram[bucketIndex], &shard->nodeCountHistogram[bucketIndex], reset);
+      accumulateCounter(&statistics->retainedByteHistogram[bucketIndex], &shard->retainedByteHistogram[bucketIndex], reset);
+    }
+  }
+}
+
+namespace objctk {
+
+std::atomic<bool> gStatisticsEnabled(false);
+
+uint64_t statisticsTimestamp() {
+  std::chrono::steady_clock::duration timeSinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(timeSinceEpoch).count();
+}
+
+void recordParseSample(const objctk_parsesample *sample) {
+  objctk_statisticsshard *shard = currentThreadStatisticsShard();
+  addToCounter(&shard->parseCount, 1);
+  addToCounter(&shard->failedParseCount, sample->failed ? 1 : 0);
+  addToCounter(&shard->inputByteCount, sample->inputByteCount);
+  addToCounter(&shard->tokenCount, sample->tokenCount);
+  addToCounter(&shard->nodeCount, sample->nodeCount);
+  addToCounter(&shard->retainedByteCount, sample->retainedByteCount);
+  addToCounter(&shard->parseNanoseconds, sample->nanoseconds);
+  addToHistogram(shard->parseLatencyHistogram, sample->nanoseconds);
+  addToHistogram(shard->nodeCountHistogram, sample->nodeCount);
+  addToHistogram(shard->retainedByteHistogram, sample->retainedByteCount);
+}
+
+}
+
+void objctk_setStatisticsEnabled(bool enabled) {
+#if OBJCTK_ENABLE_STATISTICS
+  gStatisticsEnabled.store(enabled, std::memory_order_relaxed);
+#endif
+}
+
+bool objctk_isStatisticsEnabled(void) {
+  return statisticsEnabled();
+}
+
+void objctk_getStatistics(objctk_statistics *outStatistics) {
+  if (outStatistics == NULL) {
+    return;
+  }
+  memset(outStatistics, 0, sizeof(objctk_statistics));
+  accumulateStatistics(outStatistics, false);
+}
+
+void objctk_resetStatistics(void) {
+  objctk_statistics discardedStatistics;
+  memset(&discardedStatistics, 0, sizeof(objctk_statistics));
+  accumulateStatistics(&discardedStatistics, true);
+}
@@ -0,0 +1,109 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_STRUCTURAL_CHARACTERS__
+#define OBJCTK_STRUCTURAL_CHARACTERS__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace objctk {
+
+/**
+ * Returns whether a character delimits nested types, type names or class names, or terminates a
+ * type encoding: brackets, quotes, equal signs and the null character.
+ */
+static inline bool isStructuralCharacter(const char ch) {
+  switch (ch) {
+    case '{': case '}': case '(': case ')': case '[': case ']': case '"': case '=': case '\0':
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** The number of characters classified at once by structuralCharacterMask. */
+static const size_t kStructuralCharacterBlockSize = 16;
+
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+#define OBJCTK_HAS_STRUCTURAL_CHARACTER_MASK 1
+
+/**
+ * Returns a mask marking the structural characters of a block of kStructuralCharacterBlockSize
+ * characters, kStructuralCharacterMaskBitsPerCharacter bits per character. Brackets are matched by
+ * masking the bit distinguishing '[' from '{' and ']' from '}' and the bit distinguishing '(' from
+ * ')'.
+ */
+static inline uint64_t structuralCharacterMask(const char *block);
+
+#if defined(__SSE2__)
+static const unsigned int kStructuralCharacterMaskBitsPerCharacter = 1;
+
+static inline uint64_t structuralCharacterMask(const char *block) {
+  __m128i characters = _mm_loadu_si128((const __m128i *)block);
+  __m128i squareOrCurly = _mm_and_si128(characters, _mm_set1_epi8((char)0xDF));
+  __m128i matches = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(squareOrCurly, _mm_set1_epi8('[')), _mm_cmpeq_epi8(squareOrCurly, _mm_set1_epi8(']'))),
+      _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(_mm_and_si128(characters, _mm_set1_epi8((char)0xFE)), _mm_set1_epi8('(')), _mm_cmpeq_epi8(characters, _mm_setzero_si128())),
+          _mm_or_si128(_mm_cmpeq_epi8(characters, _mm_set1_epi8('"')), _mm_cmpeq_epi8(characters, _mm_set1_epi8('=')))));
+  return (uint64_t)(unsigned int)_mm_movemask_epi8(matches);
+}
+#else
+static const unsigned int kStructuralCharacterMaskBitsPerCharacter = 4;
+
+static inline uint64_t structuralCharacterMask(const char *block) {
+  uint8x16_t characters = vld1q_u8((const uint8_t *)block);
+  uint8x16_t squareOrCurly = vandq_u8(characters, vdupq_n_u8(0xDF));
+  uint8x16_t matches = vorrq_u8(
+      vorrq_u8(vceqq_u8(squareOrCurly, vdupq_n_u8('[')), vceqq_u8(squareOrCurly, vdupq_n_u8(']'))),
+      vorrq_u8(
+          vorrq_u8(vceqq_u8(vandq_u8(characters, vdupq_n_u8(0xFE)), vdupq_n_u8('(')), vceqzq_u8(characters)),
+          vorrq_u8(vceqq_u8(characters, vdupq_n_u8('"')), vceqq_u8(characters, vdupq_n_u8('=')))));
+  // Narrowing yields four mask bits per character.
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+}
+#endif
+
+/** Returns the index of the first structural character marked in a non-zero mask. */
+static inline size_t firstStructuralCharacterIndex(const uint64_t mask) {
+  return (size_t)__builtin_ctzll(mask) / kStructuralCharacterMaskBitsPerCharacter;
+}
+
+/** Clears the mask bits of the first structural character marked in a non-zero mask. */
+static inline uint64_t maskWithoutFirstStructuralCharacter(const uint64_t mask) {
+  const uint64_t characterBits = (1ULL << kStructuralCharacterMaskBitsPerCharacter) - 1;
+  return mask & ~(characterBits << (firstStructuralCharacterIndex(mask) * kStructuralCharacterMaskBitsPerCharacter));
+}
+#endif
+
+}
+
+#endif
@@ -0,0 +1,609 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "type-corpus.h"
+
+#include "internal-allocator.h"
+#include "name-table.h"
+#include "parser.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace objctk;
+
+static const size_t kBitsPerWord = 64;
+
+// Ranks are sampled before every kWordsPerRankBlock words and stored relative to the sample for
+// each word in between.
+static const size_t kWordsPerRankBlock = 8;
+
+// The minimum excess of the parentheses is summarized for each word and for each block of
+// kWordsPerExcessBlock words so that searches for closing parentheses skip whole words and blocks.
+static const size_t kWordsPerExcessBlock = 32;
+
+/** A growable sequence of bits. */
+class bitbuilder {
+  scratchstack<uint64_t> m_words;
+  size_t m_count;
+public:
+  explicit bitbuilder(const objctk_allocator *allocator) : m_words(allocator), m_count(0) {}
+
+  size_t size() const { return m_count; }
+  const uint64_t *words() const { return m_words.begin(); }
+
+  bool push_back(const bool bit) {
+    if (((m_count % kBitsPerWord) == 0) && !m_words.push_back(0)) {
+      return false;
+    }
+    if (bit) {
+      m_words.end()[-1] |= (UINT64_C(1) << (m_count % kBitsPerWord));
+    }
+    ++m_count;
+    return true;
+  }
+
+  void resize(const size_t count) {
+    if (count >= m_count) {
+      return;
+    }
+    m_count = count;
+    m_words.resize((count + kBitsPerWord - 1) / kBitsPerWord);
+    if ((count % kBitsPerWord) != 0) {
+      m_words.end()[-1] &= (UINT64_C(1) << (count % kBitsPerWord)) - 1;
+    }
+  }
+};
+
+struct _objctk_typecorpusbuilder {
+  objctk_allocator allocator;
+  // An opening parenthesis (1) and a closing parenthesis (0) for every type node in preorder.
+  bitbuilder parentheses;
+  scratchstack<uint8_t> categories;
+  scratchstack<int64_t> sizes;
+  // Whether each type node has an element count, bitfield width or name.
+  bitbuilder payloadFlags;
+  scratchstack<uint64_t> payloads;
+  scratchstack<size_t> rootPositions;
+  objctk_parser parser;
+
+  explicit _objctk_typecorpusbuilder(const objctk_allocator *allocator) : allocator(*allocator), parentheses(allocator), categories(allocator), sizes(allocator), payloadFlags(allocator), payloads(allocator), rootPositions(allocator), parser(NULL) {}
+};
+
+/** A sequence of bits supporting constant-time rank queries. */
+typedef struct objctk_rankedbits {
+  const uint64_t *words;
+  size_t count;
+  const uint64_t *blockRanks;
+  const uint16_t *wordRanks;
+} objctk_rankedbits;
+
+/** An array of unsigned integers of a fixed bit width. */
+typedef struct objctk_packedarray {
+  const uint64_t *words;
+  unsigned int width;
+} objctk_packedarray;
+
+struct _objctk_typecorpus {
+  objctk_allocator allocator;
+  size_t byteCount;
+  size_t typeCount;
+  size_t nodeCount;
+  objctk_rankedbits parentheses;
+  const int8_t *wordMinimumExcesses;
+  const int16_t *blockMinimumExcesses;
+  const uint8_t *categories;
+  // Sizes are stored incremented by one so that undeterminable sizes are stored as zero.
+  objctk_packedarray sizes;
+  objctk_rankedbits payloadFlags;
+  objctk_packedarray payloads;
+  objctk_packedarray rootPositions;
+};
+
+/** The minimum prefix excess and total excess of the parentheses of every byte. */
+static const struct objctk_byteexcesstable {
+  int8_t minimumExcesses[256];
+  int8_t excesses[256];
+  objctk_byteexcesstable() {
+    for (int byte = 0; byte < 256; byte++) {
+      int excess = 0;
+      int minimumExcess = CHAR_BIT;
+      for (int bit = 0; bit < CHAR_BIT; bit++) {
+        excess += ((byte >> bit) & 1) ? 1 : -1;
+        minimumExcess = (excess < minimumExcess) ? excess : minimumExcess;
+      }
+      minimumExcesses[byte] = (int8_t)minimumExcess;
+      excesses[byte] = (int8_t)excess;
+    }
+  }
+} kByteExcessTable;
+
+static inline size_t wordCountForBitCount(const size_t bitCount) {
+  return (bitCount + kBitsPerWord - 1) / kBitsPerWord;
+}
+
+static inline bool bitAtIndex(const uint64_t *words, const size_t index) {
+  return ((words[index / kBitsPerWord] >> (index % kBitsPerWord)) & 1) != 0;
+}
+
+// Returns the number of set bits before a position.
+static inline size_t rank(const objctk_rankedbits *bits, const size_t position) {
+  const size_t wordIndex = position / kBitsPerWord;
+  const size_t bitIndex = position % kBitsPerWord;
+  size_t result = bits->blockRanks[wordIndex / kWordsPerRankBlock] + bits->wordRanks[wordIndex];
+  if (bitIndex != 0) {
+    result += (size_t)__builtin_popcountll(bits->words[wordIndex] & ((UINT64_C(1) << bitIndex) - 1));
+  }
+  return result;
+}
+
+static inline uint64_t packedValue(const objctk_packedarray *array, const size_t index) {
+  if (array->width == 0) {
+    return 0;
+  }
+  const size_t bitOffset = index * array->width;
+  const size_t wordIndex = bitOffset / kBitsPerWord;
+  const unsigned int shift = (unsigned int)(bitOffset % kBitsPerWord);
+  uint64_t value = array->words[wordIndex] >> shift;
+  if ((shift + array->width) > kBitsPerWord) {
+    value |= array->words[wordIndex + 1] << (kBitsPerWord - shift);
+  }
+  return (array->width < kBitsPerWord) ? (value & ((UINT64_C(1) << array->width) - 1)) : value;
+}
+
+static inline unsigned int bitWidthForValue(const uint64_t value) {
+  return (value == 0) ? 0 : (unsigned int)(kBitsPerWord - __builtin_clzll(value));
+}
+
+// Advances through the parentheses of a word from a bit, returning the index of the bit at which
+// the excess reaches zero or kBitsPerWord if it does not.
+static inline unsigned int findZeroExcessInWord(const uint64_t word, unsigned int bit, int *excess) {
+  for (; (bit % CHAR_BIT) != 0; bit++) {
+    *excess += ((word >> bit) & 1) ? 1 : -1;
+    if (*excess == 0) {
+      return bit;
+    }
+  }
+  for (; bit < kBitsPerWord; bit += CHAR_BIT) {
+    const uint8_t byte = (uint8_t)(word >> bit);
+    if ((*excess + kByteExcessTable.minimumExcesses[byte]) <= 0) {
+      for (unsigned int index = 0;; index++) {
+        *excess += ((byte >> index) & 1) ? 1 : -1;
+        if (*excess == 0) {
+          return bit + index;
+        }
+      }
+    }
+    *excess += kByteExcessTable.excesses[byte];
+  }
+  return kBitsPerWord;
+}
+
+// Returns the position of the parenthesis closing the parenthesis opened at a position.
+static size_t findClose(const objctk_typecorpus corpus, const size_t position) {
+  const objctk_rankedbits *parentheses = &corpus->parentheses;
+  const size_t wordCount = wordCountForBitCount(parentheses->count);
+  int excess = 1;
+  size_t wordIndex = (position + 1) / kBitsPerWord;
+  const unsigned int firstBit = (unsigned int)((position + 1) % kBitsPerWord);
+  if (firstBit != 0) {
+    unsigned int bit = findZeroExcessInWord(parentheses->words[wordIndex], firstBit, &excess);
+    if (bit < kBitsPerWord) {
+      return (wordIndex * kBitsPerWord) + bit;
+    }
+    ++wordIndex;
+  }
+
+  while (wordIndex < wordCount) {
+    // Skip whole blocks in which the excess does not return to zero.
+    while (((wordIndex % kWordsPerExcessBlock) == 0) && ((wordIndex + kWordsPerExcessBlock) <= wordCount) &&
+           ((excess + corpus->blockMinimumExcesses[wordIndex / kWordsPerExcessBlock]) > 0)) {
+      const size_t blockOneCount = parentheses->blockRanks[(wordIndex + kWordsPerExcessBlock) / kWordsPerRankBlock] - parentheses->blockRanks[wordIndex / kWordsPerRankBlock];
+      excess += (int)(2 * blockOneCount) - (int)(kWordsPerExcessBlock * kBitsPerWord);
+      wordIndex += kWordsPerExcessBlock;
+    }
+    if (wordIndex >= wordCount) {
+      break;
+    }
+    const uint64_t word = parentheses->words[wordIndex];
+    if ((excess + corpus->wordMinimumExcesses[wordIndex]) <= 0) {
+      return (wordIndex * kBitsPerWord) + findZeroExcessInWord(word, 0, &excess);
+    }
+    excess += (2 * __builtin_popcountll(word)) - (int)kBitsPerWord;
+    ++wordIndex;
+  }
+  return OBJCTK_CORPUSNODE_NONE;
+}
+
+static inline bool isCorpusNode(const objctk_typecorpus corpus, const objctk_corpusnode node) {
+  return (corpus != NULL) && (node < corpus->parentheses.count) && bitAtIndex(corpus->parentheses.words, node);
+}
+
+// Returns the preorder index of a type node, which indexes its per-node values.
+static inline size_t nodeIndex(const objctk_typecorpus corpus, const objctk_corpusnode node) {
+  return rank(&corpus->parentheses, node);
+}
+
+static bool appendTypeNode(objctk_typecorpusbuilder builder, _objctk_typenode *node) {
+  const objctk_typecategory typeCategory = node->typeCategory();
+  bool hasPayload = true;
+  uint64_t payload = 0;
+  if (typeCategory == OBJCTKTypeCategoryArray) {
+    payload = static_cast<arraynode *>(node)->elementCount();
+  } else if (typeCategory == OBJCTKTypeCategoryBitField) {
+    payload = static_cast<bitfieldnode *>(node)->bitCount();
+  } else if (node->typeNameID() != OBJCTK_NAMEID_NONE) {
+    payload = node->typeNameID();
+  } else {
+    hasPayload = false;
+  }
+  if (!builder->parentheses.push_back(true) || !builder->categories.push_back((uint8_t)typeCategory) || !builder->sizes.push_back(node->typeSize()) ||
+      !builder->payloadFlags.push_back(hasPayload) || (hasPayload && !builder->payloads.push_back(payload))) {
+    return false;
+  }
+
+  _objctk_typenode *referencedTypeNode = node->referencedType();
+  if ((referencedTypeNode != NULL) && !appendTypeNode(builder, referencedTypeNode)) {
+    return false;
+  }
+  _objctk_typenode_list memberTypes = node->memberTypes();
+  for (_objctk_typenode_list::const_iterator iter = memberTypes.begin(); iter != memberTypes.end(); iter++) {
+    if (!appendTypeNode(builder, *iter)) {
+      return false;
+    }
+  }
+  return builder->parentheses.push_back(false);
+}
+
+// Reserves space for an array in the single allocation of a type corpus.
+static inline size_t reserveBytes(size_t *byteCount, const size_t size) {
+  const size_t offset = (*byteCount + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+  *byteCount = offset + size;
+  return offset;
+}
+
+static inline size_t packedArrayWordCount(const size_t count, const unsigned int width) {
+  // An extra word lets values straddling the last word be read without a bounds check.
+  return wordCountForBitCount(count * width) + 1;
+}
+
+template <typename Function>
+static void packValues(uint64_t *words, const size_t wordCount, const unsigned int width, const size_t count, Function value) {
+  memset(words, 0, wordCount * sizeof(uint64_t));
+  if (width == 0) {
+    return;
+  }
+  for (size_t index = 0; index < count; index++) {
+    const uint64_t packedValue = value(index);
+    const size_t bitOffset = index * width;
+    const size_t wordIndex = bitOffset / kBitsPerWord;
+    const unsigned int shift = (unsigned int)(bitOffset % kBitsPerWord);
+    words[wordIndex] |= packedValue << shift;
+    if ((shift + width) > kBitsPerWord) {
+      words[wordIndex + 1] |= packedValue >> (kBitsPerWord - shift);
+    }
+  }
+}
+
+// Copies bits and computes their rank samples.
+static void makeRankedBits(const bitbuilder *bits, uint64_t *words, uint64_t *blockRanks, uint16_t *wordRanks, objctk_rankedbits *outRankedBits) {
+  const size_t wordCount = wordCountForBitCount(bits->size());
+  memcpy(words, bits->words(), wordCount * sizeof(uint64_t));
+  words[wordCount] = 0;
+  uint64_t rankBeforeWord = 0;
+  for (size_t wordIndex = 0; wordIndex <= wordCount; wordIndex++) {
+    if ((wordIndex % kWordsPerRankBlock) == 0) {
+      blockRanks[wordIndex / kWordsPerRankBlock] = rankBeforeWord;
+    }
+    wordRanks[wordIndex] = (uint16_t)(rankBeforeWord - blockRanks[wordIndex / kWordsPerRankBlock]);
+    rankBeforeWord += (uint64_t)__builtin_popcountll(words[wordIndex]);
+  }
+  // A trailing sample lets blocks ending with the last word be measured.
+  blockRanks[(wordCount / kWordsPerRankBlock) + 1] = rankBeforeWord;
+  *outRankedBits = {
+    .words = words,
+    .count = bits->size(),
+    .blockRanks = blockRanks,
+    .wordRanks = wordRanks,
+  };
+}
+
+static inline size_t rankedBitsByteCount(const size_t bitCount, size_t *byteCount, size_t *wordsOffset, size_t *blockRanksOffset, size_t *wordRanksOffset) {
+  const size_t wordCount = wordCountForBitCount(bitCount);
+  *wordsOffset = reserveBytes(byteCount, (wordCount + 1) * sizeof(uint64_t));
+  *blockRanksOffset = reserveBytes(byteCount, ((wordCount / kWordsPerRankBlock) + 2) * sizeof(uint64_t));
+  *wordRanksOffset = reserveBytes(byteCount, (wordCount + 1) * sizeof(uint16_t));
+  return wordCount;
+}
+
+objctk_typecorpusbuilder objctk_typecorpusbuilder_create(const objctk_allocator *allocator) {
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+  return makeObject<_objctk_typecorpusbuilder>(allocator, allocator);
+}
+
+objctk_statuscode objctk_typecorpusbuilder_addType(objctk_typecorpusbuilder builder, objctk_typenode node) {
+  if ((builder == NULL) || (node == NULL)) {
+    return objctk_statuscode_InvalidInput;
+  }
+  const size_t parenthesisCount = builder->parentheses.size();
+  const size_t nodeCount = builder->categories.size();
+  const size_t payloadCount = builder->payloads.size();
+  const size_t typeCount = builder->rootPositions.size();
+  if (!builder->rootPositions.push_back(parenthesisCount) || !appendTypeNode(builder, node)) {
+    // Discard the partially added type.
+    builder->rootPositions.resize(typeCount);
+    builder->parentheses.resize(parenthesisCount);
+    builder->categories.resize(nodeCount);
+    builder->sizes.resize(nodeCount);
+    builder->payloadFlags.resize(nodeCount);
+    builder->payloads.resize(payloadCount);
+    return objctk_statuscode_OutOfMemory;
+  }
+  return objctk_statuscode_NoError;
+}
+
+objctk_statuscode objctk_typecorpusbuilder_addTypeEncoding(objctk_typecorpusbuilder builder, const char *typeEncoding) {
+  if ((builder == NULL) || (typeEncoding == NULL)) {
+    return objctk_statuscode_InvalidInput;
+  }
+  if (builder->parser == NULL) {
+    builder->parser = objctk_parser_createWithAllocator(&builder->allocator);
+    if (builder->parser == NULL) {
+      return objctk_statuscode_OutOfMemory;
+    }
+  }
+  objctk_typeparseresult parseResult = objctk_parser_parseTypeEncoding(builder->parser, typeEncoding);
+  objctk_statuscode statusCode = objctk_typeparseresult_getStatusCode(parseResult);
+  if (statusCode != objctk_statuscode_NoError) {
+    return statusCode;
+  }
+  return objctk_typecorpusbuilder_addType(builder, objctk_typeparseresult_getParsedType(parseResult));
+}
+
+objctk_typecorpus objctk_typecorpusbuilder_createCorpus(objctk_typecorpusbuilder builder) {
+  if (builder == NULL) {
+    return NULL;
+  }
+  const size_t nodeCount = builder->categories.size();
+  const size_t typeCount = builder->rootPositions.size();
+  uint64_t maximumSize = 0;
+  for (const int64_t *size = builder->sizes.begin(); size != builder->sizes.end(); size++) {
+    maximumSize = (*size >= 0) ? std::max(maximumSize, (uint64_t)*size + 1) : maximumSize;
+  }
+  uint64_t maximumPayload = 0;
+  for (const uint64_t *payload = builder->payloads.begin(); payload != builder->payloads.end(); payload++) {
+    maximumPayload = std::max(maximumPayload, *payload);
+  }
+  const unsigned int sizeWidth = bitWidthForValue(maximumSize);
+  const unsigned int payloadWidth = bitWidthForValue(maximumPayload);
+  const unsigned int rootPositionWidth = bitWidthForValue(builder->parentheses.size());
+
+  // The corpus and all of its arrays share a single allocation.
+  size_t byteCount = sizeof(_objctk_typecorpus);
+  size_t parenthesisWordsOffset, parenthesisBlockRanksOffset, parenthesisWordRanksOffset;
+  const size_t parenthesisWordCount = rankedBitsByteCount(builder->parentheses.size(), &byteCount, &parenthesisWordsOffset, &parenthesisBlockRanksOffset, &parenthesisWordRanksOffset);
+  const size_t excessBlockCount = (parenthesisWordCount + kWordsPerExcessBlock - 1) / kWordsPerExcessBlock;
+  const size_t wordMinimumExcessesOffset = reserveBytes(&byteCount, parenthesisWordCount * sizeof(int8_t));
+  const size_t blockMinimumExcessesOffset = reserveBytes(&byteCount, excessBlockCount * sizeof(int16_t));
+  const size_t categoriesOffset = reserveBytes(&byteCount, nodeCount * sizeof(uint8_t));
+  const size_t sizeWordCount = packedArrayWordCount(nodeCount, sizeWidth);
+  const size_t sizesOffset = reserveBytes(&byteCount, sizeWordCount * sizeof(uint64_t));
+  size_t payloadFlagWordsOffset, payloadFlagBlockRanksOffset, payloadFlagWordRanksOffset;
+  rankedBitsByteCount(builder->payloadFlags.size(), &byteCount, &payloadFlagWordsOffset, &payloadFlagBlockRanksOffset, &payloadFlagWordRanksOffset);
+  const size_t payloadWordCount = packedArrayWordCount(builder->payloads.size(), payloadWidth);
+  const size_t payloadsOffset = reserveBytes(&byteCount, payloadWordCount * sizeof(uint64_t));
+  const size_t rootPositionWordCount = packedArrayWordCount(typeCount, rootPositionWidth);
+  const size_t rootPositionsOffset = reserveBytes(&byteCount, rootPositionWordCount * sizeof(uint64_t));
+
+  char *memory = static_cast<char *>(allocateMemory(&builder->allocator, byteCount));
+  if (memory == NULL) {
+    return NULL;
+  }
+  objctk_typecorpus corpus = new (memory) _objctk_typecorpus();
+  corpus->allocator = builder->allocator;
+  corpus->byteCount = byteCount;
+  corpus->typeCount = typeCount;
+  corpus->nodeCount = nodeCount;
+
+  uint64_t *parenthesisWords = reinterpret_cast<uint64_t *>(memory + parenthesisWordsOffset);
+  makeRankedBits(&builder->parentheses, parenthesisWords, reinterpret_cast<uint64_t *>(memory + parenthesisBlockRanksOffset), reinterpret_cast<uint16_t *>(memory + parenthesisWordRanksOffset), &corpus->parentheses);
+
+  // Summarize the minimum excess within each word and each block of words.
+  int8_t *wordMinimumExcesses = reinterpret_cast<int8_t *>(memory + wordMinimumExcessesOffset);
+  int16_t *blockMinimumExcesses = reinterpret_cast<int16_t *>(memory + blockMinimumExcessesOffset);
+  int blockExcess = 0;
+  int blockMinimumExcess = 0;
+  for (size_t wordIndex = 0; wordIndex < parenthesisWordCount; wordIndex++) {
+    if ((wordIndex % kWordsPerExcessBlock) == 0) {
+      blockExcess = 0;
+      blockMinimumExcess = INT_MAX;
+    }
+    int excess = 0;
+    int minimumExcess = INT_MAX;
+    for (size_t byteIndex = 0; byteIndex < sizeof(uint64_t); byteIndex++) {
+      const uint8_t byte = (uint8_t)(parenthesisWords[wordIndex] >> (byteIndex * CHAR_BIT));
+      minimumExcess = std::min(minimumExcess, excess + kByteExcessTable.minimumExcesses[byte]);
+      excess += kByteExcessTable.excesses[byte];
+    }
+    wordMinimumExcesses[wordIndex] = (int8_t)minimumExcess;
+    blockMinimumExcess = std::min(blockMinimumExcess, blockExcess + minimumExcess);
+    blockExcess += excess;
+    blockMinimumExcesses[wordIndex / kWordsPerExcessBlock] = (int16_t)blockMinimumExcess;
+  }
+  corpus->wordMinimumExcesses = wordMinimumExcesses;
+  corpus->blockMinimumExcesses = blockMinimumExcesses;
+
+  uint8_t *categories = reinterpret_cast<uint8_t *>(memory + categoriesOffset);
+  memcpy(categories, builder->categories.begin(), nodeCount * sizeof(uint8_t));
+  corpus->categories = categories;
+
+  uint64_t *sizeWords = reinterpret_cast<uint64_t *>(memory + sizesOffset);
+  packValues(sizeWords, sizeWordCount, sizeWidth, nodeCount, [&](size_t index) {
+    int64_t size = builder->sizes.begin()[index];
+    return (size >= 0) ? ((uint64_t)size + 1) : 0;
+  });
+  corpus->sizes = { sizeWords, sizeWidth };
+
+  makeRankedBits(&builder->payloadFlags, reinterpret_cast<uint64_t *>(memory + payloadFlagWordsOffset), reinterpret_cast<uint64_t *>(memory + payloadFlagBlockRanksOffset), reinterpret_cast<uint16_t *>(memory + payloadFlagWordRanksOffset), &corpus->payloadFlags);
+
+  uint64_t *payloadWords = reinterpret_cast<uint64_t *>(memory + payloadsOffset);
+  packValues(payloadWords, payloadWordCount, payloadWidth, builder->payloads.size(), [&](size_t index) {
+    return builder->payloads.begin()[index];
+  });
+  corpus->payloads = { payloadWords, payloadWidth };
+
+  uint64_t *rootPositionWords = reinterpret_cast<uint64_t *>(memory + rootPositionsOffset);
+  packValues(rootPositionWords, rootPositionWordCount, rootPositionWidth, typeCount, [&](size_t index) {
+    return (uint64_t)builder->rootPositions.begin()[index];
+  });
+  corpus->rootPositions = { rootPositionWords, rootPositionWidth };
+  return corpus;
+}
+
+void objctk_typecorpusbuilder_release(objctk_typecorpusbuilder builder) {
+  if (builder == NULL) {
+    return;
+  }
+  objctk_parser_release(builder->parser);
+  objctk_allocator allocator = builder->allocator;
+  releaseObject(&allocator, builder);
+}
+
+size_t objctk_typecorpus_getTypeCount(objctk_typecorpus corpus) {
+  return (corpus != NULL) ? corpus->typeCount : 0;
+}
+
+size_t objctk_typecorpus_getNodeCount(objctk_typecorpus corpus) {
+  return (corpus != NULL) ? corpus->nodeCount : 0;
+}
+
+size_t objctk_typecorpus_getByteCount(objctk_typecorpus corpus) {
+  return (corpus != NULL) ? corpus->byteCount : 0;
+}
+
+objctk_corpusnode objctk_typecorpus_getType(objctk_typecorpus corpus, size_t typeIndex) {
+  if ((corpus == NULL) || (typeIndex >= corpus->typeCount)) {
+    return OBJCTK_CORPUSNODE_NONE;
+  }
+  return (objctk_corpusnode)packedValue(&corpus->rootPositions, typeIndex);
+}
+
+objctk_typecategory objctk_typecorpus_getTypeCategory(objctk_typecorpus corpus, objctk_corpusnode node) {
+  if (!isCorpusNode(corpus, node)) {
+    return OBJCTKTypeCategoryUnknown;
+  }
+  return (objctk_typecategory)corpus->categories[nodeIndex(corpus, node)];
+}
+
+int64_t objctk_typecorpus_getTypeSize(objctk_typecorpus corpus, objctk_corpusnode node) {
+  if (!isCorpusNode(corpus, node)) {
+    return -1;
+  }
+  return (int64_t)packedValue(&corpus->sizes, nodeIndex(corpus, node)) - 1;
+}
+
+// Returns whether a type node has an element count, bitfield width or name and retrieves it.
+static inline bool nodePayload(const objctk_typecorpus corpus, const objctk_corpusnode node, uint64_t *outPayload, objctk_typecategory *outTypeCategory) {
+  if (!isCorpusNode(corpus, node)) {
+    return false;
+  }
+  const size_t index = nodeIndex(corpus, node);
+  *outTypeCategory = (objctk_typecategory)corpus->categories[index];
+  if (!bitAtIndex(corpus->payloadFlags.words, index)) {
+    return false;
+  }
+  *outPayload = packedValue(&corpus->payloads, rank(&corpus->payloadFlags, index));
+  return true;
+}
+
+size_t objctk_typecorpus_getElementCount(objctk_typecorpus corpus, objctk_corpusnode node) {
+  uint64_t payload;
+  objctk_typecategory typeCategory;
+  if (!nodePayload(corpus, node, &payload, &typeCategory) || ((typeCategory != OBJCTKTypeCategoryArray) && (typeCategory != OBJCTKTypeCategoryBitField))) {
+    return 0;
+  }
+  return (size_t)payload;
+}
+
+objctk_nameid objctk_typecorpus_getNameID(objctk_typecorpus corpus, objctk_corpusnode node) {
+  uint64_t payload;
+  objctk_typecategory typeCategory;
+  if (!nodePayload(corpus, node, &payload, &typeCategory) || (typeCategory == OBJCTKTypeCategoryArray) || (typeCategory == OBJCTKTypeCategoryBitField)) {
+    return OBJCTK_NAMEID_NONE;
+  }
+  return (objctk_nameid)payload;
+}
+
+const char *objctk_typecorpus_getName(objctk_typecorpus corpus, objctk_corpusnode node) {
+  return internedName(objctk_typecorpus_getNameID(corpus, node), NULL);
+}
+
+objctk_corpusnode objctk_typecorpus_getFirstChild(objctk_typecorpus corpus, objctk_corpusnode node) {
+  if (!isCorpusNode(corpus, node) || !bitAtIndex(corpus->parentheses.words, node + 1)) {
+    return OBJCTK_CORPUSNODE_NONE;
+  }
+  return node + 1;
+}
+
+objctk_corpusnode objctk_typecorpus_getNextSibling(objctk_typecorpus corpus, objctk_corpusnode node) {
+  // The roots of the types, whose parentheses are preceded by zero excess, have no siblings.
+  if (!isCorpusNode(corpus, node) || ((2 * nodeIndex(corpus, node)) == node)) {
+    return OBJCTK_CORPUSNODE_NONE;
+  }
+  const size_t closePosition = findClose(corpus, node);
+  if ((closePosition == OBJCTK_CORPUSNODE_NONE) || !bitAtIndex(corpus->parentheses.words, closePosition + 1)) {
+    return OBJCTK_CORPUSNODE_NONE;
+  }
+  return closePosition + 1;
+}
+
+size_t objctk_typecorpus_getChildCount(objctk_typecorpus corpus, objctk_corpusnode node) {
+  size_t childCount = 0;
+  for (objctk_corpusnode child = objctk_typecorpus_getFirstChild(corpus, node); child != OBJCTK_CORPUSNODE_NONE; child = objctk_typecorpus_getNextSibling(corpus, child)) {
+    ++childCount;
+  }
+  return childCount;
+}
+
+size_t objctk_typecorpus_getSubtreeSize(objctk_typecorpus corpus, objctk_corpusnode node) {
+  if (!isCorpusNode(corpus, node)) {
+    return 0;
+  }
+  const size_t closePosition = findClose(corpus, node);
+  return (closePosition != OBJCTK_CORPUSNODE_NONE) ? (((closePosition - node) + 1) / 2) : 0;
+}
+
+void objctk_typecorpus_release(objctk_typecorpus corpus) {
+  if (corpus == NULL) {
+    return;
+  }
+  objctk_allocator allocator = corpus->allocator;
+  deallocateMemory(&allocator, corpus);
+}
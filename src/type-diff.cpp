@@ -0,0 +1,277 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "type-diff.h"
+
+#include "internal-allocator.h"
+#include "layout.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include <limits.h>
+#include <algorithm>
+
+using namespace objctk;
+
+struct _objctk_typediff {
+  objctk_allocator allocator;
+  objctk_layoutprofile profile;
+  const objctk_layoutrules *rules;
+
+  // Changes found by the last comparison.
+  scratchstack<objctk_typechange> changes;
+
+  // Member offsets of the composite types being compared, stacked by nesting depth.
+  scratchstack<int> memberOffsets;
+
+  bool failed;
+
+  explicit _objctk_typediff(const objctk_allocator *allocator) : allocator(*allocator), profile(objctk_layoutprofile_Host), rules(NULL), changes(allocator), memberOffsets(allocator), failed(false) {}
+};
+
+/** The position of a type node within the type being compared. */
+typedef struct objctk_diffposition {
+  _objctk_typenode *node;
+  _objctk_typenode *parentNode;
+  unsigned int memberIndex;
+  int offset;
+} objctk_diffposition;
+
+static inline objctk_diffposition makeDiffPosition(_objctk_typenode *node, _objctk_typenode *parentNode, const unsigned int memberIndex, const int offset) {
+  objctk_diffposition position = {
+    .node = node,
+    .parentNode = parentNode,
+    .memberIndex = memberIndex,
+    .offset = offset,
+  };
+  return position;
+}
+
+static inline objctk_diffposition emptyDiffPosition() {
+  return makeDiffPosition(NULL, NULL, UINT_MAX, -1);
+}
+
+static inline bool isCompositeTypeCategory(const objctk_typecategory typeCategory) {
+  return (typeCategory == OBJCTKTypeCategoryStruct) || (typeCategory == OBJCTKTypeCategoryUnion) || (typeCategory == OBJCTKTypeCategoryTopLevel);
+}
+
+// Returns whether two structurally different types are versions of the same type whose differences
+// should be described in terms of their members or referenced types.
+static inline bool areComparableTypeNodes(_objctk_typenode *oldNode, _objctk_typenode *newNode) {
+  objctk_typecategory typeCategory = oldNode->typeCategory();
+  if (typeCategory != newNode->typeCategory()) {
+    return false;
+  }
+  if (isCompositeTypeCategory(typeCategory)) {
+    return oldNode->typeNameID() == newNode->typeNameID();
+  }
+  return (typeCategory == OBJCTKTypeCategoryArray) || (typeCategory == OBJCTKTypeCategoryPointer);
+}
+
+static void addChange(objctk_typediff diff, const objctk_typechangekind kind, const unsigned int depth, const objctk_diffposition oldPosition, const objctk_diffposition newPosition) {
+  objctk_typechange change = {
+    .kind = kind,
+    .depth = depth,
+    .oldNode = oldPosition.node,
+    .newNode = newPosition.node,
+    .oldParentNode = oldPosition.parentNode,
+    .newParentNode = newPosition.parentNode,
+    .oldMemberIndex = oldPosition.memberIndex,
+    .newMemberIndex = newPosition.memberIndex,
+    .oldOffset = oldPosition.offset,
+    .newOffset = newPosition.offset,
+    .oldSize = (oldPosition.node != NULL) ? oldPosition.node->typeSize(diff->profile) : -1,
+    .newSize = (newPosition.node != NULL) ? newPosition.node->typeSize(diff->profile) : -1,
+  };
+  if (!diff->changes.push_back(change)) {
+    diff->failed = true;
+  }
+}
+
+// Pushes the offsets of the members of a composite type, returning the index of the first offset.
+static size_t pushMemberOffsets(objctk_typediff diff, compositetypenode *node, const int baseOffset) {
+  const size_t startIndex = diff->memberOffsets.size();
+  node->layoutMembers(diff->rules, [&](_objctk_typenode *, int offset, int) {
+    if (!diff->memberOffsets.push_back((baseOffset < 0) ? -1 : (baseOffset + offset))) {
+      diff->failed = true;
+    }
+  });
+  // Keep one offset per member even if the layout could not be determined.
+  while (diff->memberOffsets.size() < (startIndex + node->memberTypes().size())) {
+    if (!diff->memberOffsets.push_back(-1)) {
+      diff->failed = true;
+      break;
+    }
+  }
+  return startIndex;
+}
+
+static void diffComparableTypeNodes(objctk_typediff diff, const unsigned int depth, const objctk_diffposition oldPosition, const objctk_diffposition newPosition);
+
+static void diffMemberTypes(objctk_typediff diff, const unsigned int depth, const objctk_diffposition oldPosition, const objctk_diffposition newPosition) {
+  compositetypenode *oldNode = static_cast<compositetypenode *>(oldPosition.node);
+  compositetypenode *newNode = static_cast<compositetypenode *>(newPosition.node);
+  const _objctk_typenode_list oldMembers = oldNode->memberTypes();
+  const _objctk_typenode_list newMembers = newNode->memberTypes();
+  const size_t oldCount = oldMembers.size();
+  const size_t newCount = newMembers.size();
+  const size_t oldOffsetsIndex = pushMemberOffsets(diff, oldNode, oldPosition.offset);
+  const size_t newOffsetsIndex = pushMemberOffsets(diff, newNode, newPosition.offset);
+  if (diff->failed) {
+    return;
+  }
+
+  // Offsets are re-read through the stack on each access as nested comparisons may grow it.
+  auto oldMemberPosition = [&](size_t index) {
+    return makeDiffPosition(oldMembers[index], oldNode, (unsigned int)index, diff->memberOffsets.begin()[oldOffsetsIndex + index]);
+  };
+  auto newMemberPosition = [&](size_t index) {
+    return makeDiffPosition(newMembers[index], newNode, (unsigned int)index, diff->memberOffsets.begin()[newOffsetsIndex + index]);
+  };
+
+  // Identical leading members are skipped entirely. Identical trailing members are only reported
+  // if they moved.
+  const size_t commonCount = std::min(oldCount, newCount);
+  size_t prefixCount = 0;
+  while ((prefixCount < commonCount) && areStructurallyEqualTypeNodes(oldMembers[prefixCount], newMembers[prefixCount])) {
+    ++prefixCount;
+  }
+  size_t suffixCount = 0;
+  while ((suffixCount < (commonCount - prefixCount)) && areStructurallyEqualTypeNodes(oldMembers[oldCount - 1 - suffixCount], newMembers[newCount - 1 - suffixCount])) {
+    ++suffixCount;
+  }
+
+  const size_t oldChangedCount = oldCount - prefixCount - suffixCount;
+  const size_t newChangedCount = newCount - prefixCount - suffixCount;
+  const size_t pairedCount = std::min(oldChangedCount, newChangedCount);
+  for (size_t index = 0; index < pairedCount; index++) {
+    objctk_diffposition oldMember = oldMemberPosition(prefixCount + index);
+    objctk_diffposition newMember = newMemberPosition(prefixCount + index);
+    if (areComparableTypeNodes(oldMember.node, newMember.node)) {
+      diffComparableTypeNodes(diff, depth + 1, oldMember, newMember);
+    } else {
+      addChange(diff, objctk_typechangekind_MemberRetyped, depth + 1, oldMember, newMember);
+    }
+  }
+  for (size_t index = pairedCount; index < oldChangedCount; index++) {
+    addChange(diff, objctk_typechangekind_MemberRemoved, depth + 1, oldMemberPosition(prefixCount + index), emptyDiffPosition());
+  }
+  for (size_t index = pairedCount; index < newChangedCount; index++) {
+    addChange(diff, objctk_typechangekind_MemberAdded, depth + 1, emptyDiffPosition(), newMemberPosition(prefixCount + index));
+  }
+  for (size_t index = 0; index < suffixCount; index++) {
+    objctk_diffposition oldMember = oldMemberPosition(oldCount - suffixCount + index);
+    objctk_diffposition newMember = newMemberPosition(newCount - suffixCount + index);
+    if (oldMember.offset != newMember.offset) {
+      addChange(diff, objctk_typechangekind_MemberMoved, depth + 1, oldMember, newMember);
+    }
+  }
+
+  diff->memberOffsets.resize(oldOffsetsIndex);
+}
+
+static void diffComparableTypeNodes(objctk_typediff diff, const unsigned int depth, const objctk_diffposition oldPosition, const objctk_diffposition newPosition) {
+  _objctk_typenode *oldNode = oldPosition.node;
+  _objctk_typenode *newNode = newPosition.node;
+  if (diff->failed || areStructurallyEqualTypeNodes(oldNode, newNode)) {
+    return;
+  }
+
+  objctk_typecategory typeCategory = oldNode->typeCategory();
+  if ((typeCategory != OBJCTKTypeCategoryPointer) && (oldNode->typeSize(diff->profile) != newNode->typeSize(diff->profile))) {
+    addChange(diff, objctk_typechangekind_SizeChanged, depth, oldPosition, newPosition);
+  }
+
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryUnion:
+    case OBJCTKTypeCategoryTopLevel:
+      diffMemberTypes(diff, depth, oldPosition, newPosition);
+      break;
+    case OBJCTKTypeCategoryArray:
+    case OBJCTKTypeCategoryPointer: {
+      // Array elements are compared at the offset of the first element. Referenced types of
+      // pointers are not part of the layout of the pointer and have no offset.
+      const bool isArray = (typeCategory == OBJCTKTypeCategoryArray);
+      objctk_diffposition oldReferencedPosition = makeDiffPosition(oldNode->referencedType(), oldNode, 0, isArray ? oldPosition.offset : -1);
+      objctk_diffposition newReferencedPosition = makeDiffPosition(newNode->referencedType(), newNode, 0, isArray ? newPosition.offset : -1);
+      if ((oldReferencedPosition.node == NULL) || (newReferencedPosition.node == NULL)) {
+        break;
+      }
+      if (areComparableTypeNodes(oldReferencedPosition.node, newReferencedPosition.node)) {
+        diffComparableTypeNodes(diff, depth + 1, oldReferencedPosition, newReferencedPosition);
+      } else if (!areStructurallyEqualTypeNodes(oldReferencedPosition.node, newReferencedPosition.node)) {
+        addChange(diff, objctk_typechangekind_MemberRetyped, depth + 1, oldReferencedPosition, newReferencedPosition);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+objctk_typediff objctk_typediff_create(void) {
+  return makeObject<_objctk_typediff>(defaultAllocator(), defaultAllocator());
+}
+
+size_t objctk_typediff_compare(objctk_typediff diff, objctk_typenode oldNode, objctk_typenode newNode, objctk_layoutprofile profile) {
+  if (diff == NULL) {
+    return 0;
+  }
+  diff->changes.clear();
+  diff->memberOffsets.clear();
+  diff->failed = false;
+  diff->profile = profile;
+  diff->rules = layoutRulesForProfile(profile);
+  if ((oldNode == NULL) || (newNode == NULL) || (diff->rules == NULL)) {
+    return 0;
+  }
+
+  objctk_diffposition oldPosition = makeDiffPosition(oldNode, NULL, UINT_MAX, 0);
+  objctk_diffposition newPosition = makeDiffPosition(newNode, NULL, UINT_MAX, 0);
+  if (areStructurallyEqualTypeNodes(oldNode, newNode)) {
+    return 0;
+  }
+  if (areComparableTypeNodes(oldNode, newNode)) {
+    diffComparableTypeNodes(diff, 0, oldPosition, newPosition);
+  } else {
+    addChange(diff, objctk_typechangekind_TypeReplaced, 0, oldPosition, newPosition);
+  }
+  return diff->changes.size();
+}
+
+const objctk_typechange *objctk_typediff_getChanges(objctk_typediff diff, size_t *outCount) {
+  if (outCount != NULL) {
+    *outCount = (diff != NULL) ? diff->changes.size() : 0;
+  }
+  return (diff != NULL) ? diff->changes.begin() : NULL;
+}
+
+void objctk_typediff_release(objctk_typediff diff) {
+  if (diff == NULL) {
+    return;
+  }
+  objctk_allocator allocator = diff->allocator;
+  releaseObject(&allocator, diff);
+}
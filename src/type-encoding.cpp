@@ -24,15 +24,31 @@ SOFTWARE.
 
 #include "type-encoding.h"
 
+#include "internal-hot-encodings.h"
+#include "name-table.h"
 #include "parser.h"
+#include "typenode-subtypes.h"
 
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define OBJCTK_EARLY_RETURN_ON_NULL(value, fallback) \
   if (value == NULL) { return fallback; }
 
 using namespace objctk;
 
+static inline bool isCompositeTypeCategory(const objctk_typecategory typeCategory) {
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryUnion:
+    case OBJCTKTypeCategoryTopLevel:
+      return true;
+    default:
+      return false;
+  }
+}
+
 static inline objctk_range invalidRange() {
   objctk_range invalidRange = {
     .offset = UINT_MAX,
@@ -51,6 +67,45 @@ int objctk_typenode_getTypeSize(objctk_typenode node) {
   return node->typeSize();
 }
 
+int objctk_typenode_getTypeSizeForLayoutProfile(objctk_typenode node, objctk_layoutprofile profile) {
+  OBJCTK_EARLY_RETURN_ON_NULL(node, -1);
+  return node->typeSize(profile);
+}
+
+int objctk_typenode_getTypeAlignment(objctk_typenode node) {
+  return objctk_typenode_getTypeAlignmentForLayoutProfile(node, objctk_layoutprofile_Host);
+}
+
+int objctk_typenode_getTypeAlignmentForLayoutProfile(objctk_typenode node, objctk_layoutprofile profile) {
+  OBJCTK_EARLY_RETURN_ON_NULL(node, -1);
+  objctk_typelayout layout = node->typeLayout(profile);
+  return (layout.size < 0) ? -1 : layout.alignment;
+}
+
+int objctk_typenode_getMemberOffsetForLayoutProfile(objctk_typenode node, unsigned int memberIndex, objctk_layoutprofile profile) {
+  OBJCTK_EARLY_RETURN_ON_NULL(node, -1);
+  const objctk_layoutrules *rules = layoutRulesForProfile(profile);
+  if ((rules == NULL) || !isCompositeTypeCategory(node->typeCategory())) {
+    return -1;
+  }
+
+  compositetypenode *compositeTypeNode = static_cast<compositetypenode *>(node);
+  unsigned int index = 0;
+  int memberOffset = -1;
+  objctk_typelayout layout = compositeTypeNode->layoutMembers(rules, [&](_objctk_typenode *, int offset, int) {
+    if (index == memberIndex) {
+      memberOffset = offset;
+    }
+    ++index;
+  });
+  return (layout.size < 0) ? -1 : memberOffset;
+}
+
+uint64_t objctk_typenode_getStructuralHash(objctk_typenode node) {
+  OBJCTK_EARLY_RETURN_ON_NULL(node, 0);
+  return node->structuralHash();
+}
+
 objctk_range objctk_typenode_getRange(objctk_typenode node) {
   OBJCTK_EARLY_RETURN_ON_NULL(node, invalidRange());
   return node->substring();
@@ -61,13 +116,27 @@ objctk_range objctk_typenode_getNameRange(objctk_typenode node) {
   return node->typeName();
 }
 
+objctk_nameid objctk_typenode_getNameID(objctk_typenode node) {
+  OBJCTK_EARLY_RETURN_ON_NULL(node, OBJCTK_NAMEID_NONE);
+  return node->typeNameID();
+}
+
+const char *objctk_typenode_getName(objctk_typenode node) {
+  OBJCTK_EARLY_RETURN_ON_NULL(node, NULL);
+  return internedName(node->typeNameID(), NULL);
+}
+
 objctk_typenode objctk_typenode_getReferencedType(objctk_typenode node) {
   OBJCTK_EARLY_RETURN_ON_NULL(node, NULL);
   _objctk_typenode_ptr refencedTypeNodePtr = node->referencedType();
-  return refencedTypeNodePtr.get();
+  return refencedTypeNodePtr;
 }
 
 objctk_typenode *objctk_typenode_copyMemberTypeList(objctk_typenode node, unsigned int *outCount) {
+  return objctk_typenode_copyMemberTypeListWithAllocator(node, NULL, outCount);
+}
+
+objctk_typenode *objctk_typenode_copyMemberTypeListWithAllocator(objctk_typenode node, const objctk_allocator *allocator, unsigned int *outCount) {
   OBJCTK_EARLY_RETURN_ON_NULL(node, NULL);
   _objctk_typenode_list list = node->memberTypes();
 
@@ -80,12 +149,16 @@ objctk_typenode *objctk_typenode_copyMemberTypeList(objctk_typenode node, unsign
     return NULL;
   }
 
-  objctk_typenode *memberTypeList = (objctk_typenode *)malloc(count * sizeof(objctk_typenode));
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+  objctk_typenode *memberTypeList = (objctk_typenode *)allocateMemory(allocator, count * sizeof(objctk_typenode));
+  OBJCTK_EARLY_RETURN_ON_NULL(memberTypeList, NULL);
 
   unsigned int index = 0;
   for (_objctk_typenode_list::iterator iter = list.begin(); iter != list.end(); iter++) {
     _objctk_typenode_ptr typeNodePtr = *iter;
-    memberTypeList[index] = typeNodePtr.get();
+    memberTypeList[index] = typeNodePtr;
     ++index;
   }
   return memberTypeList;
@@ -100,59 +173,212 @@ void objctk_enumerateMemberValues(
     return;
   }
 
-  _objctk_typenode_list list = node->memberTypes();
-  int offset = 0;
-  for (_objctk_typenode_list::iterator iter = list.begin(); iter != list.end(); iter++) {
-    _objctk_typenode_ptr memberTypeNodePtr = *iter;
+  if (!isCompositeTypeCategory(node->typeCategory())) {
+    return;
+  }
 
-    // Calculate the offset to the member value.
-    int memberTypeSize = memberTypeNodePtr->typeSize();
-    if (memberTypeSize == -1) {
-      // Unable to continue further.
+  // Calculate the offsets to the member values using the layout rules of the host, stopping at the
+  // first member whose layout cannot be determined.
+  compositetypenode *compositeTypeNode = static_cast<compositetypenode *>(node);
+  const objctk_layoutrules *rules = layoutRulesForProfile(objctk_layoutprofile_Host);
+  bool canContinue = true;
+  compositeTypeNode->layoutMembers(rules, [&](_objctk_typenode *memberTypeNode, int offset, int) {
+    if (!canContinue || (memberTypeNode->typeSize() == -1)) {
+      canContinue = false;
       return;
     }
+    char *memberValueAddress = ((char *)address) + offset;
+    enumerationFunction(memberValueAddress, memberTypeNode, NULL);
+  });
+}
+
+objctk_typeparseresult objctk_parseTypeEncoding(const char *typeEncoding) {
+  return objctk_parseTypeEncodingWithAllocator(typeEncoding, NULL);
+}
+
+objctk_typeparseresult objctk_parseTypeEncodingWithAllocator(const char *typeEncoding, const objctk_allocator *allocator) {
+  return objctk_parseTypeEncodingWithLimits(typeEncoding, NULL, allocator);
+}
 
-    // Calculate the offset to the member based on:
-    // • C99 §6.7.2.1
-    // • An undocumented assumption that compilers generally target alignment to the type's size.
-    int alignmentOffset = (offset % memberTypeSize);
-    if (alignmentOffset != 0) {
-      offset += (memberTypeSize - alignmentOffset);
+// Returns the persistent parse result of a prewarmed type encoding if the parse has no resource
+// limits which the prewarmed parse might have exceeded. Parses which obtain memory from a specific
+// allocator always parse their type encodings, as persistent parse results are allocated from the
+// default allocator.
+static inline objctk_typeparseresult prewarmedParseResultWithinLimits(const char *typeEncoding, const objctk_parselimits *limits) {
+  if ((limits != NULL) && ((limits->maximumInputLength != 0) || (limits->maximumDepth != 0) || (limits->maximumNodeCount != 0) || (limits->maximumByteCount != 0) || (limits->maximumNanoseconds != 0))) {
+    return NULL;
+  }
+  return prewarmedParseResult(typeEncoding);
+}
+
+objctk_typeparseresult objctk_parseTypeEncodingWithLimits(const char *typeEncoding, const objctk_parselimits *limits, const objctk_allocator *allocator) {
+  OBJCTK_EARLY_RETURN_ON_NULL(typeEncoding, NULL);
+  objctk_typeparseresult parseResult = NULL;
+  if (allocator == NULL) {
+    parseResult = prewarmedParseResultWithinLimits(typeEncoding, limits);
+    if (parseResult != NULL) {
+      return parseResult;
     }
-    char *memberValueAddress = ((char *)address) + offset;
-    enumerationFunction(memberValueAddress, memberTypeNodePtr.get(), NULL);
-    offset += memberTypeSize;
+    allocator = defaultAllocator();
   }
+  parseResult = makeObject<_objctk_typeparseresult>(allocator, allocator);
+  OBJCTK_EARLY_RETURN_ON_NULL(parseResult, NULL);
+  _objctk_typenode_stack scratchStack(allocator);
+  parseTypeEncoding(typeEncoding, parseResult, &scratchStack, limits);
+  return parseResult;
 }
 
-objctk_typeparseresult objctk_parseTypeEncoding(const char *typeEncoding) {
+namespace objctk {
+
+_objctk_typeparseresult *makeParserOwnedParseResult(const objctk_allocator *allocator) {
+  _objctk_typeparseresult *result = makeObject<_objctk_typeparseresult>(allocator, allocator);
+  if (result != NULL) {
+    result->reference_state.store(kParseResultParserOwnership, std::memory_order_relaxed);
+  }
+  return result;
+}
+
+_objctk_typeparseresult *resetParserResult(_objctk_parser *parser) {
+  parser->scratch_stack.clear();
+  _objctk_typeparseresult *result = parser->result;
+  if (result != NULL) {
+    // Callers only retain the parse result on the parser's thread, so a result without references
+    // cannot gain any while it is reused.
+    if (result->reference_state.load(std::memory_order_acquire) == kParseResultParserOwnership) {
+      result->node = NULL;
+      result->status.status_code = objctk_statuscode_NoError;
+      result->status.error_description = NULL;
+      result->unexpected_token_count = 0;
+      result->arena.reset();
+      return result;
+    }
+    releaseParserOwnedParseResult(result);
+  }
+  parser->result = makeParserOwnedParseResult(&parser->allocator);
+  return parser->result;
+}
+
+void releaseParserOwnedParseResult(_objctk_typeparseresult *result) {
+  // Callers may release their references concurrently, and whoever drops the last reference frees
+  // the parse result.
+  const size_t referenceState = result->reference_state.fetch_sub(kParseResultParserOwnership, std::memory_order_acq_rel);
+  if (referenceState == kParseResultParserOwnership) {
+    objctk_allocator allocator = result->allocator;
+    releaseObject(&allocator, result);
+  }
+}
+
+}
+
+objctk_parser objctk_parser_create(void) {
+  return objctk_parser_createWithAllocator(NULL);
+}
+
+objctk_parser objctk_parser_createWithAllocator(const objctk_allocator *allocator) {
+  const bool usesPrewarmedParseResults = (allocator == NULL);
+  if (allocator == NULL) {
+    allocator = defaultAllocator();
+  }
+  objctk_parser parser = makeObject<_objctk_parser>(allocator, allocator);
+  OBJCTK_EARLY_RETURN_ON_NULL(parser, NULL);
+  parser->uses_prewarmed_parse_results = usesPrewarmedParseResults;
+  parser->result = makeParserOwnedParseResult(allocator);
+  if (parser->result == NULL) {
+    releaseObject(allocator, parser);
+    return NULL;
+  }
+  return parser;
+}
+
+objctk_typeparseresult objctk_parser_parseTypeEncoding(objctk_parser parser, const char *typeEncoding) {
+  OBJCTK_EARLY_RETURN_ON_NULL(parser, NULL);
   OBJCTK_EARLY_RETURN_ON_NULL(typeEncoding, NULL);
-  objctk_typeparseresult parseResult = new _objctk_typeparseresult();
-  *parseResult = parseTypeEncoding(typeEncoding);
+  objctk_typeparseresult parseResult = resetParserResult(parser);
+  OBJCTK_EARLY_RETURN_ON_NULL(parseResult, NULL);
+  objctk_typeparseresult prewarmedParseResult = parser->uses_prewarmed_parse_results ? prewarmedParseResultWithinLimits(typeEncoding, &parser->limits) : NULL;
+  if (prewarmedParseResult != NULL) {
+    return prewarmedParseResult;
+  }
+  parseTypeEncoding(typeEncoding, parseResult, &parser->scratch_stack, &parser->limits);
   return parseResult;
 }
 
+void objctk_parser_setLimits(objctk_parser parser, const objctk_parselimits *limits) {
+  OBJCTK_EARLY_RETURN_ON_NULL(parser, );
+  parser->limits = (limits != NULL) ? *limits : objctk_parselimits();
+}
+
+void objctk_parser_reset(objctk_parser parser) {
+  OBJCTK_EARLY_RETURN_ON_NULL(parser, );
+  resetParserResult(parser);
+}
+
+void objctk_parser_release(objctk_parser parser) {
+  OBJCTK_EARLY_RETURN_ON_NULL(parser, );
+  if (parser->result != NULL) {
+    releaseParserOwnedParseResult(parser->result);
+  }
+  objctk_allocator allocator = parser->allocator;
+  releaseObject(&allocator, parser);
+}
+
 objctk_statuscode objctk_typeparseresult_getStatusCode(objctk_typeparseresult parseResult) {
   OBJCTK_EARLY_RETURN_ON_NULL(parseResult, objctk_statuscode_InvalidInput);
   _objctk_parsestatus status = parseResult->status;
   return status.status_code;
 }
 
+size_t objctk_typeparseresult_getUnexpectedTokenCount(objctk_typeparseresult parseResult) {
+  OBJCTK_EARLY_RETURN_ON_NULL(parseResult, 0);
+  return parseResult->unexpected_token_count;
+}
+
 char *objctk_typeparseresult_copyErrorDescription(objctk_typeparseresult parseResult) {
   OBJCTK_EARLY_RETURN_ON_NULL(parseResult, NULL);
   _objctk_parsestatus status = parseResult->status;
-  std::string errorDescription = status.error_description;
-  char *copiedErrorDescription = (char *)malloc(errorDescription.length() + 1);
-  std::strcpy(copiedErrorDescription, errorDescription.c_str());
+  const char *errorDescription = (status.error_description != NULL) ? status.error_description : "";
+  size_t errorDescriptionSize = strlen(errorDescription) + 1;
+  char *copiedErrorDescription = (char *)allocateMemory(&parseResult->allocator, errorDescriptionSize);
+  OBJCTK_EARLY_RETURN_ON_NULL(copiedErrorDescription, NULL);
+  memcpy(copiedErrorDescription, errorDescription, errorDescriptionSize);
   return copiedErrorDescription;
 }
 
 objctk_typenode objctk_typeparseresult_getParsedType(objctk_typeparseresult parseResult) {
   OBJCTK_EARLY_RETURN_ON_NULL(parseResult, NULL);
   _objctk_typenode_ptr typeNodePtr = parseResult->node;
-  return typeNodePtr.get();
+  return typeNodePtr;
+}
+
+objctk_typeparseresult objctk_typeparseresult_retain(objctk_typeparseresult parseResult) {
+  if ((parseResult == NULL) || parseResult->is_persistent) {
+    return parseResult;
+  }
+  parseResult->reference_state.fetch_add(kParseResultReference, std::memory_order_relaxed);
+  return parseResult;
 }
 
-OBJCTK_EXTERN void objctk_typeparseresult_release(objctk_typeparseresult parseResult) {
-  delete parseResult;
+void objctk_typeparseresult_release(objctk_typeparseresult parseResult) {
+  if ((parseResult == NULL) || parseResult->is_persistent) {
+    return;
+  }
+  // Freeing a parse result of a batch releases the parse result sharing its prefix types in turn,
+  // which is done iteratively because batches may chain many parse results.
+  while (parseResult != NULL) {
+    // Releasing a parse result without a reference, such as one owned by a parser which has not been
+    // retained, has no effect.
+    size_t referenceState = parseResult->reference_state.load(std::memory_order_relaxed);
+    do {
+      if (referenceState < kParseResultReference) {
+        return;
+      }
+    } while (!parseResult->reference_state.compare_exchange_weak(referenceState, referenceState - kParseResultReference, std::memory_order_acq_rel, std::memory_order_relaxed));
+    if (referenceState != kParseResultReference) {
+      return;
+    }
+    objctk_typeparseresult prefixResult = parseResult->prefix_result;
+    objctk_allocator allocator = parseResult->allocator;
+    releaseObject(&allocator, parseResult);
+    parseResult = prefixResult;
+  }
 }
@@ -27,7 +27,9 @@ SOFTWARE.
 
 #include "typenode.h"
 
+#include <limits.h>
 #include <string.h>
+#include <algorithm>
 
 namespace objctk {
 
@@ -37,15 +39,18 @@ namespace objctk {
 class bitfieldnode : public _objctk_typenode {
   const size_t m_size;
 public:
-  bitfieldnode(const objctk_substring substring, size_t size) : _objctk_typenode(substring, OBJCTKTypeCategoryBitField), m_size(size) {}
-  int typeSize() {
-    size_t byteSize = sizeof(char);
-    int numberOfBytes = m_size / byteSize;
-    int bitRemainder = m_size % byteSize;
-    if (bitRemainder != 0) {
-      numberOfBytes += 1;
+  bitfieldnode(const objctk_substring substring, size_t size) : _objctk_typenode(substring, OBJCTKTypeCategoryBitField), m_size(size) {
+    combineStructuralHash(size);
+  }
+
+  /** Returns the width of the bitfield in bits. */
+  size_t bitCount() { return m_size; }
+
+  objctk::objctk_typelayout computeTypeLayout(const objctk::objctk_layoutrules *) {
+    if (m_size > (size_t)objctk::kMaximumTypeBitCount) {
+      return objctk::invalidTypeLayout();
     }
-    return numberOfBytes;
+    return objctk::makeTypeLayout((int)((m_size + CHAR_BIT - 1) / CHAR_BIT), 1);
   }
 };
 
@@ -55,10 +60,14 @@ public:
 class pointernode : public _objctk_typenode {
   const _objctk_typenode_ptr m_referenced_type;
 public:
-  pointernode(const objctk_substring substring, const objctk_typecategory typeCategory, const _objctk_typenode_ptr typeNode) : _objctk_typenode(substring, typeCategory), m_referenced_type(typeNode) {}
+  pointernode(const objctk_substring substring, const objctk_typecategory typeCategory, const _objctk_typenode_ptr typeNode) : _objctk_typenode(substring, typeCategory), m_referenced_type(typeNode) {
+    combineStructuralHash((typeNode != NULL) ? typeNode->structuralHash() : 0);
+  }
+
+  /** Copies a pointer type node, replacing its referenced type with a copy of it. */
+  pointernode(const pointernode &other, const _objctk_typenode_ptr typeNode) : _objctk_typenode(other), m_referenced_type(typeNode) {}
 
   virtual _objctk_typenode_ptr referencedType() { return m_referenced_type; }
-  int typeSize() { return sizeof(void *); }
 };
 
 /**
@@ -67,10 +76,26 @@ public:
 class arraynode : public pointernode {
   const size_t m_size;
 public:
-  arraynode(const objctk_substring substring, const _objctk_typenode_ptr node, const size_t size) : pointernode(substring, OBJCTKTypeCategoryArray, node), m_size(size) {}
-  int typeSize() {
+  arraynode(const objctk_substring substring, const _objctk_typenode_ptr node, const size_t size) : pointernode(substring, OBJCTKTypeCategoryArray, node), m_size(size) {
+    combineStructuralHash(size);
+  }
+
+  /** Copies an array type node, replacing its element type with a copy of it. */
+  arraynode(const arraynode &other, const _objctk_typenode_ptr node) : pointernode(other, node), m_size(other.m_size) {}
+
+  /** Returns the number of elements in the array. */
+  size_t elementCount() { return m_size; }
+
+  objctk::objctk_typelayout computeTypeLayout(const objctk::objctk_layoutrules *rules) {
     _objctk_typenode_ptr referencedType = this->referencedType();
-    return m_size * referencedType->typeSize();
+    objctk::objctk_typelayout elementLayout = referencedType->typeLayout(rules->profile);
+    if (elementLayout.size < 0) {
+      return objctk::invalidTypeLayout();
+    }
+    if ((elementLayout.size != 0) && (m_size > (size_t)(objctk::kMaximumTypeSize / elementLayout.size))) {
+      return objctk::invalidTypeLayout();
+    }
+    return objctk::makeTypeLayout((int)(m_size * elementLayout.size), elementLayout.alignment);
   }
 };
 
@@ -79,11 +104,17 @@ public:
  */
 class objectpointernode : public _objctk_typenode {
   const objctk_substring m_type_name;
+  objctk_nameid m_type_name_id;
 public:
-  objectpointernode(const objctk_substring substring, const objctk_substring typeName) : _objctk_typenode(substring, OBJCTKTypeCategoryObject), m_type_name(typeName) {}
+  objectpointernode(const objctk_substring substring, const objctk_substring typeName, const uint64_t typeNameHash) : _objctk_typenode(substring, OBJCTKTypeCategoryObject), m_type_name(typeName), m_type_name_id(OBJCTK_NAMEID_NONE) {
+    combineStructuralHash(typeNameHash);
+  }
 
   virtual objctk_substring typeName() { return m_type_name; }
-  int typeSize() { return sizeof(void *); }
+  virtual objctk_nameid typeNameID() { return m_type_name_id; }
+
+  /** Sets the identifier of the interned type name once the type has been parsed successfully. */
+  void setTypeNameID(const objctk_nameid typeNameID) { m_type_name_id = typeNameID; }
 };
 
 /**
@@ -92,29 +123,146 @@ public:
 class compositetypenode : public _objctk_typenode {
   const _objctk_typenode_list m_member_types;
   const objctk_substring m_type_name;
+  objctk_nameid m_type_name_id;
 public:
-  compositetypenode(const objctk_substring substring, const objctk_typecategory typeCategory, const _objctk_typenode_list memberTypes, const objctk_substring typeName) : _objctk_typenode(substring, typeCategory), m_member_types(memberTypes), m_type_name(typeName) {}
+  compositetypenode(const objctk_substring substring, const objctk_typecategory typeCategory, const _objctk_typenode_list memberTypes, const objctk_substring typeName, const uint64_t typeNameHash) : _objctk_typenode(substring, typeCategory), m_member_types(memberTypes), m_type_name(typeName), m_type_name_id(OBJCTK_NAMEID_NONE) {
+    combineStructuralHash(typeNameHash);
+    for (_objctk_typenode_list::const_iterator iter = memberTypes.begin(); iter != memberTypes.end(); iter++) {
+      combineStructuralHash((*iter)->structuralHash());
+    }
+  }
+
+  /** Copies a composite type node, replacing its member types with copies of them. */
+  compositetypenode(const compositetypenode &other, const _objctk_typenode_list memberTypes) : _objctk_typenode(other), m_member_types(memberTypes), m_type_name(other.m_type_name), m_type_name_id(other.m_type_name_id) {}
 
   virtual objctk_substring typeName() { return m_type_name; }
+  virtual objctk_nameid typeNameID() { return m_type_name_id; }
   virtual _objctk_typenode_list memberTypes() { return m_member_types; }
-  int typeSize() {
-    _objctk_typenode_list list = this->memberTypes();
-    int totalSize = 0;
+
+  /** Sets the identifier of the interned type name once the type has been parsed successfully. */
+  void setTypeNameID(const objctk_nameid typeNameID) { m_type_name_id = typeNameID; }
+
+  /**
+   * Lays out the member types under the rules of a layout profile, passing each member type node,
+   * its byte offset and, for bitfields, its bit offset within that byte to a visitor.
+   *
+   * Structs follow the C99 §6.7.2.1 rules common to the supported ABIs: members are placed at the
+   * next offset satisfying their alignment, bitfields are packed into storage units which they do
+   * not straddle and the struct size is padded to its strictest member alignment. Top-level types,
+   * which describe sequences of unrelated values such as method signatures, are not padded.
+   */
+  template <typename Visitor>
+  objctk::objctk_typelayout layoutMembers(const objctk::objctk_layoutrules *rules, Visitor visit) {
+    const objctk_typecategory typeCategory = this->typeCategory();
+    const bool isUnion = (typeCategory == OBJCTKTypeCategoryUnion);
+    const bool isPadded = (typeCategory != OBJCTKTypeCategoryTopLevel);
+    const int unitBits = rules->bitfieldUnitSize * CHAR_BIT;
+
+    // Offsets are accumulated in 64-bit arithmetic so that types too large for an int layout are
+    // reported as invalid rather than wrapping around.
+    int64_t bitOffset = 0;
     int largestMemberTypeSize = 0;
-    for (_objctk_typenode_list::iterator iter = list.begin(); iter != list.end(); iter++) {
+    int largestAlignment = 1;
+    for (_objctk_typenode_list::const_iterator iter = m_member_types.begin(); iter != m_member_types.end(); iter++) {
       _objctk_typenode_ptr typeNodePtr = *iter;
-      int memberTypeSize = typeNodePtr->typeSize();
-      largestMemberTypeSize = std::max(largestMemberTypeSize, memberTypeSize);
-      totalSize += memberTypeSize;
+      if (typeNodePtr->typeCategory() == OBJCTKTypeCategoryBitField) {
+        objctk::objctk_typelayout memberLayout = typeNodePtr->typeLayout(rules->profile);
+        if (memberLayout.size < 0) {
+          return objctk::invalidTypeLayout();
+        }
+        const int64_t bitCount = (int64_t)static_cast<bitfieldnode *>(typeNodePtr)->bitCount();
+        int64_t memberBitOffset = isUnion ? 0 : bitOffset;
+        if ((bitCount == 0) || ((memberBitOffset % unitBits) + bitCount > unitBits)) {
+          memberBitOffset = objctk::alignedOffset(memberBitOffset, unitBits);
+        }
+        if (memberBitOffset + bitCount > objctk::kMaximumTypeBitCount) {
+          return objctk::invalidTypeLayout();
+        }
+        visit(typeNodePtr, (int)(memberBitOffset / CHAR_BIT), (int)(memberBitOffset % CHAR_BIT));
+        largestAlignment = std::max(largestAlignment, (int)rules->bitfieldUnitAlignment);
+        largestMemberTypeSize = std::max(largestMemberTypeSize, memberLayout.size);
+        if (!isUnion) {
+          bitOffset = memberBitOffset + bitCount;
+        }
+        continue;
+      }
+
+      objctk::objctk_typelayout memberLayout = typeNodePtr->typeLayout(rules->profile);
+      if (memberLayout.size < 0) {
+        return objctk::invalidTypeLayout();
+      }
+      int64_t byteOffset = (bitOffset + CHAR_BIT - 1) / CHAR_BIT;
+      if (isPadded) {
+        byteOffset = objctk::alignedOffset(byteOffset, memberLayout.alignment);
+      }
+      const int64_t memberOffset = isUnion ? 0 : byteOffset;
+      if (memberOffset + memberLayout.size > objctk::kMaximumTypeSize) {
+        return objctk::invalidTypeLayout();
+      }
+      visit(typeNodePtr, (int)memberOffset, 0);
+      largestAlignment = std::max(largestAlignment, memberLayout.alignment);
+      largestMemberTypeSize = std::max(largestMemberTypeSize, memberLayout.size);
+      if (!isUnion) {
+        bitOffset = (memberOffset + memberLayout.size) * CHAR_BIT;
+      }
     }
-    objctk_typecategory typeCategory = this->typeCategory();
-    if (typeCategory == OBJCTKTypeCategoryUnion) {
-      return largestMemberTypeSize;
+
+    int64_t size = isUnion ? largestMemberTypeSize : ((bitOffset + CHAR_BIT - 1) / CHAR_BIT);
+    if (isPadded) {
+      size = objctk::alignedOffset(size, largestAlignment);
     }
-    return totalSize;
+    return objctk::makeCheckedTypeLayout(size, largestAlignment);
+  }
+
+  objctk::objctk_typelayout computeTypeLayout(const objctk::objctk_layoutrules *rules) {
+    return layoutMembers(rules, [](_objctk_typenode *, int, int) {});
   }
 };
 
+/**
+ * Returns whether two type nodes describe structurally identical types. Structural hashes are
+ * compared first so that differing types are usually rejected without walking them, while types
+ * whose hashes collide are still told apart. Type names are compared by their interned identifiers,
+ * which are assigned once a type has been parsed successfully.
+ */
+static inline bool areStructurallyEqualTypeNodes(_objctk_typenode *lhs, _objctk_typenode *rhs) {
+  if (lhs == rhs) {
+    return true;
+  }
+  if ((lhs == NULL) || (rhs == NULL) || (lhs->structuralHash() != rhs->structuralHash())) {
+    return false;
+  }
+  const objctk_typecategory typeCategory = lhs->typeCategory();
+  if ((typeCategory != rhs->typeCategory()) || (lhs->typeNameID() != rhs->typeNameID())) {
+    return false;
+  }
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryBitField:
+      return static_cast<bitfieldnode *>(lhs)->bitCount() == static_cast<bitfieldnode *>(rhs)->bitCount();
+    case OBJCTKTypeCategoryArray:
+      if (static_cast<arraynode *>(lhs)->elementCount() != static_cast<arraynode *>(rhs)->elementCount()) {
+        return false;
+      }
+      break;
+    default:
+      break;
+  }
+  if (!areStructurallyEqualTypeNodes(lhs->referencedType(), rhs->referencedType())) {
+    return false;
+  }
+  const _objctk_typenode_list lhsMembers = lhs->memberTypes();
+  const _objctk_typenode_list rhsMembers = rhs->memberTypes();
+  if (lhsMembers.size() != rhsMembers.size()) {
+    return false;
+  }
+  for (size_t index = 0; index < lhsMembers.size(); index++) {
+    if (!areStructurallyEqualTypeNodes(lhsMembers[index], rhsMembers[index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }
 
 #endif
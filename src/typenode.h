@@ -25,64 +25,171 @@ SOFTWARE.
 #ifndef OBJCTK_TYPE_NODE__
 #define OBJCTK_TYPE_NODE__
 
+#include "internal-allocator.h"
 #include "internal-types.h"
+#include "layout.h"
+#include "names.h"
 
+#include <stdint.h>
 #include <string.h>
-#include <queue>
-#include <vector>
+#include <atomic>
 
 struct _objctk_typenode;
 
-typedef std::shared_ptr<_objctk_typenode> _objctk_typenode_ptr;
-typedef std::vector<_objctk_typenode_ptr> _objctk_typenode_list;
+typedef _objctk_typenode *_objctk_typenode_ptr;
+
+/**
+ * An immutable list of type nodes. The list does not own its storage, which is allocated in the
+ * arena of the parse result alongside the type nodes.
+ */
+class _objctk_typenode_list {
+  const _objctk_typenode_ptr *m_type_nodes;
+  size_t m_count;
+public:
+  typedef const _objctk_typenode_ptr *iterator;
+  typedef const _objctk_typenode_ptr *const_iterator;
+
+  _objctk_typenode_list() : m_type_nodes(NULL), m_count(0) {}
+  _objctk_typenode_list(const _objctk_typenode_ptr *typeNodes, size_t count) : m_type_nodes(typeNodes), m_count(count) {}
+
+  const_iterator begin() const { return m_type_nodes; }
+  const_iterator end() const { return m_type_nodes + m_count; }
+  size_t size() const { return m_count; }
+  bool empty() const { return (m_count == 0); }
+  _objctk_typenode_ptr operator[](size_t index) const { return m_type_nodes[index]; }
+};
+
+/** A stack of type nodes used as scratch space while parsing. */
+typedef objctk::scratchstack<_objctk_typenode_ptr> _objctk_typenode_stack;
+
+namespace objctk {
+
+/**
+ * Returns the hash of a type name mixed into structural hashes, which is zero for types without a
+ * name. Type names are hashed rather than interned while parsing so that only successful parses
+ * intern their type names.
+ */
+static inline uint64_t typeNameStructuralHash(const char *typeName, const size_t length) {
+  if (length == 0) {
+    return 0;
+  }
+  // 64-bit FNV-1a.
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t index = 0; index < length; index++) {
+    hash ^= (unsigned char)typeName[index];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/** Mixes a value into a structural hash. */
+static inline uint64_t combinedStructuralHash(const uint64_t hash, const uint64_t value) {
+  uint64_t mixedValue = (hash ^ value) * 0x9E3779B97F4A7C15ULL;
+  mixedValue ^= (mixedValue >> 29);
+  mixedValue *= 0xBF58476D1CE4E5B9ULL;
+  return mixedValue ^ (mixedValue >> 32);
+}
+
+}
 
 struct _objctk_typenode {
 private:
   objctk_substring m_substring;
   objctk_typecategory m_type_category;
 
+  // A hash of the structure of the type, independent of where it was parsed from, which is
+  // computed bottom-up as type nodes are constructed.
+  uint64_t m_structural_hash;
+
+  // Layouts are computed lazily and cached per layout profile. A cached value of zero indicates
+  // that the layout has not been computed yet.
+  std::atomic<uint64_t> m_layout_cache[objctk::kLayoutProfileCount];
+
+  static uint64_t packedTypeLayout(const objctk::objctk_typelayout layout) {
+    return (1ULL << 63) | ((uint64_t)(uint32_t)layout.size << 32) | (uint32_t)layout.alignment;
+  }
+
+  static objctk::objctk_typelayout unpackedTypeLayout(const uint64_t packedLayout) {
+    return objctk::makeTypeLayout((int)(uint32_t)((packedLayout >> 32) & 0x7FFFFFFF), (int)(uint32_t)packedLayout);
+  }
+
+protected:
+  void combineStructuralHash(const uint64_t value) {
+    m_structural_hash = objctk::combinedStructuralHash(m_structural_hash, value);
+  }
+
 public:
-  _objctk_typenode(const objctk_substring substring, const objctk_typecategory typeCategory) :  m_substring(substring), m_type_category(typeCategory) {}
+  _objctk_typenode(const objctk_substring substring, const objctk_typecategory typeCategory) :  m_substring(substring), m_type_category(typeCategory), m_structural_hash(objctk::combinedStructuralHash(0, typeCategory)) {
+    for (int index = 0; index < objctk::kLayoutProfileCount; index++) {
+      m_layout_cache[index].store(0, std::memory_order_relaxed);
+    }
+  }
   virtual ~_objctk_typenode() {}
 
+  /**
+   * Copies a type node, including its structural hash and cached layouts. Only type nodes whose
+   * class is exactly _objctk_typenode may be copied this way; subclasses with child type nodes
+   * provide copies which take copies of their children.
+   */
+  _objctk_typenode(const _objctk_typenode &other) : m_substring(other.m_substring), m_type_category(other.m_type_category), m_structural_hash(other.m_structural_hash) {
+    for (int index = 0; index < objctk::kLayoutProfileCount; index++) {
+      m_layout_cache[index].store(other.m_layout_cache[index].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+  }
+
   objctk_typecategory typeCategory() { return m_type_category; }
 
   objctk_substring substring() { return m_substring; }
 
-  virtual int typeSize() {
+  /**
+   * Returns a hash that is equal for type nodes describing structurally identical types. Distinct
+   * types may share a hash, so equal hashes do not imply equal types.
+   */
+  uint64_t structuralHash() { return m_structural_hash; }
+
+  /** Returns the layout of the type under the rules of a layout profile. */
+  objctk::objctk_typelayout typeLayout(const objctk_layoutprofile profile) {
+    const objctk::objctk_layoutrules *rules = objctk::layoutRulesForProfile(profile);
+    if (rules == NULL) {
+      return objctk::invalidTypeLayout();
+    }
+
+    // Racing threads compute identical layouts so relaxed ordering suffices.
+    std::atomic<uint64_t> *cachedLayout = &m_layout_cache[profile];
+    uint64_t packedLayout = cachedLayout->load(std::memory_order_relaxed);
+    if (packedLayout != 0) {
+      objctk::objctk_typelayout layout = unpackedTypeLayout(packedLayout);
+      return (layout.alignment == 0) ? objctk::invalidTypeLayout() : layout;
+    }
+
+    objctk::objctk_typelayout layout = computeTypeLayout(rules);
+    if (layout.size < 0) {
+      layout = objctk::invalidTypeLayout();
+    }
+    cachedLayout->store(packedTypeLayout(layout), std::memory_order_relaxed);
+    return layout;
+  }
+
+  int typeSize(const objctk_layoutprofile profile) { return typeLayout(profile).size; }
+
+  int typeSize() { return typeSize(objctk_layoutprofile_Host); }
+
+  /** Computes the layout of the type without consulting the layout cache. */
+  virtual objctk::objctk_typelayout computeTypeLayout(const objctk::objctk_layoutrules *rules) {
     objctk_typecategory typeCategory = this->typeCategory();
-    switch (typeCategory) {
-      case OBJCTKTypeCategorySignedChar:
-      case OBJCTKTypeCategoryUnsignedChar:
-        return sizeof(char);
-      case OBJCTKTypeCategorySignedInt:
-      case OBJCTKTypeCategoryUnsignedInt:
-        return sizeof(int);
-      case OBJCTKTypeCategorySignedShort:
-      case OBJCTKTypeCategoryUnsignedShort:
-        return sizeof(short);
-      case OBJCTKTypeCategorySignedLong:
-      case OBJCTKTypeCategoryUnsignedLong:
-        return sizeof(long);
-      case OBJCTKTypeCategorySignedLongLong:
-      case OBJCTKTypeCategoryUnsignedLongLong:
-        return sizeof(long long);
-      case OBJCTKTypeCategoryFloat:
-        return sizeof(float);
-      case OBJCTKTypeCategoryDouble:
-        return sizeof(double);
-      case OBJCTKTypeCategoryBool:
-        return sizeof(char);
-      case OBJCTKTypeCategoryVoid:
-        return 0;
-      default:
-        break;
+    int size = rules->sizes[typeCategory];
+    int alignment = rules->alignments[typeCategory];
+    if (alignment == 0) {
+      return objctk::invalidTypeLayout();
     }
-    return -1;
+    return objctk::makeTypeLayout(size, alignment);
   }
 
   virtual objctk_substring typeName() { return makeRange(0, 0); }
 
+  /** Returns the identifier of the interned type name or OBJCTK_NAMEID_NONE. */
+  virtual objctk_nameid typeNameID() { return OBJCTK_NAMEID_NONE; }
+
   virtual _objctk_typenode_ptr referencedType() { return nullptr; }
 
   virtual _objctk_typenode_list memberTypes() { return _objctk_typenode_list(); }
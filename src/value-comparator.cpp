@@ -0,0 +1,519 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "value-comparator.h"
+
+#include "internal-allocator.h"
+#include "layout.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace objctk;
+
+// The number of values compared with a single memcmp when values have no padding or floating point
+// members.
+static const size_t kComparisonBlockValueCount = 64;
+
+enum objctk_comparisonkind : unsigned char {
+  // Compares bytes.
+  OBJCTKComparisonKindBytes,
+
+  // Compares floats numerically, treating all NaNs as equal.
+  OBJCTKComparisonKindFloat,
+
+  // Compares doubles numerically, treating all NaNs as equal.
+  OBJCTKComparisonKindDouble,
+
+  // Compares the bits of a bitfield storage unit selected by a mask.
+  OBJCTKComparisonKindBitField,
+};
+
+/**
+ * An operation of an equality and hash kernel, repeated count times at a constant stride from the
+ * offset of its first occurrence. The whole run of repetitions is itself repeated outerCount times
+ * at the outer stride, which is how the elements of an array repeat operations that do not tile an
+ * element.
+ */
+typedef struct objctk_comparisonop {
+  objctk_comparisonkind kind;
+  // The number of bytes compared, which for bitfields is the number of bytes loaded from the start
+  // of their storage unit.
+  size_t length;
+  size_t offset;
+  size_t count;
+  size_t stride;
+  size_t outerCount;
+  size_t outerStride;
+  // The bits of the loaded bytes which belong to bitfields.
+  uint64_t mask;
+} objctk_comparisonop;
+
+struct _objctk_valuecomparator {
+  objctk_allocator allocator;
+  size_t valueSize;
+  // Whether values have no padding or floating point members and thus compare like their bytes.
+  bool comparesBytes;
+  size_t operationCount;
+  const objctk_comparisonop *operations;
+};
+
+typedef scratchstack<objctk_comparisonop> objctk_comparisonopstack;
+
+static inline objctk_comparisonop makeComparisonOperation(const objctk_comparisonkind kind, const size_t length, const size_t offset) {
+  objctk_comparisonop operation = {
+    .kind = kind,
+    .length = length,
+    .offset = offset,
+    .count = 1,
+    .stride = 0,
+    .outerCount = 1,
+    .outerStride = 0,
+    .mask = 0,
+  };
+  return operation;
+}
+
+// Appends an operation, merging it into the previous operation when it extends a run of bytes,
+// selects more bits of the same bitfield storage unit or continues a stride of operations of the
+// same shape.
+static bool appendOperation(objctk_comparisonopstack *operations, const objctk_comparisonop operation) {
+  if ((operations->size() > 0) && (operation.count == 1) && (operation.outerCount == 1) && (operations->back().outerCount == 1)) {
+    objctk_comparisonop *previous = operations->end() - 1;
+    if ((previous->kind == operation.kind) && (previous->count == 1)) {
+      if ((operation.kind == OBJCTKComparisonKindBytes) && (operation.offset == (previous->offset + previous->length))) {
+        previous->length += operation.length;
+        return true;
+      }
+      if ((operation.kind == OBJCTKComparisonKindBitField) && (operation.offset == previous->offset)) {
+        previous->length = std::max(previous->length, operation.length);
+        previous->mask |= operation.mask;
+        return true;
+      }
+    }
+    if ((previous->kind == operation.kind) && (previous->length == operation.length) && (previous->mask == operation.mask)) {
+      if ((previous->count == 1) && (operation.offset > previous->offset)) {
+        previous->stride = operation.offset - previous->offset;
+        previous->count = 2;
+        return true;
+      }
+      if ((previous->count > 1) && (operation.offset == (previous->offset + (previous->count * previous->stride)))) {
+        previous->count++;
+        return true;
+      }
+    }
+  }
+  return operations->push_back(operation);
+}
+
+static bool appendComparisonOperations(_objctk_typenode *node, const objctk_layoutrules *rules, const size_t offset, objctk_comparisonopstack *operations);
+
+static bool appendBitFieldOperation(bitfieldnode *bitFieldNode, const objctk_layoutrules *rules, const size_t bitOffset, objctk_comparisonopstack *operations) {
+  const size_t bitCount = bitFieldNode->bitCount();
+  if (bitCount == 0) {
+    return true;
+  }
+  // Bitfields are compared through a 64-bit word loaded from the start of their storage unit.
+  const size_t unitBits = rules->bitfieldUnitSize * CHAR_BIT;
+  const size_t unitOffset = (bitOffset / unitBits) * rules->bitfieldUnitSize;
+  const size_t unitBitOffset = bitOffset - (unitOffset * CHAR_BIT);
+  const size_t byteCount = (unitBitOffset + bitCount + CHAR_BIT - 1) / CHAR_BIT;
+  if (byteCount > sizeof(uint64_t)) {
+    return false;
+  }
+  objctk_comparisonop operation = makeComparisonOperation(OBJCTKComparisonKindBitField, byteCount, unitOffset);
+  operation.mask = ((bitCount < 64) ? ((UINT64_C(1) << bitCount) - 1) : UINT64_MAX) << unitBitOffset;
+  return appendOperation(operations, operation);
+}
+
+static bool appendArrayOperations(arraynode *arrayNode, const objctk_layoutrules *rules, const size_t offset, objctk_comparisonopstack *operations) {
+  _objctk_typenode *elementTypeNode = arrayNode->referencedType();
+  objctk_typelayout elementLayout = elementTypeNode->typeLayout(rules->profile);
+  if ((elementLayout.size < 0) || (arrayNode->typeLayout(rules->profile).size < 0)) {
+    return false;
+  }
+  const size_t elementCount = arrayNode->elementCount();
+  if ((elementCount == 0) || (elementLayout.size == 0)) {
+    return true;
+  }
+
+  objctk_comparisonopstack elementOperations(defaultAllocator());
+  if (!appendComparisonOperations(elementTypeNode, rules, 0, &elementOperations)) {
+    return false;
+  }
+
+  // Elements compared as a whole are compared as one run of bytes.
+  const objctk_comparisonop *firstOperation = elementOperations.begin();
+  if ((elementOperations.size() == 1) && (firstOperation->kind == OBJCTKComparisonKindBytes) && (firstOperation->count == 1) && (firstOperation->length == (size_t)elementLayout.size)) {
+    return appendOperation(operations, makeComparisonOperation(OBJCTKComparisonKindBytes, elementCount * elementLayout.size, offset));
+  }
+
+  // Each operation of an element whose repetitions tile the element repeats across the array at
+  // the element stride. Operations whose repetitions do not tile the element repeat at the element
+  // stride as their outer repetitions. Operations whose outer repetitions do not tile the element
+  // either, which only arise from arrays nested three deep, are replicated for every element.
+  const size_t elementStride = elementLayout.size;
+  for (const objctk_comparisonop *elementOperation = elementOperations.begin(); elementOperation != elementOperations.end(); elementOperation++) {
+    objctk_comparisonop operation = *elementOperation;
+    operation.offset += offset;
+    const bool tilesElement = (operation.count == 1) || ((operation.count * operation.stride) == elementStride);
+    if ((operation.outerCount == 1) && tilesElement) {
+      if (operation.count == 1) {
+        operation.stride = elementStride;
+      }
+      operation.count *= elementCount;
+      if (!appendOperation(operations, operation)) {
+        return false;
+      }
+      continue;
+    }
+    if ((operation.outerCount == 1) || ((operation.outerCount * operation.outerStride) == elementStride)) {
+      if (operation.outerCount == 1) {
+        operation.outerStride = elementStride;
+      }
+      operation.outerCount *= elementCount;
+      if (!appendOperation(operations, operation)) {
+        return false;
+      }
+      continue;
+    }
+    for (size_t elementIndex = 0; elementIndex < elementCount; elementIndex++) {
+      if (!appendOperation(operations, operation)) {
+        return false;
+      }
+      operation.offset += elementStride;
+    }
+  }
+  return true;
+}
+
+static bool appendComparisonOperations(_objctk_typenode *node, const objctk_layoutrules *rules, const size_t offset, objctk_comparisonopstack *operations) {
+  const objctk_typecategory typeCategory = node->typeCategory();
+  switch (typeCategory) {
+    case OBJCTKTypeCategoryStruct:
+    case OBJCTKTypeCategoryTopLevel: {
+      bool succeeded = true;
+      objctk_typelayout layout = static_cast<compositetypenode *>(node)->layoutMembers(rules, [&](_objctk_typenode *memberTypeNode, int memberOffset, int bitOffset) {
+        if (!succeeded) {
+          return;
+        }
+        if (memberTypeNode->typeCategory() == OBJCTKTypeCategoryBitField) {
+          succeeded = appendBitFieldOperation(static_cast<bitfieldnode *>(memberTypeNode), rules, ((offset + memberOffset) * CHAR_BIT) + bitOffset, operations);
+        } else {
+          succeeded = appendComparisonOperations(memberTypeNode, rules, offset + memberOffset, operations);
+        }
+      });
+      return succeeded && (layout.size >= 0);
+    }
+    case OBJCTKTypeCategoryArray:
+      return appendArrayOperations(static_cast<arraynode *>(node), rules, offset, operations);
+    case OBJCTKTypeCategoryBitField:
+      // Bitfields are only laid out as members of composite types.
+      return false;
+    default:
+      break;
+  }
+
+  // Unions, whose active member cannot be determined, and scalars other than floating point
+  // values are compared byte by byte.
+  objctk_typelayout layout = node->typeLayout(rules->profile);
+  if (layout.size < 0) {
+    return false;
+  }
+  if (layout.size == 0) {
+    return true;
+  }
+  if ((typeCategory == OBJCTKTypeCategoryFloat) && (layout.size == sizeof(float))) {
+    return appendOperation(operations, makeComparisonOperation(OBJCTKComparisonKindFloat, layout.size, offset));
+  }
+  if ((typeCategory == OBJCTKTypeCategoryDouble) && (layout.size == sizeof(double))) {
+    return appendOperation(operations, makeComparisonOperation(OBJCTKComparisonKindDouble, layout.size, offset));
+  }
+  return appendOperation(operations, makeComparisonOperation(OBJCTKComparisonKindBytes, layout.size, offset));
+}
+
+static inline uint64_t loadWord(const char *address, const size_t size) {
+  uint64_t value = 0;
+  if (size == sizeof(uint64_t)) {
+    memcpy(&value, address, sizeof(uint64_t));
+  } else if (size == sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word, address, sizeof(word));
+    value = word;
+  } else {
+    memcpy(&value, address, size);
+  }
+  return value;
+}
+
+static inline bool equalBytes(const char *bytes, const char *otherBytes, const size_t length) {
+  switch (length) {
+    case 1:
+      return *bytes == *otherBytes;
+    case 2:
+    case 4:
+    case 8:
+      return loadWord(bytes, length) == loadWord(otherBytes, length);
+    default:
+      return memcmp(bytes, otherBytes, length) == 0;
+  }
+}
+
+template <typename FloatingPointType>
+static inline bool equalFloatingPointValues(const char *address, const char *otherAddress) {
+  FloatingPointType value;
+  FloatingPointType otherValue;
+  memcpy(&value, address, sizeof(value));
+  memcpy(&otherValue, otherAddress, sizeof(otherValue));
+  return (value == otherValue) || ((value != value) && (otherValue != otherValue));
+}
+
+// Returns the bits of a floating point value with all zeros and all NaNs mapped to a single
+// representation.
+template <typename FloatingPointType, typename BitsType>
+static inline uint64_t normalizedFloatingPointBits(const char *address) {
+  FloatingPointType value;
+  memcpy(&value, address, sizeof(value));
+  if (value == 0) {
+    return 0;
+  }
+  if (value != value) {
+    return UINT64_MAX;
+  }
+  BitsType bits;
+  memcpy(&bits, address, sizeof(bits));
+  return bits;
+}
+
+static bool applyInnerEqualityOperation(const objctk_comparisonop *operation, const char *value, const char *otherValue) {
+  const char *address = value + operation->offset;
+  const char *otherAddress = otherValue + operation->offset;
+  for (size_t index = 0; index < operation->count; index++, address += operation->stride, otherAddress += operation->stride) {
+    bool isEqual;
+    switch (operation->kind) {
+      case OBJCTKComparisonKindBytes:
+        isEqual = equalBytes(address, otherAddress, operation->length);
+        break;
+      case OBJCTKComparisonKindFloat:
+        isEqual = equalFloatingPointValues<float>(address, otherAddress);
+        break;
+      case OBJCTKComparisonKindDouble:
+        isEqual = equalFloatingPointValues<double>(address, otherAddress);
+        break;
+      case OBJCTKComparisonKindBitField:
+        isEqual = ((loadWord(address, operation->length) ^ loadWord(otherAddress, operation->length)) & operation->mask) == 0;
+        break;
+    }
+    if (!isEqual) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Applies each outer repetition of an operation in turn.
+static bool applyEqualityOperation(const objctk_comparisonop *operation, const char *value, const char *otherValue) {
+  for (size_t outerIndex = 0; outerIndex < operation->outerCount; outerIndex++) {
+    const size_t outerOffset = outerIndex * operation->outerStride;
+    if (!applyInnerEqualityOperation(operation, value + outerOffset, otherValue + outerOffset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline uint64_t mixedHash(const uint64_t hash, const uint64_t word) {
+  uint64_t mixedHash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+  return mixedHash ^ (mixedHash >> 31);
+}
+
+static uint64_t hashBytes(uint64_t hash, const char *bytes, const size_t length) {
+  size_t offset = 0;
+  for (; (offset + sizeof(uint64_t)) <= length; offset += sizeof(uint64_t)) {
+    hash = mixedHash(hash, loadWord(bytes + offset, sizeof(uint64_t)));
+  }
+  if (offset < length) {
+    hash = mixedHash(hash, loadWord(bytes + offset, length - offset));
+  }
+  return hash;
+}
+
+static uint64_t applyInnerHashOperation(const objctk_comparisonop *operation, const char *value, uint64_t hash) {
+  const char *address = value + operation->offset;
+  for (size_t index = 0; index < operation->count; index++, address += operation->stride) {
+    switch (operation->kind) {
+      case OBJCTKComparisonKindBytes:
+        hash = hashBytes(hash, address, operation->length);
+        break;
+      case OBJCTKComparisonKindFloat:
+        hash = mixedHash(hash, normalizedFloatingPointBits<float, uint32_t>(address));
+        break;
+      case OBJCTKComparisonKindDouble:
+        hash = mixedHash(hash, normalizedFloatingPointBits<double, uint64_t>(address));
+        break;
+      case OBJCTKComparisonKindBitField:
+        hash = mixedHash(hash, loadWord(address, operation->length) & operation->mask);
+        break;
+    }
+  }
+  return hash;
+}
+
+// Applies each outer repetition of an operation in turn.
+static uint64_t applyHashOperation(const objctk_comparisonop *operation, const char *value, uint64_t hash) {
+  for (size_t outerIndex = 0; outerIndex < operation->outerCount; outerIndex++) {
+    hash = applyInnerHashOperation(operation, value + (outerIndex * operation->outerStride), hash);
+  }
+  return hash;
+}
+
+static bool equalValues(const objctk_valuecomparator comparator, const char *value, const char *otherValue) {
+  for (size_t operationIndex = 0; operationIndex < comparator->operationCount; operationIndex++) {
+    if (!applyEqualityOperation(&comparator->operations[operationIndex], value, otherValue)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint64_t hashValue(const objctk_valuecomparator comparator, const char *value) {
+  uint64_t hash = 0x9E3779B97F4A7C15ULL;
+  for (size_t operationIndex = 0; operationIndex < comparator->operationCount; operationIndex++) {
+    hash = applyHashOperation(&comparator->operations[operationIndex], value, hash);
+  }
+  hash *= 0x94D049BB133111EBULL;
+  return hash ^ (hash >> 29);
+}
+
+objctk_valuecomparator objctk_valuecomparator_create(objctk_typenode node, objctk_layoutprofile profile) {
+  const objctk_layoutrules *rules = layoutRulesForProfile(profile);
+  if ((node == NULL) || (rules == NULL)) {
+    return NULL;
+  }
+  objctk_typelayout layout = node->typeLayout(profile);
+  if (layout.size < 0) {
+    return NULL;
+  }
+
+  const objctk_allocator *allocator = defaultAllocator();
+  objctk_comparisonopstack operations(allocator);
+  if (!appendComparisonOperations(node, rules, 0, &operations)) {
+    return NULL;
+  }
+
+  // The comparator and its operations share a single allocation.
+  const size_t operationsOffset = sizeof(_objctk_valuecomparator);
+  char *memory = static_cast<char *>(allocateMemory(allocator, operationsOffset + (operations.size() * sizeof(objctk_comparisonop))));
+  if (memory == NULL) {
+    return NULL;
+  }
+  objctk_comparisonop *comparisonOperations = reinterpret_cast<objctk_comparisonop *>(memory + operationsOffset);
+  std::copy(operations.begin(), operations.end(), comparisonOperations);
+
+  objctk_valuecomparator comparator = new (memory) _objctk_valuecomparator();
+  comparator->allocator = *allocator;
+  comparator->valueSize = layout.size;
+  comparator->comparesBytes = (operations.size() == 0) || ((operations.size() == 1) && (comparisonOperations->kind == OBJCTKComparisonKindBytes) && (comparisonOperations->count == 1) && (comparisonOperations->outerCount == 1) && (comparisonOperations->length == comparator->valueSize));
+  comparator->operationCount = operations.size();
+  comparator->operations = comparisonOperations;
+  return comparator;
+}
+
+size_t objctk_valuecomparator_getValueSize(objctk_valuecomparator comparator) {
+  return (comparator != NULL) ? comparator->valueSize : 0;
+}
+
+size_t objctk_valuecomparator_getOperationCount(objctk_valuecomparator comparator) {
+  return (comparator != NULL) ? comparator->operationCount : 0;
+}
+
+bool objctk_valuecomparator_equalValues(objctk_valuecomparator comparator, const void *value, const void *otherValue) {
+  if ((comparator == NULL) || (value == NULL) || (otherValue == NULL)) {
+    return false;
+  }
+  return equalValues(comparator, static_cast<const char *>(value), static_cast<const char *>(otherValue));
+}
+
+size_t objctk_valuecomparator_findFirstDifference(
+    objctk_valuecomparator comparator,
+    const void *values,
+    const void *otherValues,
+    size_t valueCount) {
+  if ((comparator == NULL) || (values == NULL) || (otherValues == NULL)) {
+    return 0;
+  }
+  const char *value = static_cast<const char *>(values);
+  const char *otherValue = static_cast<const char *>(otherValues);
+  size_t valueIndex = 0;
+  if (comparator->comparesBytes) {
+    // Skip blocks of equal values with a single memcmp.
+    const size_t blockSize = kComparisonBlockValueCount * comparator->valueSize;
+    for (; ((valueIndex + kComparisonBlockValueCount) <= valueCount) && (memcmp(value, otherValue, blockSize) == 0); valueIndex += kComparisonBlockValueCount) {
+      value += blockSize;
+      otherValue += blockSize;
+    }
+  }
+  for (; valueIndex < valueCount; valueIndex++) {
+    if (!equalValues(comparator, value, otherValue)) {
+      return valueIndex;
+    }
+    value += comparator->valueSize;
+    otherValue += comparator->valueSize;
+  }
+  return valueCount;
+}
+
+uint64_t objctk_valuecomparator_hashValue(objctk_valuecomparator comparator, const void *value) {
+  if ((comparator == NULL) || (value == NULL)) {
+    return 0;
+  }
+  return hashValue(comparator, static_cast<const char *>(value));
+}
+
+void objctk_valuecomparator_hashValues(
+    objctk_valuecomparator comparator,
+    const void *values,
+    size_t valueCount,
+    uint64_t *outHashes) {
+  if ((comparator == NULL) || (values == NULL) || (outHashes == NULL)) {
+    return;
+  }
+  const char *value = static_cast<const char *>(values);
+  for (size_t valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+    outHashes[valueIndex] = hashValue(comparator, value);
+    value += comparator->valueSize;
+  }
+}
+
+void objctk_valuecomparator_release(objctk_valuecomparator comparator) {
+  if (comparator == NULL) {
+    return;
+  }
+  objctk_allocator allocator = comparator->allocator;
+  deallocateMemory(&allocator, comparator);
+}
@@ -0,0 +1,222 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Counts the allocations and deallocations made through it, forwarding them to malloc.
+struct countingallocator {
+  std::atomic<long> allocationCount;
+  std::atomic<long> liveAllocationCount;
+};
+
+static void *countingAllocate(void *context, size_t size) {
+  countingallocator *counter = static_cast<countingallocator *>(context);
+  counter->allocationCount++;
+  counter->liveAllocationCount++;
+  return malloc(size);
+}
+
+static void *countingReallocate(void *context, void *pointer, size_t size) {
+  countingallocator *counter = static_cast<countingallocator *>(context);
+  if (pointer == NULL) {
+    counter->allocationCount++;
+    counter->liveAllocationCount++;
+  }
+  return realloc(pointer, size);
+}
+
+static void countingDeallocate(void *context, void *pointer) {
+  static_cast<countingallocator *>(context)->liveAllocationCount--;
+  free(pointer);
+}
+
+static objctk_allocator makeCountingAllocator(countingallocator *counter) {
+  counter->allocationCount = 0;
+  counter->liveAllocationCount = 0;
+  objctk_allocator allocator = { counter, countingAllocate, countingReallocate, countingDeallocate };
+  return allocator;
+}
+
+static const char *const kTypeEncodings[] = {
+  "{CGRect={CGPoint=dd}{CGSize=dd}}",
+  "v32@0:8@\"NSString\"16^{__CFError}24",
+  "(U=i[4c]^{node=^{node}i})",
+  "[16{pair=qb3b5}]",
+};
+
+static void testParseResultsUseTheirAllocator() {
+  countingallocator counter;
+  objctk_allocator allocator = makeCountingAllocator(&counter);
+  for (const char *typeEncoding : kTypeEncodings) {
+    objctk_typeparseresult parseResult = objctk_parseTypeEncodingWithAllocator(typeEncoding, &allocator);
+    EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+    objctk_typeparseresult_release(parseResult);
+  }
+  EXPECT(counter.allocationCount > 0);
+  EXPECT_EQ(0, counter.liveAllocationCount);
+}
+
+static void testParsersUseTheirAllocator() {
+  countingallocator counter;
+  objctk_allocator allocator = makeCountingAllocator(&counter);
+  objctk_parser parser = objctk_parser_createWithAllocator(&allocator);
+  for (int iteration = 0; iteration < 4; iteration++) {
+    for (const char *typeEncoding : kTypeEncodings) {
+      EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(objctk_parser_parseTypeEncoding(parser, typeEncoding)));
+    }
+  }
+
+  // A warmed up parser does not allocate again.
+  const long allocationCount = counter.allocationCount;
+  for (const char *typeEncoding : kTypeEncodings) {
+    objctk_parser_parseTypeEncoding(parser, typeEncoding);
+  }
+  EXPECT_EQ(allocationCount, counter.allocationCount);
+
+  objctk_parser_release(parser);
+  EXPECT_EQ(0, counter.liveAllocationCount);
+}
+
+static void testDefaultAllocator() {
+  countingallocator counter;
+  objctk_allocator allocator = makeCountingAllocator(&counter);
+  objctk_setDefaultAllocator(&allocator);
+  EXPECT(objctk_getDefaultAllocator().context == &counter);
+
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(kTypeEncodings[0]);
+  unsigned int memberCount = 0;
+  objctk_typenode *memberTypes = objctk_typenode_copyMemberTypeList(objctk_typeparseresult_getParsedType(parseResult), &memberCount);
+  EXPECT_EQ(2, memberCount);
+  objctk_free(memberTypes);
+  objctk_typeparseresult_release(parseResult);
+  EXPECT(counter.allocationCount > 0);
+  EXPECT_EQ(0, counter.liveAllocationCount);
+
+  objctk_setDefaultAllocator(NULL);
+  EXPECT(objctk_getDefaultAllocator().context == NULL);
+}
+
+// Copies member lists, which are allocated with the default allocator, while another thread replaces
+// the default allocator. Both allocators forward to malloc so memory may be freed with either one,
+// which leaves the test meaningful only under ThreadSanitizer.
+static void testDefaultAllocatorChangesWhileCopying() {
+  countingallocator counters[2];
+  objctk_allocator allocators[2] = { makeCountingAllocator(&counters[0]), makeCountingAllocator(&counters[1]) };
+  std::atomic<bool> isCopying(true);
+  std::vector<std::thread> threads;
+  for (int threadIndex = 0; threadIndex < 4; threadIndex++) {
+    threads.emplace_back([&isCopying] {
+      countingallocator counter;
+      objctk_allocator allocator = makeCountingAllocator(&counter);
+      objctk_typeparseresult parseResult = objctk_parseTypeEncodingWithAllocator(kTypeEncodings[1], &allocator);
+      objctk_typenode node = objctk_typeparseresult_getParsedType(parseResult);
+      while (isCopying) {
+        unsigned int memberCount = 0;
+        objctk_free(objctk_typenode_copyMemberTypeList(node, &memberCount));
+      }
+      objctk_typeparseresult_release(parseResult);
+    });
+  }
+  for (int iteration = 0; iteration < 1000; iteration++) {
+    objctk_setDefaultAllocator(&allocators[iteration % 2]);
+  }
+  objctk_setDefaultAllocator(NULL);
+  isCopying = false;
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+static void testCopiesUseTheirAllocator() {
+  countingallocator counter;
+  objctk_allocator allocator = makeCountingAllocator(&counter);
+  objctk_parselimits limits = {};
+  limits.maximumNodeCount = 2;
+  objctk_typeparseresult parseResult = objctk_parseTypeEncodingWithLimits(kTypeEncodings[0], &limits, &allocator);
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, objctk_typeparseresult_getStatusCode(parseResult));
+
+  // The error description is copied with the allocator of its parse result.
+  long allocationCount = counter.allocationCount;
+  char *errorDescription = objctk_typeparseresult_copyErrorDescription(parseResult);
+  EXPECT(errorDescription != NULL);
+  EXPECT_EQ(allocationCount + 1, counter.allocationCount);
+  allocator.deallocate(allocator.context, errorDescription);
+  objctk_typeparseresult_release(parseResult);
+  EXPECT_EQ(0, counter.liveAllocationCount);
+
+  parseResult = objctk_parseTypeEncodingWithAllocator(kTypeEncodings[0], &allocator);
+  allocationCount = counter.allocationCount;
+  unsigned int memberCount = 0;
+  objctk_typenode *memberTypes = objctk_typenode_copyMemberTypeListWithAllocator(objctk_typeparseresult_getParsedType(parseResult), &allocator, &memberCount);
+  EXPECT_EQ(2, memberCount);
+  EXPECT_EQ(allocationCount + 1, counter.allocationCount);
+  allocator.deallocate(allocator.context, memberTypes);
+  objctk_typeparseresult_release(parseResult);
+  EXPECT_EQ(0, counter.liveAllocationCount);
+}
+
+// Prewarmed parse results are allocated from the default allocator, so they are not returned to
+// callers which parse with an allocator of their own.
+static void testPrewarmedParseResultsNeedTheDefaultAllocator() {
+  EXPECT_EQ(1, objctk_prewarmTypeEncodings(kTypeEncodings, 1));
+  objctk_typeparseresult prewarmedResult = objctk_getPrewarmedParseResult(kTypeEncodings[0]);
+  EXPECT(prewarmedResult != NULL);
+  EXPECT(objctk_parseTypeEncoding(kTypeEncodings[0]) == prewarmedResult);
+  objctk_parser parser = objctk_parser_create();
+  EXPECT(objctk_parser_parseTypeEncoding(parser, kTypeEncodings[0]) == prewarmedResult);
+  objctk_parser_release(parser);
+
+  countingallocator counter;
+  objctk_allocator allocator = makeCountingAllocator(&counter);
+  objctk_typeparseresult parseResult = objctk_parseTypeEncodingWithAllocator(kTypeEncodings[0], &allocator);
+  EXPECT(parseResult != prewarmedResult);
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+  EXPECT(counter.liveAllocationCount > 0);
+  objctk_typeparseresult_release(parseResult);
+
+  parser = objctk_parser_createWithAllocator(&allocator);
+  parseResult = objctk_parser_parseTypeEncoding(parser, kTypeEncodings[0]);
+  EXPECT(parseResult != prewarmedResult);
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+  objctk_parser_release(parser);
+  EXPECT_EQ(0, counter.liveAllocationCount);
+}
+
+int main() {
+  testParseResultsUseTheirAllocator();
+  testParsersUseTheirAllocator();
+  testDefaultAllocator();
+  testDefaultAllocatorChangesWhileCopying();
+  testCopiesUseTheirAllocator();
+  // Prewarming lasts for the life of the process, so it is tested last.
+  testPrewarmedParseResultsNeedTheDefaultAllocator();
+  return testResult();
+}
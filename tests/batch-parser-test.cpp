@@ -0,0 +1,171 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include "test.h"
+
+#include <string>
+#include <vector>
+
+using namespace objctk;
+
+// Parses a batch and checks each parse result against a serial parse of its type encoding,
+// returning the number of parse results which differ.
+static int batchMismatchCount(const std::vector<std::string> &typeEncodings) {
+  std::vector<const char *> typeEncodingPointers;
+  for (const std::string &typeEncoding : typeEncodings) {
+    typeEncodingPointers.push_back(typeEncoding.c_str());
+  }
+  std::vector<objctk_typeparseresult> parseResults(typeEncodings.size());
+  if (objctk_parseTypeEncodingBatch(typeEncodingPointers.data(), typeEncodingPointers.size(), parseResults.data(), NULL) != objctk_statuscode_NoError) {
+    return (int)typeEncodings.size();
+  }
+
+  int mismatchCount = 0;
+  for (size_t index = 0; index < typeEncodings.size(); index++) {
+    objctk_typeparseresult serialResult = objctk_parseTypeEncoding(typeEncodings[index].c_str());
+    objctk_typenode serialType = objctk_typeparseresult_getParsedType(serialResult);
+    objctk_typenode batchType = objctk_typeparseresult_getParsedType(parseResults[index]);
+    const bool isEqual = (objctk_typeparseresult_getStatusCode(serialResult) == objctk_typeparseresult_getStatusCode(parseResults[index])) &&
+        (objctk_typeparseresult_getUnexpectedTokenCount(serialResult) == objctk_typeparseresult_getUnexpectedTokenCount(parseResults[index])) &&
+        ((serialType == NULL) ? (batchType == NULL) : ((batchType != NULL) && areStructurallyEqualTypeNodes(serialType, batchType)));
+    if (!isEqual) {
+      fprintf(stderr, "batch parse differs from serial parse: %s\n", typeEncodings[index].c_str());
+      mismatchCount++;
+    }
+    objctk_typeparseresult_release(serialResult);
+  }
+  for (objctk_typeparseresult parseResult : parseResults) {
+    objctk_typeparseresult_release(parseResult);
+  }
+  return mismatchCount;
+}
+
+static void testBatchParsesMatchSerialParses() {
+  // Method type encodings of a class hierarchy share long prefixes in every order.
+  std::vector<std::string> typeEncodings;
+  const char *returnTypes[] = { "v", "@", "{CGRect={CGPoint=dd}{CGSize=dd}}", "^{Node=^{Node}i}", "B" };
+  const char *argumentTypes[] = { "", "@", "q", "{CGPoint=dd}", "@?", "[4c]", "b3", "b32", "^v" };
+  for (const char *returnType : returnTypes) {
+    for (const char *firstArgumentType : argumentTypes) {
+      for (const char *secondArgumentType : argumentTypes) {
+        typeEncodings.push_back(std::string(returnType) + "16@0:8" + firstArgumentType + secondArgumentType);
+      }
+    }
+  }
+  EXPECT_EQ(0, batchMismatchCount(typeEncodings));
+  std::vector<std::string> reversedTypeEncodings(typeEncodings.rbegin(), typeEncodings.rend());
+  EXPECT_EQ(0, batchMismatchCount(reversedTypeEncodings));
+
+  // Malformed and failing encodings are reported as a serial parse reports them.
+  EXPECT_EQ(0, batchMismatchCount({ "", "i", "[1i{AAA", "[1i{AAB", std::string(1000, '^') + "i", std::string(1000, '^') + "c" }));
+}
+
+static void testTokensContinuingPastThePrefix() {
+  // The bitfield 'b1' is a prefix of the bitfield 'b12', and the element count '[1' of '[12'.
+  EXPECT_EQ(0, batchMismatchCount({ "b1i", "b12i", "b1", "b12" }));
+  EXPECT_EQ(0, batchMismatchCount({ "i[1c]", "i[12c]", "i[1c]q", "i[12c]q" }));
+  EXPECT_EQ(0, batchMismatchCount({ "{S=i}", "{S=i}{T=q}", "{SS=i}", "@\"NSString\"i", "@\"NSStringX\"i" }));
+
+  const char *typeEncodings[] = { "ib1", "ib12" };
+  objctk_typeparseresult parseResults[2];
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_parseTypeEncodingBatch(typeEncodings, 2, parseResults, NULL));
+  unsigned int memberCount = 0;
+  objctk_typenode *memberTypes = objctk_typenode_copyMemberTypeList(objctk_typeparseresult_getParsedType(parseResults[1]), &memberCount);
+  EXPECT_EQ(2, memberCount);
+  if (memberCount == 2) {
+    EXPECT_EQ(12, static_cast<bitfieldnode *>(memberTypes[1])->bitCount());
+  }
+  objctk_free(memberTypes);
+  objctk_typeparseresult_release(parseResults[0]);
+  objctk_typeparseresult_release(parseResults[1]);
+}
+
+static void testDuplicateEncodingsShareTypes() {
+  const char *typeEncodings[] = { "v16@0:8", "{CGPoint=dd}", "v16@0:8", "v16@0:8" };
+  objctk_typeparseresult parseResults[4];
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_parseTypeEncodingBatch(typeEncodings, 4, parseResults, NULL));
+  objctk_typenode sharedType = objctk_typeparseresult_getParsedType(parseResults[0]);
+  EXPECT(sharedType != NULL);
+  EXPECT(objctk_typeparseresult_getParsedType(parseResults[2]) == sharedType);
+  EXPECT(objctk_typeparseresult_getParsedType(parseResults[3]) == sharedType);
+
+  // The shared type outlives whichever parse results are released first.
+  objctk_typeparseresult_release(parseResults[0]);
+  objctk_typeparseresult_release(parseResults[3]);
+  unsigned int memberCount = 0;
+  objctk_typenode *memberTypes = objctk_typenode_copyMemberTypeList(objctk_typeparseresult_getParsedType(parseResults[2]), &memberCount);
+  EXPECT_EQ(3, memberCount);
+  if (memberCount == 3) {
+    EXPECT_EQ(OBJCTKTypeCategorySelector, objctk_typenode_getTypeCategory(memberTypes[2]));
+  }
+  objctk_free(memberTypes);
+  objctk_typeparseresult_release(parseResults[2]);
+  objctk_typeparseresult_release(parseResults[1]);
+}
+
+static void testPrefixChainsKeepSharedTypesAlive() {
+  // Each encoding extends the previous one, so the parse results form a chain of shared prefixes.
+  std::vector<std::string> typeEncodings;
+  std::string typeEncoding = "v16@0:8";
+  for (int index = 0; index < 200; index++) {
+    typeEncoding += "{S" + std::to_string(index) + "=iq}";
+    typeEncodings.push_back(typeEncoding);
+  }
+  std::vector<const char *> typeEncodingPointers;
+  for (const std::string &chainedTypeEncoding : typeEncodings) {
+    typeEncodingPointers.push_back(chainedTypeEncoding.c_str());
+  }
+  std::vector<objctk_typeparseresult> parseResults(typeEncodings.size());
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_parseTypeEncodingBatch(typeEncodingPointers.data(), typeEncodingPointers.size(), parseResults.data(), NULL));
+
+  // Releasing every parse result but the last leaves the whole chain reachable from it.
+  objctk_typeparseresult serialResult = objctk_parseTypeEncoding(typeEncodings.back().c_str());
+  for (size_t index = 0; (index + 1) < parseResults.size(); index++) {
+    objctk_typeparseresult_release(parseResults[index]);
+  }
+  EXPECT(areStructurallyEqualTypeNodes(objctk_typeparseresult_getParsedType(serialResult), objctk_typeparseresult_getParsedType(parseResults.back())));
+  objctk_typeparseresult_release(parseResults.back());
+  objctk_typeparseresult_release(serialResult);
+}
+
+static void testInvalidBatches() {
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_parseTypeEncodingBatch(NULL, 0, NULL, NULL));
+  const char *typeEncodings[] = { "i", NULL };
+  objctk_typeparseresult parseResults[2];
+  EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_parseTypeEncodingBatch(typeEncodings, 2, parseResults, NULL));
+  EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_parseTypeEncodingBatch(typeEncodings, 1, NULL, NULL));
+}
+
+int main() {
+  testBatchParsesMatchSerialParses();
+  testTokensContinuingPastThePrefix();
+  testDuplicateEncodingsShareTypes();
+  testPrefixChainsKeepSharedTypesAlive();
+  testInvalidBatches();
+  return testResult();
+}
@@ -0,0 +1,99 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <string>
+
+static std::string definitions(const char *typeEncoding) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(typeEncoding);
+  objctk_declarationemitter emitter = objctk_declarationemitter_create(NULL);
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_declarationemitter_addType(emitter, objctk_typeparseresult_getParsedType(parseResult)));
+  char buffer[1024];
+  size_t length = 0;
+  objctk_declarationemitter_copyDefinitions(emitter, buffer, sizeof(buffer), &length);
+  objctk_declarationemitter_release(emitter);
+  objctk_typeparseresult_release(parseResult);
+  return std::string(buffer);
+}
+
+static std::string declaration(const char *typeEncoding, const char *name) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(typeEncoding);
+  char buffer[1024];
+  size_t length = 0;
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_declarationemitter_copyDeclaration(NULL, objctk_typeparseresult_getParsedType(parseResult), name, buffer, sizeof(buffer), &length));
+  objctk_typeparseresult_release(parseResult);
+  return std::string(buffer);
+}
+
+static void expectText(const std::string &expected, const std::string &actual) {
+  EXPECT(expected == actual);
+  if (expected != actual) {
+    fprintf(stderr, "expected:\n%s\nactual:\n%s\n", expected.c_str(), actual.c_str());
+  }
+}
+
+static void testDeclarations() {
+  expectText("struct CGRect **x", declaration("^^{CGRect}", "x"));
+  expectText("struct CGRect frame", declaration("{CGRect={CGPoint=dd}{CGSize=dd}}", "frame"));
+  expectText("int (*)[4]", declaration("^[4i]", NULL));
+  expectText("union Value *value", declaration("^(Value)", "value"));
+}
+
+static void testSelfReferentialDefinitions() {
+  expectText("struct node {\n    struct node *field0;\n    int field1;\n};\n\n", definitions("{node=^{node}i}"));
+  expectText("struct B {\n    struct A *field0;\n};\n\nstruct A {\n    struct B field0;\n};\n\n", definitions("{A={B=^{A}}}"));
+}
+
+static void testReservedWordTags() {
+  expectText("struct int_ value", declaration("{int=i}", "value"));
+  expectText("union char_ *value", declaration("^(char)", "value"));
+  expectText("struct _Bool_ value", declaration("{_Bool=B}", "value"));
+  // Tags which merely begin or end with a keyword are left alone.
+  expectText("struct integer value", declaration("{integer=i}", "value"));
+  expectText("struct in value", declaration("{in=i}", "value"));
+  expectText("struct int_ {\n    int field0;\n};\n\nstruct while_ {\n    struct int_ field0;\n    struct int_ *field1;\n};\n\n", definitions("{while={int=i}^{int}}"));
+  expectText("struct int_ {\n    int field0;\n};\n\nstruct int__2 {\n    double field0;\n};\n\n", definitions("{?={int=i}{int=d}}"));
+}
+
+static void testObjects() {
+  // Objects are ids whatever their class, so the declarations compile without declaring classes.
+  expectText("id string", declaration("@\"NSString\"", "string"));
+  expectText("id *strings", declaration("^@\"NSString\"", "strings"));
+  expectText("id strings[4]", declaration("[4@\"NSString\"]", "strings"));
+  expectText("id value", declaration("@", "value"));
+  expectText("id<NSCopying> value", declaration("@\"<NSCopying>\"", "value"));
+  expectText("id<NSCopying><NSCoding> value", declaration("@\"NSObject<NSCopying><NSCoding>\"", "value"));
+  expectText("struct Holder {\n    id field0;\n    Class field1;\n};\n\n", definitions("{Holder=@\"NSString\"#}"));
+}
+
+int main() {
+  testDeclarations();
+  testSelfReferentialDefinitions();
+  testReservedWordTags();
+  testObjects();
+  return testResult();
+}
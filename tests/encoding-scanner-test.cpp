@@ -0,0 +1,148 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Expects the scanner to agree with the layout of the parsed type tree.
+static void expectScannedLayoutMatchesTree(const char *typeEncoding, objctk_layoutprofile profile) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(typeEncoding);
+  objctk_typenode node = objctk_typeparseresult_getParsedType(parseResult);
+  int size = 0;
+  int alignment = 0;
+  size_t endOffset = 0;
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_getSizeAndAlignment(typeEncoding, SIZE_MAX, profile, &size, &alignment, &endOffset));
+  EXPECT_EQ(objctk_typenode_getTypeSizeForLayoutProfile(node, profile), size);
+  EXPECT_EQ(objctk_typenode_getTypeAlignmentForLayoutProfile(node, profile), alignment);
+  EXPECT_EQ(strlen(typeEncoding), endOffset);
+  if (objctk_typenode_getTypeSizeForLayoutProfile(node, profile) != size) {
+    fprintf(stderr, "  for %s\n", typeEncoding);
+  }
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testScannerMatchesTree() {
+  const char *typeEncodings[] = {
+    "{CGRect={CGPoint=dd}{CGSize=dd}}",
+    "^^{__CFError}",
+    "^{CGPoint}",
+    "{CGPoint}",
+    "(Opaque)",
+    "{s=^{t}i^(u)c}",
+    "[4{s=cb3b6}]",
+    "(u=iq[3c])",
+    "{s=@\"NSString\"c}",
+    "[536870911i]",
+    "[536870912i]",
+    "[99999999999999999999999i]",
+    "b99999999999",
+    "{s=[536870911i][536870911i]}",
+    "{s=[268435455q]b64}",
+    "{S=\"x\"d\"y\"i}",
+    "{CGRect=\"origin\"{CGPoint=\"x\"d\"y\"d}\"size\"{CGSize=\"width\"d\"height\"d}}",
+    "{s=\"object\"@\"NSString\"\"flags\"b3\"count\"Q}",
+    "@?",
+  };
+  for (const char *typeEncoding : typeEncodings) {
+    expectScannedLayoutMatchesTree(typeEncoding, objctk_layoutprofile_LP64);
+    expectScannedLayoutMatchesTree(typeEncoding, objctk_layoutprofile_ILP32);
+  }
+}
+
+static void testSkippingWithGenerousLength() {
+  // The encoding fills an exactly sized allocation so that reads past its terminator are caught by
+  // address sanitizers.
+  std::string encoding = "{Large=";
+  for (int index = 0; index < 100; index++) {
+    encoding += "iqdcsl";
+  }
+  encoding += "}";
+  for (size_t trailingLength = 0; trailingLength < 40; trailingLength++) {
+    const std::string prefix = encoding + std::string(trailingLength, 'i');
+    char *typeEncoding = static_cast<char *>(malloc(prefix.size() + 1));
+    memcpy(typeEncoding, prefix.c_str(), prefix.size() + 1);
+    size_t endOffset = 0;
+    EXPECT_EQ(objctk_statuscode_NoError, objctk_skipType(typeEncoding, SIZE_MAX, &endOffset));
+    EXPECT_EQ(encoding.size(), endOffset);
+    typeEncoding[prefix.size() - trailingLength - 1] = '\0';
+    EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_skipType(typeEncoding, SIZE_MAX, &endOffset));
+    free(typeEncoding);
+  }
+}
+
+static void expectSplitTypes(const char *typeEncoding, const std::vector<std::string> &expectedTypes) {
+  objctk_typesplitter splitter;
+  objctk_typesplitter_init(&splitter, typeEncoding, SIZE_MAX);
+  std::vector<std::string> types;
+  objctk_range range;
+  while (objctk_typesplitter_next(&splitter, &range)) {
+    types.push_back(std::string(typeEncoding + range.offset, range.length));
+  }
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typesplitter_getStatusCode(&splitter));
+  EXPECT(expectedTypes == types);
+}
+
+static void testSplittingMemberlessStructs() {
+  expectSplitTypes("B32@0:8^^{__CFError}16@24", { "B", "@", ":", "^^{__CFError}", "@" });
+  expectSplitTypes("v24@0:8(Opaque)16", { "v", "@", ":", "(Opaque)" });
+  expectSplitTypes("v24@0:8@?16", { "v", "@", ":", "@?" });
+  expectSplitTypes("{s=^{t}[2{u}]i}c", { "{s=^{t}[2{u}]i}", "c" });
+
+  size_t endOffset = 0;
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_skipType("^{CGPoint}i", SIZE_MAX, &endOffset));
+  EXPECT_EQ(10, endOffset);
+  EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_skipType("{CGPoint)", SIZE_MAX, &endOffset));
+}
+
+static void testMemberNames() {
+  // Names made of type characters must not be mistaken for types.
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding("{S=\"dict\"c\"i\"i}");
+  EXPECT_EQ(0, objctk_typeparseresult_getUnexpectedTokenCount(parseResult));
+  unsigned int memberCount = 0;
+  objctk_free(objctk_typenode_copyMemberTypeList(objctk_typeparseresult_getParsedType(parseResult), &memberCount));
+  EXPECT_EQ(2, memberCount);
+  objctk_typeparseresult_release(parseResult);
+  expectScannedLayoutMatchesTree("{S=\"dict\"c\"i\"i}", objctk_layoutprofile_LP64);
+
+  expectSplitTypes("\"x\"d\"y\"i", { "d", "i" });
+  int size = 0;
+  EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_getSizeAndAlignment("{S=\"x", SIZE_MAX, objctk_layoutprofile_LP64, &size, NULL, NULL));
+  size_t endOffset = 0;
+  EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_skipType("\"x", SIZE_MAX, &endOffset));
+}
+
+int main() {
+  testScannerMatchesTree();
+  testSkippingWithGenerousLength();
+  testSplittingMemberlessStructs();
+  testMemberNames();
+  return testResult();
+}
@@ -0,0 +1,138 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void testPrewarmedLookups() {
+  EXPECT(objctk_getPrewarmedParseResult("{CGPoint=dd}") == NULL);
+
+  // Encodings nested beyond the default depth limit fail to parse.
+  const std::string invalidEncoding = std::string(1000, '^') + "i";
+  const char *typeEncodings[] = { "{CGPoint=dd}", "{CGSize=dd}", invalidEncoding.c_str(), NULL };
+  EXPECT_EQ(2, objctk_prewarmTypeEncodings(typeEncodings, 4));
+  objctk_typeparseresult pointResult = objctk_getPrewarmedParseResult("{CGPoint=dd}");
+  EXPECT(pointResult != NULL);
+  EXPECT(objctk_parseTypeEncoding("{CGPoint=dd}") == pointResult);
+  EXPECT(objctk_getPrewarmedParseResult("{CGSize=dd}") != NULL);
+
+  // Misses of the same length as a prewarmed encoding, of other lengths and longer than every
+  // prewarmed encoding.
+  EXPECT(objctk_getPrewarmedParseResult("{CGPoint=ff}") == NULL);
+  EXPECT(objctk_getPrewarmedParseResult("{CGRect={CGPoint=dd}{CGSize=dd}}") == NULL);
+  EXPECT(objctk_getPrewarmedParseResult("{CGPoint=dd}i") == NULL);
+  EXPECT(objctk_getPrewarmedParseResult("{CGPoint=d") == NULL);
+  EXPECT(objctk_getPrewarmedParseResult("") == NULL);
+  EXPECT(objctk_getPrewarmedParseResult(invalidEncoding.c_str()) == NULL);
+
+  // Later calls add to the encodings prewarmed by earlier ones.
+  const std::string longEncoding = "{" + std::string(100, 'L') + "=i}";
+  const char *moreTypeEncodings[] = { longEncoding.c_str(), "{CGPoint=dd}" };
+  EXPECT_EQ(2, objctk_prewarmTypeEncodings(moreTypeEncodings, 2));
+  EXPECT(objctk_getPrewarmedParseResult("{CGPoint=dd}") == pointResult);
+  EXPECT(objctk_getPrewarmedParseResult(longEncoding.c_str()) != NULL);
+  EXPECT(objctk_getPrewarmedParseResult((longEncoding + "i").c_str()) == NULL);
+}
+
+static void *allocateCounted(void *context, size_t size) {
+  *static_cast<size_t *>(context) += size;
+  return malloc(size);
+}
+
+static void *reallocateCounted(void *context, void *pointer, size_t size) {
+  *static_cast<size_t *>(context) += size;
+  return realloc(pointer, size);
+}
+
+static void deallocateCounted(void *, void *pointer) {
+  free(pointer);
+}
+
+static void testIncrementalPrewarming() {
+  // Prewarming one encoding per call neither recopies every prewarmed encoding nor retains a table
+  // per call, so the memory allocated per encoding stays constant as encodings are added. Each
+  // encoding takes a parse result of about a kilobyte of its own.
+  const size_t encodingCount = 2048;
+  std::vector<std::string> typeEncodings;
+  for (size_t index = 0; index < encodingCount; index++) {
+    typeEncodings.push_back("{Incremental" + std::to_string(index) + "=iq}");
+  }
+  size_t allocatedByteCount = 0;
+  const objctk_allocator allocator = { &allocatedByteCount, allocateCounted, reallocateCounted, deallocateCounted };
+  objctk_setDefaultAllocator(&allocator);
+  for (size_t index = 0; index < encodingCount; index++) {
+    const char *typeEncoding = typeEncodings[index].c_str();
+    EXPECT_EQ(1, objctk_prewarmTypeEncodings(&typeEncoding, 1));
+  }
+  objctk_setDefaultAllocator(NULL);
+  EXPECT(allocatedByteCount < (encodingCount * 4096));
+
+  for (size_t index = 0; index < encodingCount; index++) {
+    EXPECT(objctk_getPrewarmedParseResult(typeEncodings[index].c_str()) != NULL);
+  }
+  EXPECT(objctk_getPrewarmedParseResult("{CGPoint=dd}") != NULL);
+  EXPECT(objctk_getPrewarmedParseResult("{Incremental2048=iq}") == NULL);
+}
+
+static void testLookupsDuringPrewarming() {
+  // Encodings are added to the published table while other threads look encodings up, which find
+  // every encoding prewarmed before their lookup began.
+  const size_t encodingCount = 512;
+  std::vector<std::string> typeEncodings;
+  for (size_t index = 0; index < encodingCount; index++) {
+    typeEncodings.push_back("{Concurrent" + std::to_string(index) + "=dd}");
+  }
+  std::atomic<size_t> prewarmedCount(0);
+  std::atomic<bool> failedLookup(false);
+  std::thread lookupThread([&]() {
+    size_t count;
+    while ((count = prewarmedCount.load()) < encodingCount) {
+      if ((objctk_getPrewarmedParseResult("{CGPoint=dd}") == NULL) ||
+          ((count > 0) && (objctk_getPrewarmedParseResult(typeEncodings[count - 1].c_str()) == NULL))) {
+        failedLookup = true;
+      }
+    }
+  });
+  for (size_t index = 0; index < encodingCount; index++) {
+    const char *typeEncoding = typeEncodings[index].c_str();
+    objctk_prewarmTypeEncodings(&typeEncoding, 1);
+    prewarmedCount++;
+  }
+  lookupThread.join();
+  EXPECT(!failedLookup);
+}
+
+int main() {
+  testPrewarmedLookups();
+  testIncrementalPrewarming();
+  testLookupsDuringPrewarming();
+  return testResult();
+}
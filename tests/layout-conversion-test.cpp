@@ -0,0 +1,109 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+static objctk_layoutconversion makeConversion(const char *typeEncoding, objctk_typeparseresult *outParseResult) {
+  *outParseResult = objctk_parseTypeEncoding(typeEncoding);
+  return objctk_layoutconversion_create(objctk_typeparseresult_getParsedType(*outParseResult), objctk_layoutprofile_ILP32, objctk_layoutprofile_LP64);
+}
+
+static uint64_t translatePointer(uint64_t pointer, void *context) {
+  (*static_cast<int *>(context))++;
+  return pointer + 0x100000000ULL;
+}
+
+static void testArraysOfStructsRepeatNonTilingOperations() {
+  // The longs of each element do not tile it because of the trailing char, so they repeat at the
+  // element strides instead of once per element.
+  objctk_typeparseresult parseResult;
+  objctk_layoutconversion conversion = makeConversion("{Outer=[100{Inner=[3l]c^v}]}", &parseResult);
+  EXPECT(conversion != NULL);
+  EXPECT_EQ(100 * 20, objctk_layoutconversion_getSourceValueSize(conversion));
+  EXPECT_EQ(100 * 40, objctk_layoutconversion_getDestinationValueSize(conversion));
+  EXPECT_EQ(3, objctk_layoutconversion_getOperationCount(conversion));
+
+  const size_t valueCount = 3;
+  std::vector<unsigned char> source(valueCount * 100 * 20);
+  for (size_t index = 0; index < source.size(); index++) {
+    source[index] = (unsigned char)(index * 7 + 1);
+  }
+  std::vector<unsigned char> destination(valueCount * 100 * 40, 0xAA);
+  int translationCount = 0;
+  objctk_layoutconversion_convertValues(conversion, source.data(), destination.data(), valueCount, translatePointer, &translationCount);
+  EXPECT_EQ(valueCount * 100, translationCount);
+
+  bool matches = true;
+  for (size_t element = 0; element < (valueCount * 100); element++) {
+    const unsigned char *sourceElement = source.data() + (element * 20);
+    const unsigned char *destinationElement = destination.data() + (element * 40);
+    for (int index = 0; index < 3; index++) {
+      int32_t sourceLong;
+      int64_t destinationLong;
+      memcpy(&sourceLong, sourceElement + (index * 4), sizeof(sourceLong));
+      memcpy(&destinationLong, destinationElement + (index * 8), sizeof(destinationLong));
+      matches = matches && (destinationLong == sourceLong);
+    }
+    matches = matches && (destinationElement[24] == sourceElement[12]);
+    for (int index = 25; index < 32; index++) {
+      matches = matches && (destinationElement[index] == 0);
+    }
+    uint32_t sourcePointer;
+    uint64_t destinationPointer;
+    memcpy(&sourcePointer, sourceElement + 16, sizeof(sourcePointer));
+    memcpy(&destinationPointer, destinationElement + 32, sizeof(destinationPointer));
+    matches = matches && (destinationPointer == (sourcePointer + 0x100000000ULL));
+  }
+  EXPECT(matches);
+  objctk_layoutconversion_release(conversion);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testUnionsWithPointersAreRejected() {
+  objctk_typeparseresult parseResult;
+  objctk_layoutconversion conversion = makeConversion("{S=(U=iI)}", &parseResult);
+  EXPECT(conversion != NULL);
+  objctk_layoutconversion_release(conversion);
+  objctk_typeparseresult_release(parseResult);
+  EXPECT(makeConversion("{S=(U=ii)[2(V=c^v)]}", &parseResult) == NULL);
+  objctk_typeparseresult_release(parseResult);
+
+  // The pointers of a union are rejected even when both profiles share their size.
+  objctk_typeparseresult pointerParseResult = objctk_parseTypeEncoding("(U=^vq)");
+  objctk_typenode node = objctk_typeparseresult_getParsedType(pointerParseResult);
+  EXPECT(objctk_layoutconversion_create(node, objctk_layoutprofile_LP64, objctk_layoutprofile_ARM64) == NULL);
+  objctk_typeparseresult_release(pointerParseResult);
+}
+
+int main() {
+  testArraysOfStructsRepeatNonTilingOperations();
+  testUnionsWithPointersAreRejected();
+  return testResult();
+}
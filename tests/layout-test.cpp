@@ -0,0 +1,60 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+static int typeSize(const char *typeEncoding, objctk_layoutprofile profile) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(typeEncoding);
+  const int size = objctk_typenode_getTypeSizeForLayoutProfile(objctk_typeparseresult_getParsedType(parseResult), profile);
+  objctk_typeparseresult_release(parseResult);
+  return size;
+}
+
+static void testProfiles() {
+  EXPECT_EQ(16, typeSize("{CGPoint=dd}", objctk_layoutprofile_LP64));
+  EXPECT_EQ(20, typeSize("{x=lclcl}", objctk_layoutprofile_ILP32));
+  EXPECT_EQ(40, typeSize("{x=lclcl}", objctk_layoutprofile_LP64));
+  EXPECT_EQ(12, typeSize("{x=id}", objctk_layoutprofile_I386));
+  EXPECT_EQ(4, typeSize("{b=b1b31}", objctk_layoutprofile_LP64));
+  EXPECT_EQ(40, typeSize("[10i]", objctk_layoutprofile_LP64));
+}
+
+static void testOverflowingSizesAreInvalid() {
+  EXPECT_EQ(-1, typeSize("[99999999999999i]", objctk_layoutprofile_LP64));
+  EXPECT_EQ(-1, typeSize("[999999999999999999999999i]", objctk_layoutprofile_LP64));
+  EXPECT_EQ(-1, typeSize("b99999999999", objctk_layoutprofile_LP64));
+  EXPECT_EQ(-1, typeSize("[536870912i]", objctk_layoutprofile_LP64));
+  EXPECT_EQ(2147483644, typeSize("[536870911i]", objctk_layoutprofile_LP64));
+  EXPECT_EQ(-1, typeSize("{s=[536870911i][536870911i]}", objctk_layoutprofile_LP64));
+  EXPECT_EQ(-1, typeSize("{s=[268435455q]b64}", objctk_layoutprofile_LP64));
+  EXPECT_EQ(-1, typeSize("[2{s=[536870911i]}]", objctk_layoutprofile_LP64));
+}
+
+int main() {
+  testProfiles();
+  testOverflowingSizesAreInvalid();
+  return testResult();
+}
@@ -0,0 +1,243 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+// Builds Mach-O files byte by byte with a single segment holding one section.
+class machobuilder {
+  std::string m_bytes;
+  bool m_bigEndian;
+
+ public:
+  explicit machobuilder(const bool bigEndian) : m_bigEndian(bigEndian) {}
+
+  void appendUInt32(const uint32_t value) {
+    for (int index = 0; index < 4; index++) {
+      const int shift = m_bigEndian ? (24 - (index * 8)) : (index * 8);
+      m_bytes += (char)((value >> shift) & 0xFF);
+    }
+  }
+
+  void appendUInt64(const uint64_t value) {
+    appendUInt32(m_bigEndian ? (uint32_t)(value >> 32) : (uint32_t)value);
+    appendUInt32(m_bigEndian ? (uint32_t)value : (uint32_t)(value >> 32));
+  }
+
+  void appendName(const char *name) {
+    std::string field(name);
+    field.resize(16, '\0');
+    m_bytes += field;
+  }
+
+  const std::string &bytes() const { return m_bytes; }
+};
+
+static std::string machOFile(const bool is64Bit, const bool bigEndian, const char *segmentName, const char *sectionName, const std::string &sectionData, const uint32_t sectionDataOffsetAdjustment = 0) {
+  machobuilder builder(bigEndian);
+  const uint32_t headerSize = is64Bit ? 32 : 28;
+  const uint32_t commandSize = is64Bit ? (72 + 80) : (56 + 68);
+  const uint32_t dataOffset = headerSize + commandSize;
+  builder.appendUInt32(is64Bit ? 0xfeedfacf : 0xfeedface);
+  builder.appendUInt32(is64Bit ? 0x01000007 : 7);
+  builder.appendUInt32(3);
+  builder.appendUInt32(1);
+  builder.appendUInt32(1);
+  builder.appendUInt32(commandSize);
+  builder.appendUInt32(0);
+  if (is64Bit) {
+    builder.appendUInt32(0);
+    builder.appendUInt32(0x19);
+    builder.appendUInt32(commandSize);
+    builder.appendName(segmentName);
+    builder.appendUInt64(0);
+    builder.appendUInt64(sectionData.size());
+    builder.appendUInt64(dataOffset);
+    builder.appendUInt64(sectionData.size());
+    builder.appendUInt32(7);
+    builder.appendUInt32(5);
+    builder.appendUInt32(1);
+    builder.appendUInt32(0);
+    builder.appendName(sectionName);
+    builder.appendName(segmentName);
+    builder.appendUInt64(0);
+    builder.appendUInt64(sectionData.size());
+    builder.appendUInt32(dataOffset + sectionDataOffsetAdjustment);
+    for (int index = 0; index < 7; index++) {
+      builder.appendUInt32(0);
+    }
+  } else {
+    builder.appendUInt32(0x1);
+    builder.appendUInt32(commandSize);
+    builder.appendName(segmentName);
+    builder.appendUInt32(0);
+    builder.appendUInt32((uint32_t)sectionData.size());
+    builder.appendUInt32(dataOffset);
+    builder.appendUInt32((uint32_t)sectionData.size());
+    builder.appendUInt32(7);
+    builder.appendUInt32(5);
+    builder.appendUInt32(1);
+    builder.appendUInt32(0);
+    builder.appendName(sectionName);
+    builder.appendName(segmentName);
+    builder.appendUInt32(0);
+    builder.appendUInt32((uint32_t)sectionData.size());
+    builder.appendUInt32(dataOffset + sectionDataOffsetAdjustment);
+    for (int index = 0; index < 6; index++) {
+      builder.appendUInt32(0);
+    }
+  }
+  return builder.bytes() + sectionData;
+}
+
+static std::string fatFile(const std::string &firstSlice, const std::string &secondSlice) {
+  // Fat headers are big-endian and slices are aligned to 4 KiB.
+  machobuilder builder(true);
+  builder.appendUInt32(0xcafebabe);
+  builder.appendUInt32(2);
+  const uint32_t sliceOffsets[] = { 4096, 8192 };
+  const std::string *slices[] = { &firstSlice, &secondSlice };
+  for (int index = 0; index < 2; index++) {
+    builder.appendUInt32(7);
+    builder.appendUInt32(3);
+    builder.appendUInt32(sliceOffsets[index]);
+    builder.appendUInt32((uint32_t)slices[index]->size());
+    builder.appendUInt32(12);
+  }
+  std::string file = builder.bytes();
+  file.resize(4096, '\0');
+  file += firstSlice;
+  file.resize(8192, '\0');
+  return file + secondSlice;
+}
+
+// Writes a file to a temporary path and opens it as a Mach-O image.
+static objctk_machoimage openImage(const std::string &bytes) {
+  char path[] = "/tmp/objctk-macho-test-XXXXXX";
+  const int fileDescriptor = mkstemp(path);
+  if (fileDescriptor < 0) {
+    return NULL;
+  }
+  const bool isWritten = write(fileDescriptor, bytes.data(), bytes.size()) == (ssize_t)bytes.size();
+  close(fileDescriptor);
+  objctk_machoimage image = isWritten ? objctk_machoimage_open(path) : NULL;
+  unlink(path);
+  return image;
+}
+
+// Returns the characters of a string literal including embedded NULs.
+template <size_t Length>
+static std::string literalBytes(const char (&characters)[Length]) {
+  return std::string(characters, Length - 1);
+}
+
+static const std::string kMethodTypes = literalBytes("v16@0:8\0@\"NSString\"16@0:8\0v16@0:8\0{CGPoint=dd}\0\0");
+
+static void testThinImages() {
+  objctk_machoimage image = openImage(machOFile(true, false, "__TEXT", "__objc_methtype", kMethodTypes));
+  EXPECT(image != NULL);
+  EXPECT_EQ(1, objctk_machoimage_getArchitectureCount(image));
+  EXPECT_EQ(3, objctk_machoimage_getEncodingCount(image));
+  EXPECT(std::string(objctk_machoimage_getEncoding(image, 0)) == "v16@0:8");
+  EXPECT(std::string(objctk_machoimage_getEncoding(image, 1)) == "@\"NSString\"16@0:8");
+  EXPECT(std::string(objctk_machoimage_getEncoding(image, 2)) == "{CGPoint=dd}");
+  EXPECT(objctk_machoimage_getEncoding(image, 3) == NULL);
+  objctk_machoimage_release(image);
+
+  // Byte-swapped 32-bit images with the legacy runtime section; the unterminated trailing string is
+  // ignored.
+  image = openImage(machOFile(false, true, "__OBJC", "__meth_var_types", literalBytes("i\0^{Node}\0unterminated")));
+  EXPECT(image != NULL);
+  EXPECT_EQ(2, objctk_machoimage_getEncodingCount(image));
+  EXPECT(std::string(objctk_machoimage_getEncoding(image, 1)) == "^{Node}");
+  objctk_machoimage_release(image);
+
+  // Sections in other segments are not type encodings.
+  image = openImage(machOFile(true, false, "__DATA", "__objc_methtype", kMethodTypes));
+  EXPECT(image != NULL);
+  EXPECT_EQ(0, objctk_machoimage_getEncodingCount(image));
+  objctk_machoimage_release(image);
+}
+
+static void testFatImages() {
+  const std::string firstSlice = machOFile(true, false, "__TEXT", "__objc_methtype", kMethodTypes);
+  const std::string secondSlice = machOFile(false, false, "__TEXT", "__objc_methtype", literalBytes("v16@0:8\0c\0"));
+  objctk_machoimage image = openImage(fatFile(firstSlice, secondSlice));
+  EXPECT(image != NULL);
+  EXPECT_EQ(2, objctk_machoimage_getArchitectureCount(image));
+  EXPECT_EQ(4, objctk_machoimage_getEncodingCount(image));
+  EXPECT(std::string(objctk_machoimage_getEncoding(image, 3)) == "c");
+  objctk_machoimage_release(image);
+}
+
+static void testMalformedImagesAreRejected() {
+  EXPECT(openImage("") == NULL);
+  EXPECT(openImage("not a Mach-O file") == NULL);
+  const std::string file = machOFile(true, false, "__TEXT", "__objc_methtype", kMethodTypes);
+  EXPECT(openImage(file.substr(0, 40)) == NULL);
+  EXPECT(openImage(machOFile(true, false, "__TEXT", "__objc_methtype", kMethodTypes, 4096)) == NULL);
+  EXPECT(openImage(fatFile(file, file).substr(0, 6000)) == NULL);
+}
+
+static std::atomic<size_t> gParsedEncodingCount(0);
+
+static void countParsedEncoding(size_t, const char *typeEncoding, objctk_typeparseresult parseResult, void *) {
+  if ((objctk_typeparseresult_getStatusCode(parseResult) == objctk_statuscode_NoError) && (typeEncoding[0] != '\0')) {
+    gParsedEncodingCount++;
+  }
+}
+
+static void testEncodingsAreParsed() {
+  std::string methodTypes;
+  for (int index = 0; index < 1000; index++) {
+    methodTypes += "{S" + std::to_string(index) + "=iq}";
+    methodTypes += '\0';
+  }
+  objctk_machoimage image = openImage(machOFile(true, false, "__TEXT", "__objc_methtype", methodTypes));
+  EXPECT_EQ(1000, objctk_machoimage_getEncodingCount(image));
+  for (unsigned int threadCount : { 0u, 1u, 4u }) {
+    gParsedEncodingCount = 0;
+    EXPECT_EQ(objctk_statuscode_NoError, objctk_machoimage_parseEncodings(image, threadCount, countParsedEncoding, NULL));
+    EXPECT_EQ(1000, gParsedEncodingCount.load());
+  }
+  EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_machoimage_parseEncodings(image, 1, NULL, NULL));
+  EXPECT_EQ(objctk_statuscode_InvalidInput, objctk_machoimage_parseEncodings(NULL, 1, countParsedEncoding, NULL));
+  objctk_machoimage_release(image);
+}
+
+int main() {
+  testThinImages();
+  testFatImages();
+  testMalformedImagesAreRejected();
+  testEncodingsAreParsed();
+  return testResult();
+}
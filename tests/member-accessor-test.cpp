@@ -0,0 +1,194 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct Point {
+  double x;
+  double y;
+};
+
+struct Size {
+  double width;
+  double height;
+};
+
+struct Rect {
+  Point origin;
+  Size size;
+};
+
+struct Node {
+  char tag;
+  Node *next;
+  int values[3];
+};
+
+static size_t memberOffset(objctk_memberaccessor accessor, const void *value) {
+  return (size_t)(static_cast<const char *>(objctk_memberaccessor_getAddress(accessor, value)) - static_cast<const char *>(value));
+}
+
+static void testDottedPaths() {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding("{Rect={Point=dd}{Size=dd}}");
+  objctk_typenode node = objctk_typeparseresult_getParsedType(parseResult);
+  Rect rect = {{1, 2}, {3, 4}};
+
+  objctk_memberaccessor accessor = objctk_memberaccessor_create(node, "Size.0");
+  EXPECT(accessor != NULL);
+  EXPECT_EQ(offsetof(Rect, size) + offsetof(Size, width), memberOffset(accessor, &rect));
+  EXPECT_EQ(0, objctk_memberaccessor_getDereferenceCount(accessor));
+  EXPECT_EQ(OBJCTKTypeCategoryDouble, objctk_typenode_getTypeCategory(objctk_memberaccessor_getMemberType(accessor)));
+  objctk_memberaccessor_release(accessor);
+
+  accessor = objctk_memberaccessor_create(node, ".1.1");
+  EXPECT(accessor != NULL);
+  EXPECT_EQ(offsetof(Rect, size) + offsetof(Size, height), memberOffset(accessor, &rect));
+  objctk_memberaccessor_release(accessor);
+
+  accessor = objctk_memberaccessor_create(node, "Point");
+  EXPECT(accessor != NULL);
+  EXPECT_EQ(OBJCTKTypeCategoryStruct, objctk_typenode_getTypeCategory(objctk_memberaccessor_getMemberType(accessor)));
+  Point copiedPoints[2];
+  const Rect rects[2] = {{{5, 6}, {7, 8}}, {{9, 10}, {11, 12}}};
+  EXPECT_EQ(2, objctk_memberaccessor_copyMemberValues(accessor, rects, 2, sizeof(Rect), copiedPoints));
+  EXPECT(copiedPoints[0].x == 5);
+  EXPECT(copiedPoints[1].y == 10);
+  objctk_memberaccessor_release(accessor);
+
+  // Unknown names, out of range indexes, malformed paths and paths through scalars do not resolve.
+  EXPECT(objctk_memberaccessor_create(node, "NoSuchMemberType") == NULL);
+  EXPECT(objctk_memberaccessor_create(node, ".2") == NULL);
+  EXPECT(objctk_memberaccessor_create(node, "0..1") == NULL);
+  EXPECT(objctk_memberaccessor_create(node, "0.0.0") == NULL);
+  EXPECT(objctk_memberaccessor_create(node, "[0]") == NULL);
+  EXPECT(objctk_memberaccessor_create(node, "0->0") == NULL);
+  objctk_typeparseresult_release(parseResult);
+
+  // Ambiguous type names and bitfields do not resolve either.
+  parseResult = objctk_parseTypeEncoding("{Pair={Point=dd}{Point=dd}b3}");
+  node = objctk_typeparseresult_getParsedType(parseResult);
+  EXPECT(objctk_memberaccessor_create(node, "Point") == NULL);
+  accessor = objctk_memberaccessor_create(node, "1");
+  EXPECT(accessor != NULL);
+  objctk_memberaccessor_release(accessor);
+  EXPECT(objctk_memberaccessor_create(node, "2") == NULL);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testIndexedAndDereferencedPaths() {
+  // Pointers to structs without members cannot be dereferenced, so the pointer spells out the
+  // members of the struct it points to.
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding("{Node=c^{Node=c^v[3i]}[3i]}");
+  objctk_typenode node = objctk_typeparseresult_getParsedType(parseResult);
+  Node last = {'b', NULL, {4, 5, 6}};
+  Node first = {'a', &last, {1, 2, 3}};
+
+  objctk_memberaccessor accessor = objctk_memberaccessor_create(node, "2[1]");
+  EXPECT(accessor != NULL);
+  EXPECT_EQ(offsetof(Node, values) + sizeof(int), memberOffset(accessor, &first));
+  EXPECT(objctk_memberaccessor_create(node, "2[3]") == NULL);
+  EXPECT(objctk_memberaccessor_create(node, "2[1") == NULL);
+  objctk_memberaccessor_release(accessor);
+
+  accessor = objctk_memberaccessor_create(node, "1->2[2]");
+  EXPECT(accessor != NULL);
+  EXPECT_EQ(1, objctk_memberaccessor_getDereferenceCount(accessor));
+  EXPECT(objctk_memberaccessor_getAddress(accessor, &first) == &last.values[2]);
+  EXPECT(objctk_memberaccessor_getAddress(accessor, &last) == NULL);
+
+  int values[2] = {-1, -1};
+  const Node nodes[2] = {first, last};
+  EXPECT_EQ(1, objctk_memberaccessor_copyMemberValues(accessor, nodes, 2, sizeof(Node), values));
+  EXPECT_EQ(6, values[0]);
+  EXPECT_EQ(0, values[1]);
+  void *addresses[2];
+  objctk_memberaccessor_getAddresses(accessor, nodes, 2, sizeof(Node), addresses);
+  EXPECT(addresses[0] == &last.values[2]);
+  EXPECT(addresses[1] == NULL);
+  objctk_memberaccessor_release(accessor);
+
+  // A subscript after a pointer dereferences it and selects the value at that index.
+  objctk_typeparseresult pointerParseResult = objctk_parseTypeEncoding("{Buffer=^iQ}");
+  int elements[3] = {7, 8, 9};
+  struct {
+    int *elements;
+    unsigned long long count;
+  } buffer = {elements, 3};
+  accessor = objctk_memberaccessor_create(objctk_typeparseresult_getParsedType(pointerParseResult), "0[2]");
+  EXPECT(accessor != NULL);
+  EXPECT(objctk_memberaccessor_getAddress(accessor, &buffer) == &elements[2]);
+  objctk_memberaccessor_release(accessor);
+  objctk_typeparseresult_release(pointerParseResult);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testCacheMatchesTypesByStructure() {
+  objctk_memberaccessorcache cache = objctk_memberaccessorcache_create(NULL);
+  objctk_parser parser = objctk_parser_create();
+
+  objctk_typenode node = objctk_typeparseresult_getParsedType(objctk_parser_parseTypeEncoding(parser, "{Rect={Point=dd}{Size=dd}}"));
+  objctk_memberaccessor rectAccessor = objctk_memberaccessorcache_getAccessor(cache, node, "1.1");
+  EXPECT(rectAccessor != NULL);
+  EXPECT(objctk_memberaccessorcache_getAccessor(cache, node, "1.1") == rectAccessor);
+  EXPECT(objctk_memberaccessorcache_getAccessor(cache, node, "NoSuchMemberType") == NULL);
+
+  // The parser reuses the memory of the previous type for a different type of the same shape,
+  // which must not be served the accessor of the previous type.
+  objctk_typenode otherNode = objctk_typeparseresult_getParsedType(objctk_parser_parseTypeEncoding(parser, "{Pair={Half=cc}{Word=ii}}"));
+  EXPECT(otherNode == node);
+  objctk_memberaccessor pairAccessor = objctk_memberaccessorcache_getAccessor(cache, otherNode, "1.1");
+  EXPECT(pairAccessor != NULL);
+  EXPECT(pairAccessor != rectAccessor);
+  EXPECT_EQ(OBJCTKTypeCategorySignedInt, objctk_typenode_getTypeCategory(objctk_memberaccessor_getMemberType(pairAccessor)));
+  const char pair[12] = {0};
+  EXPECT_EQ(8, memberOffset(pairAccessor, pair));
+
+  // Reparsing the first type finds its accessor again, which still refers to its own copy of the
+  // type after the parser is released.
+  node = objctk_typeparseresult_getParsedType(objctk_parser_parseTypeEncoding(parser, "{Rect={Point=dd}{Size=dd}}"));
+  EXPECT(objctk_memberaccessorcache_getAccessor(cache, node, "1.1") == rectAccessor);
+  objctk_parser_release(parser);
+  EXPECT_EQ(OBJCTKTypeCategoryDouble, objctk_typenode_getTypeCategory(objctk_memberaccessor_getMemberType(rectAccessor)));
+  const Rect rect = {{1, 2}, {3, 4}};
+  EXPECT_EQ(offsetof(Rect, size) + offsetof(Size, height), memberOffset(rectAccessor, &rect));
+
+  // Types differing only in their names are distinct.
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding("{Other={Point=dd}{Size=dd}}");
+  EXPECT(objctk_memberaccessorcache_getAccessor(cache, objctk_typeparseresult_getParsedType(parseResult), "1.1") != rectAccessor);
+  objctk_typeparseresult_release(parseResult);
+  objctk_memberaccessorcache_release(cache);
+}
+
+int main() {
+  testDottedPaths();
+  testIndexedAndDereferencedPaths();
+  testCacheMatchesTypesByStructure();
+  return testResult();
+}
@@ -0,0 +1,117 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Counts allocations and offsets each block by a header, so that freeing a block with another
+// allocator crashes.
+static const size_t kHeaderSize = 16;
+static long gAllocationCount = 0;
+static long gLiveAllocationCount = 0;
+
+static void *countingAllocate(void *, size_t size) {
+  char *memory = static_cast<char *>(malloc(kHeaderSize + size));
+  if (memory == NULL) {
+    return NULL;
+  }
+  gAllocationCount++;
+  gLiveAllocationCount++;
+  return memory + kHeaderSize;
+}
+
+static void *countingReallocate(void *context, void *pointer, size_t size) {
+  if (pointer == NULL) {
+    return countingAllocate(context, size);
+  }
+  char *memory = static_cast<char *>(realloc(static_cast<char *>(pointer) - kHeaderSize, kHeaderSize + size));
+  return (memory != NULL) ? (memory + kHeaderSize) : NULL;
+}
+
+static void countingDeallocate(void *, void *pointer) {
+  gLiveAllocationCount--;
+  free(static_cast<char *>(pointer) - kHeaderSize);
+}
+
+// The name table keeps the default allocator of its first use, so this runs first.
+static void testNameTableKeepsItsAllocator() {
+  objctk_allocator allocator = { NULL, countingAllocate, countingReallocate, countingDeallocate };
+  objctk_setDefaultAllocator(&allocator);
+  EXPECT(objctk_internName("First", 5) != OBJCTK_NAMEID_NONE);
+  objctk_setDefaultAllocator(NULL);
+
+  // Growing the table allocates and frees slots with the counting allocator, which would crash if the
+  // slots were freed with the default allocator.
+  const long allocationCount = gAllocationCount;
+  char name[32];
+  for (int index = 0; index < 10000; index++) {
+    snprintf(name, sizeof(name), "Name%d", index);
+    EXPECT(objctk_internName(name, strlen(name)) != OBJCTK_NAMEID_NONE);
+  }
+  EXPECT(gAllocationCount > allocationCount);
+  EXPECT(gLiveAllocationCount > 0);
+}
+
+static void testNamesAreInterned() {
+  const objctk_nameid nameID = objctk_internName("NSString", 8);
+  EXPECT(nameID != OBJCTK_NAMEID_NONE);
+  EXPECT_EQ(nameID, objctk_internName("NSString", 8));
+  EXPECT_EQ(nameID, objctk_lookupName("NSString", 8));
+  EXPECT(strcmp(objctk_getInternedName(nameID, NULL), "NSString") == 0);
+  EXPECT_EQ(OBJCTK_NAMEID_NONE, objctk_internName("", 0));
+  EXPECT_EQ(OBJCTK_NAMEID_NONE, objctk_lookupName("NeverInterned", 13));
+}
+
+static void testSuccessfulParsesInternTypeNames() {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding("{Outer=@\"InnerClass\"^{Pointee=i}}");
+  objctk_typenode node = objctk_typeparseresult_getParsedType(parseResult);
+  EXPECT(strcmp(objctk_typenode_getName(node), "Outer") == 0);
+  EXPECT_EQ(objctk_lookupName("Outer", 5), objctk_typenode_getNameID(node));
+  EXPECT(objctk_lookupName("InnerClass", 10) != OBJCTK_NAMEID_NONE);
+  EXPECT(objctk_lookupName("Pointee", 7) != OBJCTK_NAMEID_NONE);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testFailedParsesDoNotInternTypeNames() {
+  objctk_parselimits limits = {};
+  limits.maximumNodeCount = 3;
+  objctk_typeparseresult parseResult = objctk_parseTypeEncodingWithLimits("{FailedOuter=@\"FailedClass\"iii}", &limits, NULL);
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, objctk_typeparseresult_getStatusCode(parseResult));
+  objctk_typeparseresult_release(parseResult);
+  EXPECT_EQ(OBJCTK_NAMEID_NONE, objctk_lookupName("FailedOuter", 11));
+  EXPECT_EQ(OBJCTK_NAMEID_NONE, objctk_lookupName("FailedClass", 11));
+}
+
+int main() {
+  testNameTableKeepsItsAllocator();
+  testNamesAreInterned();
+  testSuccessfulParsesInternTypeNames();
+  testFailedParsesDoNotInternTypeNames();
+  return testResult();
+}
@@ -0,0 +1,172 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+
+// Runs objctk-analyze, whose path is the first argument, over a small input and checks its JSON
+// lines. The input is written to the working directory so that the reported source is stable.
+static const char *gAnalyzePath = NULL;
+static const char *const kInputPath = "objctk-analyze-test-input.txt";
+
+static const char kInput[] =
+    "{CGPoint=dd}\n"
+    "i\n"
+    "{Bad=i}}x\n"
+    "\n"
+    "[4{Pair=^ii}]\r\n"
+    "{CGRect={CGPoint=dd}{CGSize=dd}}\n"
+    "{L=iiiiiiiiiiiiiiiiiiii}\n"
+    "{Small=c}\n"
+    "{CGPoint=dd}\n"
+    "{Mid=dddd}\n"
+    "}}\n"
+    "(U=ic)";
+
+static bool writeInput() {
+  FILE *file = fopen(kInputPath, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  const bool wroteInput = (fwrite(kInput, 1, sizeof(kInput) - 1, file) == (sizeof(kInput) - 1));
+  return (fclose(file) == 0) && wroteInput;
+}
+
+// Returns the lines written to standard output and stores the exit status of the tool.
+static std::vector<std::string> runAnalyze(const std::string &arguments, int *outExitStatus) {
+  const std::string command = std::string("\"") + gAnalyzePath + "\" " + arguments + " 2>/dev/null";
+  std::vector<std::string> lines;
+  FILE *pipe = popen(command.c_str(), "r");
+  if (pipe == NULL) {
+    *outExitStatus = -1;
+    return lines;
+  }
+  std::string output;
+  char buffer[4096];
+  size_t readCount;
+  while ((readCount = fread(buffer, 1, sizeof(buffer), pipe)) != 0) {
+    output.append(buffer, readCount);
+  }
+  const int status = pclose(pipe);
+  *outExitStatus = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+  size_t lineStart = 0;
+  size_t newline;
+  while ((newline = output.find('\n', lineStart)) != std::string::npos) {
+    lines.push_back(output.substr(lineStart, newline - lineStart));
+    lineStart = newline + 1;
+  }
+  EXPECT_EQ(output.size(), lineStart);
+  return lines;
+}
+
+static void expectLines(const std::vector<std::string> &expectedLines, const std::vector<std::string> &lines) {
+  EXPECT_EQ(expectedLines.size(), lines.size());
+  for (size_t index = 0; (index < expectedLines.size()) && (index < lines.size()); index++) {
+    if (expectedLines[index] != lines[index]) {
+      fprintf(stderr, "line %zu: expected %s\n  but got %s\n", index + 1, expectedLines[index].c_str(), lines[index].c_str());
+      EXPECT(expectedLines[index] == lines[index]);
+    }
+  }
+}
+
+static void testEncodingsMode() {
+  // Small batches spread over several parser threads are still written in input order.
+  int exitStatus;
+  std::vector<std::string> lines = runAnalyze(std::string("--mode=encodings --profile=lp64 --threads=3 --batch-lines=2 --max-line-length=30 ") + kInputPath, &exitStatus);
+  EXPECT_EQ(0, exitStatus);
+  expectLines({
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":1,\"encoding\":\"{CGPoint=dd}\",\"status\":0,\"category\":\"struct\",\"name\":\"CGPoint\",\"size\":16,\"alignment\":8}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":2,\"encoding\":\"i\",\"status\":0,\"category\":\"int\",\"size\":4,\"alignment\":4}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":3,\"encoding\":\"{Bad=i}}x\",\"status\":0,\"unexpectedTokens\":2,\"category\":\"struct\",\"name\":\"Bad\",\"size\":4,\"alignment\":4}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":5,\"encoding\":\"[4{Pair=^ii}]\",\"status\":0,\"category\":\"array\",\"size\":64,\"alignment\":8}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":6,\"status\":-4}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":7,\"encoding\":\"{L=iiiiiiiiiiiiiiiiiiii}\",\"status\":0,\"category\":\"struct\",\"name\":\"L\",\"size\":80,\"alignment\":4}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":8,\"encoding\":\"{Small=c}\",\"status\":0,\"category\":\"struct\",\"name\":\"Small\",\"size\":1,\"alignment\":1}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":9,\"encoding\":\"{CGPoint=dd}\",\"status\":0,\"category\":\"struct\",\"name\":\"CGPoint\",\"size\":16,\"alignment\":8}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":10,\"encoding\":\"{Mid=dddd}\",\"status\":0,\"category\":\"struct\",\"name\":\"Mid\",\"size\":32,\"alignment\":8}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":11,\"encoding\":\"}}\",\"status\":0,\"unexpectedTokens\":2,\"category\":\"topLevel\",\"size\":0,\"alignment\":1}",
+    "{\"source\":\"objctk-analyze-test-input.txt\",\"line\":12,\"encoding\":\"(U=ic)\",\"status\":0,\"category\":\"union\",\"name\":\"U\",\"size\":4,\"alignment\":4}",
+  }, lines);
+}
+
+static void testSummaryMode() {
+  // The two encodings with unexpected tokens are failed and the overlong line is counted apart.
+  // Small is rejected by its size once the list is full, the repeated CGPoint is not a distinct
+  // struct, and Mid replaces CGPoint as the smallest entry.
+  int exitStatus;
+  std::vector<std::string> lines = runAnalyze(std::string("--profile=lp64 --threads=3 --batch-lines=2 --max-line-length=30 --largest-structs=2 ") + kInputPath, &exitStatus);
+  EXPECT_EQ(0, exitStatus);
+  expectLines({
+    "{\"kind\":\"summary\",\"encodings\":11,\"failed\":2,\"overlong\":1,\"bytes\":98,\"distinctEncodingsEstimate\":9}",
+    "{\"kind\":\"category\",\"category\":\"int\",\"count\":1}",
+    "{\"kind\":\"category\",\"category\":\"array\",\"count\":1}",
+    "{\"kind\":\"category\",\"category\":\"struct\",\"count\":5}",
+    "{\"kind\":\"category\",\"category\":\"union\",\"count\":1}",
+    "{\"kind\":\"largestStruct\",\"rank\":1,\"source\":\"objctk-analyze-test-input.txt\",\"line\":7,\"name\":\"L\",\"size\":80,\"encoding\":\"{L=iiiiiiiiiiiiiiiiiiii}\"}",
+    "{\"kind\":\"largestStruct\",\"rank\":2,\"source\":\"objctk-analyze-test-input.txt\",\"line\":10,\"name\":\"Mid\",\"size\":32,\"encoding\":\"{Mid=dddd}\"}",
+  }, lines);
+}
+
+static void testFailedLines() {
+  // Failed lines accumulate across inputs, and a missing input fails the run without losing the
+  // summary of the inputs which were read.
+  int exitStatus;
+  std::vector<std::string> lines = runAnalyze(std::string("--threads=1 --largest-structs=0 ") + kInputPath + " objctk-analyze-test-missing.txt " + kInputPath, &exitStatus);
+  EXPECT_EQ(1, exitStatus);
+  EXPECT(!lines.empty());
+  if (!lines.empty()) {
+    EXPECT(lines[0] == "{\"kind\":\"summary\",\"encodings\":22,\"failed\":4,\"overlong\":0,\"bytes\":260,\"distinctEncodingsEstimate\":10}");
+  }
+  for (const std::string &line : lines) {
+    EXPECT(line.find("largestStruct") == std::string::npos);
+  }
+
+  // Unknown options are rejected without reading any input.
+  lines = runAnalyze("--mode=unknown", &exitStatus);
+  EXPECT_EQ(2, exitStatus);
+  EXPECT(lines.empty());
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: objctk-analyze-test <path to objctk-analyze>\n");
+    return EXIT_FAILURE;
+  }
+  gAnalyzePath = argv[1];
+  if (!writeInput()) {
+    fprintf(stderr, "unable to write %s\n", kInputPath);
+    return EXIT_FAILURE;
+  }
+  testEncodingsMode();
+  testSummaryMode();
+  testFailedLines();
+  remove(kInputPath);
+  return testResult();
+}
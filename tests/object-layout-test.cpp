@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <string.h>
+#include <vector>
+
+static objctk_objectlayout createObjectLayout(const char *typeEncoding, objctk_typeparseresult *outParseResult) {
+  *outParseResult = objctk_parseTypeEncoding(typeEncoding);
+  return objctk_objectlayout_create(objctk_typeparseresult_getParsedType(*outParseResult), objctk_layoutprofile_LP64);
+}
+
+static void expectRuns(const char *typeEncoding, const std::vector<objctk_objectlayoutrun> &expectedRuns) {
+  objctk_typeparseresult parseResult;
+  objctk_objectlayout layout = createObjectLayout(typeEncoding, &parseResult);
+  EXPECT(layout != NULL);
+  size_t runCount = 0;
+  const objctk_objectlayoutrun *runs = objctk_objectlayout_getRuns(layout, &runCount);
+  EXPECT_EQ(expectedRuns.size(), runCount);
+  for (size_t index = 0; (index < runCount) && (index < expectedRuns.size()); index++) {
+    EXPECT_EQ(expectedRuns[index].offset, runs[index].offset);
+    EXPECT_EQ(expectedRuns[index].count, runs[index].count);
+    EXPECT_EQ(expectedRuns[index].stride, runs[index].stride);
+  }
+  objctk_objectlayout_release(layout);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testRuns() {
+  expectRuns("@", { { 0, 1, 8 } });
+  expectRuns("{x=@@i@}", { { 0, 2, 8 }, { 24, 1, 8 } });
+  expectRuns("[4@]", { { 0, 4, 8 } });
+  expectRuns("[0@]", {});
+  expectRuns("{x=[2@]#}", { { 0, 3, 8 } });
+}
+
+static void testArraysOfStructsUseStridedRuns() {
+  expectRuns("[1000{x=@i}]", { { 0, 1000, 16 } });
+  expectRuns("[1000000{x=@i}]", { { 0, 1000000, 16 } });
+  expectRuns("[3{x=@@i}]", { { 0, 3, 24 }, { 8, 3, 24 } });
+  expectRuns("[2{x=[8@]i}]", { { 0, 8, 8 }, { 72, 8, 8 } });
+  expectRuns("[1000{x=@i@}]", { { 0, 1000, 24 }, { 16, 1000, 24 } });
+  expectRuns("[1000{x=[8@]i}]", { { 0, 1000, 72 }, { 8, 1000, 72 }, { 16, 1000, 72 }, { 24, 1000, 72 }, { 32, 1000, 72 }, { 40, 1000, 72 }, { 48, 1000, 72 }, { 56, 1000, 72 } });
+  expectRuns("[10[10{x=@i}]]", { { 0, 100, 16 } });
+  expectRuns("{y=i[4{x=@i}]}", { { 8, 4, 16 } });
+}
+
+static void testUnalignedReferencesAreRejected() {
+  objctk_typeparseresult parseResult;
+  objctk_objectlayout layout = createObjectLayout("c@", &parseResult);
+  EXPECT(layout == NULL);
+  objctk_typeparseresult_release(parseResult);
+
+  layout = createObjectLayout("q@", &parseResult);
+  EXPECT(layout != NULL);
+  objctk_objectlayout_release(layout);
+  objctk_typeparseresult_release(parseResult);
+}
+
+struct scanContext {
+  size_t offsetSum;
+  uint64_t referenceSum;
+};
+
+static void recordReference(size_t valueIndex, size_t offset, uint64_t reference, void *context) {
+  scanContext *scan = static_cast<scanContext *>(context);
+  scan->offsetSum += (valueIndex * 1000) + offset;
+  scan->referenceSum += reference;
+}
+
+static void testScanningStridedRuns() {
+  objctk_typeparseresult parseResult;
+  objctk_objectlayout layout = createObjectLayout("[9{x=@i}]", &parseResult);
+  EXPECT(layout != NULL);
+  EXPECT_EQ(144, objctk_objectlayout_getValueSize(layout));
+
+  // Populate the references of a few elements of two values, with nonzero integers between them.
+  std::vector<uint64_t> values(2 * 144 / sizeof(uint64_t), 0);
+  for (size_t index = 1; index < values.size(); index += 2) {
+    values[index] = 0xFFFFFFFF;
+  }
+  values[0] = 1;
+  values[10] = 2;
+  values[16] = 3;
+  values[18 + 14] = 4;
+  scanContext scan = { 0, 0 };
+  size_t referenceCount = objctk_objectlayout_scanValues(layout, values.data(), 2, recordReference, &scan);
+  EXPECT_EQ(4, referenceCount);
+  EXPECT_EQ(10, scan.referenceSum);
+  EXPECT_EQ(0 + 80 + 128 + 1000 + 112, scan.offsetSum);
+
+  size_t slotCount = 0;
+  const uint8_t *bitmap = objctk_objectlayout_getBitmap(layout, &slotCount);
+  EXPECT_EQ(18, slotCount);
+  EXPECT_EQ(0x55, bitmap[0]);
+  EXPECT_EQ(0x55, bitmap[1]);
+  EXPECT_EQ(0x01, bitmap[2]);
+  objctk_objectlayout_release(layout);
+  objctk_typeparseresult_release(parseResult);
+}
+
+int main() {
+  testRuns();
+  testArraysOfStructsUseStridedRuns();
+  testUnalignedReferencesAreRejected();
+  testScanningStridedRuns();
+  return testResult();
+}
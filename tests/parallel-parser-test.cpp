@@ -0,0 +1,97 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace objctk;
+
+static std::string largeStructEncoding(const unsigned int memberCount) {
+  std::string encoding = "{Large=";
+  for (unsigned int index = 0; index < memberCount; index++) {
+    const std::string suffix = std::to_string(index % 37);
+    switch (index % 4) {
+      case 0: encoding += "{Point" + suffix + "=dd}"; break;
+      case 1: encoding += "^{Node" + suffix + "=^v}^{Opaque" + suffix + "}"; break;
+      case 2: encoding += "[4(Value" + suffix + "=iq)]"; break;
+      default: encoding += "@\"NSString\"i"; break;
+    }
+  }
+  return encoding + "}";
+}
+
+static bool parsesLikeSerialParse(const std::string &encoding, const unsigned int threadCount) {
+  objctk_typeparseresult serialResult = objctk_parseTypeEncoding(encoding.c_str());
+  objctk_typeparseresult parallelResult = objctk_parseTypeEncodingInParallel(encoding.c_str(), threadCount, NULL);
+  objctk_typenode serialType = objctk_typeparseresult_getParsedType(serialResult);
+  objctk_typenode parallelType = objctk_typeparseresult_getParsedType(parallelResult);
+  const bool isEqual = (serialType != NULL) && areStructurallyEqualTypeNodes(serialType, parallelType) &&
+      (objctk_typeparseresult_getStatusCode(parallelResult) == objctk_statuscode_NoError);
+  objctk_typeparseresult_release(parallelResult);
+  objctk_typeparseresult_release(serialResult);
+  return isEqual;
+}
+
+static void testParallelParsesMatchSerialParses() {
+  // Encodings of at least 16 KiB are divided among threads.
+  const std::string encoding = largeStructEncoding(4000);
+  EXPECT(encoding.size() > (16 * 1024));
+  for (unsigned int threadCount : { 0u, 1u, 2u, 3u, 8u, 1000u }) {
+    EXPECT(parsesLikeSerialParse(encoding, threadCount));
+  }
+  EXPECT(parsesLikeSerialParse(largeStructEncoding(10), 4));
+}
+
+static void testWorkersAreSharedByConcurrentParses() {
+  const std::string encoding = largeStructEncoding(2000);
+  std::atomic<int> mismatchCount(0);
+  std::vector<std::thread> threads;
+  for (int threadIndex = 0; threadIndex < 4; threadIndex++) {
+    threads.emplace_back([&]() {
+      for (int iteration = 0; iteration < 25; iteration++) {
+        if (!parsesLikeSerialParse(encoding, 4)) {
+          ++mismatchCount;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatchCount.load());
+}
+
+int main() {
+  testParallelParsesMatchSerialParses();
+  testWorkersAreSharedByConcurrentParses();
+  return testResult();
+}
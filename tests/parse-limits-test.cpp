@@ -0,0 +1,174 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include "test.h"
+
+#include <string>
+
+using namespace objctk;
+
+// Encodings built to exhaust a parser which trusts its input: deep nesting, huge tokens, huge
+// element counts and long runs of unexpected tokens.
+static std::string repeated(const std::string &prefix, const std::string &unit, const size_t count, const std::string &suffix) {
+  std::string encoding = prefix;
+  encoding.reserve(prefix.size() + (unit.size() * count) + suffix.size());
+  for (size_t index = 0; index < count; index++) {
+    encoding += unit;
+  }
+  return encoding + suffix;
+}
+
+static std::string largeStructEncoding(const unsigned int memberCount) {
+  return repeated("{Large=", "{Point=dd}^{Opaque}[4(Value=iq)]@\"NSString\"i", memberCount, "}");
+}
+
+static objctk_statuscode serialParseStatus(const std::string &encoding, const objctk_parselimits *limits) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncodingWithLimits(encoding.c_str(), limits, NULL);
+  const objctk_statuscode statusCode = objctk_typeparseresult_getStatusCode(parseResult);
+  EXPECT((statusCode == objctk_statuscode_NoError) == (objctk_typeparseresult_getParsedType(parseResult) != NULL));
+  objctk_typeparseresult_release(parseResult);
+  return statusCode;
+}
+
+static objctk_statuscode parallelParseStatus(const std::string &encoding, const objctk_parselimits *limits) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncodingInParallelWithLimits(encoding.c_str(), 4, limits, NULL);
+  const objctk_statuscode statusCode = objctk_typeparseresult_getStatusCode(parseResult);
+  EXPECT((statusCode == objctk_statuscode_NoError) == (objctk_typeparseresult_getParsedType(parseResult) != NULL));
+  objctk_typeparseresult_release(parseResult);
+  return statusCode;
+}
+
+static void testAdversarialEncodingsFailWithoutLimits() {
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("", "^", 100000, "i"), NULL));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("", "{A=", 100000, ""), NULL));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("", "[1", 100000, ""), NULL));
+
+  // Element counts beyond the range of the element count are parsed without overflowing.
+  EXPECT_EQ(objctk_statuscode_NoError, serialParseStatus("[18446744073709551615i]", NULL));
+  EXPECT_EQ(objctk_statuscode_NoError, serialParseStatus("[99999999999999999999999999{Huge=dd}]", NULL));
+
+  // A huge type name is a single token.
+  EXPECT_EQ(objctk_statuscode_NoError, serialParseStatus(repeated("{", "A", 1 << 20, "=i}"), NULL));
+
+  // An unexpected token of 20 MB is skipped and logged without being copied onto the stack.
+  EXPECT_EQ(objctk_statuscode_NoError, serialParseStatus(repeated("[1i{", "A", 20 << 20, ""), NULL));
+}
+
+static void testAdversarialEncodingsFailWithinLimits() {
+  objctk_parselimits limits = {
+    .maximumInputLength = 4096,
+    .maximumDepth = 16,
+    .maximumNodeCount = 1024,
+    .maximumByteCount = 64 * 1024,
+    .maximumNanoseconds = 0,
+  };
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("", "^", 1000, "i"), &limits));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("", "{A=", 1000, ""), &limits));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("{", "A", 1 << 20, "=i}"), &limits));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("[1i{", "A", 20 << 20, ""), &limits));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(repeated("{S=", "i", 2000, "}"), &limits));
+  EXPECT_EQ(objctk_statuscode_NoError, serialParseStatus(repeated("{S=", "i", 200, "}"), &limits));
+}
+
+static void testParallelParsesApplyLimits() {
+  const std::string encoding = largeStructEncoding(1000);
+  EXPECT_EQ(objctk_statuscode_NoError, parallelParseStatus(encoding, NULL));
+
+  objctk_parselimits limits = {
+    .maximumInputLength = 0,
+    .maximumDepth = 0,
+    .maximumNodeCount = 0,
+    .maximumByteCount = 0,
+    .maximumNanoseconds = 0,
+  };
+  EXPECT_EQ(objctk_statuscode_NoError, parallelParseStatus(encoding, &limits));
+
+  limits.maximumInputLength = encoding.size() - 1;
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, parallelParseStatus(encoding, &limits));
+  limits.maximumInputLength = encoding.size();
+  EXPECT_EQ(objctk_statuscode_NoError, parallelParseStatus(encoding, &limits));
+
+  // The members of every chunk fit within the limits while all the members together do not.
+  objctk_typeparseresult serialResult = objctk_parseTypeEncoding(encoding.c_str());
+  objctk_typeparseresult parallelResult = objctk_parseTypeEncodingInParallel(encoding.c_str(), 4, NULL);
+  EXPECT(areStructurallyEqualTypeNodes(objctk_typeparseresult_getParsedType(serialResult), objctk_typeparseresult_getParsedType(parallelResult)));
+  objctk_typeparseresult_release(parallelResult);
+  objctk_typeparseresult_release(serialResult);
+  limits.maximumNodeCount = 1000 * 4;
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(encoding, &limits));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, parallelParseStatus(encoding, &limits));
+  limits.maximumNodeCount = 0;
+  limits.maximumByteCount = 4096;
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(encoding, &limits));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, parallelParseStatus(encoding, &limits));
+  limits.maximumByteCount = 0;
+
+  // The members are nested within the outermost struct.
+  limits.maximumDepth = 2;
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, serialParseStatus(encoding, &limits));
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, parallelParseStatus(encoding, &limits));
+  limits.maximumDepth = 4;
+  EXPECT_EQ(objctk_statuscode_NoError, parallelParseStatus(encoding, &limits));
+}
+
+static void testUnexpectedTokensAreCounted() {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding("{CGPoint=dd}");
+  EXPECT_EQ(0, objctk_typeparseresult_getUnexpectedTokenCount(parseResult));
+  objctk_typeparseresult_release(parseResult);
+
+  // Malformed encodings are parsed leniently.
+  parseResult = objctk_parseTypeEncoding("[1i{AAA");
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+  EXPECT_EQ(1, objctk_typeparseresult_getUnexpectedTokenCount(parseResult));
+  objctk_typeparseresult_release(parseResult);
+
+  // Parsers reset the count between parses.
+  objctk_parser parser = objctk_parser_create();
+  EXPECT_EQ(1, objctk_typeparseresult_getUnexpectedTokenCount(objctk_parser_parseTypeEncoding(parser, "[1i{AAA")));
+  EXPECT_EQ(0, objctk_typeparseresult_getUnexpectedTokenCount(objctk_parser_parseTypeEncoding(parser, "[1i]")));
+  objctk_parser_release(parser);
+
+  // Duplicates within a batch share the count along with the type tree.
+  const char *typeEncodings[] = { "[1i{AAA", "[1i{AAA", "i" };
+  objctk_typeparseresult parseResults[3];
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_parseTypeEncodingBatch(typeEncodings, 3, parseResults, NULL));
+  EXPECT_EQ(1, objctk_typeparseresult_getUnexpectedTokenCount(parseResults[0]));
+  EXPECT_EQ(1, objctk_typeparseresult_getUnexpectedTokenCount(parseResults[1]));
+  EXPECT_EQ(0, objctk_typeparseresult_getUnexpectedTokenCount(parseResults[2]));
+  for (objctk_typeparseresult batchParseResult : parseResults) {
+    objctk_typeparseresult_release(batchParseResult);
+  }
+}
+
+int main() {
+  testAdversarialEncodingsFailWithoutLimits();
+  testAdversarialEncodingsFailWithinLimits();
+  testParallelParsesApplyLimits();
+  testUnexpectedTokensAreCounted();
+  return testResult();
+}
@@ -0,0 +1,145 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Retains, reads and releases parse results from many threads at once. The races this guards
+// against are only reported reliably when the test is built with -fsanitize=thread.
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int kThreadCount = 8;
+static const int kIterationCount = 2000;
+
+static const char *const kTypeEncoding = "{Outer={CGPoint=dd}^{Node=^{Node}i}[4(Value=iq)]@\"NSString\"}";
+
+// Reads the type tree of a parse result as a caller sharing it would.
+static uint64_t readParsedType(objctk_typeparseresult parseResult) {
+  objctk_typenode node = objctk_typeparseresult_getParsedType(parseResult);
+  return objctk_typenode_getStructuralHash(node) ^ (uint64_t)objctk_typenode_getTypeSize(node) ^ (uint64_t)(objctk_typenode_getName(node) != NULL);
+}
+
+static void testSharedParseResults() {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(kTypeEncoding);
+  const uint64_t expectedValue = readParsedType(parseResult);
+  std::atomic<int> mismatchCount(0);
+  std::vector<std::thread> threads;
+  for (int threadIndex = 0; threadIndex < kThreadCount; threadIndex++) {
+    objctk_typeparseresult_retain(parseResult);
+    threads.emplace_back([&, parseResult]() {
+      for (int iteration = 0; iteration < kIterationCount; iteration++) {
+        objctk_typeparseresult retainedResult = objctk_typeparseresult_retain(parseResult);
+        if (readParsedType(retainedResult) != expectedValue) {
+          mismatchCount++;
+        }
+        objctk_typeparseresult_release(retainedResult);
+      }
+      // Each thread drops the reference it was handed, so the last thread to finish frees the parse
+      // result once the main thread has dropped its own.
+      objctk_typeparseresult_release(parseResult);
+    });
+  }
+  objctk_typeparseresult_release(parseResult);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatchCount.load());
+}
+
+static void testParserOwnedResultsReleasedElsewhere() {
+  // Parse results retained from a parser are released by other threads while the parser goes on to
+  // reuse or replace them.
+  std::atomic<objctk_typeparseresult> handoff(NULL);
+  std::atomic<bool> isParsing(true);
+  std::atomic<int> mismatchCount(0);
+  std::thread releasingThread([&]() {
+    while (isParsing.load() || (handoff.load() != NULL)) {
+      objctk_typeparseresult parseResult = handoff.exchange(NULL);
+      if (parseResult == NULL) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (objctk_typeparseresult_getParsedType(parseResult) == NULL) {
+        mismatchCount++;
+      }
+      objctk_typeparseresult_release(parseResult);
+    }
+  });
+
+  objctk_parser parser = objctk_parser_create();
+  for (int iteration = 0; iteration < (kThreadCount * kIterationCount); iteration++) {
+    objctk_typeparseresult parseResult = objctk_parser_parseTypeEncoding(parser, (iteration % 2 == 0) ? kTypeEncoding : "{CGSize=dd}");
+    if ((iteration % 3) != 0) {
+      continue;
+    }
+    objctk_typeparseresult retainedResult = objctk_typeparseresult_retain(parseResult);
+    objctk_typeparseresult previousResult = handoff.exchange(retainedResult);
+    objctk_typeparseresult_release(previousResult);
+  }
+  objctk_parser_release(parser);
+  isParsing = false;
+  releasingThread.join();
+  EXPECT_EQ(0, mismatchCount.load());
+}
+
+static void testBatchPrefixChainsReleasedConcurrently() {
+  // The parse results of a batch share prefix types along a chain, and releasing them from several
+  // threads at once must free each exactly once.
+  std::vector<std::string> typeEncodings;
+  for (int index = 0; index < 64; index++) {
+    typeEncodings.push_back("v24@0:8" + std::string(index % 8, 'i') + "{S" + std::to_string(index) + "=q}");
+    typeEncodings.push_back(typeEncodings.back());
+  }
+  std::vector<const char *> typeEncodingPointers;
+  for (const std::string &typeEncoding : typeEncodings) {
+    typeEncodingPointers.push_back(typeEncoding.c_str());
+  }
+  for (int iteration = 0; iteration < 50; iteration++) {
+    std::vector<objctk_typeparseresult> parseResults(typeEncodings.size());
+    EXPECT_EQ(objctk_statuscode_NoError, objctk_parseTypeEncodingBatch(typeEncodingPointers.data(), typeEncodingPointers.size(), parseResults.data(), NULL));
+    std::vector<std::thread> threads;
+    for (int threadIndex = 0; threadIndex < kThreadCount; threadIndex++) {
+      threads.emplace_back([&, threadIndex]() {
+        for (size_t index = threadIndex; index < parseResults.size(); index += kThreadCount) {
+          objctk_typeparseresult_release(parseResults[index]);
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+int main() {
+  testSharedParseResults();
+  testParserOwnedResultsReleasedElsewhere();
+  testBatchPrefixChainsReleasedConcurrently();
+  return testResult();
+}
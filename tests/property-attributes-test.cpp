@@ -0,0 +1,175 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <limits.h>
+#include <string.h>
+#include <string>
+
+static std::string rangeString(const char *attributes, const objctk_range range) {
+  if ((range.offset == UINT_MAX) && (range.length == UINT_MAX)) {
+    return "<absent>";
+  }
+  return std::string(attributes + range.offset, range.length);
+}
+
+static void testQuotedClassNamesContainingCommas() {
+  const char *attributes = "T@\"NSDictionary<NSString *, id>\",&,N,V_map";
+  objctk_propertyattributes propertyAttributes;
+  objctk_typeparseresult parseResult = objctk_parsePropertyAttributes(attributes, &propertyAttributes, NULL);
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+  EXPECT(propertyAttributes.type == objctk_typeparseresult_getParsedType(parseResult));
+  EXPECT_EQ(OBJCTKTypeCategoryObject, objctk_typenode_getTypeCategory(propertyAttributes.type));
+  EXPECT(rangeString(attributes, propertyAttributes.typeEncodingRange) == "@\"NSDictionary<NSString *, id>\"");
+  EXPECT(rangeString(attributes, objctk_typenode_getNameRange(propertyAttributes.type)) == "NSDictionary<NSString *, id>");
+  EXPECT_EQ(objctk_propertyownership_Retain, propertyAttributes.ownership);
+  EXPECT(propertyAttributes.isNonatomic);
+  EXPECT(!propertyAttributes.isReadOnly);
+  EXPECT(rangeString(attributes, propertyAttributes.instanceVariableNameRange) == "_map");
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testNameRanges() {
+  const char *attributes = "Tc,GisEnabled,SsetEnabled:,V_enabled";
+  objctk_propertyattributes propertyAttributes;
+  objctk_typeparseresult parseResult = objctk_parsePropertyAttributes(attributes, &propertyAttributes, NULL);
+  EXPECT_EQ(OBJCTKTypeCategorySignedChar, objctk_typenode_getTypeCategory(propertyAttributes.type));
+  EXPECT(rangeString(attributes, propertyAttributes.getterNameRange) == "isEnabled");
+  EXPECT(rangeString(attributes, propertyAttributes.setterNameRange) == "setEnabled:");
+  EXPECT(rangeString(attributes, propertyAttributes.instanceVariableNameRange) == "_enabled");
+  objctk_typeparseresult_release(parseResult);
+
+  // Names which are not specified are absent rather than empty.
+  attributes = "Ti,R,V";
+  parseResult = objctk_parsePropertyAttributes(attributes, &propertyAttributes, NULL);
+  EXPECT(rangeString(attributes, propertyAttributes.getterNameRange) == "<absent>");
+  EXPECT(rangeString(attributes, propertyAttributes.setterNameRange) == "<absent>");
+  EXPECT(rangeString(attributes, propertyAttributes.instanceVariableNameRange) == "");
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testFlags() {
+  objctk_propertyattributes propertyAttributes;
+  objctk_typeparseresult parseResult = objctk_parsePropertyAttributes("T@,R,C,N,D", &propertyAttributes, NULL);
+  EXPECT(propertyAttributes.isReadOnly);
+  EXPECT(propertyAttributes.isNonatomic);
+  EXPECT(propertyAttributes.isDynamic);
+  EXPECT_EQ(objctk_propertyownership_Copy, propertyAttributes.ownership);
+  objctk_typeparseresult_release(parseResult);
+
+  parseResult = objctk_parsePropertyAttributes("T@\"NSObject\",W", &propertyAttributes, NULL);
+  EXPECT_EQ(objctk_propertyownership_Weak, propertyAttributes.ownership);
+  EXPECT(!propertyAttributes.isReadOnly);
+  EXPECT(!propertyAttributes.isNonatomic);
+  EXPECT(!propertyAttributes.isDynamic);
+  objctk_typeparseresult_release(parseResult);
+
+  parseResult = objctk_parsePropertyAttributes("Tq", &propertyAttributes, NULL);
+  EXPECT_EQ(objctk_propertyownership_Assign, propertyAttributes.ownership);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testBlocks() {
+  const char *attributes = "T@?,C,N,V_completionHandler";
+  objctk_propertyattributes propertyAttributes;
+  objctk_typeparseresult parseResult = objctk_parsePropertyAttributes(attributes, &propertyAttributes, NULL);
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+  EXPECT_EQ(0, objctk_typeparseresult_getUnexpectedTokenCount(parseResult));
+  EXPECT_EQ(OBJCTKTypeCategoryObject, objctk_typenode_getTypeCategory(propertyAttributes.type));
+  EXPECT(rangeString(attributes, objctk_typenode_getRange(propertyAttributes.type)) == "@?");
+  EXPECT(objctk_typenode_getName(propertyAttributes.type) == NULL);
+  EXPECT_EQ(objctk_propertyownership_Copy, propertyAttributes.ownership);
+  EXPECT(rangeString(attributes, propertyAttributes.instanceVariableNameRange) == "_completionHandler");
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testMalformedAttributes() {
+  objctk_propertyattributes propertyAttributes;
+  EXPECT(objctk_parsePropertyAttributes(NULL, &propertyAttributes, NULL) == NULL);
+  EXPECT(objctk_parsePropertyAttributes("Ti", NULL, NULL) == NULL);
+
+  // Attribute strings without a type attribute have no type.
+  const char *attributesWithoutTypes[] = { "", ",,,", "R,N", "X,Y,Z" };
+  for (const char *attributes : attributesWithoutTypes) {
+    objctk_typeparseresult parseResult = objctk_parsePropertyAttributes(attributes, &propertyAttributes, NULL);
+    EXPECT(parseResult != NULL);
+    EXPECT(propertyAttributes.type == NULL);
+    EXPECT_EQ(UINT_MAX, propertyAttributes.typeEncodingRange.offset);
+    objctk_typeparseresult_release(parseResult);
+  }
+
+  // The parser is lenient, so an empty type is an empty top-level type and an incomplete struct is
+  // parsed as far as it goes, without affecting the other attributes.
+  objctk_typeparseresult parseResult = objctk_parsePropertyAttributes("T,N", &propertyAttributes, NULL);
+  EXPECT_EQ(OBJCTKTypeCategoryTopLevel, objctk_typenode_getTypeCategory(propertyAttributes.type));
+  EXPECT_EQ(0, propertyAttributes.typeEncodingRange.length);
+  EXPECT(propertyAttributes.isNonatomic);
+  objctk_typeparseresult_release(parseResult);
+  parseResult = objctk_parsePropertyAttributes("T{S=i,N", &propertyAttributes, NULL);
+  EXPECT_EQ(OBJCTKTypeCategoryStruct, objctk_typenode_getTypeCategory(propertyAttributes.type));
+  EXPECT(propertyAttributes.isNonatomic);
+  objctk_typeparseresult_release(parseResult);
+
+  // An unterminated class name extends the type attribute to the end of the string.
+  const char *attributes = "T@\"NSString,N";
+  parseResult = objctk_parsePropertyAttributes(attributes, &propertyAttributes, NULL);
+  EXPECT(rangeString(attributes, propertyAttributes.typeEncodingRange) == "@\"NSString,N");
+  EXPECT(!propertyAttributes.isNonatomic);
+  objctk_typeparseresult_release(parseResult);
+
+  // Unknown attributes and trailing commas are ignored.
+  parseResult = objctk_parsePropertyAttributes("Ti,X,Pfoo,N,", &propertyAttributes, NULL);
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+  EXPECT_EQ(OBJCTKTypeCategorySignedInt, objctk_typenode_getTypeCategory(propertyAttributes.type));
+  EXPECT(propertyAttributes.isNonatomic);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testParserLimits() {
+  objctk_parser parser = objctk_parser_create();
+  objctk_parselimits limits;
+  memset(&limits, 0, sizeof(limits));
+  limits.maximumNodeCount = 2;
+  objctk_parser_setLimits(parser, &limits);
+  objctk_propertyattributes propertyAttributes;
+  objctk_typeparseresult parseResult = objctk_parser_parsePropertyAttributes(parser, "T{S=iii},R", &propertyAttributes);
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, objctk_typeparseresult_getStatusCode(parseResult));
+  EXPECT(propertyAttributes.isReadOnly);
+  parseResult = objctk_parser_parsePropertyAttributes(parser, "Ti,R", &propertyAttributes);
+  EXPECT_EQ(objctk_statuscode_NoError, objctk_typeparseresult_getStatusCode(parseResult));
+  objctk_parser_release(parser);
+}
+
+int main() {
+  testQuotedClassNamesContainingCommas();
+  testNameRanges();
+  testFlags();
+  testBlocks();
+  testMalformedAttributes();
+  testParserLimits();
+  return testResult();
+}
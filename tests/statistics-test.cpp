@@ -0,0 +1,286 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// The encodings parsed by the tests along with the tokens and type nodes each parse produces. The
+// token counts include the end of the input.
+typedef struct objctk_expectedparse {
+  const char *typeEncoding;
+  uint64_t tokenCount;
+  uint64_t nodeCount;
+} objctk_expectedparse;
+
+static const objctk_expectedparse kExpectedParses[] = {
+  { "i", 2, 1 },
+  { "{CGPoint=dd}", 5, 3 },
+  { "[4{Pair=^ii}]", 8, 5 },
+  { "^^^i", 5, 4 },
+  { "", 1, 1 },
+};
+
+static const size_t kExpectedParseCount = sizeof(kExpectedParses) / sizeof(kExpectedParses[0]);
+
+static unsigned int histogramBucketIndex(uint64_t value) {
+  unsigned int bucketIndex = 0;
+  while ((value != 0) && (bucketIndex < (OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT - 1))) {
+    value >>= 1;
+    bucketIndex++;
+  }
+  return bucketIndex;
+}
+
+static uint64_t histogramSampleCount(const uint64_t *histogram) {
+  uint64_t sampleCount = 0;
+  for (unsigned int bucketIndex = 0; bucketIndex < OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT; bucketIndex++) {
+    sampleCount += histogram[bucketIndex];
+  }
+  return sampleCount;
+}
+
+static bool isZeroStatistics(const objctk_statistics *statistics) {
+  objctk_statistics zeroStatistics;
+  memset(&zeroStatistics, 0, sizeof(objctk_statistics));
+  return memcmp(statistics, &zeroStatistics, sizeof(objctk_statistics)) == 0;
+}
+
+static objctk_statistics currentStatistics() {
+  objctk_statistics statistics;
+  objctk_getStatistics(&statistics);
+  return statistics;
+}
+
+static void parseAndRelease(const char *typeEncoding) {
+  objctk_typeparseresult parseResult = objctk_parseTypeEncoding(typeEncoding);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testDisabledStatistics() {
+  objctk_setStatisticsEnabled(false);
+  objctk_resetStatistics();
+  EXPECT(!objctk_isStatisticsEnabled());
+  parseAndRelease("{CGPoint=dd}");
+  objctk_statistics statistics = currentStatistics();
+  EXPECT(isZeroStatistics(&statistics));
+
+  // A NULL snapshot is ignored.
+  objctk_getStatistics(NULL);
+}
+
+static void testSingleParseCounters() {
+  objctk_setStatisticsEnabled(true);
+  EXPECT(objctk_isStatisticsEnabled());
+  for (size_t index = 0; index < kExpectedParseCount; index++) {
+    const objctk_expectedparse *expectedParse = &kExpectedParses[index];
+    objctk_resetStatistics();
+    parseAndRelease(expectedParse->typeEncoding);
+
+    objctk_statistics statistics = currentStatistics();
+    EXPECT_EQ(1, statistics.parseCount);
+    EXPECT_EQ(0, statistics.failedParseCount);
+    EXPECT_EQ(strlen(expectedParse->typeEncoding), statistics.inputByteCount);
+    EXPECT_EQ(expectedParse->tokenCount, statistics.tokenCount);
+    EXPECT_EQ(expectedParse->nodeCount, statistics.nodeCount);
+    EXPECT(statistics.retainedByteCount > 0);
+
+    // A single parse lands in exactly one bucket of each histogram.
+    EXPECT_EQ(1, statistics.nodeCountHistogram[histogramBucketIndex(expectedParse->nodeCount)]);
+    EXPECT_EQ(1, histogramSampleCount(statistics.nodeCountHistogram));
+    EXPECT_EQ(1, statistics.retainedByteHistogram[histogramBucketIndex(statistics.retainedByteCount)]);
+    EXPECT_EQ(1, histogramSampleCount(statistics.retainedByteHistogram));
+    EXPECT_EQ(1, statistics.parseLatencyHistogram[histogramBucketIndex(statistics.parseNanoseconds)]);
+    EXPECT_EQ(1, histogramSampleCount(statistics.parseLatencyHistogram));
+  }
+}
+
+static void testHistogramBuckets() {
+  objctk_setStatisticsEnabled(true);
+  objctk_resetStatistics();
+  uint64_t nodeCount = 0;
+  uint64_t expectedNodeCountHistogram[OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT] = { 0 };
+  for (size_t index = 0; index < kExpectedParseCount; index++) {
+    parseAndRelease(kExpectedParses[index].typeEncoding);
+    nodeCount += kExpectedParses[index].nodeCount;
+    expectedNodeCountHistogram[histogramBucketIndex(kExpectedParses[index].nodeCount)]++;
+  }
+
+  // Node counts of 1, 3, 5, 4 and 1 fill the buckets [1, 2), [2, 4) and [4, 8).
+  objctk_statistics statistics = currentStatistics();
+  EXPECT_EQ(kExpectedParseCount, statistics.parseCount);
+  EXPECT_EQ(nodeCount, statistics.nodeCount);
+  EXPECT_EQ(0, statistics.nodeCountHistogram[0]);
+  EXPECT_EQ(2, statistics.nodeCountHistogram[1]);
+  EXPECT_EQ(1, statistics.nodeCountHistogram[2]);
+  EXPECT_EQ(2, statistics.nodeCountHistogram[3]);
+  for (unsigned int bucketIndex = 0; bucketIndex < OBJCTK_STATISTICS_HISTOGRAM_BUCKET_COUNT; bucketIndex++) {
+    EXPECT_EQ(expectedNodeCountHistogram[bucketIndex], statistics.nodeCountHistogram[bucketIndex]);
+  }
+  EXPECT_EQ(kExpectedParseCount, histogramSampleCount(statistics.retainedByteHistogram));
+  EXPECT_EQ(kExpectedParseCount, histogramSampleCount(statistics.parseLatencyHistogram));
+
+  // The histograms are not cleared by taking a snapshot.
+  objctk_statistics repeatedStatistics = currentStatistics();
+  EXPECT(memcmp(&statistics.nodeCountHistogram, &repeatedStatistics.nodeCountHistogram, sizeof(statistics.nodeCountHistogram)) == 0);
+}
+
+static void testFailedParses() {
+  objctk_setStatisticsEnabled(true);
+  objctk_resetStatistics();
+  objctk_parselimits limits;
+  memset(&limits, 0, sizeof(objctk_parselimits));
+  limits.maximumNodeCount = 2;
+  objctk_typeparseresult parseResult = objctk_parseTypeEncodingWithLimits("^^^i", &limits, NULL);
+  EXPECT_EQ(objctk_statuscode_LimitExceeded, objctk_typeparseresult_getStatusCode(parseResult));
+  objctk_typeparseresult_release(parseResult);
+  parseAndRelease("^^^i");
+
+  objctk_statistics statistics = currentStatistics();
+  EXPECT_EQ(2, statistics.parseCount);
+  EXPECT_EQ(1, statistics.failedParseCount);
+  EXPECT_EQ(8, statistics.inputByteCount);
+}
+
+static void testReset() {
+  objctk_setStatisticsEnabled(true);
+  parseAndRelease("{CGPoint=dd}");
+  objctk_statistics statistics = currentStatistics();
+  EXPECT(!isZeroStatistics(&statistics));
+
+  objctk_resetStatistics();
+  statistics = currentStatistics();
+  EXPECT(isZeroStatistics(&statistics));
+
+  // Statistics collected after a reset start from zero.
+  parseAndRelease("i");
+  statistics = currentStatistics();
+  EXPECT_EQ(1, statistics.parseCount);
+  EXPECT_EQ(1, statistics.nodeCount);
+  EXPECT_EQ(1, statistics.nodeCountHistogram[1]);
+}
+
+static void testConcurrentParses() {
+  const unsigned int threadCount = 8;
+  const unsigned int iterationCount = 500;
+  objctk_setStatisticsEnabled(true);
+  objctk_resetStatistics();
+
+  // Every thread lands on a statistics shard of its own or shares one, and either way the totals
+  // cover every parse.
+  std::vector<std::thread> threads;
+  for (unsigned int threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+    threads.emplace_back([]() {
+      for (unsigned int iteration = 0; iteration < iterationCount; iteration++) {
+        for (size_t index = 0; index < kExpectedParseCount; index++) {
+          parseAndRelease(kExpectedParses[index].typeEncoding);
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t nodeCount = 0;
+  uint64_t tokenCount = 0;
+  uint64_t inputByteCount = 0;
+  for (size_t index = 0; index < kExpectedParseCount; index++) {
+    nodeCount += kExpectedParses[index].nodeCount;
+    tokenCount += kExpectedParses[index].tokenCount;
+    inputByteCount += strlen(kExpectedParses[index].typeEncoding);
+  }
+  const uint64_t repetitionCount = threadCount * iterationCount;
+  objctk_statistics statistics = currentStatistics();
+  EXPECT_EQ(repetitionCount * kExpectedParseCount, statistics.parseCount);
+  EXPECT_EQ(0, statistics.failedParseCount);
+  EXPECT_EQ(repetitionCount * nodeCount, statistics.nodeCount);
+  EXPECT_EQ(repetitionCount * tokenCount, statistics.tokenCount);
+  EXPECT_EQ(repetitionCount * inputByteCount, statistics.inputByteCount);
+  EXPECT_EQ(repetitionCount * 2, statistics.nodeCountHistogram[1]);
+  EXPECT_EQ(repetitionCount, statistics.nodeCountHistogram[2]);
+  EXPECT_EQ(repetitionCount * 2, statistics.nodeCountHistogram[3]);
+  EXPECT_EQ(statistics.parseCount, histogramSampleCount(statistics.retainedByteHistogram));
+  EXPECT_EQ(statistics.parseCount, histogramSampleCount(statistics.parseLatencyHistogram));
+
+  objctk_resetStatistics();
+  statistics = currentStatistics();
+  EXPECT(isZeroStatistics(&statistics));
+}
+
+static void testResetDuringConcurrentParses() {
+  const unsigned int threadCount = 4;
+  const unsigned int iterationCount = 2000;
+  objctk_setStatisticsEnabled(true);
+  objctk_resetStatistics();
+
+  std::atomic<unsigned int> runningThreadCount(threadCount);
+  std::vector<std::thread> threads;
+  for (unsigned int threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+    threads.emplace_back([&runningThreadCount]() {
+      for (unsigned int iteration = 0; iteration < iterationCount; iteration++) {
+        parseAndRelease("{CGPoint=dd}");
+      }
+      runningThreadCount.fetch_sub(1);
+    });
+  }
+
+  // A reset racing with a parse may drop part of its sample, but never counts a sample twice, so
+  // no snapshot ever holds more than was parsed.
+  while (runningThreadCount.load() > 0) {
+    objctk_resetStatistics();
+    objctk_statistics statistics = currentStatistics();
+    EXPECT(statistics.parseCount <= threadCount * iterationCount);
+    EXPECT(statistics.nodeCount <= 3 * threadCount * iterationCount);
+    EXPECT(statistics.nodeCountHistogram[2] <= threadCount * iterationCount);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Parses made after the last reset are all counted.
+  objctk_resetStatistics();
+  parseAndRelease("{CGPoint=dd}");
+  objctk_statistics statistics = currentStatistics();
+  EXPECT_EQ(1, statistics.parseCount);
+  EXPECT_EQ(3, statistics.nodeCount);
+  EXPECT_EQ(1, statistics.nodeCountHistogram[2]);
+  objctk_setStatisticsEnabled(false);
+}
+
+int main() {
+  testDisabledStatistics();
+  testSingleParseCounters();
+  testHistogramBuckets();
+  testFailedParses();
+  testReset();
+  testConcurrentParses();
+  testResetDuringConcurrentParses();
+  return testResult();
+}
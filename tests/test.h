@@ -0,0 +1,61 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OBJCTK_TEST__
+#define OBJCTK_TEST__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Reports a failed expectation and fails the test without aborting it, so that a run lists every
+// failed expectation.
+static int gTestFailureCount = 0;
+
+#define EXPECT(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: expectation failed: %s\n", __FILE__, __LINE__, #condition); \
+      gTestFailureCount++; \
+    } \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual) \
+  do { \
+    const long long expectedValue = (long long)(expected); \
+    const long long actualValue = (long long)(actual); \
+    if (expectedValue != actualValue) { \
+      fprintf(stderr, "%s:%d: expected %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #expected, #actual, expectedValue, actualValue); \
+      gTestFailureCount++; \
+    } \
+  } while (0)
+
+static inline int testResult() {
+  if (gTestFailureCount != 0) {
+    fprintf(stderr, "%d expectation(s) failed\n", gTestFailureCount);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include "test.h"
+
+#include <string>
+#include <vector>
+
+using namespace objctk;
+
+static std::vector<std::string> mixedTypeEncodings(const unsigned int count) {
+  std::vector<std::string> typeEncodings;
+  for (unsigned int index = 0; index < count; index++) {
+    const std::string suffix = std::to_string(index % 61);
+    switch (index % 5) {
+      case 0: typeEncodings.push_back("{CGRect" + suffix + "={CGPoint=dd}{CGSize=dd}}"); break;
+      case 1: typeEncodings.push_back("^{Node" + suffix + "=^{Node" + suffix + "}i[4c]}"); break;
+      case 2: typeEncodings.push_back("(Value" + suffix + "=iqb3b5@\"NSString\")"); break;
+      case 3: typeEncodings.push_back("[16{Pair" + suffix + "=#:}]"); break;
+      default: typeEncodings.push_back("{Flags" + suffix + "=b1b2b3b4b5b6b7b8^?*}"); break;
+    }
+  }
+  return typeEncodings;
+}
+
+// Compares a type node in a corpus with the parsed type node it was built from, returning the
+// number of type nodes compared or zero if they differ.
+static size_t matchingNodeCount(objctk_typecorpus corpus, objctk_corpusnode corpusNode, _objctk_typenode *node) {
+  if ((objctk_typecorpus_getTypeCategory(corpus, corpusNode) != node->typeCategory()) || (objctk_typecorpus_getTypeSize(corpus, corpusNode) != node->typeSize())) {
+    return 0;
+  }
+  std::vector<_objctk_typenode *> children;
+  if (node->referencedType() != NULL) {
+    children.push_back(node->referencedType());
+  }
+  _objctk_typenode_list memberTypes = node->memberTypes();
+  children.insert(children.end(), memberTypes.begin(), memberTypes.end());
+  if (objctk_typecorpus_getChildCount(corpus, corpusNode) != children.size()) {
+    return 0;
+  }
+  size_t nodeCount = 1;
+  objctk_corpusnode child = objctk_typecorpus_getFirstChild(corpus, corpusNode);
+  for (_objctk_typenode *childNode : children) {
+    const size_t childNodeCount = matchingNodeCount(corpus, child, childNode);
+    if (childNodeCount == 0) {
+      return 0;
+    }
+    nodeCount += childNodeCount;
+    child = objctk_typecorpus_getNextSibling(corpus, child);
+  }
+  if ((child != OBJCTK_CORPUSNODE_NONE) || (objctk_typecorpus_getSubtreeSize(corpus, corpusNode) != nodeCount)) {
+    return 0;
+  }
+  return nodeCount;
+}
+
+static void testCorpusMatchesParsedTypes() {
+  const std::vector<std::string> typeEncodings = mixedTypeEncodings(500);
+  objctk_typecorpusbuilder builder = objctk_typecorpusbuilder_create(NULL);
+  for (const std::string &typeEncoding : typeEncodings) {
+    EXPECT_EQ(objctk_statuscode_NoError, objctk_typecorpusbuilder_addTypeEncoding(builder, typeEncoding.c_str()));
+  }
+  objctk_typecorpus corpus = objctk_typecorpusbuilder_createCorpus(builder);
+  EXPECT(corpus != NULL);
+  EXPECT_EQ(typeEncodings.size(), objctk_typecorpus_getTypeCount(corpus));
+
+  size_t nodeCount = 0;
+  for (size_t typeIndex = 0; typeIndex < typeEncodings.size(); typeIndex++) {
+    objctk_typeparseresult parseResult = objctk_parseTypeEncoding(typeEncodings[typeIndex].c_str());
+    const size_t typeNodeCount = matchingNodeCount(corpus, objctk_typecorpus_getType(corpus, typeIndex), objctk_typeparseresult_getParsedType(parseResult));
+    EXPECT(typeNodeCount != 0);
+    nodeCount += typeNodeCount;
+    objctk_typeparseresult_release(parseResult);
+  }
+  EXPECT_EQ(nodeCount, objctk_typecorpus_getNodeCount(corpus));
+  EXPECT(objctk_typecorpus_getType(corpus, typeEncodings.size()) == OBJCTK_CORPUSNODE_NONE);
+
+  objctk_corpusnode array = objctk_typecorpus_getType(corpus, 3);
+  EXPECT_EQ(16, objctk_typecorpus_getElementCount(corpus, array));
+  EXPECT(std::string(objctk_typecorpus_getName(corpus, objctk_typecorpus_getFirstChild(corpus, array))) == "Pair3");
+
+  objctk_typecorpus_release(corpus);
+  objctk_typecorpusbuilder_release(builder);
+}
+
+static void testCorpusFootprint() {
+  // The corpus is only worthwhile if its type nodes take a few bytes each. Its size depends only
+  // on the shape of the types, so it is checked against a fixed bound per type node.
+  const std::vector<std::string> typeEncodings = mixedTypeEncodings(20000);
+  objctk_typecorpusbuilder builder = objctk_typecorpusbuilder_create(NULL);
+  for (const std::string &typeEncoding : typeEncodings) {
+    objctk_typecorpusbuilder_addTypeEncoding(builder, typeEncoding.c_str());
+  }
+  objctk_typecorpus corpus = objctk_typecorpusbuilder_createCorpus(builder);
+  const size_t nodeCount = objctk_typecorpus_getNodeCount(corpus);
+  const size_t byteCount = objctk_typecorpus_getByteCount(corpus);
+  EXPECT(nodeCount > 100000);
+  EXPECT(byteCount <= (nodeCount * 6));
+  objctk_typecorpus_release(corpus);
+  objctk_typecorpusbuilder_release(builder);
+}
+
+int main() {
+  testCorpusMatchesParsedTypes();
+  testCorpusFootprint();
+  return testResult();
+}
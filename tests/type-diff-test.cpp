@@ -0,0 +1,79 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+#include "typenode.h"
+#include "typenode-subtypes.h"
+
+#include "test.h"
+
+using namespace objctk;
+
+static size_t changeCount(const char *oldTypeEncoding, const char *newTypeEncoding, objctk_typechangekind *outFirstKind) {
+  objctk_typeparseresult oldParseResult = objctk_parseTypeEncoding(oldTypeEncoding);
+  objctk_typeparseresult newParseResult = objctk_parseTypeEncoding(newTypeEncoding);
+  objctk_typediff diff = objctk_typediff_create();
+  size_t count = objctk_typediff_compare(diff, objctk_typeparseresult_getParsedType(oldParseResult), objctk_typeparseresult_getParsedType(newParseResult), objctk_layoutprofile_LP64);
+  if ((count > 0) && (outFirstKind != NULL)) {
+    *outFirstKind = objctk_typediff_getChanges(diff, NULL)[0].kind;
+  }
+  objctk_typediff_release(diff);
+  objctk_typeparseresult_release(newParseResult);
+  objctk_typeparseresult_release(oldParseResult);
+  return count;
+}
+
+static void testChanges() {
+  objctk_typechangekind kind = objctk_typechangekind_TypeReplaced;
+  EXPECT_EQ(0, changeCount("{CGPoint=dd}", "{CGPoint=dd}", NULL));
+  EXPECT_EQ(2, changeCount("{s=ic}", "{s=iq}", &kind));
+  EXPECT_EQ(objctk_typechangekind_SizeChanged, kind);
+  EXPECT_EQ(2, changeCount("{s=i}", "{s=ii}", &kind));
+  EXPECT_EQ(objctk_typechangekind_SizeChanged, kind);
+  EXPECT_EQ(1, changeCount("i", "q", &kind));
+  EXPECT_EQ(objctk_typechangekind_TypeReplaced, kind);
+}
+
+static void testCollidingHashesAreCompared() {
+  // Nodes constructed with the same type name hash collide regardless of their names.
+  objectpointernode oldNode(makeRange(0, 11), makeRange(2, 8), 42);
+  objectpointernode newNode(makeRange(0, 11), makeRange(2, 8), 42);
+  oldNode.setTypeNameID(objctk_internName("NSString", 8));
+  newNode.setTypeNameID(objctk_internName("NSNumber", 8));
+  EXPECT_EQ(oldNode.structuralHash(), newNode.structuralHash());
+  EXPECT(!areStructurallyEqualTypeNodes(&oldNode, &newNode));
+
+  objctk_typediff diff = objctk_typediff_create();
+  EXPECT_EQ(1, objctk_typediff_compare(diff, &oldNode, &newNode, objctk_layoutprofile_LP64));
+  objctk_typediff_release(diff);
+
+  newNode.setTypeNameID(oldNode.typeNameID());
+  EXPECT(areStructurallyEqualTypeNodes(&oldNode, &newNode));
+}
+
+int main() {
+  testChanges();
+  testCollidingHashesAreCompared();
+  return testResult();
+}
@@ -0,0 +1,210 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "objctk.h"
+
+#include "test.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+static objctk_valuecomparator makeComparator(const char *typeEncoding, objctk_typeparseresult *outParseResult) {
+  *outParseResult = objctk_parseTypeEncoding(typeEncoding);
+  return objctk_valuecomparator_create(objctk_typeparseresult_getParsedType(*outParseResult), objctk_layoutprofile_Host);
+}
+
+// Expects two values to compare equal and hash alike, or to compare unequal.
+static bool agreesWithHash(objctk_valuecomparator comparator, const void *value, const void *otherValue) {
+  const bool isEqual = objctk_valuecomparator_equalValues(comparator, value, otherValue);
+  return !isEqual || (objctk_valuecomparator_hashValue(comparator, value) == objctk_valuecomparator_hashValue(comparator, otherValue));
+}
+
+static void testPaddingIsIgnored() {
+  struct Padded {
+    char c;
+    int i;
+    short s;
+  };
+  objctk_typeparseresult parseResult;
+  objctk_valuecomparator comparator = makeComparator("{Padded=cis}", &parseResult);
+  EXPECT(comparator != NULL);
+  EXPECT_EQ(sizeof(Padded), objctk_valuecomparator_getValueSize(comparator));
+
+  Padded value;
+  Padded otherValue;
+  memset(&value, 0x00, sizeof(value));
+  memset(&otherValue, 0xFF, sizeof(otherValue));
+  value.c = otherValue.c = 'a';
+  value.i = otherValue.i = 42;
+  value.s = otherValue.s = 7;
+  EXPECT(objctk_valuecomparator_equalValues(comparator, &value, &otherValue));
+  EXPECT(agreesWithHash(comparator, &value, &otherValue));
+  otherValue.s = 8;
+  EXPECT(!objctk_valuecomparator_equalValues(comparator, &value, &otherValue));
+  objctk_valuecomparator_release(comparator);
+  objctk_typeparseresult_release(parseResult);
+
+  // The unnamed bits of a bitfield storage unit are ignored too.
+  comparator = makeComparator("{Flags=b3b2}", &parseResult);
+  EXPECT(comparator != NULL);
+  const unsigned char flags[4] = {0x1D, 0x00, 0x00, 0x00};
+  const unsigned char otherFlags[4] = {0xFD, 0xFF, 0xFF, 0xFF};
+  const unsigned char differentFlags[4] = {0x1E, 0x00, 0x00, 0x00};
+  EXPECT(objctk_valuecomparator_equalValues(comparator, flags, otherFlags));
+  EXPECT(agreesWithHash(comparator, flags, otherFlags));
+  EXPECT(!objctk_valuecomparator_equalValues(comparator, flags, differentFlags));
+  objctk_valuecomparator_release(comparator);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testFloatingPointValues() {
+  objctk_typeparseresult parseResult;
+  objctk_valuecomparator comparator = makeComparator("{Vector=df}", &parseResult);
+  EXPECT(comparator != NULL);
+  struct Vector {
+    double d;
+    float f;
+  };
+  Vector zero;
+  Vector negativeZero;
+  memset(&zero, 0, sizeof(zero));
+  memset(&negativeZero, 0xAB, sizeof(negativeZero));
+  negativeZero.d = -0.0;
+  negativeZero.f = -0.0f;
+  EXPECT(objctk_valuecomparator_equalValues(comparator, &zero, &negativeZero));
+  EXPECT(agreesWithHash(comparator, &zero, &negativeZero));
+
+  // NaNs with different payloads are equal to each other but not to numbers.
+  Vector nan = zero;
+  Vector otherNaN = zero;
+  nan.d = nan.f = NAN;
+  uint64_t bits;
+  memcpy(&bits, &nan.d, sizeof(bits));
+  bits |= 1;
+  memcpy(&otherNaN.d, &bits, sizeof(bits));
+  otherNaN.f = -NAN;
+  EXPECT(objctk_valuecomparator_equalValues(comparator, &nan, &otherNaN));
+  EXPECT(agreesWithHash(comparator, &nan, &otherNaN));
+  EXPECT(!objctk_valuecomparator_equalValues(comparator, &nan, &zero));
+  objctk_valuecomparator_release(comparator);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testPointersCompareByIdentity() {
+  objctk_typeparseresult parseResult;
+  objctk_valuecomparator comparator = makeComparator("{Pair=@^v}", &parseResult);
+  EXPECT(comparator != NULL);
+  int object;
+  int otherObject;
+  void *value[2] = {&object, NULL};
+  void *sameValue[2] = {&object, NULL};
+  void *otherValue[2] = {&otherObject, NULL};
+  EXPECT(objctk_valuecomparator_equalValues(comparator, value, sameValue));
+  EXPECT(agreesWithHash(comparator, value, sameValue));
+  EXPECT(!objctk_valuecomparator_equalValues(comparator, value, otherValue));
+  objctk_valuecomparator_release(comparator);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testArraysOfStructsRepeatNonTilingOperations() {
+  // The doubles of each element do not tile it because of the trailing char, so they repeat at the
+  // element stride instead of once per element.
+  struct Element {
+    double x;
+    double y;
+    char tag;
+  };
+  const size_t elementCount = 100000;
+  objctk_typeparseresult parseResult;
+  objctk_valuecomparator comparator = makeComparator("[100000{Element=ddc}]", &parseResult);
+  EXPECT(comparator != NULL);
+  EXPECT_EQ(elementCount * sizeof(Element), objctk_valuecomparator_getValueSize(comparator));
+  EXPECT_EQ(2, objctk_valuecomparator_getOperationCount(comparator));
+
+  std::vector<Element> value(elementCount);
+  memset(value.data(), 0, value.size() * sizeof(Element));
+  for (size_t index = 0; index < elementCount; index++) {
+    value[index].x = (double)index;
+    value[index].y = -(double)index;
+    value[index].tag = (char)index;
+  }
+  std::vector<Element> otherValue = value;
+  // Differences in the padding of the last element are ignored.
+  memset(reinterpret_cast<char *>(&otherValue[elementCount - 1]) + offsetof(Element, tag) + 1, 0xFF, sizeof(Element) - offsetof(Element, tag) - 1);
+  EXPECT(objctk_valuecomparator_equalValues(comparator, value.data(), otherValue.data()));
+  EXPECT(agreesWithHash(comparator, value.data(), otherValue.data()));
+
+  otherValue[elementCount - 1].y = 1;
+  EXPECT(!objctk_valuecomparator_equalValues(comparator, value.data(), otherValue.data()));
+  otherValue[elementCount - 1].y = value[elementCount - 1].y;
+  otherValue[elementCount - 1].tag++;
+  EXPECT(!objctk_valuecomparator_equalValues(comparator, value.data(), otherValue.data()));
+  objctk_valuecomparator_release(comparator);
+  objctk_typeparseresult_release(parseResult);
+
+  // Arrays of arrays of such structs repeat the same operations.
+  comparator = makeComparator("[10[20{Element=ddc}]]", &parseResult);
+  EXPECT_EQ(2, objctk_valuecomparator_getOperationCount(comparator));
+  EXPECT(objctk_valuecomparator_equalValues(comparator, value.data(), otherValue.data()));
+  otherValue[199].x = 0.5;
+  EXPECT(!objctk_valuecomparator_equalValues(comparator, value.data(), otherValue.data()));
+  objctk_valuecomparator_release(comparator);
+  objctk_typeparseresult_release(parseResult);
+}
+
+static void testValueArrays() {
+  objctk_typeparseresult parseResult;
+  objctk_valuecomparator comparator = makeComparator("{Point=ii}", &parseResult);
+  EXPECT(comparator != NULL);
+  std::vector<int32_t> values(2 * 1000);
+  for (size_t index = 0; index < values.size(); index++) {
+    values[index] = (int32_t)(index * 3);
+  }
+  std::vector<int32_t> otherValues = values;
+  EXPECT_EQ(1000, objctk_valuecomparator_findFirstDifference(comparator, values.data(), otherValues.data(), 1000));
+  otherValues[2 * 700 + 1]++;
+  EXPECT_EQ(700, objctk_valuecomparator_findFirstDifference(comparator, values.data(), otherValues.data(), 1000));
+
+  std::vector<uint64_t> hashes(1000);
+  std::vector<uint64_t> otherHashes(1000);
+  objctk_valuecomparator_hashValues(comparator, values.data(), 1000, hashes.data());
+  objctk_valuecomparator_hashValues(comparator, otherValues.data(), 1000, otherHashes.data());
+  EXPECT(hashes[699] == otherHashes[699]);
+  EXPECT(hashes[700] != otherHashes[700]);
+  EXPECT(hashes[0] == objctk_valuecomparator_hashValue(comparator, values.data()));
+  objctk_valuecomparator_release(comparator);
+  objctk_typeparseresult_release(parseResult);
+}
+
+int main() {
+  testPaddingIsIgnored();
+  testFloatingPointValues();
+  testPointersCompareByIdentity();
+  testArraysOfStructsRepeatNonTilingOperations();
+  testValueArrays();
+  return testResult();
+}
@@ -0,0 +1,745 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Stephane Moore
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// objctk-analyze streams newline-delimited type encodings from files or standard input through a
+// reader thread, a pool of parser threads and an aggregator on the main thread, writing JSON lines
+// to standard output. Lines travel in batches drawn from a fixed pool, so a slow stage blocks the
+// stages before it and memory use does not grow with the size of the input.
+
+#include "type-encoding.h"
+#include "types.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum OutputMode {
+  // One JSON object per encoding.
+  OutputModeEncodings,
+  // Aggregate statistics once the input is exhausted.
+  OutputModeSummary,
+};
+
+struct Options {
+  OutputMode mode = OutputModeSummary;
+  objctk_layoutprofile profile = objctk_layoutprofile_Host;
+  unsigned int threadCount = 0;
+  size_t batchCount = 0;
+  size_t batchLineCount = 1024;
+  size_t maximumLineLength = 1 << 20;
+  size_t largestStructCount = 10;
+  std::vector<const char *> inputPaths;
+};
+
+// Batches are flushed once their text reaches this size even if they hold fewer lines.
+static const size_t kBatchByteCapacity = 1 << 20;
+static const size_t kReadBufferSize = 1 << 16;
+
+// The number of registers of the HyperLogLog sketch estimating the number of distinct encodings.
+static const unsigned int kDistinctRegisterBits = 14;
+static const size_t kDistinctRegisterCount = (size_t)1 << kDistinctRegisterBits;
+
+static const char *const kTypeCategoryNames[] = {
+  "unknown",
+  "char",
+  "int",
+  "short",
+  "long",
+  "longLong",
+  "unsignedChar",
+  "unsignedInt",
+  "unsignedShort",
+  "unsignedLong",
+  "unsignedLongLong",
+  "float",
+  "double",
+  "bool",
+  "void",
+  "characterString",
+  "object",
+  "class",
+  "selector",
+  "array",
+  "struct",
+  "union",
+  "bitField",
+  "pointer",
+  "topLevel",
+};
+static const size_t kTypeCategoryCount = sizeof(kTypeCategoryNames) / sizeof(kTypeCategoryNames[0]);
+
+// A queue holding at most a fixed number of items, blocking producers while it is full and
+// consumers while it is empty until it is closed.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : m_capacity(capacity), m_closed(false) {}
+
+  void push(T item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] { return m_items.size() < m_capacity; });
+    m_items.push_back(item);
+    m_notEmpty.notify_one();
+  }
+
+  // Returns false once the queue is closed and empty.
+  bool pop(T *outItem) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this] { return !m_items.empty() || m_closed; });
+    if (m_items.empty()) {
+      return false;
+    }
+    *outItem = m_items.front();
+    m_items.pop_front();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_notEmpty.notify_all();
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::condition_variable m_notEmpty;
+  std::condition_variable m_notFull;
+  std::deque<T> m_items;
+  const size_t m_capacity;
+  bool m_closed;
+};
+
+struct EncodingRecord {
+  // The NUL-terminated encoding within the text of its batch.
+  size_t offset;
+  size_t length;
+  uint64_t lineNumber;
+  bool overlong;
+
+  objctk_statuscode statusCode;
+  size_t unexpectedTokenCount;
+  objctk_typecategory category;
+  int size;
+  int alignment;
+  const char *name;
+};
+
+struct Batch {
+  uint64_t sequenceNumber;
+  size_t inputIndex;
+  std::string text;
+  std::vector<EncodingRecord> records;
+};
+
+struct Pipeline {
+  explicit Pipeline(size_t batchCount) : freeBatches(batchCount), parseQueue(batchCount), resultQueue(batchCount), activeParserCount(0), hadInputError(false) {}
+
+  BoundedQueue<Batch *> freeBatches;
+  BoundedQueue<Batch *> parseQueue;
+  BoundedQueue<Batch *> resultQueue;
+  std::atomic<unsigned int> activeParserCount;
+  std::atomic<bool> hadInputError;
+};
+
+class LineReader {
+ public:
+  LineReader(const Options &options, Pipeline *pipeline) : m_options(options), m_pipeline(pipeline), m_batch(nullptr), m_nextSequenceNumber(0), m_lineStart(0), m_lineLength(0), m_lineNumber(0), m_lineOverlong(false) {}
+
+  void readInputs() {
+    std::vector<char> buffer(kReadBufferSize);
+    for (size_t inputIndex = 0; inputIndex < m_options.inputPaths.size(); inputIndex++) {
+      const char *path = m_options.inputPaths[inputIndex];
+      const bool readsStandardInput = (strcmp(path, "-") == 0);
+      FILE *file = readsStandardInput ? stdin : fopen(path, "rb");
+      if (file == nullptr) {
+        fprintf(stderr, "objctk-analyze: %s: %s\n", path, strerror(errno));
+        m_pipeline->hadInputError = true;
+        continue;
+      }
+      m_lineNumber = 0;
+      size_t readCount;
+      while ((readCount = fread(buffer.data(), 1, buffer.size(), file)) != 0) {
+        appendBytes(inputIndex, buffer.data(), readCount);
+      }
+      if (ferror(file)) {
+        fprintf(stderr, "objctk-analyze: %s: %s\n", path, strerror(errno));
+        m_pipeline->hadInputError = true;
+      }
+      // A final line need not be terminated by a newline.
+      if ((m_lineLength != 0) || m_lineOverlong) {
+        finishLine();
+      }
+      flushBatch();
+      if (!readsStandardInput) {
+        fclose(file);
+      }
+    }
+    m_pipeline->parseQueue.close();
+  }
+
+ private:
+  void appendBytes(size_t inputIndex, const char *bytes, size_t count) {
+    size_t position = 0;
+    while (position < count) {
+      if (m_batch == nullptr) {
+        m_pipeline->freeBatches.pop(&m_batch);
+        m_batch->sequenceNumber = m_nextSequenceNumber++;
+        m_batch->inputIndex = inputIndex;
+        m_lineStart = 0;
+      }
+      const char *newline = (const char *)memchr(bytes + position, '\n', count - position);
+      const size_t end = (newline != nullptr) ? (size_t)(newline - bytes) : count;
+      const size_t pieceLength = end - position;
+      // The remainder of an overlong line is discarded as it is read.
+      if (!m_lineOverlong) {
+        if ((m_lineLength + pieceLength) > m_options.maximumLineLength) {
+          m_lineOverlong = true;
+          m_batch->text.resize(m_lineStart);
+        } else {
+          m_batch->text.append(bytes + position, pieceLength);
+        }
+      }
+      m_lineLength += pieceLength;
+      position = end;
+      if (newline != nullptr) {
+        position++;
+        finishLine();
+        if ((m_batch->records.size() >= m_options.batchLineCount) || (m_batch->text.size() >= kBatchByteCapacity)) {
+          flushBatch();
+        }
+      }
+    }
+  }
+
+  void finishLine() {
+    m_lineNumber++;
+    size_t length = m_lineOverlong ? 0 : (m_batch->text.size() - m_lineStart);
+    if ((length != 0) && (m_batch->text.back() == '\r')) {
+      m_batch->text.pop_back();
+      length--;
+    }
+    if ((length != 0) || m_lineOverlong) {
+      EncodingRecord record = {};
+      record.offset = m_lineStart;
+      record.length = length;
+      record.lineNumber = m_lineNumber;
+      record.overlong = m_lineOverlong;
+      m_batch->records.push_back(record);
+      m_batch->text.push_back('\0');
+    }
+    m_lineStart = m_batch->text.size();
+    m_lineLength = 0;
+    m_lineOverlong = false;
+  }
+
+  void flushBatch() {
+    if (m_batch == nullptr) {
+      return;
+    }
+    m_pipeline->parseQueue.push(m_batch);
+    m_batch = nullptr;
+  }
+
+  const Options &m_options;
+  Pipeline *m_pipeline;
+  Batch *m_batch;
+  uint64_t m_nextSequenceNumber;
+  size_t m_lineStart;
+  size_t m_lineLength;
+  uint64_t m_lineNumber;
+  bool m_lineOverlong;
+};
+
+static void parseBatches(const Options &options, Pipeline *pipeline) {
+  objctk_parser parser = objctk_parser_create();
+  objctk_parselimits limits = {};
+  limits.maximumInputLength = options.maximumLineLength;
+  objctk_parser_setLimits(parser, &limits);
+
+  Batch *batch;
+  while (pipeline->parseQueue.pop(&batch)) {
+    for (EncodingRecord &record : batch->records) {
+      if (record.overlong) {
+        record.statusCode = objctk_statuscode_LimitExceeded;
+        continue;
+      }
+      // The parse result is owned by the parser and only valid until the next parse.
+      objctk_typeparseresult parseResult = objctk_parser_parseTypeEncoding(parser, batch->text.data() + record.offset);
+      record.statusCode = objctk_typeparseresult_getStatusCode(parseResult);
+      record.unexpectedTokenCount = objctk_typeparseresult_getUnexpectedTokenCount(parseResult);
+      objctk_typenode node = objctk_typeparseresult_getParsedType(parseResult);
+      if ((record.statusCode != objctk_statuscode_NoError) || (node == NULL)) {
+        continue;
+      }
+      record.category = objctk_typenode_getTypeCategory(node);
+      record.size = objctk_typenode_getTypeSizeForLayoutProfile(node, options.profile);
+      record.alignment = objctk_typenode_getTypeAlignmentForLayoutProfile(node, options.profile);
+      record.name = objctk_typenode_getName(node);
+    }
+    pipeline->resultQueue.push(batch);
+  }
+
+  objctk_parser_release(parser);
+  if (--pipeline->activeParserCount == 0) {
+    pipeline->resultQueue.close();
+  }
+}
+
+static void appendJSONString(std::string *output, const char *string, size_t length) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  output->push_back('"');
+  for (size_t index = 0; index < length; index++) {
+    const unsigned char ch = (unsigned char)string[index];
+    if ((ch == '"') || (ch == '\\')) {
+      output->push_back('\\');
+      output->push_back((char)ch);
+    } else if ((ch < 0x20) || (ch >= 0x7f)) {
+      // Bytes outside printable ASCII are escaped as Latin-1 code points to keep the output valid.
+      const char escape[] = { '\\', 'u', '0', '0', kHexDigits[ch >> 4], kHexDigits[ch & 0xf] };
+      output->append(escape, sizeof(escape));
+    } else {
+      output->push_back((char)ch);
+    }
+  }
+  output->push_back('"');
+}
+
+static void appendJSONString(std::string *output, const char *string) {
+  appendJSONString(output, string, strlen(string));
+}
+
+static void appendJSONKey(std::string *output, const char *key) {
+  if (output->back() != '{') {
+    output->push_back(',');
+  }
+  appendJSONString(output, key);
+  output->push_back(':');
+}
+
+static void appendJSONNumber(std::string *output, const char *key, long long value) {
+  appendJSONKey(output, key);
+  output->append(std::to_string(value));
+}
+
+static const char *categoryName(objctk_typecategory category) {
+  return ((size_t)category < kTypeCategoryCount) ? kTypeCategoryNames[category] : "unknown";
+}
+
+static uint64_t hashEncoding(const char *encoding, size_t length) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t index = 0; index < length; index++) {
+    hash = (hash ^ (unsigned char)encoding[index]) * 0x100000001b3ULL;
+  }
+  // FNV-1a leaves the high bits poorly mixed for short inputs.
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+struct LargestStruct {
+  int size;
+  size_t inputIndex;
+  uint64_t lineNumber;
+  std::string encoding;
+  const char *name;
+};
+
+class Aggregator {
+ public:
+  Aggregator(const Options &options, FILE *output) : m_options(options), m_outputFile(output), m_encodingCount(0), m_failedCount(0), m_overlongCount(0), m_byteCount(0), m_categoryCounts(kTypeCategoryCount, 0), m_distinctRegisters(kDistinctRegisterCount, 0), m_smallestLargestStructIndex(0) {}
+
+  void processBatch(const Batch *batch) {
+    m_output.clear();
+    for (const EncodingRecord &record : batch->records) {
+      if (m_options.mode == OutputModeEncodings) {
+        appendEncodingRecord(batch, record);
+      } else {
+        aggregateRecord(batch, record);
+      }
+    }
+    writeOutput();
+  }
+
+  void finish() {
+    if (m_options.mode != OutputModeSummary) {
+      return;
+    }
+    m_output.clear();
+    m_output.append("{");
+    appendJSONKey(&m_output, "kind");
+    appendJSONString(&m_output, "summary");
+    appendJSONNumber(&m_output, "encodings", (long long)m_encodingCount);
+    appendJSONNumber(&m_output, "failed", (long long)m_failedCount);
+    appendJSONNumber(&m_output, "overlong", (long long)m_overlongCount);
+    appendJSONNumber(&m_output, "bytes", (long long)m_byteCount);
+    appendJSONNumber(&m_output, "distinctEncodingsEstimate", (long long)estimateDistinctEncodingCount());
+    m_output.append("}\n");
+
+    for (size_t category = 0; category < kTypeCategoryCount; category++) {
+      if (m_categoryCounts[category] == 0) {
+        continue;
+      }
+      m_output.append("{");
+      appendJSONKey(&m_output, "kind");
+      appendJSONString(&m_output, "category");
+      appendJSONKey(&m_output, "category");
+      appendJSONString(&m_output, kTypeCategoryNames[category]);
+      appendJSONNumber(&m_output, "count", (long long)m_categoryCounts[category]);
+      m_output.append("}\n");
+    }
+
+    std::vector<LargestStruct> largestStructs = m_largestStructs;
+    std::sort(largestStructs.begin(), largestStructs.end(), [](const LargestStruct &a, const LargestStruct &b) {
+      return (a.size != b.size) ? (a.size > b.size) : ((a.inputIndex != b.inputIndex) ? (a.inputIndex < b.inputIndex) : (a.lineNumber < b.lineNumber));
+    });
+    for (size_t rank = 0; rank < largestStructs.size(); rank++) {
+      const LargestStruct &largestStruct = largestStructs[rank];
+      m_output.append("{");
+      appendJSONKey(&m_output, "kind");
+      appendJSONString(&m_output, "largestStruct");
+      appendJSONNumber(&m_output, "rank", (long long)(rank + 1));
+      appendJSONKey(&m_output, "source");
+      appendJSONString(&m_output, m_options.inputPaths[largestStruct.inputIndex]);
+      appendJSONNumber(&m_output, "line", (long long)largestStruct.lineNumber);
+      if (largestStruct.name != NULL) {
+        appendJSONKey(&m_output, "name");
+        appendJSONString(&m_output, largestStruct.name);
+      }
+      appendJSONNumber(&m_output, "size", largestStruct.size);
+      appendJSONKey(&m_output, "encoding");
+      appendJSONString(&m_output, largestStruct.encoding.data(), largestStruct.encoding.size());
+      m_output.append("}\n");
+    }
+    writeOutput();
+  }
+
+ private:
+  void appendEncodingRecord(const Batch *batch, const EncodingRecord &record) {
+    m_output.append("{");
+    appendJSONKey(&m_output, "source");
+    appendJSONString(&m_output, m_options.inputPaths[batch->inputIndex]);
+    appendJSONNumber(&m_output, "line", (long long)record.lineNumber);
+    if (!record.overlong) {
+      appendJSONKey(&m_output, "encoding");
+      appendJSONString(&m_output, batch->text.data() + record.offset, record.length);
+    }
+    appendJSONNumber(&m_output, "status", record.statusCode);
+    if (record.unexpectedTokenCount != 0) {
+      appendJSONNumber(&m_output, "unexpectedTokens", (long long)record.unexpectedTokenCount);
+    }
+    if (record.statusCode == objctk_statuscode_NoError) {
+      appendJSONKey(&m_output, "category");
+      appendJSONString(&m_output, categoryName(record.category));
+      if (record.name != NULL) {
+        appendJSONKey(&m_output, "name");
+        appendJSONString(&m_output, record.name);
+      }
+      appendJSONNumber(&m_output, "size", record.size);
+      appendJSONNumber(&m_output, "alignment", record.alignment);
+    }
+    m_output.append("}\n");
+  }
+
+  void aggregateRecord(const Batch *batch, const EncodingRecord &record) {
+    m_encodingCount++;
+    m_byteCount += record.length;
+    if (record.overlong) {
+      m_overlongCount++;
+      return;
+    }
+    const char *encoding = batch->text.data() + record.offset;
+    addDistinctEncoding(hashEncoding(encoding, record.length));
+    // Malformed encodings are parsed leniently and fail only through their unexpected tokens.
+    if ((record.statusCode != objctk_statuscode_NoError) || (record.unexpectedTokenCount != 0)) {
+      m_failedCount++;
+      return;
+    }
+    if ((size_t)record.category < kTypeCategoryCount) {
+      m_categoryCounts[record.category]++;
+    }
+    if (record.category == OBJCTKTypeCategoryStruct) {
+      considerLargestStruct(batch, record, encoding);
+    }
+  }
+
+  void addDistinctEncoding(uint64_t hash) {
+    const size_t registerIndex = (size_t)(hash >> (64 - kDistinctRegisterBits));
+    const uint64_t remainingBits = (hash << kDistinctRegisterBits) | ((uint64_t)1 << (kDistinctRegisterBits - 1));
+    const uint8_t rank = (uint8_t)(__builtin_clzll(remainingBits) + 1);
+    if (rank > m_distinctRegisters[registerIndex]) {
+      m_distinctRegisters[registerIndex] = rank;
+    }
+  }
+
+  uint64_t estimateDistinctEncodingCount() const {
+    const double registerCount = (double)kDistinctRegisterCount;
+    double harmonicSum = 0;
+    size_t zeroRegisterCount = 0;
+    for (uint8_t rank : m_distinctRegisters) {
+      harmonicSum += ldexp(1.0, -(int)rank);
+      zeroRegisterCount += (rank == 0);
+    }
+    double estimate = (0.7213 / (1 + 1.079 / registerCount)) * registerCount * registerCount / harmonicSum;
+    // Linear counting is more accurate while many registers are still empty.
+    if ((estimate <= 2.5 * registerCount) && (zeroRegisterCount != 0)) {
+      estimate = registerCount * log(registerCount / (double)zeroRegisterCount);
+    }
+    return (uint64_t)llround(estimate);
+  }
+
+  // Keeps the largest distinct structs, copying an encoding only when it enters the list. Once the
+  // list is full most structs are no larger than its smallest entry and are rejected by their size
+  // alone.
+  void considerLargestStruct(const Batch *batch, const EncodingRecord &record, const char *encoding) {
+    if (m_options.largestStructCount == 0) {
+      return;
+    }
+    const bool isFull = (m_largestStructs.size() >= m_options.largestStructCount);
+    if (isFull && (record.size <= m_largestStructs[m_smallestLargestStructIndex].size)) {
+      return;
+    }
+    for (const LargestStruct &largestStruct : m_largestStructs) {
+      if ((largestStruct.size == record.size) && (largestStruct.encoding.size() == record.length) && (memcmp(largestStruct.encoding.data(), encoding, record.length) == 0)) {
+        return;
+      }
+    }
+    LargestStruct largestStruct = { record.size, batch->inputIndex, record.lineNumber, std::string(encoding, record.length), record.name };
+    if (isFull) {
+      m_largestStructs[m_smallestLargestStructIndex] = std::move(largestStruct);
+    } else {
+      m_largestStructs.push_back(std::move(largestStruct));
+    }
+    m_smallestLargestStructIndex = 0;
+    for (size_t index = 1; index < m_largestStructs.size(); index++) {
+      if (m_largestStructs[index].size < m_largestStructs[m_smallestLargestStructIndex].size) {
+        m_smallestLargestStructIndex = index;
+      }
+    }
+  }
+
+  void writeOutput() {
+    if (!m_output.empty()) {
+      fwrite(m_output.data(), 1, m_output.size(), m_outputFile);
+    }
+  }
+
+  const Options &m_options;
+  FILE *m_outputFile;
+  std::string m_output;
+  uint64_t m_encodingCount;
+  uint64_t m_failedCount;
+  uint64_t m_overlongCount;
+  uint64_t m_byteCount;
+  std::vector<uint64_t> m_categoryCounts;
+  std::vector<uint8_t> m_distinctRegisters;
+  std::vector<LargestStruct> m_largestStructs;
+  size_t m_smallestLargestStructIndex;
+};
+
+static void printUsage(FILE *file) {
+  fprintf(file,
+      "usage: objctk-analyze [options] [file ...]\n"
+      "\n"
+      "Reads one type encoding per line from each file, or from standard input if no files are\n"
+      "given or a file is '-', and writes JSON lines to standard output. Encodings which fail to\n"
+      "parse or contain unexpected tokens are counted as failed.\n"
+      "\n"
+      "  --mode=summary|encodings  aggregate statistics (default) or one object per encoding\n"
+      "  --profile=PROFILE         host (default), lp64, ilp32, arm64 or i386\n"
+      "  --threads=N               number of parser threads (default: number of CPUs)\n"
+      "  --batch-lines=N           lines per batch (default: 1024)\n"
+      "  --batches=N               batches in flight, bounding memory use (default: 4 per thread)\n"
+      "  --max-line-length=N       longer lines are reported but not parsed (default: 1048576)\n"
+      "  --largest-structs=N       number of largest structs to summarize (default: 10)\n");
+}
+
+static bool parseCount(const char *value, size_t minimum, size_t *outCount) {
+  char *end;
+  errno = 0;
+  const unsigned long long count = strtoull(value, &end, 10);
+  if ((*value == '\0') || (*end != '\0') || (errno != 0) || (count < minimum)) {
+    return false;
+  }
+  *outCount = (size_t)count;
+  return true;
+}
+
+static bool parseProfile(const char *value, objctk_layoutprofile *outProfile) {
+  static const struct {
+    const char *name;
+    objctk_layoutprofile profile;
+  } kProfiles[] = {
+    { "host", objctk_layoutprofile_Host },
+    { "lp64", objctk_layoutprofile_LP64 },
+    { "ilp32", objctk_layoutprofile_ILP32 },
+    { "arm64", objctk_layoutprofile_ARM64 },
+    { "i386", objctk_layoutprofile_I386 },
+  };
+  for (const auto &entry : kProfiles) {
+    if (strcmp(value, entry.name) == 0) {
+      *outProfile = entry.profile;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the value of an option of the form --name=value or NULL if the argument is another option.
+static const char *optionValue(const char *argument, const char *name) {
+  const size_t nameLength = strlen(name);
+  if ((strncmp(argument, name, nameLength) != 0) || (argument[nameLength] != '=')) {
+    return NULL;
+  }
+  return argument + nameLength + 1;
+}
+
+static bool parseOptions(int argc, char **argv, Options *options) {
+  bool readsOptions = true;
+  for (int index = 1; index < argc; index++) {
+    const char *argument = argv[index];
+    if (!readsOptions || (argument[0] != '-') || (strcmp(argument, "-") == 0)) {
+      options->inputPaths.push_back(argument);
+      continue;
+    }
+    if (strcmp(argument, "--") == 0) {
+      readsOptions = false;
+      continue;
+    }
+    size_t count;
+    const char *value;
+    if ((value = optionValue(argument, "--mode")) != NULL) {
+      if (strcmp(value, "summary") == 0) {
+        options->mode = OutputModeSummary;
+      } else if (strcmp(value, "encodings") == 0) {
+        options->mode = OutputModeEncodings;
+      } else {
+        return false;
+      }
+    } else if ((value = optionValue(argument, "--profile")) != NULL) {
+      if (!parseProfile(value, &options->profile)) {
+        return false;
+      }
+    } else if ((value = optionValue(argument, "--threads")) != NULL) {
+      if (!parseCount(value, 1, &count)) {
+        return false;
+      }
+      options->threadCount = (unsigned int)count;
+    } else if ((value = optionValue(argument, "--batch-lines")) != NULL) {
+      if (!parseCount(value, 1, &options->batchLineCount)) {
+        return false;
+      }
+    } else if ((value = optionValue(argument, "--batches")) != NULL) {
+      if (!parseCount(value, 1, &options->batchCount)) {
+        return false;
+      }
+    } else if ((value = optionValue(argument, "--max-line-length")) != NULL) {
+      if (!parseCount(value, 1, &options->maximumLineLength)) {
+        return false;
+      }
+    } else if ((value = optionValue(argument, "--largest-structs")) != NULL) {
+      if (!parseCount(value, 0, &options->largestStructCount)) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  if (options->inputPaths.empty()) {
+    options->inputPaths.push_back("-");
+  }
+  if (options->threadCount == 0) {
+    options->threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (options->batchCount == 0) {
+    options->batchCount = 4 * (size_t)options->threadCount;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if ((argc == 2) && ((strcmp(argv[1], "--help") == 0) || (strcmp(argv[1], "-h") == 0))) {
+    printUsage(stdout);
+    return 0;
+  }
+  if (!parseOptions(argc, argv, &options)) {
+    printUsage(stderr);
+    return 2;
+  }
+
+  Pipeline pipeline(options.batchCount);
+  std::vector<Batch> batches(options.batchCount);
+  for (Batch &batch : batches) {
+    pipeline.freeBatches.push(&batch);
+  }
+
+  LineReader reader(options, &pipeline);
+  std::thread readerThread(&LineReader::readInputs, &reader);
+  pipeline.activeParserCount = options.threadCount;
+  std::vector<std::thread> parserThreads;
+  for (unsigned int index = 0; index < options.threadCount; index++) {
+    parserThreads.emplace_back(parseBatches, std::cref(options), &pipeline);
+  }
+
+  // Batches are parsed out of order but aggregated in the order they were read so the output is
+  // deterministic.
+  Aggregator aggregator(options, stdout);
+  std::map<uint64_t, Batch *> pendingBatches;
+  uint64_t nextSequenceNumber = 0;
+  Batch *batch;
+  while (pipeline.resultQueue.pop(&batch)) {
+    pendingBatches[batch->sequenceNumber] = batch;
+    for (auto pending = pendingBatches.begin(); (pending != pendingBatches.end()) && (pending->first == nextSequenceNumber); pending = pendingBatches.erase(pending)) {
+      Batch *nextBatch = pending->second;
+      aggregator.processBatch(nextBatch);
+      nextSequenceNumber++;
+      nextBatch->text.clear();
+      nextBatch->records.clear();
+      pipeline.freeBatches.push(nextBatch);
+    }
+  }
+  aggregator.finish();
+
+  readerThread.join();
+  for (std::thread &parserThread : parserThreads) {
+    parserThread.join();
+  }
+  const bool hadOutputError = (fclose(stdout) != 0);
+  return (pipeline.hadInputError || hadOutputError) ? 1 : 0;
+}